@@ -89,6 +89,44 @@ namespace mars {
       return 0;
     }
 
+    static bool sameSource(const PendingRegistration &,
+                           const PendingRegistration &) {
+      return true;
+    }
+
+    static bool sameSource(const PendingTimedRegistration &a,
+                           const PendingTimedRegistration &b) {
+      return a.timerName == b.timerName;
+    }
+
+    static bool sameSource(const PendingTriggeredRegistration &a,
+                           const PendingTriggeredRegistration &b) {
+      return a.triggerName == b.triggerName;
+    }
+
+    // Files the registration of a receiver of a removed element as pending
+    // again. Wildcard registrations are still pending and are skipped.
+    template <typename T>
+    static void requeueRegistration(PatternTrie<T> *pending,
+                                    const T &registration) {
+      std::vector<T*> registrations;
+      typename std::vector<T*>::iterator registrationIt;
+      pending->collectPath(PatternTrie<T>::nameKey(registration.groupName,
+                                                   registration.dataName),
+                           &registrations);
+      for(registrationIt = registrations.begin();
+          registrationIt != registrations.end(); ++registrationIt) {
+        if((*registrationIt)->receiver == registration.receiver &&
+           (*registrationIt)->callbackParam == registration.callbackParam &&
+           sameSource(**registrationIt, registration) &&
+           matchPattern((*registrationIt)->groupName, registration.groupName) &&
+           matchPattern((*registrationIt)->dataName, registration.dataName)) {
+          return;
+        }
+      }
+      pending->push_back(registration);
+    }
+
     DataBroker::DataBroker(lib_manager::LibManager *theManager) :
       DataBrokerInterface(theManager),
       mars::utils::Thread(),
@@ -177,6 +215,7 @@ namespace mars {
       }
       elementsById.clear();
       elementsByName.clear();
+      elementsByPattern.clear();
       updatedElementsLock.unlock();
       triggersLock.unlock();
       timersLock.unlock();
@@ -206,7 +245,6 @@ namespace mars {
     bool DataBroker::createTimer(const std::string &timerName) {
       std::map<std::string, Timer>::iterator timerIt;
       bool ok = false;
-      bool advanceIterator = true;
       timersLock.lockForWrite();
       timerIt = timers.find(timerName);
       if(timerIt == timers.end()) {
@@ -225,31 +263,28 @@ namespace mars {
         elementsLock.unlock();
 
         // check for pending timer registrations
-        std::list<PendingTimedRegistration>::iterator pendingIt;
+        std::vector<PendingTimedRegistration*> pending;
+        std::vector<PendingTimedRegistration*>::iterator pendingIt;
         pendingRegistrationLock.lock();
-        for(pendingIt = pendingTimedRegistrations.begin();
-            pendingIt != pendingTimedRegistrations.end(); /* do nothing */) {
-          advanceIterator = true;
-          if(pendingIt->timerName == timerName) {
+        pendingTimedRegistrations.collectAll(&pending);
+        for(pendingIt = pending.begin(); pendingIt != pending.end(); ++pendingIt) {
+          PendingTimedRegistration *registration = *pendingIt;
+          if(registration->timerName == timerName) {
             elementsLock.lockForRead();
-            elementIt = elementsByName.find(std::make_pair(pendingIt->groupName,
-                                                           pendingIt->dataName));
+            elementIt = elementsByName.find(std::make_pair(registration->groupName,
+                                                           registration->dataName));
             if(elementIt != elementsByName.end()) {
               DataElement *element = elementIt->second;
-              TimedReceiver timedReceiver = {pendingIt->receiver, element,
-                                             pendingIt->updatePeriod,
+              TimedReceiver timedReceiver = {registration->receiver, element,
+                                             registration->updatePeriod,
                                              timerIt->second.t,
-                                             pendingIt->callbackParam};
+                                             registration->callbackParam};
               timerIt->second.receivers.locked_push_back(timedReceiver);
-              element->timedReceivers.push_back(pendingIt->receiver);
-              pendingIt = pendingTimedRegistrations.erase(pendingIt);
-              advanceIterator = false;
+              element->timedReceivers.push_back(registration->receiver);
+              pendingTimedRegistrations.erase(registration);
             }
             elementsLock.unlock();
           }
-          if(advanceIterator) {
-            ++pendingIt;
-          }
         }
 
         // check for pending timed producers
@@ -312,6 +347,7 @@ namespace mars {
       for(producerIt = timerIt->second.producers.begin();
           producerIt != timerIt->second.producers.end();
           ++producerIt) {
+        if(producerIt->suspended) continue;
         if(producerIt->nextTriggerTime <= timerIt->second.t) {
           while(producerIt->updatePeriod > 0 &&
                 producerIt->nextTriggerTime <= timerIt->second.t) {
@@ -378,6 +414,7 @@ namespace mars {
       for(timedReceiverIt = timerIt->second.receivers.begin();
           timedReceiverIt != timerIt->second.receivers.end();
           ++timedReceiverIt) {
+        if(timedReceiverIt->suspended) continue;
         if(timedReceiverIt->nextTriggerTime <= time) {
           while(timedReceiverIt->updatePeriod > 0 &&
                 timedReceiverIt->nextTriggerTime <= time) {
@@ -527,17 +564,17 @@ namespace mars {
         timerIt->second.lock->unlock();
       }
       // remove receiver from pendingTimedRegistration list
-      std::list<PendingTimedRegistration>::iterator pendingIt;
+      std::vector<PendingTimedRegistration*> pending;
+      std::vector<PendingTimedRegistration*>::iterator pendingIt;
       pendingRegistrationLock.lock();
-      for(pendingIt = pendingTimedRegistrations.begin();
-          pendingIt != pendingTimedRegistrations.end(); /* do nothing */) {
-        if((pendingIt->receiver == receiver) &&
-           (pendingIt->timerName == timerName) &&
-           matchPattern(groupName, pendingIt->groupName) &&
-           matchPattern(dataName, pendingIt->dataName)) {
-          pendingIt = pendingTimedRegistrations.erase(pendingIt);
-        } else {
-          ++pendingIt;
+      pendingTimedRegistrations.collectRelated(PatternTrie<PendingTimedRegistration>::patternKey(groupName, dataName),
+                                               &pending);
+      for(pendingIt = pending.begin(); pendingIt != pending.end(); ++pendingIt) {
+        if(((*pendingIt)->receiver == receiver) &&
+           ((*pendingIt)->timerName == timerName) &&
+           matchPattern(groupName, (*pendingIt)->groupName) &&
+           matchPattern(dataName, (*pendingIt)->dataName)) {
+          pendingTimedRegistrations.erase(*pendingIt);
         }
       }
       pendingRegistrationLock.unlock();
@@ -641,6 +678,42 @@ namespace mars {
       return ok;
     }
 
+    void DataBroker::setTimedReceiverSuspended(ReceiverInterface *receiver,
+                                               bool suspended) {
+      std::map<std::string, Timer>::iterator timerIt;
+      std::list<TimedReceiver>::iterator receiverIt;
+      timersLock.lockForRead();
+      for(timerIt = timers.begin(); timerIt != timers.end(); ++timerIt) {
+        timerIt->second.lock->lockForWrite();
+        for(receiverIt = timerIt->second.receivers.begin();
+            receiverIt != timerIt->second.receivers.end(); ++receiverIt) {
+          if(receiverIt->receiver == receiver) {
+            receiverIt->suspended = suspended;
+          }
+        }
+        timerIt->second.lock->unlock();
+      }
+      timersLock.unlock();
+    }
+
+    void DataBroker::setTimedProducerSuspended(ProducerInterface *producer,
+                                               bool suspended) {
+      std::map<std::string, Timer>::iterator timerIt;
+      std::list<TimedProducer>::iterator producerIt;
+      timersLock.lockForRead();
+      for(timerIt = timers.begin(); timerIt != timers.end(); ++timerIt) {
+        timerIt->second.lock->lockForWrite();
+        for(producerIt = timerIt->second.producers.begin();
+            producerIt != timerIt->second.producers.end(); ++producerIt) {
+          if(producerIt->producer == producer) {
+            producerIt->suspended = suspended;
+          }
+        }
+        timerIt->second.lock->unlock();
+      }
+      timersLock.unlock();
+    }
+
 
     bool DataBroker::createTrigger(const std::string &triggerName) {
       std::map<std::string, Trigger>::iterator triggerIt;
@@ -655,22 +728,22 @@ namespace mars {
       }
       // check for pending timer registrations
       std::map<std::pair<std::string, std::string>, DataElement*>::iterator elementIt;
-      std::list<PendingTriggeredRegistration>::iterator pendingIt;
+      std::vector<PendingTriggeredRegistration*> pending;
+      std::vector<PendingTriggeredRegistration*>::iterator pendingIt;
       pendingRegistrationLock.lock();
-      for(pendingIt = pendingTriggeredRegistrations.begin();
-          pendingIt != pendingTriggeredRegistrations.end(); /* do nothing */) {
-        if(pendingIt->triggerName == triggerName){
+      pendingTriggeredRegistrations.collectAll(&pending);
+      for(pendingIt = pending.begin(); pendingIt != pending.end(); ++pendingIt) {
+        PendingTriggeredRegistration *registration = *pendingIt;
+        if(registration->triggerName == triggerName){
           elementsLock.lockForRead();
-          elementIt = elementsByName.find(std::make_pair(pendingIt->groupName,
-                                                         pendingIt->dataName));
+          elementIt = elementsByName.find(std::make_pair(registration->groupName,
+                                                         registration->dataName));
           if(elementIt != elementsByName.end()) {
-            TriggeredReceiver triggeredReceiver = { pendingIt->receiver,
+            TriggeredReceiver triggeredReceiver = { registration->receiver,
                                                     elementIt->second,
-                                                    pendingIt->callbackParam };
+                                                    registration->callbackParam };
             triggerIt->second.receivers.locked_push_back(triggeredReceiver);
-            pendingIt = pendingTriggeredRegistrations.erase(pendingIt);
-          } else {
-            ++pendingIt;
+            pendingTriggeredRegistrations.erase(registration);
           }
           elementsLock.unlock();
         }
@@ -777,16 +850,16 @@ namespace mars {
       }
 
       // remove receiver from PendingReceivers list
-      std::list<PendingTriggeredRegistration>::iterator pendingIt;
+      std::vector<PendingTriggeredRegistration*> pending;
+      std::vector<PendingTriggeredRegistration*>::iterator pendingIt;
       pendingRegistrationLock.lock();
-      for(pendingIt = pendingTriggeredRegistrations.begin();
-          pendingIt != pendingTriggeredRegistrations.end(); /* do nothing */) {
-        if((pendingIt->triggerName == triggerName) &&
-           matchPattern(groupName, pendingIt->groupName) &&
-           matchPattern(dataName, pendingIt->dataName)) {
-          pendingIt = pendingTriggeredRegistrations.erase(pendingIt);
-        } else {
-          ++pendingIt;
+      pendingTriggeredRegistrations.collectRelated(PatternTrie<PendingTriggeredRegistration>::patternKey(groupName, dataName),
+                                                   &pending);
+      for(pendingIt = pending.begin(); pendingIt != pending.end(); ++pendingIt) {
+        if(((*pendingIt)->triggerName == triggerName) &&
+           matchPattern(groupName, (*pendingIt)->groupName) &&
+           matchPattern(dataName, (*pendingIt)->dataName)) {
+          pendingTriggeredRegistrations.erase(*pendingIt);
         }
       }
       pendingRegistrationLock.unlock();
@@ -822,7 +895,8 @@ namespace mars {
                                             const std::string &dataName) {
       std::vector<DataElement*> elements;
       std::list<Receiver>::iterator receiverIt;
-      std::list<PendingRegistration>::iterator pendingRegistrationIt;
+      std::vector<PendingRegistration*> pending;
+      std::vector<PendingRegistration*>::iterator pendingRegistrationIt;
       elementsLock.lockForRead();
       getElementsByName(groupName, dataName, &elements);
       int cnt = 0;
@@ -843,14 +917,14 @@ namespace mars {
       }
       // remove from pending list
       pendingRegistrationLock.lock();
-      for(pendingRegistrationIt = pendingSyncRegistrations.begin();
-          pendingRegistrationIt != pendingSyncRegistrations.end(); /*nothing*/) {
-        if((pendingRegistrationIt->receiver == receiver) &&
-           (matchPattern(groupName, pendingRegistrationIt->groupName)) &&
-           (matchPattern(dataName, pendingRegistrationIt->dataName))) {
-          pendingRegistrationIt = pendingSyncRegistrations.erase(pendingRegistrationIt);
-        } else {
-          ++pendingRegistrationIt;
+      pendingSyncRegistrations.collectRelated(PatternTrie<PendingRegistration>::patternKey(groupName, dataName),
+                                              &pending);
+      for(pendingRegistrationIt = pending.begin();
+          pendingRegistrationIt != pending.end(); ++pendingRegistrationIt) {
+        if(((*pendingRegistrationIt)->receiver == receiver) &&
+           (matchPattern(groupName, (*pendingRegistrationIt)->groupName)) &&
+           (matchPattern(dataName, (*pendingRegistrationIt)->dataName))) {
+          pendingSyncRegistrations.erase(*pendingRegistrationIt);
         }
       }
       pendingRegistrationLock.unlock();
@@ -886,7 +960,8 @@ namespace mars {
                                              const std::string &dataName) {
       std::vector<DataElement*> elements;
       std::list<Receiver>::iterator receiverIt;
-      std::list<PendingRegistration>::iterator pendingRegistrationIt;
+      std::vector<PendingRegistration*> pending;
+      std::vector<PendingRegistration*>::iterator pendingRegistrationIt;
       elementsLock.lockForRead();
       getElementsByName(groupName, dataName, &elements);
       int cnt = 0;
@@ -907,14 +982,14 @@ namespace mars {
       }
       // remove from pending list
       pendingAsyncRegistrations.lock();
-      for(pendingRegistrationIt = pendingAsyncRegistrations.begin();
-          pendingRegistrationIt != pendingAsyncRegistrations.end(); /*nothing*/) {
-        if((pendingRegistrationIt->receiver == receiver) &&
-           (matchPattern(groupName, pendingRegistrationIt->groupName)) &&
-           (matchPattern(dataName, pendingRegistrationIt->dataName))) {
-          pendingRegistrationIt = pendingAsyncRegistrations.erase(pendingRegistrationIt);
-        } else {
-          ++pendingRegistrationIt;
+      pendingAsyncRegistrations.collectRelated(PatternTrie<PendingRegistration>::patternKey(groupName, dataName),
+                                               &pending);
+      for(pendingRegistrationIt = pending.begin();
+          pendingRegistrationIt != pending.end(); ++pendingRegistrationIt) {
+        if(((*pendingRegistrationIt)->receiver == receiver) &&
+           (matchPattern(groupName, (*pendingRegistrationIt)->groupName)) &&
+           (matchPattern(dataName, (*pendingRegistrationIt)->dataName))) {
+          pendingAsyncRegistrations.erase(*pendingRegistrationIt);
         }
       }
       pendingAsyncRegistrations.unlock();
@@ -1014,6 +1089,172 @@ namespace mars {
       return id;
     }
 
+    bool DataBroker::removeData(unsigned long id) {
+      std::map<unsigned long, DataElement*>::iterator elementIt;
+      std::map<std::string, Timer>::iterator timerIt;
+      std::map<std::string, Trigger>::iterator triggerIt;
+      std::list<TimedProducer>::iterator producerIt;
+      std::list<TimedReceiver>::iterator timedReceiverIt;
+      std::list<TriggeredReceiver>::iterator triggeredReceiverIt;
+      std::list<Receiver>::iterator receiverIt;
+      std::list<DataItemConnection>::iterator connectionIt;
+      std::list<PendingTimedRegistration> timedRegistrations;
+      std::list<PendingTriggeredRegistration> triggeredRegistrations;
+      std::list<PendingRegistration> syncRegistrations, asyncRegistrations;
+
+      // The timers and triggers are handled first because stepTimer()
+      // takes the elementsLock while it holds the lock of a timer.
+      timersLock.lockForRead();
+      for(timerIt = timers.begin(); timerIt != timers.end(); ++timerIt) {
+        timerIt->second.lock->lockForWrite();
+        for(producerIt = timerIt->second.producers.begin();
+            producerIt != timerIt->second.producers.end(); /* do nothing */) {
+          if(producerIt->element->info.dataId == id) {
+            producerIt = timerIt->second.producers.erase(producerIt);
+          } else {
+            ++producerIt;
+          }
+        }
+        for(timedReceiverIt = timerIt->second.receivers.begin();
+            timedReceiverIt != timerIt->second.receivers.end(); /* do nothing */) {
+          if(timedReceiverIt->element->info.dataId == id) {
+            PendingTimedRegistration tmp;
+            tmp.receiver = timedReceiverIt->receiver;
+            tmp.groupName = timedReceiverIt->element->info.groupName.c_str();
+            tmp.dataName = timedReceiverIt->element->info.dataName.c_str();
+            tmp.timerName = timerIt->first.c_str();
+            tmp.updatePeriod = timedReceiverIt->updatePeriod;
+            tmp.callbackParam = timedReceiverIt->callbackParam;
+            timedRegistrations.push_back(tmp);
+            timedReceiverIt = timerIt->second.receivers.erase(timedReceiverIt);
+          } else {
+            ++timedReceiverIt;
+          }
+        }
+        timerIt->second.lock->unlock();
+      }
+      timersLock.unlock();
+
+      triggersLock.lockForRead();
+      for(triggerIt = triggers.begin(); triggerIt != triggers.end(); ++triggerIt) {
+        triggerIt->second.lock->lockForWrite();
+        for(triggeredReceiverIt = triggerIt->second.receivers.begin();
+            triggeredReceiverIt != triggerIt->second.receivers.end(); /* do nothing */) {
+          if(triggeredReceiverIt->element->info.dataId == id) {
+            PendingTriggeredRegistration tmp;
+            tmp.receiver = triggeredReceiverIt->receiver;
+            tmp.groupName = triggeredReceiverIt->element->info.groupName.c_str();
+            tmp.dataName = triggeredReceiverIt->element->info.dataName.c_str();
+            tmp.triggerName = triggerIt->first.c_str();
+            tmp.callbackParam = triggeredReceiverIt->callbackParam;
+            triggeredRegistrations.push_back(tmp);
+            triggeredReceiverIt = triggerIt->second.receivers.erase(triggeredReceiverIt);
+          } else {
+            ++triggeredReceiverIt;
+          }
+        }
+        triggerIt->second.lock->unlock();
+      }
+      triggersLock.unlock();
+
+      elementsLock.lockForWrite();
+      elementIt = elementsById.find(id);
+      if(elementIt == elementsById.end()) {
+        elementsLock.unlock();
+        return false;
+      }
+      DataElement *element = elementIt->second;
+      std::string groupName = element->info.groupName.c_str();
+      std::string dataName = element->info.dataName.c_str();
+      elementsById.erase(elementIt);
+      elementsByName.erase(std::make_pair(groupName, dataName));
+      std::string key = PatternTrie<DataElement*>::nameKey(groupName, dataName);
+      std::vector<DataElement**> candidates;
+      std::vector<DataElement**>::iterator candidateIt;
+      elementsByPattern.collectPath(key, &candidates);
+      for(candidateIt = candidates.begin();
+          candidateIt != candidates.end(); ++candidateIt) {
+        if(**candidateIt == element) {
+          elementsByPattern.erase(key, *candidateIt);
+          break;
+        }
+      }
+
+      // drop the connections of other elements into this one
+      for(elementIt = elementsById.begin();
+          elementIt != elementsById.end(); ++elementIt) {
+        std::list<DataItemConnection> &connections = elementIt->second->connections;
+        for(connectionIt = connections.begin();
+            connectionIt != connections.end(); /* do nothing */) {
+          if(connectionIt->toElement == element) {
+            connectionIt = connections.erase(connectionIt);
+          } else {
+            ++connectionIt;
+          }
+        }
+      }
+
+      updatedElementsLock.lock();
+      updatedElementsBackBuffer->erase(element);
+      updatedElementsFrontBuffer->erase(element);
+      updatedElementsLock.unlock();
+
+      element->receiverLock->lockForWrite();
+      for(receiverIt = element->syncReceivers.begin();
+          receiverIt != element->syncReceivers.end(); ++receiverIt) {
+        PendingRegistration tmp = { receiverIt->receiver, groupName,
+                                    dataName, receiverIt->callbackParam };
+        syncRegistrations.push_back(tmp);
+      }
+      for(receiverIt = element->asyncReceivers.begin();
+          receiverIt != element->asyncReceivers.end(); ++receiverIt) {
+        PendingRegistration tmp = { receiverIt->receiver, groupName,
+                                    dataName, receiverIt->callbackParam };
+        asyncRegistrations.push_back(tmp);
+      }
+      element->receiverLock->unlock();
+      elementsLock.unlock();
+
+      delete element->backBuffer;
+      delete element->frontBuffer;
+      delete element->bufferLock;
+      delete element->receiverLock;
+      delete element;
+
+      // keep the receivers for an element that is created with the same name
+      std::list<PendingRegistration>::iterator registrationIt;
+      pendingSyncRegistrations.lock();
+      for(registrationIt = syncRegistrations.begin();
+          registrationIt != syncRegistrations.end(); ++registrationIt) {
+        requeueRegistration(&pendingSyncRegistrations, *registrationIt);
+      }
+      pendingSyncRegistrations.unlock();
+      pendingAsyncRegistrations.lock();
+      for(registrationIt = asyncRegistrations.begin();
+          registrationIt != asyncRegistrations.end(); ++registrationIt) {
+        requeueRegistration(&pendingAsyncRegistrations, *registrationIt);
+      }
+      pendingAsyncRegistrations.unlock();
+      std::list<PendingTimedRegistration>::iterator timedRegistrationIt;
+      pendingTimedRegistrations.lock();
+      for(timedRegistrationIt = timedRegistrations.begin();
+          timedRegistrationIt != timedRegistrations.end();
+          ++timedRegistrationIt) {
+        requeueRegistration(&pendingTimedRegistrations, *timedRegistrationIt);
+      }
+      pendingTimedRegistrations.unlock();
+      std::list<PendingTriggeredRegistration>::iterator triggeredRegistrationIt;
+      pendingRegistrationLock.lock();
+      for(triggeredRegistrationIt = triggeredRegistrations.begin();
+          triggeredRegistrationIt != triggeredRegistrations.end();
+          ++triggeredRegistrationIt) {
+        requeueRegistration(&pendingTriggeredRegistrations,
+                            *triggeredRegistrationIt);
+      }
+      pendingRegistrationLock.unlock();
+      return true;
+    }
+
     void DataBroker::pushMessage(MessageType messageType,
                                  const std::string &format, va_list args) {
       const int MAX_BUFFER_SIZE = 1024;
@@ -1217,6 +1458,9 @@ namespace mars {
       elementsByName[std::make_pair(groupName.c_str(),
                                     dataName.c_str())] = element;
       elementsById[element->info.dataId] = element;
+      elementsByPattern.insert(PatternTrie<DataElement*>::nameKey(groupName,
+                                                                   dataName),
+                               element);
       updatePendingRegistrations(element);
       return element;
     }
@@ -1240,110 +1484,106 @@ namespace mars {
     }
 
     void DataBroker::updatePendingRegistrations(DataElement *newElement) {
-      std::list<PendingRegistration>::iterator registrationIt;
-      std::list<PendingTimedRegistration>::iterator timedRegistrationIt;
-      std::list<PendingTriggeredRegistration>::iterator triggeredRegistrationIt;
+      std::vector<PendingRegistration*> registrations;
+      std::vector<PendingTimedRegistration*> timedRegistrations;
+      std::vector<PendingTriggeredRegistration*> triggeredRegistrations;
+      std::vector<PendingRegistration*>::iterator registrationIt;
+      std::vector<PendingTimedRegistration*>::iterator timedRegistrationIt;
+      std::vector<PendingTriggeredRegistration*>::iterator triggeredRegistrationIt;
       std::map<std::string, Timer>::iterator timerIt;
       std::map<std::string, Trigger>::iterator triggerIt;
       std::string newGroupName = newElement->info.groupName.c_str();
       std::string newDataName = newElement->info.dataName.c_str();
+      // only the registrations filed on the path of the new name can match
+      std::string key = PatternTrie<PendingRegistration>::nameKey(newGroupName,
+                                                                  newDataName);
 
       // pending async receivers
-      for(registrationIt = pendingAsyncRegistrations.begin();
-          registrationIt != pendingAsyncRegistrations.end(); ) {
-        if(matchPattern(registrationIt->groupName, newGroupName) &&
-           matchPattern(registrationIt->dataName, newDataName)) {
-          Receiver r = {registrationIt->receiver, registrationIt->callbackParam};
+      pendingAsyncRegistrations.collectPath(key, &registrations);
+      for(registrationIt = registrations.begin();
+          registrationIt != registrations.end(); ++registrationIt) {
+        PendingRegistration *registration = *registrationIt;
+        if(matchPattern(registration->groupName, newGroupName) &&
+           matchPattern(registration->dataName, newDataName)) {
+          Receiver r = {registration->receiver, registration->callbackParam};
           newElement->asyncReceivers.push_back(r);
           // if the registration has wildcards keep it in the pending list...
-          if(hasWildcards(registrationIt->groupName) ||
-             hasWildcards(registrationIt->dataName)) {
-            ++registrationIt;
-          } else {
+          if(!hasWildcards(registration->groupName) &&
+             !hasWildcards(registration->dataName)) {
             // ...otherwise remove it.
-            registrationIt = pendingAsyncRegistrations.erase(registrationIt);
+            pendingAsyncRegistrations.erase(registration);
           }
-        } else {
-          ++registrationIt;
         }
       }
 
       // pending sync receivers
-      for(registrationIt = pendingSyncRegistrations.begin();
-          registrationIt != pendingSyncRegistrations.end(); ) {
-        if(matchPattern(registrationIt->groupName, newGroupName) &&
-           matchPattern(registrationIt->dataName, newDataName)) {
-          Receiver r = {registrationIt->receiver, registrationIt->callbackParam};
+      registrations.clear();
+      pendingSyncRegistrations.collectPath(key, &registrations);
+      for(registrationIt = registrations.begin();
+          registrationIt != registrations.end(); ++registrationIt) {
+        PendingRegistration *registration = *registrationIt;
+        if(matchPattern(registration->groupName, newGroupName) &&
+           matchPattern(registration->dataName, newDataName)) {
+          Receiver r = {registration->receiver, registration->callbackParam};
           newElement->syncReceivers.push_back(r);
           // if the registration has wildcards keep it in the pending list...
-          if(hasWildcards(registrationIt->groupName) ||
-             hasWildcards(registrationIt->dataName)) {
-            ++registrationIt;
-          } else {
+          if(!hasWildcards(registration->groupName) &&
+             !hasWildcards(registration->dataName)) {
             // ...otherwise remove it.
-            registrationIt = pendingSyncRegistrations.erase(registrationIt);
+            pendingSyncRegistrations.erase(registration);
           }
-        } else {
-          ++registrationIt;
         }
       }
 
       // pending timed receivers
-      for(timedRegistrationIt = pendingTimedRegistrations.begin();
-          timedRegistrationIt != pendingTimedRegistrations.end();/*do nothing*/){
-        bool removeItem = false;
-        if(matchPattern(timedRegistrationIt->groupName, newGroupName) &&
-           matchPattern(timedRegistrationIt->dataName, newDataName)) {
-          timerIt = timers.find(timedRegistrationIt->timerName);
+      pendingTimedRegistrations.collectPath(key, &timedRegistrations);
+      for(timedRegistrationIt = timedRegistrations.begin();
+          timedRegistrationIt != timedRegistrations.end();
+          ++timedRegistrationIt) {
+        PendingTimedRegistration *registration = *timedRegistrationIt;
+        if(matchPattern(registration->groupName, newGroupName) &&
+           matchPattern(registration->dataName, newDataName)) {
+          timerIt = timers.find(registration->timerName);
           if(timerIt != timers.end()) {
-            TimedReceiver r = { timedRegistrationIt->receiver,
+            TimedReceiver r = { registration->receiver,
                                 newElement,
-                                timedRegistrationIt->updatePeriod,
+                                registration->updatePeriod,
                                 timerIt->second.t,
-                                timedRegistrationIt->callbackParam };
+                                registration->callbackParam };
             timerIt->second.receivers.push_back(r);
-            newElement->timedReceivers.push_back(timedRegistrationIt->receiver);
+            newElement->timedReceivers.push_back(registration->receiver);
             // if the registration has wildcards keep it in the pending list...
-            if(!hasWildcards(timedRegistrationIt->groupName) &&
-               !hasWildcards(timedRegistrationIt->dataName)) {
-              removeItem = true;
+            if(!hasWildcards(registration->groupName) &&
+               !hasWildcards(registration->dataName)) {
+              pendingTimedRegistrations.erase(registration);
             }
           }
         }
-        if(removeItem) {
-          timedRegistrationIt = pendingTimedRegistrations.erase(timedRegistrationIt);
-        } else {
-          ++timedRegistrationIt;
-        }
       }
 
       // pending triggered receivers
-      for(triggeredRegistrationIt = pendingTriggeredRegistrations.begin();
-          triggeredRegistrationIt != pendingTriggeredRegistrations.end();
-          /*do nothing*/) {
-        bool removeItem = false;
-        if(matchPattern(triggeredRegistrationIt->groupName, newGroupName) &&
-           matchPattern(triggeredRegistrationIt->dataName, newDataName)) {
-          triggerIt = triggers.find(triggeredRegistrationIt->triggerName);
+      pendingTriggeredRegistrations.collectPath(key, &triggeredRegistrations);
+      for(triggeredRegistrationIt = triggeredRegistrations.begin();
+          triggeredRegistrationIt != triggeredRegistrations.end();
+          ++triggeredRegistrationIt) {
+        PendingTriggeredRegistration *registration = *triggeredRegistrationIt;
+        if(matchPattern(registration->groupName, newGroupName) &&
+           matchPattern(registration->dataName, newDataName)) {
+          triggerIt = triggers.find(registration->triggerName);
           if(triggerIt != triggers.end()) {
-            TriggeredReceiver r = { triggeredRegistrationIt->receiver,
+            TriggeredReceiver r = { registration->receiver,
                                     newElement,
-                                    triggeredRegistrationIt->callbackParam };
+                                    registration->callbackParam };
             triggerIt->second.receivers.push_back(r);
             newElement->triggeredReceivers.push_back(r.receiver);
             // if the registration has no wildcards remove
             // it from the pending list
-            if(!hasWildcards(triggeredRegistrationIt->groupName) &&
-               !hasWildcards(triggeredRegistrationIt->dataName)) {
-              removeItem = true;
+            if(!hasWildcards(registration->groupName) &&
+               !hasWildcards(registration->dataName)) {
+              pendingTriggeredRegistrations.erase(registration);
             }
           }
         }
-        if(removeItem) {
-          triggeredRegistrationIt = pendingTriggeredRegistrations.erase(triggeredRegistrationIt);
-        } else {
-          ++triggeredRegistrationIt;
-        }
       }
     }
 
@@ -1359,12 +1599,17 @@ namespace mars {
           elements->push_back(elementIt->second);
         }
       } else {
-        // do wildcard matching on all elements
-        for(elementIt = elementsByName.begin();
-            elementIt != elementsByName.end(); ++elementIt) {
-          if(matchPattern(groupName, elementIt->first.first) &&
-             matchPattern(dataName, elementIt->first.second)) {
-            elements->push_back(elementIt->second);
+        // do wildcard matching on the elements below the literal prefix
+        std::vector<DataElement**> candidates;
+        std::vector<DataElement**>::iterator candidateIt;
+        elementsByPattern.collectSubtree(PatternTrie<DataElement*>::patternKey(groupName, dataName),
+                                         &candidates);
+        for(candidateIt = candidates.begin();
+            candidateIt != candidates.end(); ++candidateIt) {
+          DataElement *element = **candidateIt;
+          if(matchPattern(groupName, element->info.groupName) &&
+             matchPattern(dataName, element->info.dataName)) {
+            elements->push_back(element);
           }
         }
       }
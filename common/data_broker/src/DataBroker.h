@@ -30,6 +30,7 @@
 #include "DataItem.h"
 #include "DataInfo.h"
 #include "LockableContainer.h"
+#include "PatternTrie.h"
 
 #include <mars/utils/Thread.h>
 #include <mars/utils/Mutex.h>
@@ -90,12 +91,14 @@ namespace mars {
       int callbackParam;
     };
 
+    // suspended is left out of the initializer lists and starts as false
     struct TimedReceiver {
       ReceiverInterface *receiver;
       DataElement *element;
       int updatePeriod;
       long nextTriggerTime;
       int callbackParam;
+      bool suspended;
     };
 
     struct TimedProducer {
@@ -104,6 +107,7 @@ namespace mars {
       int updatePeriod;
       long nextTriggerTime;
       int callbackParam;
+      bool suspended;
     };
 
     struct Timer {
@@ -182,6 +186,10 @@ namespace mars {
                                    const std::string &groupName,
                                    const std::string &dataName,
                                    const std::string &timerName);
+      void setTimedReceiverSuspended(ReceiverInterface *receiver,
+                                     bool suspended);
+      void setTimedProducerSuspended(ProducerInterface *producer,
+                                     bool suspended);
 
       bool createTrigger(const std::string &triggerName);
       bool trigger(const std::string &triggerName);
@@ -219,6 +227,7 @@ namespace mars {
       unsigned long pushData(unsigned long id,
                              const DataPackage &dataPackage,
                              const ReceiverInterface *producer=NULL);
+      bool removeData(unsigned long id);
 
       unsigned long getDataID(const std::string &groupName,
                               const std::string &dataName) const;
@@ -305,14 +314,18 @@ namespace mars {
       bool realtimeThreadRunning, stopRealtimeThread;
       bool startingRealtimeThread;
 
-      LockableContainer<std::list<PendingRegistration> > pendingAsyncRegistrations;
-      LockableContainer<std::list<PendingRegistration> > pendingSyncRegistrations;
+      // the pending receiver registrations are indexed by their name
+      // patterns to only match them against fitting new elements
+      LockableContainer<PatternTrie<PendingRegistration> > pendingAsyncRegistrations;
+      LockableContainer<PatternTrie<PendingRegistration> > pendingSyncRegistrations;
       LockableContainer<std::list<PendingTimedProducer> > pendingTimedProducers;
-      LockableContainer<std::list<PendingTimedRegistration> > pendingTimedRegistrations;
-      std::list<PendingTriggeredRegistration> pendingTriggeredRegistrations;
+      LockableContainer<PatternTrie<PendingTimedRegistration> > pendingTimedRegistrations;
+      PatternTrie<PendingTriggeredRegistration> pendingTriggeredRegistrations;
       std::map<unsigned long, DataElement*> elementsById;
       std::map<std::string, Trigger> triggers;
       std::map<std::pair<std::string, std::string>, DataElement*> elementsByName;
+      // the same elements for the lookup by wildcard patterns
+      PatternTrie<DataElement*> elementsByPattern;
       mutable mars::utils::ReadWriteLock elementsLock;
       mars::utils::ReadWriteLock timersLock;
       mars::utils::ReadWriteLock triggersLock;
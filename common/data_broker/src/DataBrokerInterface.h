@@ -228,6 +228,26 @@ namespace mars {
                                            const std::string &dataName,
                                            const std::string &timerName) = 0;
 
+      /**
+       * \brief suspend or resume all timer callbacks of a receiver
+       *
+       * A suspended receiver keeps its registrations but is skipped when
+       * the timers are stepped. This is cheaper than unregistering and
+       * registering again for objects that are muted temporarily.
+       * Registrations made while the receiver is suspended are not
+       * affected.
+       * \see registerTimedReceiver
+       */
+      virtual void setTimedReceiverSuspended(ReceiverInterface *receiver,
+                                             bool suspended) = 0;
+
+      /**
+       * \brief suspend or resume all timer callbacks of a producer
+       * \see setTimedReceiverSuspended, registerTimedProducer
+       */
+      virtual void setTimedProducerSuspended(ProducerInterface *producer,
+                                             bool suspended) = 0;
+
 
       /**
        * \brief create a new trigger with the given name
@@ -494,6 +514,19 @@ namespace mars {
                                      const DataPackage &dataPackage,
                                      const ReceiverInterface *producer=NULL) =0;
 
+      /**
+       * \brief removes a data item from the DataBroker
+       * \param id The pushId previously returned by \ref pushData(const std::string&,const std::string&,const DataPackage&,const ReceiverInterface*,PackageFlag) "pushData".
+       * \return \c true if the item was removed. \c false if no item with
+       *         the given \a id exists.
+       *
+       * The timed producers and the item connections of the item are
+       * dropped. Its receivers are kept as pending registrations and get
+       * the item again when it is pushed anew.
+       * After this call \a id is invalid.
+       */
+      virtual bool removeData(unsigned long id) = 0;
+
       /**
        * \brief get the unique dataId assosiated with a given groupName and 
        *        dataName
@@ -0,0 +1,232 @@
+/*
+ *  Copyright 2020, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef DATA_BROKER_PATTERN_TRIE_H
+#define DATA_BROKER_PATTERN_TRIE_H
+
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace mars {
+  namespace data_broker {
+
+    /**
+     * Files values under the group and data name (or name pattern) they
+     * belong to. The names are joined to one key and a pattern is filed
+     * under its literal prefix, i.e. the key up to the first wildcard.
+     * Thus all patterns that can match a name lie on the path of the name
+     * and all names a pattern can match lie in the subtree of the pattern.
+     * The candidates still have to be checked with matchPattern().
+     *
+     * The push_back() and erase() overloads without key are meant for the
+     * pending registrations and expect T to have a groupName and dataName.
+     */
+    template <typename T>
+    class PatternTrie {
+    public:
+      typedef T value_type;
+
+      PatternTrie() : root(new Node(NULL, 0)), count(0) {}
+      ~PatternTrie() {
+        delete root;
+      }
+
+      static std::string nameKey(const std::string &groupName,
+                                 const std::string &dataName) {
+        // the separator is not allowed in names
+        std::string key = groupName;
+        key.push_back('\0');
+        key.append(dataName);
+        return key;
+      }
+
+      static std::string patternKey(const std::string &groupName,
+                                    const std::string &dataName) {
+        size_t pos = groupName.find('*');
+        if(pos != groupName.npos) {
+          return groupName.substr(0, pos);
+        }
+        return nameKey(groupName, dataName.substr(0, dataName.find('*')));
+      }
+
+      T* insert(const std::string &key, const T &value) {
+        Node *node = root;
+        for(std::string::const_iterator it = key.begin(); it != key.end(); ++it) {
+          typename std::map<char, Node*>::iterator childIt;
+          childIt = node->children.find(*it);
+          if(childIt == node->children.end()) {
+            childIt = node->children.insert(std::make_pair(*it, new Node(node, *it))).first;
+          }
+          node = childIt->second;
+        }
+        node->values.push_back(value);
+        ++count;
+        return &node->values.back();
+      }
+
+      void push_back(const T &value) {
+        insert(patternKey(value.groupName, value.dataName), value);
+      }
+
+      /**
+       * Removes the value at the given address, which has to be filed
+       * under key. Nodes that get empty are removed.
+       */
+      bool erase(const std::string &key, const T *value) {
+        Node *node = findNode(key);
+        if(!node) return false;
+        typename std::list<T>::iterator it;
+        for(it = node->values.begin(); it != node->values.end(); ++it) {
+          if(&(*it) == value) {
+            node->values.erase(it);
+            --count;
+            prune(node);
+            return true;
+          }
+        }
+        return false;
+      }
+
+      bool erase(const T *value) {
+        return erase(patternKey(value->groupName, value->dataName), value);
+      }
+
+      /** \brief collects the values filed under any prefix of key */
+      void collectPath(const std::string &key, std::vector<T*> *values) const {
+        Node *node = root;
+        collectNode(node, values);
+        for(std::string::const_iterator it = key.begin(); it != key.end(); ++it) {
+          typename std::map<char, Node*>::const_iterator childIt;
+          childIt = node->children.find(*it);
+          if(childIt == node->children.end()) return;
+          node = childIt->second;
+          collectNode(node, values);
+        }
+      }
+
+      /** \brief collects the values filed under any extension of prefix */
+      void collectSubtree(const std::string &prefix,
+                          std::vector<T*> *values) const {
+        Node *node = findNode(prefix);
+        if(node) collectRecursive(node, values);
+      }
+
+      /**
+       * \brief collects the values of collectPath() and collectSubtree()
+       *
+       * These are the patterns that can be matched by a pattern with the
+       * given key when they are taken as plain names.
+       */
+      void collectRelated(const std::string &prefix,
+                          std::vector<T*> *values) const {
+        Node *node = root;
+        for(std::string::const_iterator it = prefix.begin();
+            it != prefix.end(); ++it) {
+          collectNode(node, values);
+          typename std::map<char, Node*>::const_iterator childIt;
+          childIt = node->children.find(*it);
+          if(childIt == node->children.end()) return;
+          node = childIt->second;
+        }
+        collectRecursive(node, values);
+      }
+
+      void collectAll(std::vector<T*> *values) const {
+        collectRecursive(root, values);
+      }
+
+      size_t size() const {
+        return count;
+      }
+      bool empty() const {
+        return count == 0;
+      }
+      void clear() {
+        delete root;
+        root = new Node(NULL, 0);
+        count = 0;
+      }
+
+    private:
+      struct Node {
+        Node(Node *parent, char c) : parent(parent), c(c) {}
+        ~Node() {
+          typename std::map<char, Node*>::iterator it;
+          for(it = children.begin(); it != children.end(); ++it) {
+            delete it->second;
+          }
+        }
+
+        Node *parent;
+        char c;
+        std::map<char, Node*> children;
+        std::list<T> values;
+      };
+
+      Node *root;
+      size_t count;
+
+      // not copyable
+      PatternTrie(const PatternTrie &other);
+      PatternTrie& operator=(const PatternTrie &other);
+
+      Node* findNode(const std::string &key) const {
+        Node *node = root;
+        for(std::string::const_iterator it = key.begin(); it != key.end(); ++it) {
+          typename std::map<char, Node*>::const_iterator childIt;
+          childIt = node->children.find(*it);
+          if(childIt == node->children.end()) return NULL;
+          node = childIt->second;
+        }
+        return node;
+      }
+
+      void prune(Node *node) {
+        while(node != root && node->values.empty() && node->children.empty()) {
+          Node *parent = node->parent;
+          parent->children.erase(node->c);
+          delete node;
+          node = parent;
+        }
+      }
+
+      static void collectNode(Node *node, std::vector<T*> *values) {
+        typename std::list<T>::iterator it;
+        for(it = node->values.begin(); it != node->values.end(); ++it) {
+          values->push_back(&(*it));
+        }
+      }
+
+      static void collectRecursive(Node *node, std::vector<T*> *values) {
+        collectNode(node, values);
+        typename std::map<char, Node*>::iterator it;
+        for(it = node->children.begin(); it != node->children.end(); ++it) {
+          collectRecursive(it->second, values);
+        }
+      }
+
+    }; // end of class PatternTrie
+
+  } // end of namespace data_broker
+} // end of namespace mars
+
+#endif /* DATA_BROKER_PATTERN_TRIE_H */
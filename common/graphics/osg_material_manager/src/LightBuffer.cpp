@@ -0,0 +1,215 @@
+/*
+ *  Copyright 2017, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "LightBuffer.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace osg_material_manager {
+
+  using namespace mars::interfaces;
+
+  LightBuffer::LightBuffer() : capacity(0), numLights(0) {
+    lightPosUniform = new osg::Uniform(osg::Uniform::FLOAT_VEC3, "lightPos", 1);
+    lightAmbientUniform = new osg::Uniform(osg::Uniform::FLOAT_VEC4, "lightAmbient", 1);
+    lightDiffuseUniform = new osg::Uniform(osg::Uniform::FLOAT_VEC4, "lightDiffuse", 1);
+    lightSpecularUniform = new osg::Uniform(osg::Uniform::FLOAT_VEC4, "lightSpecular", 1);
+    lightSpotDirUniform = new osg::Uniform(osg::Uniform::FLOAT_VEC3, "lightSpotDir", 1);
+    lightIsSpotUniform = new osg::Uniform(osg::Uniform::INT, "lightIsSpot", 1);
+    lightIsDirectionalUniform = new osg::Uniform(osg::Uniform::INT, "lightIsDirectional", 1);
+    lightConstantAttUniform = new osg::Uniform(osg::Uniform::FLOAT, "lightConstantAtt", 1);
+    lightLinearAttUniform = new osg::Uniform(osg::Uniform::FLOAT, "lightLinearAtt", 1);
+    lightQuadraticAttUniform = new osg::Uniform(osg::Uniform::FLOAT, "lightQuadraticAtt", 1);
+    lightIsSetUniform = new osg::Uniform(osg::Uniform::INT, "lightIsSet", 1);
+    lightCosCutoffUniform = new osg::Uniform(osg::Uniform::FLOAT, "lightCosCutoff", 1);
+    lightSpotExponentUniform = new osg::Uniform(osg::Uniform::FLOAT, "lightSpotExponent", 1);
+    numLightsUniform = new osg::Uniform("numLights", 1);
+    setCapacity(1);
+  }
+
+  void LightBuffer::addToStateSet(osg::StateSet *state) {
+    state->addUniform(lightPosUniform.get());
+    state->addUniform(lightAmbientUniform.get());
+    state->addUniform(lightDiffuseUniform.get());
+    state->addUniform(lightSpecularUniform.get());
+    state->addUniform(lightSpotDirUniform.get());
+    state->addUniform(lightIsSpotUniform.get());
+    state->addUniform(lightIsDirectionalUniform.get());
+    state->addUniform(lightConstantAttUniform.get());
+    state->addUniform(lightLinearAttUniform.get());
+    state->addUniform(lightQuadraticAttUniform.get());
+    state->addUniform(lightIsSetUniform.get());
+    state->addUniform(lightCosCutoffUniform.get());
+    state->addUniform(lightSpotExponentUniform.get());
+    state->addUniform(numLightsUniform.get());
+  }
+
+  void LightBuffer::setCapacity(int n) {
+    if(n < 1) n = 1;
+    if(n == capacity) return;
+    capacity = n;
+    lightPosUniform->setNumElements(n);
+    lightAmbientUniform->setNumElements(n);
+    lightDiffuseUniform->setNumElements(n);
+    lightSpecularUniform->setNumElements(n);
+    lightSpotDirUniform->setNumElements(n);
+    lightIsSpotUniform->setNumElements(n);
+    lightIsDirectionalUniform->setNumElements(n);
+    lightConstantAttUniform->setNumElements(n);
+    lightLinearAttUniform->setNumElements(n);
+    lightQuadraticAttUniform->setNumElements(n);
+    lightIsSetUniform->setNumElements(n);
+    lightCosCutoffUniform->setNumElements(n);
+    lightSpotExponentUniform->setNumElements(n);
+    numLightsUniform->set(n);
+    // the element values are undefined after resizing, force a rewrite
+    slots.clear();
+    numLights = 0;
+    for(int i=0; i<capacity; ++i) {
+      lightIsSetUniform->setElement(i, 0);
+    }
+  }
+
+  void LightBuffer::fillSlot(const LightData &light, LightSlot *slot) {
+    slot->pos = osg::Vec3f(light.pos.x(), light.pos.y(), light.pos.z());
+    slot->ambient = osg::Vec4f(light.ambient.r, light.ambient.g,
+                               light.ambient.b, light.ambient.a);
+    slot->diffuse = osg::Vec4f(light.diffuse.r, light.diffuse.g,
+                               light.diffuse.b, light.diffuse.a);
+    slot->specular = osg::Vec4f(light.specular.r, light.specular.g,
+                                light.specular.b, light.specular.a);
+    slot->isSpot = light.type-1;
+    slot->spotDir = osg::Vec3f(light.lookAt.x(), light.lookAt.y(),
+                               light.lookAt.z());
+    slot->isDirectional = light.directional;
+    slot->constantAtt = (float)light.constantAttenuation;
+    slot->linearAtt = (float)light.linearAttenuation;
+    slot->quadraticAtt = (float)light.quadraticAttenuation;
+    slot->cosCutoff = (float)cos(light.angle*0.017453292519943);
+    slot->spotExponent = (float)light.exponent;
+
+    // distance at which the attenuated light falls below 1/256 of the
+    // brightest color channel
+    slot->range = -1.0f;
+    if(!light.directional) {
+      float c = 0.0f;
+      for(int k=0; k<3; ++k) {
+        if(slot->diffuse[k] > c) c = slot->diffuse[k];
+        if(slot->specular[k] > c) c = slot->specular[k];
+      }
+      const float limit = 256.0f*c - slot->constantAtt;
+      const float q = slot->quadraticAtt, l = slot->linearAtt;
+      if(limit <= 0.0f) {
+        slot->range = 0.0f;
+      }
+      else if(q > 0.0f) {
+        slot->range = (-l + sqrtf(l*l + 4.0f*q*limit)) / (2.0f*q);
+      }
+      else if(l > 0.0f) {
+        slot->range = limit / l;
+      }
+    }
+  }
+
+  void LightBuffer::writeSlot(int i, const LightSlot &slot) {
+    lightPosUniform->setElement(i, slot.pos);
+    lightAmbientUniform->setElement(i, slot.ambient);
+    lightDiffuseUniform->setElement(i, slot.diffuse);
+    lightSpecularUniform->setElement(i, slot.specular);
+    lightIsSpotUniform->setElement(i, slot.isSpot);
+    lightSpotDirUniform->setElement(i, slot.spotDir);
+    lightIsDirectionalUniform->setElement(i, slot.isDirectional);
+    lightConstantAttUniform->setElement(i, slot.constantAtt);
+    lightLinearAttUniform->setElement(i, slot.linearAtt);
+    lightQuadraticAttUniform->setElement(i, slot.quadraticAtt);
+    lightCosCutoffUniform->setElement(i, slot.cosCutoff);
+    lightSpotExponentUniform->setElement(i, slot.spotExponent);
+  }
+
+  bool LightBuffer::update(const std::vector<LightData*> &lightList) {
+    bool influenceChanged = false;
+    int n = (int)lightList.size();
+    if(n > capacity) n = capacity;
+    if((int)slots.size() < n) slots.resize(n);
+    for(int i=0; i<n; ++i) {
+      LightSlot slot;
+      fillSlot(*(lightList[i]), &slot);
+      LightSlot &old = slots[i];
+      if(i >= numLights) {
+        writeSlot(i, slot);
+        lightIsSetUniform->setElement(i, 1);
+        influenceChanged = true;
+      }
+      else if(slot.pos != old.pos || slot.range != old.range) {
+        writeSlot(i, slot);
+        influenceChanged = true;
+      }
+      else if(slot.ambient != old.ambient || slot.diffuse != old.diffuse ||
+              slot.specular != old.specular || slot.spotDir != old.spotDir ||
+              slot.isSpot != old.isSpot ||
+              slot.isDirectional != old.isDirectional ||
+              slot.constantAtt != old.constantAtt ||
+              slot.linearAtt != old.linearAtt ||
+              slot.quadraticAtt != old.quadraticAtt ||
+              slot.cosCutoff != old.cosCutoff ||
+              slot.spotExponent != old.spotExponent) {
+        writeSlot(i, slot);
+      }
+      old = slot;
+    }
+    for(int i=n; i<numLights; ++i) {
+      lightIsSetUniform->setElement(i, 0);
+      influenceChanged = true;
+    }
+    numLights = n;
+    return influenceChanged;
+  }
+
+  bool LightBuffer::isLightAffecting(int i, const osg::BoundingSphere &bound) const {
+    if(i >= numLights) return false;
+    const LightSlot &slot = slots[i];
+    if(slot.range < 0.0f || !bound.valid()) return true;
+    const float d = slot.range + bound.radius();
+    return (bound.center() - slot.pos).length2() <= d*d;
+  }
+
+  void LightBuffer::getNearestLights(const osg::BoundingSphere &bound, int n,
+                                     std::vector<int> *mask) const {
+    mask->assign(capacity, 0);
+    std::vector<std::pair<float, int> > lights;
+    lights.reserve(numLights);
+    for(int i=0; i<numLights; ++i) {
+      if(!isLightAffecting(i, bound)) continue;
+      float d = 0.0f;
+      if(!slots[i].isDirectional) d = (bound.center() - slots[i].pos).length2();
+      lights.push_back(std::make_pair(d, i));
+    }
+    if(n < 0) n = 0;
+    if((int)lights.size() > n) {
+      std::nth_element(lights.begin(), lights.begin()+n, lights.end());
+      lights.resize(n);
+    }
+    for(size_t k=0; k<lights.size(); ++k) {
+      (*mask)[lights[k].second] = 1;
+    }
+  }
+
+} // end of namespace osg_material_manager
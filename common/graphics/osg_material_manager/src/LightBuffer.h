@@ -0,0 +1,102 @@
+/*
+ *  Copyright 2017, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef LIGHT_BUFFER_H
+#define LIGHT_BUFFER_H
+
+#ifdef _PRINT_HEADER_
+  #warning "LightBuffer.h"
+#endif
+
+#include <mars/interfaces/LightData.h>
+
+#include <vector>
+
+#include <osg/BoundingSphere>
+#include <osg/StateSet>
+#include <osg/Uniform>
+
+namespace osg_material_manager {
+
+  /**
+   * The light uniforms of the scene. The buffer is added once to the
+   * main state group and is inherited by all materials. An element is
+   * only rewritten if the corresponding light changed, thus static
+   * lights do not cause any uniform updates.
+   *
+   * Every light also gets an influence radius derived from its
+   * attenuation. A MaterialNode switches on only its nearest lights that
+   * reach its bounding sphere via its own "lightIsSet" index mask.
+   */
+  class LightBuffer {
+  public:
+    LightBuffer();
+
+    void addToStateSet(osg::StateSet *state);
+    void setCapacity(int n);
+    int getCapacity() const {return capacity;}
+    int getNumLights() const {return numLights;}
+
+    /**
+     * Copies the first getCapacity() lights into the uniforms.
+     * \return true if the position or the influence radius of a light
+     *         changed, i.e. the light masks of the nodes have to be
+     *         checked again
+     */
+    bool update(const std::vector<mars::interfaces::LightData*> &lightList);
+
+    bool isLightAffecting(int i, const osg::BoundingSphere &bound) const;
+
+    /**
+     * Sets the mask to 1 for the n nearest lights that reach the bound,
+     * directional lights come first. The mask gets getCapacity() entries.
+     */
+    void getNearestLights(const osg::BoundingSphere &bound, int n,
+                          std::vector<int> *mask) const;
+
+  private:
+    struct LightSlot {
+      osg::Vec3f pos, spotDir;
+      osg::Vec4f ambient, diffuse, specular;
+      int isSpot, isDirectional;
+      float constantAtt, linearAtt, quadraticAtt;
+      float cosCutoff, spotExponent;
+      // negative if the light has no limited range
+      float range;
+    };
+
+    osg::ref_ptr<osg::Uniform> lightPosUniform, lightAmbientUniform, lightDiffuseUniform;
+    osg::ref_ptr<osg::Uniform> lightSpecularUniform, lightIsSpotUniform;
+    osg::ref_ptr<osg::Uniform> lightSpotDirUniform, lightIsDirectionalUniform;
+    osg::ref_ptr<osg::Uniform> lightConstantAttUniform, lightLinearAttUniform, lightQuadraticAttUniform;
+    osg::ref_ptr<osg::Uniform> lightIsSetUniform, lightCosCutoffUniform, lightSpotExponentUniform;
+    osg::ref_ptr<osg::Uniform> numLightsUniform;
+
+    std::vector<LightSlot> slots;
+    int capacity, numLights;
+
+    static void fillSlot(const mars::interfaces::LightData &light,
+                         LightSlot *slot);
+    void writeSlot(int i, const LightSlot &slot);
+  }; // end of class LightBuffer
+
+} // end of namespace osg_material_manager
+
+#endif /* LIGHT_BUFFER_H */
@@ -47,6 +47,7 @@ namespace osg_material_manager {
       useFog(true),
       useNoise(true),
       getLight(true),
+      lightMaskDirty(true),
       drawLineLaser(false),
       shadow(true),
       maxNumLights(1),
@@ -75,42 +76,24 @@ namespace osg_material_manager {
     lineLaserDirection = new osg::Uniform("lineLaserDirection", osg::Vec3f(0.0f, 0.0f, 1.0f));
     lineLaserOpeningAngle = new osg::Uniform("lineLaserOpeningAngle", (float)M_PI * 2.0f);
 
-    lightPosUniform = new osg::Uniform(osg::Uniform::FLOAT_VEC3, "lightPos", maxNumLights);
-    lightAmbientUniform = new osg::Uniform(osg::Uniform::FLOAT_VEC4, "lightAmbient", maxNumLights);
-    lightDiffuseUniform = new osg::Uniform(osg::Uniform::FLOAT_VEC4, "lightDiffuse", maxNumLights);
-    lightSpecularUniform = new osg::Uniform(osg::Uniform::FLOAT_VEC4, "lightSpecular", maxNumLights);
-    lightSpotDirUniform = new osg::Uniform(osg::Uniform::FLOAT_VEC3, "lightSpotDir", maxNumLights);
-    lightIsSpotUniform = new osg::Uniform(osg::Uniform::INT, "lightIsSpot", maxNumLights);
-    lightIsDirectionalUniform = new osg::Uniform(osg::Uniform::INT, "lightIsDirectional", maxNumLights);
-    lightConstantAttUniform = new osg::Uniform(osg::Uniform::FLOAT, "lightConstantAtt", maxNumLights);
-    lightLinearAttUniform = new osg::Uniform(osg::Uniform::FLOAT, "lightLinearAtt", maxNumLights);
-    lightQuadraticAttUniform = new osg::Uniform(osg::Uniform::FLOAT, "lightQuadraticAtt", maxNumLights);
+    // the light data is shared by the whole scene (LightBuffer), a node
+    // only masks out the lights that don't reach it
     lightIsSetUniform = new osg::Uniform(osg::Uniform::INT, "lightIsSet", maxNumLights);
-    lightCosCutoffUniform = new osg::Uniform(osg::Uniform::FLOAT, "lightCosCutoff", maxNumLights);
-    lightSpotExponentUniform = new osg::Uniform(osg::Uniform::FLOAT, "lightSpotExponent", maxNumLights);
+    for(int i=0; i<maxNumLights; ++i) {
+      lightIsSetUniform->setElement(i, 0);
+    }
+    lightMask.assign(maxNumLights, 0);
+    lightMaskDirty = true;
     useFogUniform = new osg::Uniform("useFog", 1);
     useNoiseUniform = new osg::Uniform("useNoise", 1);
     noiseAmmountUniform = new osg::Uniform("noiseAmmount", 1.0f);
     useShadowUniform = new osg::Uniform("useShadow", 1);
-    numLightsUniform = new osg::Uniform("numLights", maxNumLights);
     drawLineLaserUniform = new osg::Uniform("drawLineLaser", 0);
 
     osg::StateSet *state = getOrCreateStateSet();
     state->addUniform(brightnessUniform.get());
     state->addUniform(transparencyUniform.get());
-    state->addUniform(lightPosUniform.get());
-    state->addUniform(lightAmbientUniform.get());
-    state->addUniform(lightDiffuseUniform.get());
-    state->addUniform(lightSpecularUniform.get());
-    state->addUniform(lightSpotDirUniform.get());
-    state->addUniform(lightIsSpotUniform.get());
-    state->addUniform(lightIsDirectionalUniform.get());
-    state->addUniform(lightConstantAttUniform.get());
-    state->addUniform(lightLinearAttUniform.get());
-    state->addUniform(lightQuadraticAttUniform.get());
     state->addUniform(lightIsSetUniform.get());
-    state->addUniform(lightCosCutoffUniform.get());
-    state->addUniform(lightSpotExponentUniform.get());
 
     state->addUniform(lineLaserPosUniform.get());
     state->addUniform(lineLaserNormalUniform.get());
@@ -121,7 +104,6 @@ namespace osg_material_manager {
     state->addUniform(useNoiseUniform.get());
     state->addUniform(noiseAmmountUniform.get());
     state->addUniform(useShadowUniform.get());
-    state->addUniform(numLightsUniform.get());
     state->addUniform(drawLineLaserUniform.get());
 
     isCreated = true;
@@ -247,66 +229,30 @@ namespace osg_material_manager {
     lineLaserOpeningAngle->set( openingAngle);
   }
 
-  void MaterialNode::updateLights(std::vector<mars::interfaces::LightData*> &lightList) {
+  void MaterialNode::setMaxNumLights(int n) {
+    maxNumLights = n;
     if(!isCreated) return;
-    std::vector<mars::interfaces::LightData*>::iterator it;
-    std::list<mars::interfaces::LightData*> lightList_;
-    std::list<mars::interfaces::LightData*>::iterator it2;
-    double dist1, dist2;
-    Vector position_;
-    getNodePosition(&position_);
-    for(it=lightList.begin(); it!=lightList.end(); ++it) {
-      dist1 = Vector((*it)->pos - position_).norm();
-      for(it2=lightList_.begin(); it2!=lightList_.end(); ++it2) {
-        dist2 = Vector((*it2)->pos - position_).norm();
-        if(dist1 < dist2) {
-          lightList_.insert(it2, *it);
-          break;
-        }
-      }
-      if(it2 == lightList_.end()) {
-        lightList_.push_back(*it);
+    lightIsSetUniform->setNumElements(n);
+    lightMask.assign(n, -1);
+    lightMaskDirty = true;
+  }
+
+  void MaterialNode::updateLightMask(const LightBuffer &lights, int maxLights,
+                                     bool force) {
+    if(!isCreated) return;
+    const osg::BoundingSphere &bound = getBound();
+    if(!force && !lightMaskDirty && bound == lastBound) return;
+    lastBound = bound;
+    lightMaskDirty = false;
+    std::vector<int> nearest;
+    lights.getNearestLights(bound, maxLights, &nearest);
+    for(int i=0; i<maxNumLights; ++i) {
+      int v = i < (int)nearest.size() ? nearest[i] : 0;
+      if(lightMask[i] != v) {
+        lightMask[i] = v;
+        lightIsSetUniform->setElement(i, v);
       }
     }
-    int i=0;
-    for(it2=lightList_.begin(); it2!=lightList_.end() && i<maxNumLights; ++it2, ++i) {
-      /*      
-        fprintf(stderr, "set light: %d\n", i);
-        fprintf(stderr, "  pos: %g %g %g\n", (*it2)->pos.x(), (*it2)->pos.y(), (*it2)->pos.z());
-        fprintf(stderr, "  ambient: %g %g %g %g\n", (*it2)->ambient.r, (*it2)->ambient.g,
-        (*it2)->ambient.b, (*it2)->ambient.a);
-        fprintf(stderr, "  diffuse: %g %g %g %g\n", (*it2)->diffuse.r, (*it2)->diffuse.g,
-        (*it2)->diffuse.b, (*it2)->diffuse.a);
-      */      
-      lightPosUniform->setElement(i, osg::Vec3f((*it2)->pos.x(),
-                                                (*it2)->pos.y(),
-                                                (*it2)->pos.z()));
-      lightAmbientUniform->setElement(i, osg::Vec4f((*it2)->ambient.r,
-                                                    (*it2)->ambient.g,
-                                                    (*it2)->ambient.b,
-                                                    (*it2)->ambient.a));
-      lightDiffuseUniform->setElement(i, osg::Vec4f((*it2)->diffuse.r,
-                                                    (*it2)->diffuse.g,
-                                                    (*it2)->diffuse.b,
-                                                    (*it2)->diffuse.a));
-      lightSpecularUniform->setElement(i, osg::Vec4f((*it2)->specular.r,
-                                                     (*it2)->specular.g,
-                                                     (*it2)->specular.b,
-                                                     (*it2)->specular.a));
-      lightIsSpotUniform->setElement(i, (*it2)->type-1);
-      Vector v = (*it2)->lookAt;// - (*it2)->pos;
-      lightSpotDirUniform->setElement(i, osg::Vec3f(v.x(), v.y(), v.z()));
-      lightIsDirectionalUniform->setElement(i, (*it2)->directional);
-      lightConstantAttUniform->setElement(i, (float)(*it2)->constantAttenuation);
-      lightLinearAttUniform->setElement(i, (float)(*it2)->linearAttenuation);
-      lightQuadraticAttUniform->setElement(i, (float)(*it2)->quadraticAttenuation);
-      lightIsSetUniform->setElement(i, 1);
-      lightCosCutoffUniform->setElement(i, (float)cos((*it2)->angle*0.017453292519943));
-      lightSpotExponentUniform->setElement(i, (float)(*it2)->exponent);
-    }
-    for(; i<maxNumLights; ++i) {
-      lightIsSetUniform->setElement(i, 0);
-    }
   }
 
   void MaterialNode::generateTangents() {
@@ -33,7 +33,7 @@
 #endif
 
 #include <mars/utils/Vector.h>
-#include <mars/interfaces/LightData.h>
+#include "LightBuffer.h"
 
 #include <vector>
 
@@ -83,7 +83,13 @@ namespace osg_material_manager {
     // can be used for dynamic textures
     virtual void setBlending(bool mode);
 
-    void updateLights(std::vector<mars::interfaces::LightData*> &lightList);
+    /**
+     * Switches on the maxLights nearest lights of the scene that reach the
+     * bounding sphere of the node. The check is skipped if neither the
+     * node nor the lights moved, unless force is set.
+     */
+    void updateLightMask(const LightBuffer &lights, int maxLights,
+                         bool force);
 
     void getNodePosition(mars::utils::Vector *pos);
     bool addChild(osg::Node *child);
@@ -109,7 +115,7 @@ namespace osg_material_manager {
                                   mars::utils::Vector LaserAngle,
                                   float openingAngle);
 
-    void setMaxNumLights(int n) {maxNumLights = n;}
+    void setMaxNumLights(int n);
     void seperateMaterial();
     void setTransparency(float t);
     void enableInstancing();
@@ -122,11 +128,10 @@ namespace osg_material_manager {
     bool isCreated;
     bool useFog, useNoise;
     bool getLight;
-    osg::ref_ptr<osg::Uniform> lightPosUniform, lightAmbientUniform, lightDiffuseUniform;
-    osg::ref_ptr<osg::Uniform> lightSpecularUniform, lightIsSpotUniform;
-    osg::ref_ptr<osg::Uniform> lightSpotDirUniform, lightIsDirectionalUniform;
-    osg::ref_ptr<osg::Uniform> lightConstantAttUniform, lightLinearAttUniform, lightQuadraticAttUniform;
-    osg::ref_ptr<osg::Uniform> lightIsSetUniform, lightCosCutoffUniform, lightSpotExponentUniform;
+    osg::ref_ptr<osg::Uniform> lightIsSetUniform;
+    std::vector<int> lightMask;
+    osg::BoundingSphere lastBound;
+    bool lightMaskDirty;
 
 
     osg::ref_ptr<OsgMaterial> material;
@@ -140,7 +145,6 @@ namespace osg_material_manager {
     osg::ref_ptr<osg::Uniform> lineLaserOpeningAngle;
     osg::ref_ptr<osg::Uniform> useFogUniform, useNoiseUniform, noiseAmmountUniform;
     osg::ref_ptr<osg::Uniform> useShadowUniform;
-    osg::ref_ptr<osg::Uniform> numLightsUniform;
     osg::ref_ptr<osg::Uniform> drawLineLaserUniform;
     osg::ref_ptr<osg::StateSet> materialState;
     osg::ref_ptr<osg::Depth> depth;
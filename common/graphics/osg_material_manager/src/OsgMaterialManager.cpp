@@ -36,13 +36,14 @@
 
 #include "OsgMaterialManager.h"
 #include "MaterialNode.h"
+#include "TextureManager.h"
 #include <osgDB/ReadFile>
 #include <osgDB/WriteFile>
+#include <osgDB/Registry>
+#include <osgDB/FileNameUtils>
 
 namespace osg_material_manager {
 
-  std::vector<OsgMaterialManager::textureFileStruct> OsgMaterialManager::textureFiles;
-  std::vector<OsgMaterialManager::imageFileStruct> OsgMaterialManager::imageFiles;
   std::map<std::string,osg::ref_ptr<osg::TextureCubeMap>> OsgMaterialManager::cubemaps;
 
   OsgMaterialManager::OsgMaterialManager(const std::string &resourcesPath) : lib_manager::LibInterface(NULL) {
@@ -63,12 +64,34 @@ namespace osg_material_manager {
       cfg = libManager->getLibraryAs<mars::cfg_manager::CFGManagerInterface>("cfg_manager", true);
     }
     shadowSamples.iValue = 1;
+    maxSceneLights.iValue = 8;
     if(cfg) {
       resPath = cfg->getOrCreateProperty("Preferences", "resources_path",
                                          resPath.sValue, this);
       shadowSamples = cfg->getOrCreateProperty("Graphics",
                                                "shadowSamples",
                                                shadowSamples.iValue, this);
+      maxSceneLights = cfg->getOrCreateProperty("Graphics", "maxSceneLights",
+                                                maxSceneLights.iValue, this);
+      // an empty cache path disables the mipmap cache, the budget is
+      // given in MB and 0 disables it
+      TextureManager *textures = TextureManager::instance();
+      asyncTextureLoading = cfg->getOrCreateProperty("Graphics",
+                                                     "asyncTextureLoading",
+                                                     true, this);
+      textureCachePath = cfg->getOrCreateProperty("Graphics", "textureCachePath",
+                                                  textures->getCachePath(),
+                                                  this);
+      textureCompression = cfg->getOrCreateProperty("Graphics",
+                                                    "textureCompression",
+                                                    true, this);
+      textureMemoryBudget = cfg->getOrCreateProperty("Graphics",
+                                                     "textureMemoryBudget",
+                                                     0, this);
+      textures->setAsyncLoading(asyncTextureLoading.bValue);
+      textures->setCachePath(textureCachePath.sValue);
+      textures->setCompression(textureCompression.bValue);
+      textures->setMemoryBudget((size_t)textureMemoryBudget.iValue*1024*1024);
     }
     noiseImage = new osg::Image();
     noiseImage->allocateImage(128, 128, 4, GL_RGBA, GL_UNSIGNED_BYTE);
@@ -81,6 +104,10 @@ namespace osg_material_manager {
     drawLineLaser = false;
     useShadow = true;
     defaultMaxNumNodeLights = 1;
+    lightBuffer.setCapacity(defaultMaxNumNodeLights);
+    lightBufferLimit = maxSceneLights.iValue;
+    lightMasksDirty = true;
+    lightBuffer.addToStateSet(mainStateGroup->getOrCreateStateSet());
     brightness = 1.0;
     noiseAmmount = 0.05;
   }
@@ -127,44 +154,11 @@ namespace osg_material_manager {
   }
 
   osg::ref_ptr<osg::Texture2D> OsgMaterialManager::loadTexture(std::string filename) {
-    std::vector<OsgMaterialManager::textureFileStruct>::iterator iter;
-
-    for (iter = textureFiles.begin();
-         iter != textureFiles.end(); iter++) {
-      if ((*iter).fileName == filename) {
-        return (*iter).texture;
-      }
-    }
-    OsgMaterialManager::textureFileStruct newTextureFile;
-    newTextureFile.fileName = filename;
-    newTextureFile.texture = new osg::Texture2D;
-    newTextureFile.texture->setDataVariance(osg::Object::DYNAMIC);
-    newTextureFile.texture->setWrap(osg::Texture::WRAP_S, osg::Texture::REPEAT);
-    newTextureFile.texture->setWrap(osg::Texture::WRAP_T, osg::Texture::REPEAT);
-    newTextureFile.texture->setWrap(osg::Texture::WRAP_R, osg::Texture::REPEAT);
-    osg::Image* textureImage = loadImage(filename);
-    newTextureFile.texture->setImage(textureImage);
-    textureFiles.push_back(newTextureFile);
-
-    return newTextureFile.texture;
+    return TextureManager::instance()->loadTexture(filename);
   }
 
   osg::ref_ptr<osg::Image> OsgMaterialManager::loadImage(std::string filename) {
-    std::vector<OsgMaterialManager::imageFileStruct>::iterator iter;
-
-    for (iter = imageFiles.begin();
-         iter != imageFiles.end(); iter++) {
-      if ((*iter).fileName == filename) {
-        return (*iter).image;
-      }
-    }
-    OsgMaterialManager::imageFileStruct newImageFile;
-    newImageFile.fileName = filename;
-    osg::Image* image = osgDB::readImageFile(filename);
-    newImageFile.image = image;
-    imageFiles.push_back(newImageFile);
-
-    return newImageFile.image;
+    return TextureManager::instance()->loadImage(filename);
   }
 
   void OsgMaterialManager::updateShadowSamples() {
@@ -210,6 +204,31 @@ namespace osg_material_manager {
       resPath.sValue = _property.sValue;
       return;
     }
+    if(_property.paramId == maxSceneLights.paramId) {
+      // the light buffer is rebuilt with the next updateLights()
+      maxSceneLights.iValue = _property.iValue;
+      return;
+    }
+    if(_property.paramId == asyncTextureLoading.paramId) {
+      asyncTextureLoading.bValue = _property.bValue;
+      TextureManager::instance()->setAsyncLoading(_property.bValue);
+      return;
+    }
+    if(_property.paramId == textureCachePath.paramId) {
+      textureCachePath.sValue = _property.sValue;
+      TextureManager::instance()->setCachePath(_property.sValue);
+      return;
+    }
+    if(_property.paramId == textureCompression.paramId) {
+      textureCompression.bValue = _property.bValue;
+      TextureManager::instance()->setCompression(_property.bValue);
+      return;
+    }
+    if(_property.paramId == textureMemoryBudget.paramId) {
+      textureMemoryBudget.iValue = _property.iValue;
+      TextureManager::instance()->setMemoryBudget((size_t)_property.iValue*1024*1024);
+      return;
+    }
   }
 
   void OsgMaterialManager::setShadowSamples(int v) {
@@ -226,7 +245,7 @@ namespace osg_material_manager {
     it = materialMap.find(name);
     if(it == materialMap.end()) {
       OsgMaterial *m = new OsgMaterial(resPath.sValue+"/mars/osg_material_manager/resources");
-      m->setMaxNumLights(defaultMaxNumNodeLights);
+      m->setMaxNumLights(lightBuffer.getCapacity());
       m->setShadowTextureSize(shadowTextureSize);
       m->setMaterial(map);
       m->setUseShader(useShader);
@@ -261,7 +280,7 @@ namespace osg_material_manager {
     it = materialMap.find(name);
     if(it != materialMap.end()) {
       MaterialNode *n = new MaterialNode();
-      n->setMaxNumLights(defaultMaxNumNodeLights);
+      n->setMaxNumLights(lightBuffer.getCapacity());
       n->createNodeState();
       n->setUseFog(useFog);
       n->setUseNoise(useNoise);
@@ -284,11 +303,37 @@ namespace osg_material_manager {
     // todo
   }
 
+  /**
+   * The light data is written once into the shared light buffer. Every
+   * material node switches on its "Graphics/defaultMaxNumNodeLights"
+   * nearest lights of the buffer and only updates this mask if it or a
+   * light moved. If the scene has more lights than the buffer can hold,
+   * the buffer grows up to the "Graphics/maxSceneLights" limit, a changed
+   * limit rebuilds it. This recompiles the shaders once but never happens
+   * while the number of lights and the limit are stable.
+   */
   void OsgMaterialManager::updateLights(std::vector<mars::interfaces::LightData*> &lightList) {
+    bool forceMask = lightMasksDirty;
+    lightMasksDirty = false;
+    int limit = maxSceneLights.iValue;
+    int n = (int)lightList.size();
+    if(n > limit) n = limit;
+    if(n < 1) n = 1;
+    if(limit != lightBufferLimit) {
+      lightBufferLimit = limit;
+      if(n != lightBuffer.getCapacity()) setNumLights(n);
+      forceMask = true;
+    }
+    else if(n > lightBuffer.getCapacity()) {
+      setNumLights(n);
+      forceMask = true;
+    }
+    if(lightBuffer.update(lightList)) forceMask = true;
+
     {
       std::vector<osg::ref_ptr<MaterialNode> >::iterator it = materialNodes.begin();
       for(; it!=materialNodes.end(); ++it) {
-        (*it)->updateLights(lightList);
+        (*it)->updateLightMask(lightBuffer, defaultMaxNumNodeLights, forceMask);
       }
     }
 
@@ -300,6 +345,19 @@ namespace osg_material_manager {
     }
   }
 
+  void OsgMaterialManager::setNumLights(int n) {
+    lightBuffer.setCapacity(n);
+    n = lightBuffer.getCapacity();
+    std::map<std::string, osg::ref_ptr<OsgMaterial> >::iterator it = materialMap.begin();
+    for(; it!=materialMap.end(); ++it) {
+      it->second->setMaxNumLights(n);
+    }
+    std::vector<osg::ref_ptr<MaterialNode> >::iterator nIt = materialNodes.begin();
+    for(; nIt!=materialNodes.end(); ++nIt) {
+      (*nIt)->setMaxNumLights(n);
+    }
+  }
+
   void OsgMaterialManager::setUseShader(bool v) {
     fprintf(stderr, "set use shader: %d %d\n", useShader, v);
     useShader = v;
@@ -327,6 +385,7 @@ namespace osg_material_manager {
 
   void OsgMaterialManager::setDefaultMaxNumLights(int v) {
     defaultMaxNumNodeLights = v;
+    lightMasksDirty = true;
   }
 
   void OsgMaterialManager::setUseFog(bool v) {
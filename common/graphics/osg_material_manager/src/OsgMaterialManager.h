@@ -32,6 +32,7 @@
 #endif
 
 #include "OsgMaterial.h"
+#include "LightBuffer.h"
 
 #include <lib_manager/LibInterface.hpp>
 #include <mars/cfg_manager/CFGManagerInterface.h>
@@ -43,16 +44,6 @@ namespace osg_material_manager {
   class OsgMaterialManager : public lib_manager::LibInterface,
                              public mars::cfg_manager::CFGClient {
 
-    struct textureFileStruct {
-      std::string fileName;
-      osg::ref_ptr<osg::Texture2D> texture;
-    }; // end of struct textureFileStruct
-
-    struct imageFileStruct {
-      std::string fileName;
-      osg::ref_ptr<osg::Image> image;
-    }; // end of struct imageFileStruct
-
   public:
     OsgMaterialManager(lib_manager::LibManager *theManager);
     OsgMaterialManager(const std::string &resourcesPath);
@@ -100,6 +91,7 @@ namespace osg_material_manager {
                                   mars::utils::Vector laserAngle,
                                   float openingAngle);
     void updateShadowSamples();
+    void setNumLights(int n);
 
     static osg::ref_ptr<osg::TextureCubeMap> loadCubemap(configmaps::ConfigMap &info, std::string loadPath="");
     static osg::ref_ptr<osg::Texture2D> loadTexture(std::string filename);
@@ -109,9 +101,16 @@ namespace osg_material_manager {
     mars::cfg_manager::CFGManagerInterface *cfg;
     osg::ref_ptr<osg::Group> mainStateGroup;
     osg::ref_ptr<osg::Image> noiseImage;
-    mars::cfg_manager::cfgPropertyStruct resPath, shadowSamples;
+    mars::cfg_manager::cfgPropertyStruct resPath, shadowSamples, maxSceneLights;
+    mars::cfg_manager::cfgPropertyStruct asyncTextureLoading, textureCachePath;
+    mars::cfg_manager::cfgPropertyStruct textureCompression, textureMemoryBudget;
     std::map<std::string, osg::ref_ptr<OsgMaterial> > materialMap;
     std::vector<osg::ref_ptr<MaterialNode> > materialNodes;
+    // light uniforms shared by all materials via the mainStateGroup
+    LightBuffer lightBuffer;
+    // the maxSceneLights value the buffer was built for
+    int lightBufferLimit;
+    bool lightMasksDirty;
 
     // most properties are currently global settings
     // global OsgMaterial properties
@@ -122,8 +121,6 @@ namespace osg_material_manager {
     bool useFog, useNoise, drawLineLaser, useShadow;
     float brightness, noiseAmmount;
 
-    static std::vector<textureFileStruct> textureFiles;
-    static std::vector<imageFileStruct> imageFiles;
     static std::map<std::string,osg::ref_ptr<osg::TextureCubeMap>> cubemaps;
   };
 
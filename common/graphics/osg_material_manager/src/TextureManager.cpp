@@ -0,0 +1,493 @@
+/*
+ *  Copyright 2017, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "TextureManager.h"
+
+#include <osgDB/ReadFile>
+#include <osgDB/WriteFile>
+#include <osgDB/Registry>
+#include <osgDB/FileNameUtils>
+#include <osgDB/ImageProcessor>
+
+#include <mars/utils/MutexLocker.h>
+#include <mars/utils/ArchiveFileSystem.h>
+#include <mars/utils/misc.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+#include <stdint.h>
+
+namespace osg_material_manager {
+
+  using mars::utils::MutexLocker;
+
+  // smaller textures are not reduced any further
+  static const unsigned int minReducedSize = 64;
+
+  static bool compareLastUsed(const ManagedTexture::Usage *a,
+                              const ManagedTexture::Usage *b) {
+    return a->lastUsedFrame < b->lastUsedFrame;
+  }
+
+  static uint64_t hashContent(const std::string &content) {
+    // 64 bit FNV-1a
+    uint64_t hash = 14695981039346656037ULL;
+    for(size_t i=0; i<content.size(); ++i) {
+      hash ^= (unsigned char)content[i];
+      hash *= 1099511628211ULL;
+    }
+    return hash;
+  }
+
+  /**
+   * Adds a box filtered mip chain to an uncompressed 8 bit image. The
+   * levels are stored without row padding.
+   */
+  static bool generateMipmaps(osg::Image *image) {
+    if(image->isMipmap() || image->isCompressed() || image->r() != 1 ||
+       image->getDataType() != GL_UNSIGNED_BYTE) {
+      return false;
+    }
+    const unsigned int c = image->getPixelSizeInBits()/8;
+    if(c < 1 || c > 4 || image->getPixelSizeInBits() % 8) return false;
+
+    size_t total = 0;
+    unsigned int w = image->s(), h = image->t();
+    while(true) {
+      total += (size_t)w*h*c;
+      if(w == 1 && h == 1) break;
+      w = std::max(1u, w/2);
+      h = std::max(1u, h/2);
+    }
+    unsigned char *data = new unsigned char[total];
+    w = image->s();
+    h = image->t();
+    for(unsigned int y=0; y<h; ++y) {
+      memcpy(data+(size_t)y*w*c, image->data(0, y), (size_t)w*c);
+    }
+
+    osg::Image::MipmapDataType offsets;
+    size_t offset = 0;
+    while(w > 1 || h > 1) {
+      const unsigned int nw = std::max(1u, w/2), nh = std::max(1u, h/2);
+      const size_t next = offset + (size_t)w*h*c;
+      const unsigned char *src = data+offset;
+      unsigned char *dst = data+next;
+      for(unsigned int y=0; y<nh; ++y) {
+        const unsigned char *row0 = src + (size_t)std::min(2*y, h-1)*w*c;
+        const unsigned char *row1 = src + (size_t)std::min(2*y+1, h-1)*w*c;
+        for(unsigned int x=0; x<nw; ++x) {
+          const unsigned int x0 = std::min(2*x, w-1)*c, x1 = std::min(2*x+1, w-1)*c;
+          for(unsigned int k=0; k<c; ++k) {
+            *dst++ = (row0[x0+k] + row0[x1+k] + row1[x0+k] + row1[x1+k] + 2) / 4;
+          }
+        }
+      }
+      offsets.push_back(next);
+      offset = next;
+      w = nw;
+      h = nh;
+    }
+    image->setImage(image->s(), image->t(), 1, image->getInternalTextureFormat(),
+                    image->getPixelFormat(), GL_UNSIGNED_BYTE, data,
+                    osg::Image::USE_NEW_DELETE, 1);
+    image->setMipmapLevels(offsets);
+    return true;
+  }
+
+  static bool createMipmaps(osg::Image *image, bool compress) {
+    osgDB::ImageProcessor *processor = NULL;
+    if(compress && image->getDataType() == GL_UNSIGNED_BYTE &&
+       (image->getPixelFormat() == GL_RGB ||
+        image->getPixelFormat() == GL_RGBA)) {
+      processor = osgDB::Registry::instance()->getImageProcessor();
+    }
+    if(!processor) return generateMipmaps(image);
+    processor->compress(*image, image->getPixelFormat() == GL_RGB ?
+                        osg::Texture::USE_S3TC_DXT1_COMPRESSION :
+                        osg::Texture::USE_S3TC_DXT5_COMPRESSION,
+                        true, true, osgDB::ImageProcessor::USE_CPU,
+                        osgDB::ImageProcessor::NORMAL);
+    return image->isMipmap();
+  }
+
+  static void getLevelSizes(const osg::Image *image,
+                            std::vector<unsigned int> *sizes) {
+    sizes->clear();
+    const unsigned int total = image->getTotalSizeInBytesIncludingMipmaps();
+    if(!image->isMipmap()) {
+      // the driver creates the mip levels
+      sizes->push_back(total + total/3);
+      return;
+    }
+    const unsigned int levels = image->getNumMipmapLevels();
+    for(unsigned int i=0; i<levels; ++i) {
+      unsigned int end = i+1 < levels ? image->getMipmapOffset(i+1) : total;
+      sizes->push_back(end - image->getMipmapOffset(i));
+    }
+  }
+
+  /** \brief creates an image that starts at mip level \a skip */
+  static osg::ref_ptr<osg::Image> reduceImage(osg::Image *image,
+                                              unsigned int skip) {
+    const unsigned int levels = image->getNumMipmapLevels();
+    if(!image->isMipmap() || skip == 0 || skip >= levels) return image;
+    const unsigned int base = image->getMipmapOffset(skip);
+    const unsigned int size = image->getTotalSizeInBytesIncludingMipmaps() - base;
+    unsigned char *data = new unsigned char[size];
+    memcpy(data, image->data()+base, size);
+    osg::Image::MipmapDataType offsets;
+    for(unsigned int i=skip+1; i<levels; ++i) {
+      offsets.push_back(image->getMipmapOffset(i) - base);
+    }
+    osg::ref_ptr<osg::Image> reduced = new osg::Image();
+    reduced->setImage(std::max(1, image->s() >> skip),
+                      std::max(1, image->t() >> skip), 1,
+                      image->getInternalTextureFormat(),
+                      image->getPixelFormat(), image->getDataType(), data,
+                      osg::Image::USE_NEW_DELETE, image->getPacking());
+    reduced->setMipmapLevels(offsets);
+    reduced->setOrigin(image->getOrigin());
+    return reduced;
+  }
+
+  static osg::Image* decodeImage(const std::string &filename,
+                                 const std::string &content) {
+    std::string ext = osgDB::getLowerCaseFileExtension(filename);
+    osgDB::ReaderWriter *rw;
+    rw = osgDB::Registry::instance()->getReaderWriterForExtension(ext);
+    if(rw) {
+      std::istringstream stream(content);
+      osgDB::ReaderWriter::ReadResult result = rw->readImage(stream);
+      if(result.success()) return result.takeImage();
+    }
+    return NULL;
+  }
+
+  size_t ManagedTexture::Usage::getBytes(unsigned int skip) const {
+    size_t bytes = 0;
+    for(size_t i=skip; i<levelSizes.size(); ++i) bytes += levelSizes[i];
+    return bytes;
+  }
+
+  unsigned int ManagedTexture::Usage::getMaxSkipLevels() const {
+    unsigned int skip = 0;
+    while(skip+1 < levelSizes.size() &&
+          std::min(width, height) >> (skip+1) >= minReducedSize) {
+      ++skip;
+    }
+    return skip;
+  }
+
+  ManagedTexture::ManagedTexture() {
+    usage.width = usage.height = 0;
+    usage.skipLevels = 0;
+    usage.loading = false;
+    usage.lastUsedFrame = 0;
+    setDataVariance(osg::Object::STATIC);
+    setUnRefImageDataAfterApply(true);
+  }
+
+  void ManagedTexture::apply(osg::State &state) const {
+    MutexLocker locker(&mutex);
+    if(loadedImage.valid()) {
+      const_cast<ManagedTexture*>(this)->setImage(loadedImage.get());
+      loadedImage = NULL;
+    }
+    if(state.getFrameStamp()) {
+      usage.lastUsedFrame = state.getFrameStamp()->getFrameNumber();
+    }
+    osg::Texture2D::apply(state);
+  }
+
+  void ManagedTexture::setLoading(unsigned int skipLevels) {
+    MutexLocker locker(&mutex);
+    usage.skipLevels = skipLevels;
+    usage.loading = true;
+  }
+
+  void ManagedTexture::setLoadedImage(osg::Image *image, unsigned int width,
+                                      unsigned int height,
+                                      const std::vector<unsigned int> &levelSizes) {
+    MutexLocker locker(&mutex);
+    loadedImage = image;
+    usage.width = width;
+    usage.height = height;
+    usage.levelSizes = levelSizes;
+    usage.loading = false;
+  }
+
+  ManagedTexture::Usage ManagedTexture::getUsage() const {
+    MutexLocker locker(&mutex);
+    return usage;
+  }
+
+  TextureManager* TextureManager::instance() {
+    static TextureManager manager;
+    return &manager;
+  }
+
+  TextureManager::TextureManager() : asyncLoading(true), compression(true),
+                                     stopLoading(false), memoryBudget(0) {
+    const char *tmp = getenv("TMPDIR");
+    cachePath = std::string(tmp ? tmp : "/tmp") + "/mars_texture_cache";
+  }
+
+  TextureManager::~TextureManager() {
+    mutex.lock();
+    stopLoading = true;
+    condition.wakeAll();
+    mutex.unlock();
+    if(isRunning()) wait();
+  }
+
+  osg::ref_ptr<osg::Texture2D> TextureManager::loadTexture(const std::string &filename) {
+    MutexLocker locker(&textureMutex);
+    std::unordered_map<std::string, osg::ref_ptr<ManagedTexture> >::iterator it;
+    it = textures.find(filename);
+    if(it != textures.end()) return it->second.get();
+
+    osg::ref_ptr<ManagedTexture> texture = new ManagedTexture();
+    texture->setName(filename);
+    texture->setWrap(osg::Texture::WRAP_S, osg::Texture::REPEAT);
+    texture->setWrap(osg::Texture::WRAP_T, osg::Texture::REPEAT);
+    texture->setWrap(osg::Texture::WRAP_R, osg::Texture::REPEAT);
+    textures[filename] = texture;
+    requestLoad(filename, texture.get(), 0);
+    return texture.get();
+  }
+
+  osg::ref_ptr<osg::Image> TextureManager::loadImage(const std::string &filename) {
+    MutexLocker locker(&textureMutex);
+    std::unordered_map<std::string, osg::ref_ptr<osg::Image> >::iterator it;
+    it = images.find(filename);
+    if(it != images.end()) return it->second;
+    osg::ref_ptr<osg::Image> image = readImage(filename);
+    images[filename] = image;
+    return image;
+  }
+
+  osg::Image* TextureManager::readImage(const std::string &filename) {
+    std::string content;
+    if(mars::utils::isArchivePath(filename) &&
+       mars::utils::readVirtualFile(filename, &content)) {
+      // decode the image directly from the archive data
+      osg::Image *image = decodeImage(filename, content);
+      if(image) return image;
+      return osgDB::readImageFile(mars::utils::getRealFilePath(filename, "",
+                                                                false));
+    }
+    return osgDB::readImageFile(filename);
+  }
+
+  void TextureManager::requestLoad(const std::string &filename,
+                                   ManagedTexture *texture,
+                                   unsigned int skipLevels) {
+    LoadJob job;
+    job.filename = filename;
+    job.texture = texture;
+    job.skipLevels = skipLevels;
+    texture->setLoading(skipLevels);
+
+    MutexLocker locker(&mutex);
+    if(!asyncLoading) {
+      std::string cache = cachePath;
+      bool compress = compression;
+      locker.unlock();
+      processJob(job, cache, compress);
+      return;
+    }
+    jobs.push_back(job);
+    if(!isRunning()) start();
+    condition.wakeAll();
+  }
+
+  void TextureManager::run() {
+    while(true) {
+      mutex.lock();
+      while(!stopLoading && jobs.empty()) {
+        condition.wait(&mutex);
+      }
+      if(stopLoading) {
+        mutex.unlock();
+        return;
+      }
+      LoadJob job = jobs.front();
+      jobs.pop_front();
+      std::string cache = cachePath;
+      bool compress = compression;
+      mutex.unlock();
+      processJob(job, cache, compress);
+    }
+  }
+
+  void TextureManager::processJob(const LoadJob &job, const std::string &cache,
+                                  bool compress) {
+    std::string content, cacheFile;
+    osg::ref_ptr<osg::Image> image;
+    // the cache files keep the data as it is, the origin is ignored
+    osg::ref_ptr<osgDB::Options> options = new osgDB::Options("ddsNoAutoFlipWrite");
+    if(mars::utils::readVirtualFile(job.filename, &content)) {
+      if(!cache.empty()) {
+        std::stringstream s;
+        s << cache << "/" << std::hex << std::setw(16) << std::setfill('0')
+          << hashContent(content) << (compress ? "_dxt" : "") << ".dds";
+        cacheFile = s.str();
+        if(mars::utils::pathExists(cacheFile)) {
+          image = osgDB::readImageFile(cacheFile, options.get());
+        }
+      }
+      if(!image.valid()) image = decodeImage(job.filename, content);
+    }
+    if(!image.valid()) {
+      // let osg search its data file paths
+      cacheFile.clear();
+      image = osgDB::readImageFile(job.filename);
+    }
+    if(!image.valid()) {
+      fprintf(stderr, "TextureManager: could not load texture: %s\n",
+              job.filename.c_str());
+      std::vector<unsigned int> levelSizes;
+      job.texture->setLoadedImage(NULL, 0, 0, levelSizes);
+      return;
+    }
+
+    if(!image->isMipmap() && createMipmaps(image.get(), compress) &&
+       !cacheFile.empty()) {
+      // write to a temporary file first, another instance may read the cache
+      std::string tmpFile = cacheFile.substr(0, cacheFile.size()-4) + ".tmp.dds";
+      mars::utils::createDirectory(cache);
+      if(osgDB::writeImageFile(*image, tmpFile, options.get())) {
+        rename(tmpFile.c_str(), cacheFile.c_str());
+      }
+    }
+    std::vector<unsigned int> levelSizes;
+    getLevelSizes(image.get(), &levelSizes);
+    unsigned int width = image->s(), height = image->t();
+    image = reduceImage(image.get(), job.skipLevels);
+    image->setDataVariance(osg::Object::STATIC);
+    job.texture->setLoadedImage(image.get(), width, height, levelSizes);
+  }
+
+  void TextureManager::update() {
+    size_t budget;
+    {
+      // the budget is set from the gui thread
+      MutexLocker locker(&mutex);
+      budget = memoryBudget;
+    }
+    if(budget == 0) return;
+    std::vector<osg::ref_ptr<ManagedTexture> > textureList;
+    {
+      MutexLocker locker(&textureMutex);
+      textureList.reserve(textures.size());
+      std::unordered_map<std::string, osg::ref_ptr<ManagedTexture> >::iterator it;
+      for(it=textures.begin(); it!=textures.end(); ++it) {
+        textureList.push_back(it->second);
+      }
+    }
+
+    std::vector<ManagedTexture::Usage> usages(textureList.size());
+    std::vector<ManagedTexture::Usage*> loaded;
+    size_t used = 0;
+    unsigned int frame = 0;
+    for(size_t i=0; i<textureList.size(); ++i) {
+      usages[i] = textureList[i]->getUsage();
+      if(usages[i].levelSizes.empty()) continue;
+      used += usages[i].getBytes(usages[i].skipLevels);
+      frame = std::max(frame, usages[i].lastUsedFrame);
+      loaded.push_back(&usages[i]);
+    }
+    std::sort(loaded.begin(), loaded.end(), compareLastUsed);
+    if(used > budget) {
+      // the textures that were not drawn for the longest time lose
+      // their highest mip level first
+      for(size_t i=0; i<loaded.size() && used > budget; ++i) {
+        ManagedTexture::Usage &usage = *loaded[i];
+        if(usage.loading || usage.skipLevels >= usage.getMaxSkipLevels()) {
+          continue;
+        }
+        used -= (usage.getBytes(usage.skipLevels) -
+                 usage.getBytes(usage.skipLevels+1));
+        size_t index = loaded[i] - &usages[0];
+        requestLoad(textureList[index]->getName(), textureList[index].get(),
+                    usage.skipLevels+1);
+      }
+      return;
+    }
+
+    // the recently drawn textures get their resolution back as long as a
+    // part of the budget stays free, thus they don't toggle every frame
+    const size_t limit = budget - budget/8;
+    for(size_t i=loaded.size(); i>0; --i) {
+      ManagedTexture::Usage &usage = *loaded[i-1];
+      if(usage.lastUsedFrame + 1 < frame) break;
+      if(usage.loading || usage.skipLevels == 0) continue;
+      size_t more = (usage.getBytes(usage.skipLevels-1) -
+                     usage.getBytes(usage.skipLevels));
+      if(used + more > limit) continue;
+      used += more;
+      size_t index = loaded[i-1] - &usages[0];
+      requestLoad(textureList[index]->getName(), textureList[index].get(),
+                  usage.skipLevels-1);
+    }
+  }
+
+  void TextureManager::setAsyncLoading(bool v) {
+    MutexLocker locker(&mutex);
+    asyncLoading = v;
+  }
+
+  void TextureManager::setCachePath(const std::string &path) {
+    MutexLocker locker(&mutex);
+    cachePath = path;
+  }
+
+  std::string TextureManager::getCachePath() {
+    MutexLocker locker(&mutex);
+    return cachePath;
+  }
+
+  void TextureManager::setCompression(bool v) {
+    MutexLocker locker(&mutex);
+    compression = v;
+  }
+
+  void TextureManager::setMemoryBudget(size_t bytes) {
+    MutexLocker locker(&mutex);
+    memoryBudget = bytes;
+  }
+
+  size_t TextureManager::getMemoryUsage() {
+    MutexLocker locker(&textureMutex);
+    size_t used = 0;
+    std::unordered_map<std::string, osg::ref_ptr<ManagedTexture> >::iterator it;
+    for(it=textures.begin(); it!=textures.end(); ++it) {
+      ManagedTexture::Usage usage = it->second->getUsage();
+      used += usage.getBytes(usage.skipLevels);
+    }
+    return used;
+  }
+
+} // end of namespace osg_material_manager
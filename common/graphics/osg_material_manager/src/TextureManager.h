@@ -0,0 +1,144 @@
+/*
+ *  Copyright 2017, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef TEXTURE_MANAGER_H
+#define TEXTURE_MANAGER_H
+
+#ifdef _PRINT_HEADER_
+  #warning "TextureManager.h"
+#endif
+
+#include <mars/utils/Thread.h>
+#include <mars/utils/Mutex.h>
+#include <mars/utils/WaitCondition.h>
+
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <osg/Image>
+#include <osg/Texture2D>
+
+namespace osg_material_manager {
+
+  /**
+   * A texture whose image is decoded by the TextureManager. The loading
+   * thread only hands the image over, it is set in the next apply() of
+   * the render thread. Thus the texture can be static and the image data
+   * is released after the upload.
+   */
+  class ManagedTexture : public osg::Texture2D {
+  public:
+    struct Usage {
+      unsigned int width, height;
+      // bytes of every mip level of the full resolution image
+      std::vector<unsigned int> levelSizes;
+      // number of dropped high resolution mip levels
+      unsigned int skipLevels;
+      bool loading;
+      unsigned int lastUsedFrame;
+
+      size_t getBytes(unsigned int skip) const;
+      unsigned int getMaxSkipLevels() const;
+    };
+
+    ManagedTexture();
+
+    virtual void apply(osg::State &state) const;
+
+    void setLoading(unsigned int skipLevels);
+    void setLoadedImage(osg::Image *image, unsigned int width,
+                        unsigned int height,
+                        const std::vector<unsigned int> &levelSizes);
+    Usage getUsage() const;
+
+  private:
+    // the draw threads of several contexts may apply the texture at once
+    mutable mars::utils::Mutex mutex;
+    mutable osg::ref_ptr<osg::Image> loadedImage;
+    mutable Usage usage;
+  }; // end of class ManagedTexture
+
+  /**
+   * Shares the textures and images of all materials and draw objects.
+   *
+   * Textures are decoded in a background thread. The decoded image gets
+   * a complete mip chain (compressed if an image processor plugin is
+   * available) which is stored in the cache directory, named by the hash
+   * of the file content. The next load of the same file only reads the
+   * cached chain.
+   *
+   * With a memory budget update() drops the high resolution mip levels
+   * of the textures that were not drawn for the longest time until the
+   * budget is met, and restores them once they are drawn again.
+   */
+  class TextureManager : public mars::utils::Thread {
+  public:
+    static TextureManager* instance();
+    ~TextureManager();
+
+    osg::ref_ptr<osg::Texture2D> loadTexture(const std::string &filename);
+    osg::ref_ptr<osg::Image> loadImage(const std::string &filename);
+    /** \brief reads an image from disk or from a mounted archive */
+    static osg::Image* readImage(const std::string &filename);
+
+    /** \brief applies the memory budget, called once per frame */
+    void update();
+
+    void setAsyncLoading(bool v);
+    /** \brief an empty path disables the mipmap cache */
+    void setCachePath(const std::string &path);
+    std::string getCachePath();
+    void setCompression(bool v);
+    /** \brief the texture budget in bytes, 0 means unlimited */
+    void setMemoryBudget(size_t bytes);
+    size_t getMemoryUsage();
+
+  protected:
+    void run();
+
+  private:
+    struct LoadJob {
+      std::string filename;
+      osg::ref_ptr<ManagedTexture> texture;
+      unsigned int skipLevels;
+    };
+
+    TextureManager();
+
+    mars::utils::Mutex mutex, textureMutex;
+    mars::utils::WaitCondition condition;
+    std::deque<LoadJob> jobs;
+    std::unordered_map<std::string, osg::ref_ptr<ManagedTexture> > textures;
+    std::unordered_map<std::string, osg::ref_ptr<osg::Image> > images;
+    std::string cachePath;
+    bool asyncLoading, compression, stopLoading;
+    size_t memoryBudget;
+
+    void requestLoad(const std::string &filename, ManagedTexture *texture,
+                     unsigned int skipLevels);
+    void processJob(const LoadJob &job, const std::string &cache,
+                    bool compress);
+  }; // end of class TextureManager
+
+} // end of namespace osg_material_manager
+
+#endif /* TEXTURE_MANAGER_H */
@@ -20,6 +20,8 @@
 
 #include "ConsoleGUI.h"
 
+#include <QScrollBar>
+
 #ifdef WIN32
 #include <windows.h>
 #endif
@@ -34,8 +36,8 @@ namespace mars {
       maxLines = -1;
       QHBoxLayout *buttonLayout = new QHBoxLayout();
       QVBoxLayout *mainLayout = new QVBoxLayout();
-      myTextEdit = new QTextEdit();
-      myText = new QTextDocument();
+      myListView = new QListView();
+      myModel = new ConsoleModel(myListView);
 
       //setAttribute(Qt::WA_DeleteOnClose);
       QPalette palette;
@@ -120,19 +122,29 @@ namespace mars {
       }
 
       mainLayout->addLayout(buttonLayout);
-      mainLayout->addWidget(myTextEdit);
+      mainLayout->addWidget(myListView);
       setLayout(mainLayout);
-      myText->setParent(myTextEdit);
-      myTextEdit->setDocument(myText);
+      // only the visible rows are laid out and painted
+      myListView->setUniformItemSizes(true);
+      myListView->setSelectionMode(QAbstractItemView::ExtendedSelection);
+      myListView->setEditTriggers(QAbstractItemView::NoEditTriggers);
+      myListView->setModel(myModel);
     }
 
     ConsoleGUI::~ConsoleGUI(void) {
     }
 
 
+    void ConsoleGUI::appendLines(const std::vector<ConsoleLine> &lines) {
+      QScrollBar *bar = myListView->verticalScrollBar();
+      bool atBottom = bar->value() == bar->maximum();
+      myModel->appendLines(lines);
+      if(atBottom) myListView->scrollToBottom();
+    }
+
     void ConsoleGUI::setMaxLines(int maxLines) {
       this->maxLines = maxLines;
-      myText->setMaximumBlockCount(maxLines);
+      myModel->setMaxLines(maxLines);
     }
 
     void ConsoleGUI::paintEvent(QPaintEvent *event) {
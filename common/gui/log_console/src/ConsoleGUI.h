@@ -31,8 +31,10 @@
 #warning "ConsoleGUI.h"
 #endif
 
+#include "ConsoleModel.h"
+
 #include <mars/main_gui/BaseWidget.h>
-#include <QTextEdit>
+#include <QListView>
 #include <QCloseEvent>
 #include <QPaintEvent>
 #include <QHBoxLayout>
@@ -49,15 +51,15 @@ namespace mars {
       ConsoleGUI(QWidget *parent, cfg_manager::CFGManagerInterface *cfg);
       ~ConsoleGUI();
     
-      void setTextColor(const QColor &color) {
-        myTextEdit->setTextColor(color);
-      }
+      /**
+       * Appends a batch of lines and keeps the view at the bottom if it
+       * was scrolled to the bottom before.
+       */
+      void appendLines(const std::vector<ConsoleLine> &lines);
 
       void setMaxLines(int maxLines);
+
     public slots:
-      void append(const QString &text) {
-        myTextEdit->append(text);
-      }
       void onCheckBoxToggled(int state);
 
     protected:
@@ -68,8 +70,8 @@ namespace mars {
 
     private:
       QCheckBox *buttons[5];
-      QTextEdit *myTextEdit;
-      QTextDocument *myText;
+      QListView *myListView;
+      ConsoleModel *myModel;
       int maxLines;
 
     }; // end of class ConsoleGUI
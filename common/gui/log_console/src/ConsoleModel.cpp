@@ -0,0 +1,103 @@
+/*
+ *  Copyright 2011, 2012, 2016 DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "ConsoleModel.h"
+
+#include <mars/data_broker/DataBrokerInterface.h>
+#include <QColor>
+
+namespace mars {
+
+  namespace log_console {
+
+    ConsoleModel::ConsoleModel(QObject *parent)
+      : QAbstractListModel(parent), maxLines(-1) {
+    }
+
+    ConsoleModel::~ConsoleModel() {
+    }
+
+    int ConsoleModel::rowCount(const QModelIndex &parent) const {
+      if(parent.isValid()) return 0;
+      return (int)lines.size();
+    }
+
+    QVariant ConsoleModel::data(const QModelIndex &index, int role) const {
+      if(!index.isValid() || index.row() >= (int)lines.size()) {
+        return QVariant();
+      }
+      const ConsoleLine &line = lines[index.row()];
+      if(role == Qt::DisplayRole) {
+        if(line.count > 1) {
+          return line.text + QString(" (x%1)").arg(line.count);
+        }
+        return line.text;
+      }
+      if(role == Qt::ForegroundRole) {
+        switch(line.type) {
+        case data_broker::DB_MESSAGE_TYPE_FATAL:
+          return QColor(255, 48, 9);
+        case data_broker::DB_MESSAGE_TYPE_ERROR:
+          return QColor(212, 148, 90);
+        case data_broker::DB_MESSAGE_TYPE_WARNING:
+          return QColor(90, 148, 212);
+        default:
+          return QColor(90, 200, 70);
+        }
+      }
+      return QVariant();
+    }
+
+    void ConsoleModel::appendLines(const std::vector<ConsoleLine> &newLines) {
+      if(newLines.empty()) return;
+      std::vector<ConsoleLine>::const_iterator it = newLines.begin();
+      if(!lines.empty() && lines.back().type == it->type &&
+         lines.back().text == it->text) {
+        lines.back().count += it->count;
+        QModelIndex last = index((int)lines.size()-1);
+        emit dataChanged(last, last);
+        ++it;
+      }
+      if(it != newLines.end()) {
+        int first = (int)lines.size();
+        beginInsertRows(QModelIndex(), first,
+                        first + (int)(newLines.end() - it) - 1);
+        lines.insert(lines.end(), it, newLines.end());
+        endInsertRows();
+      }
+      trim();
+    }
+
+    void ConsoleModel::setMaxLines(int maxLines) {
+      this->maxLines = maxLines;
+      trim();
+    }
+
+    void ConsoleModel::trim() {
+      if(maxLines < 0 || (int)lines.size() <= maxLines) return;
+      int remove = (int)lines.size() - maxLines;
+      beginRemoveRows(QModelIndex(), 0, remove - 1);
+      lines.erase(lines.begin(), lines.begin() + remove);
+      endRemoveRows();
+    }
+
+  } // end of namespace log_console
+
+} // end of namespace mars
@@ -0,0 +1,84 @@
+/*
+ *  Copyright 2011, 2012, 2016 DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * \file ConsoleModel.h
+ * \brief "ConsoleModel" holds the lines shown by the console view. The
+ *        view only queries the rows that are visible, so the number of
+ *        stored lines does not affect the drawing time.
+ **/
+
+#ifndef CONSOLE_MODEL_H
+#define CONSOLE_MODEL_H
+
+#ifdef _PRINT_HEADER_
+#warning "ConsoleModel.h"
+#endif
+
+#include <QAbstractListModel>
+#include <QString>
+
+#include <deque>
+#include <vector>
+
+namespace mars {
+
+  namespace log_console {
+
+    struct ConsoleLine {
+      QString text;
+      // data_broker::MessageType of the message
+      int type;
+      // number of consecutive identical messages
+      int count;
+    };
+
+    class ConsoleModel : public QAbstractListModel {
+
+    public:
+      ConsoleModel(QObject *parent = 0);
+      ~ConsoleModel();
+
+      virtual int rowCount(const QModelIndex &parent = QModelIndex()) const;
+      virtual QVariant data(const QModelIndex &index,
+                            int role = Qt::DisplayRole) const;
+
+      /**
+       * Appends a batch of lines with one row insertion. A line that
+       * repeats the last stored line only increases its counter.
+       */
+      void appendLines(const std::vector<ConsoleLine> &newLines);
+
+      /** A negative value keeps all lines. */
+      void setMaxLines(int maxLines);
+
+    private:
+      std::deque<ConsoleLine> lines;
+      int maxLines;
+
+      void trim();
+
+    }; // end of class ConsoleModel
+
+  } // end of namespace log_console
+
+} // end of namespace mars
+
+#endif // CONSOLE_MODEL_H
@@ -41,9 +41,15 @@ namespace mars {
 
     MainConsole::MainConsole(lib_manager::LibManager *theManager) :
       lib_manager::LibInterface(theManager), gui(NULL),
-      consoleWidget(NULL), cfg(NULL), set_window_prop(false) {
+      consoleWidget(NULL), messagesHead(0), messagesSize(0),
+      droppedMessages(0), cfg(NULL), set_window_prop(false) {
 
+      for(int i=0; i<data_broker::__DB_MESSAGE_TYPE_COUNT; ++i) {
+        acceptType[i] = true;
+      }
+      bufferSize.iValue = 1024;
       setupGUI();
+      setBufferSize(bufferSize.iValue);
       dataBroker = theManager->getLibraryAs<data_broker::DataBrokerInterface>("data_broker");
       if(dataBroker) {
         dataBroker->registerSyncReceiver(this, "_MESSAGES_", "fatal", 
@@ -77,6 +83,9 @@ namespace mars {
         maxMessages = cfg->getOrCreateProperty("log_console",
                                                "maxLines",
                                                -1, this);
+        bufferSize = cfg->getOrCreateProperty("log_console",
+                                              "bufferSize",
+                                              1024, this);
       }
 
 
@@ -133,25 +142,30 @@ namespace mars {
       //the error/debug messages even if the simulator crashes.
 
       if (showInWidget) {
-        int wait = 100;
-        con_data da;
-        da.type = type;
-        while(wait < 20) {
-          consoleLock.lock();
-          if(messages.size() < MAX_DE)
-            wait = 20;
-          consoleLock.unlock();
-          if(wait++ < 20) {
-#ifdef WIN32
-            Sleep(10);
-#else
-            usleep(10000);
-#endif
+        consoleLock.lock();
+        if(type < 0 || type >= data_broker::__DB_MESSAGE_TYPE_COUNT ||
+           acceptType[type]) {
+          size_t capacity = messages.size();
+          con_data *last = NULL;
+          if(messagesSize > 0) {
+            last = &messages[(messagesHead+messagesSize-1) % capacity];
+          }
+          if(last && last->type == type && last->message == message) {
+            ++last->count;
+          }
+          else if(capacity > 0) {
+            if(messagesSize == capacity) {
+              messagesHead = (messagesHead+1) % capacity;
+              --messagesSize;
+              ++droppedMessages;
+            }
+            con_data &da = messages[(messagesHead+messagesSize) % capacity];
+            da.message = message;
+            da.type = type;
+            da.count = 1;
+            ++messagesSize;
           }
         }
-        consoleLock.lock();
-        da.message = message;
-        messages.push_back(da);
         consoleLock.unlock();
       }
       if (showOnStdError.bValue)
@@ -219,25 +233,73 @@ namespace mars {
       (void)event;
       if (consoleWidget == NULL)
         return;
+      // only swap the messages out while holding the lock; the
+      // conversion and the rendering happen without blocking producers
+      size_t num = 0;
+      unsigned long dropped;
+      consoleLock.lock();
+      if(pending.size() < messagesSize) pending.resize(messagesSize);
+      for(; num < messagesSize; ++num) {
+        con_data &da = messages[(messagesHead+num) % messages.size()];
+        pending[num].message.swap(da.message);
+        pending[num].type = da.type;
+        pending[num].count = da.count;
+      }
+      messagesHead = 0;
+      messagesSize = 0;
+      dropped = droppedMessages;
+      droppedMessages = 0;
+      consoleLock.unlock();
+
+      if(num == 0 && dropped == 0) return;
+      std::vector<ConsoleLine> lines;
+      lines.reserve(num + 1);
+      if(dropped) {
+        ConsoleLine line;
+        line.text = QString("log_console: %1 messages dropped").arg(dropped);
+        line.type = data_broker::DB_MESSAGE_TYPE_WARNING;
+        line.count = 1;
+        lines.push_back(line);
+      }
+      for(size_t i=0; i<num; ++i) {
+        ConsoleLine line;
+        line.text = QString::fromStdString(pending[i].message);
+        line.type = pending[i].type;
+        line.count = pending[i].count;
+        lines.push_back(line);
+      }
+      consoleWidget->appendLines(lines);
+    }
+
+    void MainConsole::setBufferSize(int size) {
+      if(size < 1) size = 1;
       consoleLock.lock();
-      while(messages.size() > 0) {
-        if(messages[0].type == data_broker::DB_MESSAGE_TYPE_FATAL)
-          consoleWidget->setTextColor(QColor(255, 48, 9));
-        else if(messages[0].type == data_broker::DB_MESSAGE_TYPE_ERROR)
-          consoleWidget->setTextColor(QColor(212, 148, 90));
-        else if(messages[0].type == data_broker::DB_MESSAGE_TYPE_WARNING)
-          consoleWidget->setTextColor(QColor(90, 148, 212));
-        else
-          consoleWidget->setTextColor(QColor(90, 200, 70));
-    
-        consoleWidget->append(QString(messages[0].message.data()));
-        messages.erase(messages.begin());
+      // keep the newest messages
+      std::vector<con_data> buffer(size);
+      size_t keep = messagesSize < (size_t)size ? messagesSize : size;
+      size_t skip = messagesSize - keep;
+      for(size_t i=0; i<keep; ++i) {
+        con_data &da = messages[(messagesHead+skip+i) % messages.size()];
+        buffer[i].message.swap(da.message);
+        buffer[i].type = da.type;
+        buffer[i].count = da.count;
       }
+      messages.swap(buffer);
+      messagesHead = 0;
+      messagesSize = keep;
+      droppedMessages += skip;
       consoleLock.unlock();
     }
 
     void MainConsole::onMessageTypeChanged(int buttonId, bool state) {
       const char *dataNames[5] = {"fatal", "error", "warning", "info", "debug"};
+      if(buttonId < 0 || buttonId >= data_broker::__DB_MESSAGE_TYPE_COUNT) {
+        return;
+      }
+      consoleLock.lock();
+      acceptType[buttonId] = state;
+      consoleLock.unlock();
+      if(!dataBroker) return;
       if(state == false) {
         dataBroker->unregisterSyncReceiver(this, "_MESSAGES_", 
                                            dataNames[buttonId]);
@@ -262,7 +324,12 @@ namespace mars {
 
       else if(_property.paramId == maxMessages.paramId) {
         maxMessages.iValue = _property.iValue;
-        consoleWidget->setMaxLines(maxMessages.iValue);
+        if(consoleWidget) consoleWidget->setMaxLines(maxMessages.iValue);
+      }
+
+      else if(_property.paramId == bufferSize.paramId) {
+        bufferSize.iValue = _property.iValue;
+        setBufferSize(bufferSize.iValue);
       }
     }
 
@@ -43,6 +43,7 @@
 #include <mars/main_gui/MenuInterface.h>
 
 #include <string>
+#include <vector>
 
 #include <QMutex>
 #include <QTimerEvent>
@@ -52,11 +53,11 @@ namespace mars {
 
   namespace log_console {
 
-#define MAX_DE 20
-
     struct con_data {
       std::string message;
       data_broker::MessageType type;
+      // number of consecutive identical messages
+      int count;
     };
 
     class MainConsole : public QObject, public lib_manager::LibInterface,
@@ -98,11 +99,22 @@ namespace mars {
       data_broker::DataBrokerInterface *dataBroker;
       ConsoleGUI *consoleWidget;
       QMutex consoleLock;
+      /**
+       * Fixed size ring buffer between the producers and the gui thread.
+       * If it is full the oldest message is overwritten and counted in
+       * droppedMessages. Only the gui thread resizes it.
+       */
       std::vector<con_data> messages;
+      size_t messagesHead, messagesSize;
+      unsigned long droppedMessages;
+      // messages taken from the ring buffer by the gui thread
+      std::vector<con_data> pending;
+      bool acceptType[data_broker::__DB_MESSAGE_TYPE_COUNT];
       // geometry config
       cfg_manager::CFGManagerInterface *cfg;
-      cfg_manager::cfgPropertyStruct showOnStdError, maxMessages;
+      cfg_manager::cfgPropertyStruct showOnStdError, maxMessages, bufferSize;
       void setupCFG(void);
+      void setBufferSize(int size);
       bool set_window_prop;
       int ignore_next_resize;
 
@@ -0,0 +1,598 @@
+/*
+ *  Copyright 2017, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "ArchiveFileSystem.h"
+#include "Mutex.h"
+#include "MutexLocker.h"
+#include "misc.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <thread>
+
+#include <zlib.h>
+
+#include <sys/stat.h>
+
+#ifndef WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace mars {
+  namespace utils {
+
+    // little endian readers for the zip structures
+    static unsigned int read16(const unsigned char *p) {
+      return p[0] | (p[1] << 8);
+    }
+
+    static unsigned int read32(const unsigned char *p) {
+      return p[0] | (p[1] << 8) | (p[2] << 16) | ((unsigned int)p[3] << 24);
+    }
+
+    static unsigned long long read64(const unsigned char *p) {
+      return read32(p) | ((unsigned long long)read32(p+4) << 32);
+    }
+
+    /**
+     * Removes "." and empty path elements and resolves "..", the result
+     * never ends with a '/'.
+     */
+    static std::string normalizePath(const std::string &path) {
+      std::vector<std::string> parts;
+      size_t start = 0;
+      while(start <= path.size()) {
+        size_t end = path.find('/', start);
+        if(end == std::string::npos) end = path.size();
+        std::string part = path.substr(start, end-start);
+        if(part == "..") {
+          if(!parts.empty() && parts.back() != "..") parts.pop_back();
+          else parts.push_back(part);
+        }
+        else if(!part.empty() && part != ".") {
+          parts.push_back(part);
+        }
+        start = end+1;
+      }
+      std::string result = (!path.empty() && path[0] == '/') ? "/" : "";
+      for(size_t i=0; i<parts.size(); ++i) {
+        if(i) result += "/";
+        result += parts[i];
+      }
+      return result;
+    }
+
+    ZipArchive::ZipArchive() : data(0), dataSize(0), mapped(false) {
+    }
+
+    ZipArchive::~ZipArchive() {
+      close();
+    }
+
+    bool ZipArchive::open(const std::string &filename) {
+      close();
+      this->filename = filename;
+#ifndef WIN32
+      int fd = ::open(filename.c_str(), O_RDONLY);
+      if(fd < 0) return false;
+      struct stat st;
+      if(fstat(fd, &st) == 0 && st.st_size > 0) {
+        void *p = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if(p != MAP_FAILED) {
+          data = (const unsigned char*)p;
+          dataSize = st.st_size;
+          mapped = true;
+        }
+      }
+      ::close(fd);
+#endif
+      if(!data) {
+        // no mmap available, keep the archive in memory
+        std::ifstream file(filename.c_str(), std::ios::binary);
+        if(!file.is_open()) return false;
+        file.seekg(0, std::ios::end);
+        buffer.resize((size_t)file.tellg());
+        file.seekg(0, std::ios::beg);
+        if(buffer.empty()) return false;
+        file.read((char*)&buffer[0], buffer.size());
+        data = &buffer[0];
+        dataSize = buffer.size();
+      }
+      if(!readCentralDirectory()) {
+        fprintf(stderr, "ZipArchive: no valid zip archive: %s\n",
+                filename.c_str());
+        close();
+        return false;
+      }
+      return true;
+    }
+
+    void ZipArchive::close() {
+#ifndef WIN32
+      if(mapped) munmap((void*)data, dataSize);
+#endif
+      mapped = false;
+      data = 0;
+      dataSize = 0;
+      buffer.clear();
+      entries.clear();
+    }
+
+    bool ZipArchive::readCentralDirectory() {
+      if(dataSize < 22) return false;
+      // the end of central directory record is followed by a comment of
+      // at most 64k
+      size_t minPos = dataSize > 65557 ? dataSize - 65557 : 0;
+      size_t eocd = dataSize - 22;
+      while(read32(data+eocd) != 0x06054b50) {
+        if(eocd == minPos) return false;
+        --eocd;
+      }
+      unsigned long long numEntries = read16(data+eocd+10);
+      unsigned long long cdSize = read32(data+eocd+12);
+      unsigned long long cdOffset = read32(data+eocd+16);
+      if(eocd >= 20 && read32(data+eocd-20) == 0x07064b50) {
+        unsigned long long zip64 = read64(data+eocd-12);
+        if(zip64 + 56 <= dataSize && read32(data+zip64) == 0x06064b50) {
+          numEntries = read64(data+zip64+32);
+          cdSize = read64(data+zip64+40);
+          cdOffset = read64(data+zip64+48);
+        }
+      }
+      if(cdOffset + cdSize > dataSize) return false;
+
+      const unsigned char *p = data + cdOffset;
+      const unsigned char *end = p + cdSize;
+      for(unsigned long long i=0; i<numEntries; ++i) {
+        if(p+46 > end || read32(p) != 0x02014b50) return false;
+        Entry entry;
+        entry.method = read16(p+10);
+        entry.crc = read32(p+16);
+        entry.compressedSize = read32(p+20);
+        entry.size = read32(p+24);
+        unsigned int nameLength = read16(p+28);
+        unsigned int extraLength = read16(p+30);
+        unsigned int commentLength = read16(p+32);
+        entry.localHeaderOffset = read32(p+42);
+        if(p+46+nameLength+extraLength > end) return false;
+        std::string name((const char*)p+46, nameLength);
+
+        // zip64 extended information replaces the saturated values
+        const unsigned char *extra = p+46+nameLength;
+        const unsigned char *extraEnd = extra+extraLength;
+        while(extra+4 <= extraEnd) {
+          unsigned int id = read16(extra);
+          unsigned int size = read16(extra+2);
+          if(id == 0x0001) {
+            const unsigned char *v = extra+4;
+            if(entry.size == 0xFFFFFFFF) {entry.size = read64(v); v += 8;}
+            if(entry.compressedSize == 0xFFFFFFFF) {
+              entry.compressedSize = read64(v); v += 8;
+            }
+            if(entry.localHeaderOffset == 0xFFFFFFFF) {
+              entry.localHeaderOffset = read64(v);
+            }
+          }
+          extra += 4+size;
+        }
+        if(!name.empty() && name[name.size()-1] != '/') {
+          name = normalizePath(name);
+          // entries must not be extracted outside of the cache directory
+          if(name.empty() || name[0] == '/' || name == ".." ||
+             name.compare(0, 3, "../") == 0) {
+            fprintf(stderr, "ZipArchive: ignore entry outside of the archive: %s\n",
+                    name.c_str());
+          }
+          else {
+            entries[name] = entry;
+          }
+        }
+        p += 46+nameLength+extraLength+commentLength;
+      }
+      return true;
+    }
+
+    const ZipArchive::Entry* ZipArchive::findEntry(const std::string &name) const {
+      std::map<std::string, Entry>::const_iterator it = entries.find(name);
+      if(it == entries.end()) return NULL;
+      return &(it->second);
+    }
+
+    bool ZipArchive::readEntry(const Entry &entry, std::string *content) const {
+      const unsigned long long offset = entry.localHeaderOffset;
+      if(offset + 30 > dataSize || read32(data+offset) != 0x04034b50) {
+        return false;
+      }
+      unsigned long long start = offset + 30 + read16(data+offset+26) +
+        read16(data+offset+28);
+      if(start + entry.compressedSize > dataSize) return false;
+      const unsigned char *src = data+start;
+
+      content->resize(entry.size);
+      if(entry.method == 0) {
+        if(entry.size) memcpy(&(*content)[0], src, entry.size);
+      }
+      else if(entry.method == 8) {
+        z_stream stream;
+        memset(&stream, 0, sizeof(z_stream));
+        // negative window bits: raw deflate data without zlib header
+        if(inflateInit2(&stream, -MAX_WBITS) != Z_OK) return false;
+        stream.next_in = (Bytef*)src;
+        stream.avail_in = (uInt)entry.compressedSize;
+        stream.next_out = entry.size ? (Bytef*)&(*content)[0] : NULL;
+        stream.avail_out = (uInt)entry.size;
+        int result = inflate(&stream, Z_FINISH);
+        inflateEnd(&stream);
+        if(result != Z_STREAM_END || stream.total_out != entry.size) {
+          return false;
+        }
+      }
+      else {
+        fprintf(stderr, "ZipArchive: unsupported compression method %d in %s\n",
+                entry.method, filename.c_str());
+        return false;
+      }
+      unsigned long crc = crc32(0L, Z_NULL, 0);
+      if(entry.size) crc = crc32(crc, (const Bytef*)content->data(), (uInt)entry.size);
+      return crc == entry.crc;
+    }
+
+    namespace {
+
+      struct MountedArchive {
+        ZipArchive archive;
+        int refCount;
+        std::string cacheDir;
+        // modification time and size of the archive file when opened
+        long long mtime, size;
+      };
+
+      void getFileStamp(const std::string &filename, long long *mtime,
+                        long long *size) {
+        struct stat st;
+        if(stat(filename.c_str(), &st) != 0) {
+          *mtime = *size = -1;
+          return;
+        }
+        *mtime = (long long)st.st_mtime;
+        *size = (long long)st.st_size;
+      }
+
+      struct CacheKey {
+        unsigned int crc;
+        unsigned long long size, compressedSize;
+        bool operator<(const CacheKey &other) const {
+          if(crc != other.crc) return crc < other.crc;
+          if(size != other.size) return size < other.size;
+          return compressedSize < other.compressedSize;
+        }
+      };
+
+      struct CacheEntry {
+        std::string content;
+        unsigned long lastUse;
+      };
+
+      // readers hold a reference while they use the archive without the
+      // registry lock, thus unmounting can't free it under their hands
+      typedef std::shared_ptr<MountedArchive> MountedArchivePtr;
+
+      struct ArchiveRegistry {
+        ArchiveRegistry() : cacheSize(64*1024*1024), cacheUsed(0), useCounter(0) {}
+        Mutex mutex;
+        // key is the normalized mount point
+        std::map<std::string, MountedArchivePtr> mounts;
+        std::map<CacheKey, CacheEntry> cache;
+        size_t cacheSize, cacheUsed;
+        unsigned long useCounter;
+      };
+
+      ArchiveRegistry& registry() {
+        static ArchiveRegistry r;
+        return r;
+      }
+
+      /**
+       * Finds the archive that contains path. The registry mutex has to
+       * be locked. name is set to the path relative to the mount point.
+       */
+      MountedArchivePtr findMount(const std::string &path, std::string *name) {
+        ArchiveRegistry &r = registry();
+        if(r.mounts.empty()) return MountedArchivePtr();
+        std::string p = normalizePath(path);
+        std::map<std::string, MountedArchivePtr>::iterator it;
+        for(it=r.mounts.begin(); it!=r.mounts.end(); ++it) {
+          const std::string &m = it->first;
+          if(p == m) {
+            name->clear();
+            return it->second;
+          }
+          if(p.size() > m.size() && p.compare(0, m.size(), m) == 0 &&
+             p[m.size()] == '/') {
+            *name = p.substr(m.size()+1);
+            return it->second;
+          }
+        }
+        return MountedArchivePtr();
+      }
+
+      void trimCache() {
+        ArchiveRegistry &r = registry();
+        while(r.cacheUsed > r.cacheSize && !r.cache.empty()) {
+          std::map<CacheKey, CacheEntry>::iterator oldest = r.cache.begin();
+          std::map<CacheKey, CacheEntry>::iterator it = r.cache.begin();
+          for(; it!=r.cache.end(); ++it) {
+            if(it->second.lastUse < oldest->second.lastUse) oldest = it;
+          }
+          r.cacheUsed -= oldest->second.content.size();
+          r.cache.erase(oldest);
+        }
+      }
+
+      bool readEntryCached(const ZipArchive &archive,
+                           const ZipArchive::Entry &entry,
+                           std::string *content) {
+        ArchiveRegistry &r = registry();
+        CacheKey key = {entry.crc, entry.size, entry.compressedSize};
+        {
+          MutexLocker locker(&r.mutex);
+          std::map<CacheKey, CacheEntry>::iterator it = r.cache.find(key);
+          if(it != r.cache.end()) {
+            it->second.lastUse = ++r.useCounter;
+            *content = it->second.content;
+            return true;
+          }
+        }
+        // decompress without holding the lock, the mapping is read only
+        if(!archive.readEntry(entry, content)) return false;
+        MutexLocker locker(&r.mutex);
+        if(content->size() <= r.cacheSize && !r.cache.count(key)) {
+          CacheEntry &cached = r.cache[key];
+          cached.content = *content;
+          cached.lastUse = ++r.useCounter;
+          r.cacheUsed += content->size();
+          trimCache();
+        }
+        return true;
+      }
+
+      bool extractEntry(const ZipArchive &archive, const std::string &name,
+                        const ZipArchive::Entry &entry,
+                        const std::string &cacheDir) {
+        std::string target = cacheDir + "/" + name;
+        // complete files only appear by the rename below
+        if(pathExists(target)) return true;
+        std::string content;
+        if(!readEntryCached(archive, entry, &content)) return false;
+        createDirectory(getPathOfFile(target));
+        // other processes and threads may extract the same entry, each
+        // writes its own temporary file
+        std::stringstream tmp;
+        tmp << target << ".tmp";
+#ifndef WIN32
+        tmp << getpid();
+#endif
+        tmp << "_" << std::this_thread::get_id();
+        {
+          std::ofstream file(tmp.str().c_str(), std::ios::binary);
+          if(!file.is_open()) return false;
+          file.write(content.data(), content.size());
+          file.close();
+          if(file.fail()) {
+            remove(tmp.str().c_str());
+            return false;
+          }
+        }
+        if(rename(tmp.str().c_str(), target.c_str()) != 0) {
+          remove(tmp.str().c_str());
+          // the target may have been created by another process meanwhile
+          return pathExists(target);
+        }
+        return true;
+      }
+
+    } // end of anonymous namespace
+
+    bool mountArchive(const std::string &archive,
+                      const std::string &mountPoint) {
+      std::string point = normalizePath(mountPoint.empty() ? archive : mountPoint);
+      ArchiveRegistry &r = registry();
+      MutexLocker locker(&r.mutex);
+      long long mtime, size;
+      getFileStamp(archive, &mtime, &size);
+      std::map<std::string, MountedArchivePtr>::iterator it = r.mounts.find(point);
+      if(it != r.mounts.end()) {
+        // a scene that is loaded again after its archive changed gets the
+        // new content, readers of the old one keep it alive
+        if(it->second->mtime != mtime || it->second->size != size) {
+          MountedArchivePtr mounted(new MountedArchive());
+          if(mounted->archive.open(archive)) {
+            mounted->refCount = it->second->refCount;
+            mounted->mtime = mtime;
+            mounted->size = size;
+            it->second = mounted;
+          }
+        }
+        ++(it->second->refCount);
+        return true;
+      }
+      MountedArchivePtr mounted(new MountedArchive());
+      if(!mounted->archive.open(archive)) return false;
+      mounted->refCount = 1;
+      mounted->mtime = mtime;
+      mounted->size = size;
+      r.mounts[point] = mounted;
+      return true;
+    }
+
+    void unmountArchive(const std::string &mountPoint) {
+      ArchiveRegistry &r = registry();
+      MutexLocker locker(&r.mutex);
+      std::map<std::string, MountedArchivePtr>::iterator it;
+      it = r.mounts.find(normalizePath(mountPoint));
+      if(it == r.mounts.end()) return;
+      if(--(it->second->refCount) > 0) return;
+      // the archive is closed when the last reader releases it
+      r.mounts.erase(it);
+    }
+
+    bool isArchivePath(const std::string &path) {
+      ArchiveRegistry &r = registry();
+      MutexLocker locker(&r.mutex);
+      std::string name;
+      return (bool)findMount(path, &name);
+    }
+
+    std::vector<std::string> listArchiveFiles(const std::string &path) {
+      std::vector<std::string> files;
+      ArchiveRegistry &r = registry();
+      MutexLocker locker(&r.mutex);
+      std::string name;
+      MountedArchivePtr mounted = findMount(path, &name);
+      if(!mounted) return files;
+      std::string prefix = name.empty() ? "" : name + "/";
+      const std::map<std::string, ZipArchive::Entry> &entries = mounted->archive.getEntries();
+      std::map<std::string, ZipArchive::Entry>::const_iterator it;
+      for(it=entries.lower_bound(prefix); it!=entries.end(); ++it) {
+        if(it->first.compare(0, prefix.size(), prefix) != 0) break;
+        files.push_back(it->first.substr(prefix.size()));
+      }
+      return files;
+    }
+
+    bool virtualPathExists(const std::string &path) {
+      ArchiveRegistry &r = registry();
+      {
+        MutexLocker locker(&r.mutex);
+        std::string name;
+        MountedArchivePtr mounted = findMount(path, &name);
+        if(mounted) {
+          if(name.empty() || mounted->archive.findEntry(name)) return true;
+          // check for a directory
+          const std::map<std::string, ZipArchive::Entry> &entries = mounted->archive.getEntries();
+          std::map<std::string, ZipArchive::Entry>::const_iterator it;
+          it = entries.lower_bound(name + "/");
+          return (it != entries.end() &&
+                  it->first.compare(0, name.size()+1, name + "/") == 0);
+        }
+      }
+      return pathExists(path);
+    }
+
+    bool readVirtualFile(const std::string &path, std::string *content) {
+      ArchiveRegistry &r = registry();
+      MountedArchivePtr mounted;
+      const ZipArchive::Entry *entry = NULL;
+      {
+        MutexLocker locker(&r.mutex);
+        std::string name;
+        mounted = findMount(path, &name);
+        if(mounted) {
+          entry = mounted->archive.findEntry(name);
+          if(!entry) return false;
+        }
+      }
+      if(mounted) return readEntryCached(mounted->archive, *entry, content);
+
+      std::ifstream file(path.c_str(), std::ios::binary);
+      if(!file.is_open()) return false;
+      std::ostringstream stream;
+      stream << file.rdbuf();
+      *content = stream.str();
+      return true;
+    }
+
+    std::string getRealFilePath(const std::string &path,
+                                const std::string &suffixes,
+                                bool siblings) {
+      ArchiveRegistry &r = registry();
+      MutexLocker locker(&r.mutex);
+      std::string name;
+      MountedArchivePtr mounted = findMount(path, &name);
+      if(!mounted) return path;
+      const ZipArchive &archive = mounted->archive;
+      if(mounted->cacheDir.empty()) {
+        // the directory name depends on the archive name and content,
+        // thus a modified archive does not reuse outdated files
+        const std::string &filename = archive.getFilename();
+        unsigned long hash = crc32(0L, (const Bytef*)filename.data(),
+                                   (uInt)filename.size());
+        std::map<std::string, ZipArchive::Entry>::const_iterator it;
+        for(it=archive.getEntries().begin(); it!=archive.getEntries().end(); ++it) {
+          hash = crc32(hash, (const Bytef*)&(it->second.crc), sizeof(unsigned int));
+        }
+        const char *tmp = getenv("TMPDIR");
+        std::stringstream s;
+        s << (tmp ? tmp : "/tmp") << "/mars_archive_cache/" << std::hex << hash;
+        mounted->cacheDir = s.str();
+      }
+      // extract the requested directory or the directory of the file
+      std::string dir = name;
+      bool recursive = true;
+      if(!suffixes.empty()) {
+        dir = "";
+      }
+      else if(archive.findEntry(name)) {
+        size_t pos = name.rfind('/');
+        dir = pos == std::string::npos ? "" : name.substr(0, pos);
+        recursive = false;
+      }
+      std::string prefix = dir.empty() ? "" : dir + "/";
+      const std::string cacheDir = mounted->cacheDir;
+      // readEntryCached locks the registry again for the cache, mounted
+      // keeps the archive alive
+      locker.unlock();
+      const std::map<std::string, ZipArchive::Entry> &entries = archive.getEntries();
+      std::map<std::string, ZipArchive::Entry>::const_iterator it;
+      for(it=entries.lower_bound(prefix); it!=entries.end(); ++it) {
+        if(it->first.compare(0, prefix.size(), prefix) != 0) break;
+        if(!recursive && it->first.find('/', prefix.size()) != std::string::npos) {
+          continue;
+        }
+        if(!siblings && it->first != name) continue;
+        if(!suffixes.empty() && it->first != name) {
+          std::string suffix = getFilenameSuffix(it->first);
+          if(suffix.empty() || (" " + suffixes + " ").find(" " + suffix + " ") == std::string::npos) {
+            continue;
+          }
+        }
+        if(!extractEntry(archive, it->first, it->second, cacheDir)) {
+          fprintf(stderr, "ArchiveFileSystem: could not extract %s from %s\n",
+                  it->first.c_str(), archive.getFilename().c_str());
+        }
+      }
+      return name.empty() ? cacheDir : cacheDir + "/" + name;
+    }
+
+    void setArchiveCacheSize(size_t bytes) {
+      ArchiveRegistry &r = registry();
+      MutexLocker locker(&r.mutex);
+      r.cacheSize = bytes;
+      trimCache();
+    }
+
+  } // end of namespace utils
+} // end of namespace mars
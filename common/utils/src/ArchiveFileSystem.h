@@ -0,0 +1,126 @@
+/*
+ *  Copyright 2017, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef MARS_UTILS_ARCHIVE_FILE_SYSTEM_H
+#define MARS_UTILS_ARCHIVE_FILE_SYSTEM_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace mars {
+  namespace utils {
+
+    /**
+     * Read only access to the entries of a zip archive. The archive is
+     * memory mapped and only the central directory is parsed on open,
+     * thus opening is cheap even for large archives. Entries are
+     * decompressed on request.
+     */
+    class ZipArchive {
+    public:
+      struct Entry {
+        unsigned long long localHeaderOffset;
+        unsigned long long compressedSize;
+        unsigned long long size;
+        unsigned int crc;
+        unsigned short method;
+      };
+
+      ZipArchive();
+      ~ZipArchive();
+
+      bool open(const std::string &filename);
+      void close();
+      bool isOpen() const {return data != 0;}
+      const std::string& getFilename() const {return filename;}
+
+      const Entry* findEntry(const std::string &name) const;
+      const std::map<std::string, Entry>& getEntries() const {return entries;}
+      bool readEntry(const Entry &entry, std::string *content) const;
+
+    private:
+      std::string filename;
+      std::map<std::string, Entry> entries;
+      const unsigned char *data;
+      size_t dataSize;
+      bool mapped;
+      std::vector<unsigned char> buffer;
+
+      bool readCentralDirectory();
+    }; // end of class ZipArchive
+
+    /**
+     * \brief Makes the content of a zip archive readable below
+     * \a mountPoint. By default the archive path itself is used as
+     * directory, i.e. "scenes/foo.scn/foo.yml" addresses the entry
+     * "foo.yml" of "scenes/foo.scn". Mounting the same point twice only
+     * increases a reference counter, unless the archive file was modified
+     * meanwhile, then it is opened again.
+     */
+    bool mountArchive(const std::string &archive,
+                      const std::string &mountPoint = "");
+    void unmountArchive(const std::string &mountPoint);
+
+    /** \brief true if the path points into a mounted archive */
+    bool isArchivePath(const std::string &path);
+
+    /**
+     * \brief Lists the files of the mounted archive below \a path,
+     * relative to \a path.
+     */
+    std::vector<std::string> listArchiveFiles(const std::string &path);
+
+    /**
+     * \brief Like pathExists() but also knows the files and directories
+     * of the mounted archives.
+     */
+    bool virtualPathExists(const std::string &path);
+
+    /**
+     * \brief Reads a whole file either from a mounted archive or from
+     * disk. Decompressed archive entries are cached by their content
+     * hash (crc and size from the central directory), thus the same
+     * mesh in several archives is only inflated once.
+     */
+    bool readVirtualFile(const std::string &path, std::string *content);
+
+    /**
+     * \brief Returns a path on disk for libraries that can only open
+     * files by name. For archive paths the entry and the other entries
+     * of its directory (e.g. an OBJ with its material file and textures)
+     * are extracted into a cache directory once. A directory path
+     * extracts the whole subtree. If \a suffixes is given (e.g.
+     * ".urdf .yml") instead all files of the archive with one of these
+     * suffixes are extracted, thus a parser can follow relative
+     * references between them. With \a siblings false only the entry
+     * itself is extracted. Other paths are returned unchanged.
+     */
+    std::string getRealFilePath(const std::string &path,
+                                const std::string &suffixes = "",
+                                bool siblings = true);
+
+    /** \brief Sets the byte budget of the decompression cache. */
+    void setArchiveCacheSize(size_t bytes);
+
+  } // end of namespace utils
+} // end of namespace mars
+
+#endif /* MARS_UTILS_ARCHIVE_FILE_SYSTEM_H */
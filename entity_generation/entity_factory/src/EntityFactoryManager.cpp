@@ -34,6 +34,8 @@
 #include <mars/utils/MutexLocker.h>
 #include <mars/interfaces/sim/EntityManagerInterface.h>
 
+#include <sstream>
+
 namespace mars {
 
   namespace entity_generation {
@@ -49,6 +51,20 @@ namespace mars {
     }
 
     void EntityFactoryManager::reset() {
+      // the reset reloads all nodes active, send everything back to the pools
+      utils::MutexLocker locker(&poolMutex);
+      std::map<std::string, EntityPool>::iterator it;
+      for(it=pools.begin(); it!=pools.end(); ++it) {
+        EntityPool &pool = it->second;
+        pool.idle.insert(pool.idle.end(), pool.spawned.begin(),
+                         pool.spawned.end());
+        pool.spawned.clear();
+        for(size_t i=0; i<pool.idle.size(); ++i) {
+          sim::SimEntity *entity = control->entities->getEntity(pool.idle[i]);
+          if(entity) entity->setActive(false);
+        }
+      }
+      spawnedEntities.clear();
     }
 
     EntityFactoryManager::~EntityFactoryManager() {
@@ -94,6 +110,97 @@ namespace mars {
       return createEntity(config);
     }
 
+    void EntityFactoryManager::registerTemplate(const std::string &templateName,
+                                                const configmaps::ConfigMap &config,
+                                                unsigned int poolSize) {
+      {
+        utils::MutexLocker locker(&poolMutex);
+        EntityPool &pool = pools[templateName];
+        pool.config = config;
+        if(pool.idle.empty() && pool.spawned.empty()) pool.instanceCount = 0;
+      }
+      if(poolSize) reservePool(templateName, poolSize);
+    }
+
+    void EntityFactoryManager::reservePool(const std::string &templateName,
+                                           unsigned int poolSize) {
+      utils::MutexLocker locker(&poolMutex);
+      std::map<std::string, EntityPool>::iterator it = pools.find(templateName);
+      if(it == pools.end()) {
+        fprintf(stderr, "EntityFactory: unknown template '%s'.\n",
+                templateName.c_str());
+        return;
+      }
+      while(it->second.idle.size() < poolSize) {
+        unsigned long id = createPoolInstance(templateName, &(it->second));
+        if(!id) break;
+        it->second.idle.push_back(id);
+      }
+    }
+
+    unsigned long EntityFactoryManager::createPoolInstance(const std::string &templateName,
+                                                           EntityPool *pool) {
+      configmaps::ConfigMap config = pool->config;
+      std::stringstream name;
+      name << templateName << "_" << pool->instanceCount++;
+      config["name"] = name.str();
+      unsigned long id = createEntity(config);
+      sim::SimEntity *entity = id ? control->entities->getEntity(id) : NULL;
+      if(!entity) {
+        fprintf(stderr, "EntityFactory: could not create instance of template '%s'.\n",
+                templateName.c_str());
+        return 0;
+      }
+      entity->setActive(false);
+      return id;
+    }
+
+    unsigned long EntityFactoryManager::spawnEntity(const std::string &templateName,
+                                                    const utils::Vector &pos,
+                                                    const utils::Quaternion &rot) {
+      utils::MutexLocker locker(&poolMutex);
+      std::map<std::string, EntityPool>::iterator it = pools.find(templateName);
+      if(it == pools.end()) {
+        fprintf(stderr, "EntityFactory: unknown template '%s'.\n",
+                templateName.c_str());
+        return 0;
+      }
+      EntityPool &pool = it->second;
+      unsigned long id;
+      if(pool.idle.empty()) {
+        id = createPoolInstance(templateName, &pool);
+        if(!id) return 0;
+      }
+      else {
+        id = pool.idle.back();
+        pool.idle.pop_back();
+      }
+      sim::SimEntity *entity = control->entities->getEntity(id);
+      if(!entity) return 0;
+      // move while inactive, thus the old pose never collides
+      entity->setPose(pos, rot);
+      entity->setActive(true);
+      pool.spawned.insert(id);
+      spawnedEntities[id] = templateName;
+      return id;
+    }
+
+    void EntityFactoryManager::despawnEntity(unsigned long id) {
+      utils::MutexLocker locker(&poolMutex);
+      std::map<unsigned long, std::string>::iterator it = spawnedEntities.find(id);
+      if(it == spawnedEntities.end()) {
+        fprintf(stderr, "EntityFactory: entity %lu was not spawned from a pool.\n",
+                id);
+        return;
+      }
+      EntityPool &pool = pools[it->second];
+      spawnedEntities.erase(it);
+      sim::SimEntity *entity = control->entities->getEntity(id);
+      if(entity) entity->setActive(false);
+      pool.spawned.erase(id);
+      pool.idle.push_back(id);
+    }
+
   } // end of namespace entity_generation
 } // end of namespace mars
 
@@ -38,8 +38,12 @@
 #include <mars/data_broker/ReceiverInterface.h>
 #include <mars/cfg_manager/CFGManagerInterface.h>
 #include <mars/utils/Mutex.h>
+#include <mars/utils/Vector.h>
+#include <mars/utils/Quaternion.h>
 #include <configmaps/ConfigData.h>
 
+#include <set>
+
 namespace mars {
 
   namespace entity_generation {
@@ -78,9 +82,51 @@ namespace mars {
 
         // EntityFactoryManager methods
 
+        /**
+         * Registers an entity config as template for spawning. Instances
+         * of the template are created in advance and wait deactivated in
+         * a pool, thus spawning and despawning does not create or destroy
+         * any physics or graphics objects.
+         * \param poolSize number of instances created right away
+         */
+        virtual void registerTemplate(const std::string &templateName,
+                                      const configmaps::ConfigMap &config,
+                                      unsigned int poolSize=0);
+
+        /** creates instances until the pool holds \a poolSize idle ones */
+        virtual void reservePool(const std::string &templateName,
+                                 unsigned int poolSize);
+
+        /**
+         * Activates a pooled instance of the template at the given pose.
+         * The pool grows by one instance if it is empty.
+         * \return the entity id or 0 if the template is unknown
+         */
+        virtual unsigned long spawnEntity(const std::string &templateName,
+                                          const utils::Vector &pos,
+                                          const utils::Quaternion &rot);
+
+        /** deactivates a spawned entity and returns it to its pool */
+        virtual void despawnEntity(unsigned long id);
+
     private:
+        struct EntityPool {
+          configmaps::ConfigMap config;
+          std::vector<unsigned long> idle;
+          std::set<unsigned long> spawned;
+          unsigned long instanceCount;
+        };
+
         std::map<std::string, EntityFactoryInterface*> factories;
+        std::map<std::string, EntityPool> pools;
+        // maps the ids of spawned entities to their template
+        std::map<unsigned long, std::string> spawnedEntities;
         mutable utils::Mutex iMutex;
+        // separate from iMutex, the pool creates its instances via createEntity
+        mutable utils::Mutex poolMutex;
+
+        unsigned long createPoolInstance(const std::string &templateName,
+                                         EntityPool *pool);
 
       };
     // end of class definition EntityFactoryManager
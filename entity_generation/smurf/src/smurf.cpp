@@ -37,6 +37,7 @@
 
 #include <mars/utils/misc.h>
 #include <mars/utils/mathUtils.h>
+#include <mars/utils/ArchiveFileSystem.h>
 #include <smurf_parser/SMURFParser.h>
 
 //#define DEBUG_PARSE_SENSOR 1
@@ -92,6 +93,10 @@ namespace mars {
       nextControllerID = 1;
       // TODO: this needs checking for potential doubling (see above nextGroupID)
       groupID = control->nodes->getMaxGroupID() + 1;
+      collapseFixedJoints = false;
+      articulatedJoints = false;
+      linkGroupMap.clear();
+      keptJoints.clear();
 
       nodeList.clear();
       jointList.clear();
@@ -188,9 +193,16 @@ namespace mars {
       tmpPath = path;
       entityconfig["abs_path"] = pathJoin(getCurrentWorkingDir(), path);
       std::string filename = (std::string)entityconfig["file"];
+      // smurf_parser and urdfdom only read from disk, thus they get an
+      // extracted copy of the model description of zipped models; meshes
+      // are still read in place via tmpPath
+      std::string parsePath = path;
+      if(isArchivePath(path)) {
+        parsePath = getRealFilePath(path, ".smurf .yml .yaml .urdf .xml") + "/";
+      }
       fprintf(stderr, "SMURF::createEntity: Creating entity of type %s\n", ((std::string)entityconfig["type"]).c_str());
       if((std::string)entityconfig["type"] == "smurf" || entityconfig["type"].getString() == "particle") {
-        model = smurf_parser::parseFile(&entityconfig, path, filename, true);
+        model = smurf_parser::parseFile(&entityconfig, parsePath, filename, true);
 #ifdef DEBUG_SCENE_MAP
         debugMap.append(entityconfig);
 #endif
@@ -227,7 +239,7 @@ namespace mars {
             addConfigMap(tmpconfig);
         }
       } else { // if type is "urdf"
-        std::string urdfpath = path + filename;
+        std::string urdfpath = parsePath + filename;
         fprintf(stderr, "  ...loading urdf data from %s.\n", urdfpath.c_str());
         fprintf(stderr, "parsing model...\n");
         parseURDF(urdfpath);
@@ -435,8 +447,12 @@ namespace mars {
               ConfigMap::iterator cIt = it->beginMap();
               for (; cIt != it->endMap(); ++cIt) {
                 if (cIt->first != "name") {
+                  // bitmask and category can be given as number or as
+                  // list of collision group names
                   if (cIt->first == "bitmask") {
-                    (*nIt)["coll_bitmask"] = (int) cIt->second;
+                    (*nIt)["coll_bitmask"] = cIt->second;
+                  } else if (cIt->first == "category") {
+                    (*nIt)["coll_category"] = cIt->second;
                   } else {
                     (*nIt)[cIt->first] = cIt->second;
                   }
@@ -854,11 +870,23 @@ namespace mars {
       Vector v;
       Quaternion q;
 
-      groupID++;
+      bool collapse = collapseJoint(link);
+      if (collapse) {
+        // the link is rigidly attached to its parent: all its nodes become
+        // part of the parent's composite body and keep their relative pose
+        // as geom offsets, thus no joint is needed
+        groupID = linkGroupMap[link->parent_joint->parent_link_name];
+      } else {
+        groupID = ++nextGroupID;
+      }
+      // a static link has no body other links could be merged into
+      if (!fixed) {
+        linkGroupMap[link->name] = groupID;
+      }
 
       createOrigin(link, fixed);
 
-      if (link->parent_joint)
+      if (link->parent_joint && !collapse)
         translateJoint(link);
 
       // inertial
@@ -935,9 +963,65 @@ namespace mars {
 #endif
         // reduce DataBroker load
         config["reducedDataPackage"] = true;
+        if (articulatedJoints) {
+          config["articulated"] = true;
+        }
         jointList.push_back(config);
     }
 
+    /**
+     * Collects the joints that are referenced by motors, joint sensors or
+     * joint annotations of the smurf. These must not be collapsed even
+     * if they are fixed.
+     */
+    void SMURF::collectKeptJoints() {
+      ConfigVector::iterator it;
+      keptJoints.clear();
+      if (entityconfig.hasKey("motors")) {
+        for (it = entityconfig["motors"].begin(); it != entityconfig["motors"].end(); ++it) {
+          keptJoints.insert((std::string)(*it)["joint"]);
+        }
+      }
+      if (entityconfig.hasKey("sensors")) {
+        for (it = entityconfig["sensors"].begin(); it != entityconfig["sensors"].end(); ++it) {
+          std::string type = (std::string)(*it)["type"];
+          if (type == "Joint6DOF") {
+            urdf::LinkConstSharedPtr link = model->getLink((std::string)(*it)["link"]);
+            if (link && link->parent_joint) {
+              keptJoints.insert(link->parent_joint->name);
+            }
+          }
+          else if (type.find("Joint") != std::string::npos && it->hasKey("id")) {
+            for (ConfigVector::iterator idit = (*it)["id"].begin();
+                 idit != (*it)["id"].end(); ++idit) {
+              keptJoints.insert((std::string)(*idit));
+            }
+          }
+        }
+      }
+      if (entityconfig.hasKey("joint")) {
+        for (it = entityconfig["joint"].begin(); it != entityconfig["joint"].end(); ++it) {
+          keptJoints.insert((std::string)(*it)["name"]);
+        }
+      }
+    }
+
+    /**
+     * Returns true if the link should be merged into the composite body of
+     * its parent link instead of being connected by a fixed joint.
+     */
+    bool SMURF::collapseJoint(const urdf::LinkSharedPtr &childlink) {
+      if (!collapseFixedJoints || !childlink->parent_joint) {
+        return false;
+      }
+      urdf::JointSharedPtr joint = childlink->parent_joint;
+      if (joint->type != urdf::Joint::FIXED ||
+          keptJoints.find(joint->name) != keptJoints.end()) {
+        return false;
+      }
+      return linkGroupMap.find(joint->parent_link_name) != linkGroupMap.end();
+    }
+
     urdf::Pose SMURF::getGlobalPose(const urdf::LinkSharedPtr &link) {
       urdf::Pose globalPose;
       urdf::LinkSharedPtr pLink = link->getParent();
@@ -998,6 +1082,11 @@ namespace mars {
         createMaterial(it->second);
       }
 
+      collapseFixedJoints = entityconfig.get("collapse_fixed_joints", false);
+      if (collapseFixedJoints) {
+        collectKeptJoints();
+      }
+      articulatedJoints = entityconfig.get("articulated", false);
       translateLink(model->root_link_, fixed);
     }
 
@@ -1055,6 +1144,7 @@ namespace mars {
       map["rootNode"] = model->root_link_->name;
       entity->appendConfig(map);
       entity->setInitialPose();
+      entity->initCollisionExclusions();
 
       control->nodes->printNodeMasses(true);
 
@@ -1201,10 +1291,13 @@ namespace mars {
 
     BaseSensor* SMURF::loadSensor(ConfigMap config) {
       config["mapIndex"] = mapIndex;
+      // the sensors resolve their file references against the scene path
+      config["filePrefix"] = tmpPath;
       BaseSensor *sensor = control->sensors->createAndAddSensor(&config);
       if (sensor != 0) {
         control->loadCenter->setMappedID(config["index"], sensor->getID(), MAP_TYPE_SENSOR,
             mapIndex);
+        entity->addSensor(sensor->getID(), sensor->getName());
       }
 
       return sensor;
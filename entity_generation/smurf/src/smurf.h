@@ -26,6 +26,7 @@
 #endif
 
 #include <map>
+#include <set>
 
 #include <yaml-cpp/yaml.h>
 
@@ -87,6 +88,14 @@ namespace mars {
 
     private:
       int groupID;
+      // links connected by a fixed joint are merged into the group of
+      // their parent link, see collapseJoint()
+      bool collapseFixedJoints;
+      std::map<std::string, int> linkGroupMap;
+      std::set<std::string> keptJoints;
+      // the joints of the entity are solved in joint space, see
+      // mars::sim::Articulation
+      bool articulatedJoints;
       unsigned int mapIndex; // index to map nodes of a single entity
       unsigned long nextNodeID;
       unsigned long nextGroupID;
@@ -118,6 +127,8 @@ namespace mars {
       // creating URDF objects
       void translateLink(urdf::LinkSharedPtr link, bool fixed); // handleKinematics
       void translateJoint(urdf::LinkSharedPtr childlink); // handleKinematics
+      void collectKeptJoints();
+      bool collapseJoint(const urdf::LinkSharedPtr &childlink);
       void createMaterial(const urdf::MaterialSharedPtr material); // handleMaterial
       void createOrigin(const urdf::LinkSharedPtr &link, bool fixed);
       void createInertial(const urdf::LinkSharedPtr &link);
@@ -369,6 +369,41 @@ namespace mars {
       scaleTransform_->setStateSet(materialNode->getMaterial()->getStateSet());
     }
 
+    void DrawObject::setOcclusionQuery(bool val, unsigned int queryFrameCount,
+                                       unsigned int visibilityThreshold) {
+      if(!scaleTransform_.valid()) return;
+      osg::Node *content = group_.get();
+      if(lod.valid()) content = lod.get();
+      if(val) {
+        if(!occlusionNode.valid() &&
+           scaleTransform_->getChildIndex(content) >= scaleTransform_->getNumChildren()) {
+          return;
+        }
+        if(!occlusionNode.valid()) {
+          occlusionNode = new osg::OcclusionQueryNode();
+          occlusionNode->addChild(content);
+          scaleTransform_->replaceChild(content, occlusionNode.get());
+        }
+        occlusionNode->setQueryFrameCount(queryFrameCount);
+        occlusionNode->setVisibilityThreshold(visibilityThreshold);
+      }
+      else if(occlusionNode.valid()) {
+        scaleTransform_->replaceChild(occlusionNode.get(), content);
+        occlusionNode = NULL;
+      }
+    }
+
+    unsigned int DrawObject::getNumVertices() const {
+      unsigned int num = 0;
+      std::list< osg::ref_ptr<osg::Geometry> >::const_iterator it;
+      for(it=geometry_.begin(); it!=geometry_.end(); ++it) {
+        if(it->valid() && (*it)->getVertexArray()) {
+          num += (*it)->getVertexArray()->getNumElements();
+        }
+      }
+      return num;
+    }
+
     void DrawObject::showNormals(bool val) {
       if(normal_geode.valid()) {
         if(val) {
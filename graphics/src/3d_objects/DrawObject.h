@@ -49,6 +49,7 @@
 #include <osg/MatrixTransform>
 #include <osg/Geode>
 #include <osg/LOD>
+#include <osg/OcclusionQueryNode>
 #include <osg/Program>
 
 #include <mars/osg_material_manager/OsgMaterial.h>
@@ -154,6 +155,15 @@ namespace mars {
       void seperateMaterial();
       void addSelectionChild(DrawObject* c) {selectionChilds.push_back(c);}
 
+      /**
+       * \brief Draws the object only if its bounding box was visible in the
+       * last query of a view. The query is repeated every
+       * \a queryFrameCount frames, in between the last result is used.
+       */
+      void setOcclusionQuery(bool val, unsigned int queryFrameCount,
+                             unsigned int visibilityThreshold);
+      unsigned int getNumVertices() const;
+
       osg_frames::Frame* frame;
     protected:
       unsigned long id_;
@@ -168,6 +178,7 @@ namespace mars {
       osg::ref_ptr<osg::LOD> lod;
       osg::ref_ptr<osg::PositionAttitudeTransform> posTransform_;
       osg::ref_ptr<osg::MatrixTransform> scaleTransform_;
+      osg::ref_ptr<osg::OcclusionQueryNode> occlusionNode;
       std::vector<DrawObject*> selectionChilds;
       mars::utils::Vector position_, pivot_, geometrySize_, scaledSize_;
       mars::utils::Quaternion quaternion_;
@@ -0,0 +1,226 @@
+/*
+ *  Copyright 2017, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "DistortionRemap.h"
+
+#include <osg/Math>
+#include <osg/Texture>
+
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+namespace mars {
+  namespace graphics {
+
+    using namespace interfaces;
+
+    // a pinhole rendering gets useless towards 90 degree, the distorted
+    // image is black beyond this view angle
+    static const double maxViewAngle = osg::DegreesToRadians(80.0);
+    static const int maxIterations = 20;
+
+    static osg::Image* allocateRemap(int width, int height) {
+      osg::Image *remap = new osg::Image();
+      remap->allocateImage(width, height, 1, GL_RGB, GL_FLOAT);
+      remap->setInternalTextureFormat(GL_RGB32F_ARB);
+      return remap;
+    }
+
+    static double coefficient(const std::vector<double> &k, size_t i) {
+      return i < k.size() ? k[i] : 0.0;
+    }
+
+    static void distortBrownConrady(const std::vector<double> &k,
+                                    double x, double y,
+                                    double *xd, double *yd) {
+      double k1 = coefficient(k, 0), k2 = coefficient(k, 1);
+      double p1 = coefficient(k, 2), p2 = coefficient(k, 3);
+      double k3 = coefficient(k, 4), k4 = coefficient(k, 5);
+      double k5 = coefficient(k, 6), k6 = coefficient(k, 7);
+      double r2 = x*x+y*y;
+      double radial = ((1.0+((k3*r2+k2)*r2+k1)*r2) /
+                       (1.0+((k6*r2+k5)*r2+k4)*r2));
+      *xd = x*radial + 2.0*p1*x*y + p2*(r2+2.0*x*x);
+      *yd = y*radial + p1*(r2+2.0*y*y) + 2.0*p2*x*y;
+    }
+
+    static bool undistortBrownConrady(const std::vector<double> &k,
+                                      double xd, double yd,
+                                      double *x, double *y) {
+      double k1 = coefficient(k, 0), k2 = coefficient(k, 1);
+      double p1 = coefficient(k, 2), p2 = coefficient(k, 3);
+      double k3 = coefficient(k, 4), k4 = coefficient(k, 5);
+      double k5 = coefficient(k, 6), k6 = coefficient(k, 7);
+      double ux = xd, uy = yd;
+
+      for(int i=0; i<maxIterations; ++i) {
+        double r2 = ux*ux+uy*uy;
+        double radial = ((1.0+((k3*r2+k2)*r2+k1)*r2) /
+                         (1.0+((k6*r2+k5)*r2+k4)*r2));
+        if(radial <= 0.0) return false;
+        double dx = 2.0*p1*ux*uy + p2*(r2+2.0*ux*ux);
+        double dy = p1*(r2+2.0*uy*uy) + 2.0*p2*ux*uy;
+        ux = (xd-dx)/radial;
+        uy = (yd-dy)/radial;
+      }
+
+      // the iteration does not converge where the polynomial folds back,
+      // such pixels are not seen by the real lens
+      double cx, cy;
+      distortBrownConrady(k, ux, uy, &cx, &cy);
+      if(fabs(cx-xd) + fabs(cy-yd) > 1e-5) return false;
+      *x = ux;
+      *y = uy;
+      return true;
+    }
+
+    static bool undistortFisheye(const std::vector<double> &k,
+                                 double xd, double yd,
+                                 double *x, double *y) {
+      double k1 = coefficient(k, 0), k2 = coefficient(k, 1);
+      double k3 = coefficient(k, 2), k4 = coefficient(k, 3);
+      double thetaD = sqrt(xd*xd+yd*yd);
+
+      if(thetaD < 1e-12) {
+        *x = xd;
+        *y = yd;
+        return true;
+      }
+
+      // newton iteration on theta_d = theta*(1+k1*theta^2+...+k4*theta^8)
+      double theta = thetaD, f = 0.0;
+      for(int i=0; i<maxIterations; ++i) {
+        double t2 = theta*theta;
+        f = theta*(1.0+t2*(k1+t2*(k2+t2*(k3+t2*k4)))) - thetaD;
+        double df = 1.0+t2*(3.0*k1+t2*(5.0*k2+t2*(7.0*k3+t2*9.0*k4)));
+        if(df <= 0.0) return false;
+        theta -= f/df;
+      }
+      if(fabs(f) > 1e-6 || theta < 0.0 || theta >= maxViewAngle) {
+        return false;
+      }
+
+      double scale = tan(theta)/thetaD;
+      *x = xd*scale;
+      *y = yd*scale;
+      return true;
+    }
+
+    osg::Image* createDistortionRemap(double factor, int width, int height) {
+      osg::Image *remap = allocateRemap(width, height);
+      float *data = (float*)remap->data();
+      double f1 = factor*osg::PI*0.999;
+      double f2 = f1 > 0.0 ? 0.5/tan(f1*0.5) : 0.0;
+
+      for(int row=0; row<height; ++row) {
+        double t = (row+0.5)/height;
+        if(f1 > 0.0) t = tan((t-0.5)*f1)*f2+0.5;
+        for(int col=0; col<width; ++col, data+=3) {
+          double s = (col+0.5)/width;
+          if(f1 > 0.0) s = tan((s-0.5)*f1)*f2+0.5;
+          data[0] = s;
+          data[1] = t;
+          data[2] = (s >= 0.0 && s <= 1.0 && t >= 0.0 && t <= 1.0) ? 1.0 : 0.0;
+        }
+      }
+      return remap;
+    }
+
+    osg::Image* createDistortionRemap(const cameraDistortionStruct &distortion,
+                                      int width, int height, double frustum[4]) {
+      if(distortion.model == DISTORTION_NONE || distortion.width <= 0 ||
+         distortion.height <= 0 || distortion.fx <= 0.0 ||
+         distortion.fy <= 0.0 || width <= 0 || height <= 0) {
+        fprintf(stderr, "DistortionRemap: invalid camera calibration\n");
+        return NULL;
+      }
+
+      // scale the intrinsics to the rendered image, the pixel centers
+      // are at integer coordinates
+      double scaleX = (double)width/distortion.width;
+      double scaleY = (double)height/distortion.height;
+      double fx = distortion.fx*scaleX, fy = distortion.fy*scaleY;
+      double cx = (distortion.cx+0.5)*scaleX-0.5;
+      double cy = (distortion.cy+0.5)*scaleY-0.5;
+      double maxTan = tan(maxViewAngle);
+      double left = 0.0, right = 0.0, bottom = 0.0, top = 0.0;
+      bool found = false;
+
+      // first pass: the undistorted view ray of every pixel, y up
+      std::vector<float> rays(width*height*3);
+      for(int row=0; row<height; ++row) {
+        // image rows are stored bottom up, pixel coordinates count top down
+        double yd = (height-1-row-cy)/fy;
+        for(int col=0; col<width; ++col) {
+          float *ray = &rays[(row*width+col)*3];
+          double xd = (col-cx)/fx;
+          double x = 0.0, y = 0.0;
+          bool valid;
+
+          if(distortion.model == DISTORTION_FISHEYE) {
+            valid = undistortFisheye(distortion.coefficients, xd, yd, &x, &y);
+          }
+          else {
+            valid = undistortBrownConrady(distortion.coefficients, xd, yd, &x, &y);
+          }
+          valid = valid && fabs(x) <= maxTan && fabs(y) <= maxTan;
+          ray[0] = x;
+          ray[1] = -y;
+          ray[2] = valid ? 1.0 : 0.0;
+          if(!valid) continue;
+
+          if(!found) {
+            left = right = x;
+            bottom = top = -y;
+            found = true;
+          }
+          else {
+            if(x < left) left = x;
+            if(x > right) right = x;
+            if(-y < bottom) bottom = -y;
+            if(-y > top) top = -y;
+          }
+        }
+      }
+
+      if(!found || right <= left || top <= bottom) {
+        fprintf(stderr, "DistortionRemap: the calibration covers no view ray\n");
+        return NULL;
+      }
+
+      // second pass: the texture coordinates within the covering frustum
+      osg::Image *remap = allocateRemap(width, height);
+      float *data = (float*)remap->data();
+      for(size_t i=0; i<rays.size(); i+=3) {
+        data[i] = (rays[i]-left)/(right-left);
+        data[i+1] = (rays[i+1]-bottom)/(top-bottom);
+        data[i+2] = rays[i+2];
+      }
+
+      frustum[0] = left;
+      frustum[1] = right;
+      frustum[2] = bottom;
+      frustum[3] = top;
+      return remap;
+    }
+
+  } // end of namespace graphics
+} // end of namespace mars
@@ -0,0 +1,59 @@
+/*
+ *  Copyright 2017, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef MARS_GRAPHICS_DISTORTION_REMAP_H
+#define MARS_GRAPHICS_DISTORTION_REMAP_H
+
+#ifdef _PRINT_HEADER_
+  #warning "DistortionRemap.h"
+#endif
+
+#include <mars/interfaces/cameraDistortionStruct.h>
+
+#include <osg/Image>
+
+namespace mars {
+  namespace graphics {
+
+    /**
+     * The remap images are float RGB images of the output size. For every
+     * pixel of the distorted image they store the texture coordinate of
+     * the undistorted rendering (rg) and whether the pixel is covered by
+     * the rendering at all (b).
+     */
+
+    /** \brief the remap of the former single factor distortion */
+    osg::Image* createDistortionRemap(double factor, int width, int height);
+
+    /**
+     * \brief the remap of a calibrated lens model
+     *
+     * The frustum of the undistorted rendering is returned as tangents of
+     * the view angles (left, right, bottom, top); it has to be applied to
+     * the camera with the near plane as factor. Returns NULL if the
+     * calibration is invalid.
+     */
+    osg::Image* createDistortionRemap(const interfaces::cameraDistortionStruct &distortion,
+                                      int width, int height, double frustum[4]);
+
+  } // end of namespace graphics
+} // end of namespace mars
+
+#endif /* MARS_GRAPHICS_DISTORTION_REMAP_H */
@@ -31,7 +31,9 @@
 #include <cstdio>
 #include <osg/Geometry>
 #include <osg/Geode>
+#include <osg/Program>
 #include <osg/Texture2D>
+#include <osgViewer/View>
 #include <osg/PositionAttitudeTransform>
 #include <iostream>
 
@@ -966,11 +968,13 @@ namespace mars {
     void GraphicsCamera::deactivateCam() {
       nodeMask = mainCamera->getNodeMask();
       mainCamera->setNodeMask(0);
+      if(distortionCamera.valid()) distortionCamera->setNodeMask(0);
     }
 
     void GraphicsCamera::activateCam() {
       if(mainCamera->getNodeMask() == 0){
           mainCamera->setNodeMask(nodeMask);
+          if(distortionCamera.valid()) distortionCamera->setNodeMask(nodeMask);
       }
     }
 
@@ -988,95 +992,71 @@ namespace mars {
       }
     }
 
-    void GraphicsCamera::setupDistortion(osg::Texture2D *texture, osg::Image *image, osg::Group *mainScene, double factor) {
-      // create the quad to visualize.
-      osg::Geometry* polyGeom = new osg::Geometry();
-
-      polyGeom->setSupportsDisplayList(false);
-
-      osg::Vec3 origin(0.0f,0.0f,0.0f);
-      osg::Vec3 xAxis(1.0f,0.0f,0.0f);
-      osg::Vec3 yAxis(0.0f,1.0f,0.0f);
-      float height = 1024.0f;
-      float width = 1280.0f;
-      int noSteps = 50;
-
-      osg::Vec3Array* vertices = new osg::Vec3Array;
-      osg::Vec2Array* texcoords = new osg::Vec2Array;
-      osg::Vec4Array* colors = new osg::Vec4Array;
-
-      osg::Vec3 bottom = origin;
-      osg::Vec3 dx = xAxis*(width/((float)(noSteps-1)));
-      osg::Vec3 dy = yAxis*(height/((float)(noSteps-1)));
-
-      osg::Vec2 bottom_texcoord(0.0f,0.0f);
-      osg::Vec2 dx_texcoord(1.0f/(float)(noSteps-1),0.0f);
-      osg::Vec2 dy_texcoord(0.0f,1.0f/(float)(noSteps-1));
-
-      int i,j;
-      double f1 = factor*osg::PI*0.999;
-      double f2 = 0.5/tan(f1*0.5);
-      for(i=0;i<noSteps;++i) {
-        osg::Vec3 cursor = bottom+dy*(float)i;
-        osg::Vec2 texcoord = bottom_texcoord+dy_texcoord*(float)i;
-        for(j=0;j<noSteps;++j) {
-          vertices->push_back(cursor);
-          // texcoords->push_back(osg::Vec2((sin(texcoord.x()*osg::PI-osg::PI*0.5)+1.0f)*0.5f,
-          //                                (sin(texcoord.y()*osg::PI-osg::PI*0.5)+1.0f)*0.5f));
-          //texcoords->push_back(osg::Vec2(texcoord.x(), texcoord.y()));
-          double x = tan((texcoord.x()-0.5)*f1)*f2+0.5;
-          double y = tan((texcoord.y()-0.5)*f1)*f2+0.5;
-          texcoords->push_back(osg::Vec2f(x,y));
-          colors->push_back(osg::Vec4(1.0f,1.0f,1.0f,1.0f));
-
-          cursor += dx;
-          texcoord += dx_texcoord;
-        }
-      }
-
-      // pass the created vertex array to the points geometry object.
-      polyGeom->setVertexArray(vertices);
-      polyGeom->setColorArray(colors, osg::Array::BIND_PER_VERTEX);
-      polyGeom->setTexCoordArray(0,texcoords);
-
-
-      for(i=0;i<noSteps-1;++i) {
-        osg::DrawElementsUShort* elements = new osg::DrawElementsUShort(osg::PrimitiveSet::QUAD_STRIP);
-        for(j=0;j<noSteps;++j) {
-          elements->push_back(j+(i+1)*noSteps);
-          elements->push_back(j+(i)*noSteps);
-        }
-        polyGeom->addPrimitiveSet(elements);
+    void GraphicsCamera::setupDistortion(osgViewer::View *view,
+                                         osg::Texture2D *source,
+                                         osg::Texture2D *remap,
+                                         osg::Image *image) {
+      static const char *vertexSource =
+        "void main() {\n"
+        "  gl_TexCoord[0] = gl_MultiTexCoord0;\n"
+        "  gl_Position = ftransform();\n"
+        "}\n";
+      static const char *fragmentSource =
+        "uniform sampler2D sourceTexture;\n"
+        "uniform sampler2D remapTexture;\n"
+        "void main() {\n"
+        "  vec3 remap = texture2D(remapTexture, gl_TexCoord[0].xy).xyz;\n"
+        "  if(remap.z < 0.5) gl_FragColor = vec4(0.0, 0.0, 0.0, 1.0);\n"
+        "  else gl_FragColor = texture2D(sourceTexture, remap.xy);\n"
+        "}\n";
+
+      if(distortionCamera.valid()) {
+        view->removeSlave(view->findSlaveIndexForCamera(distortionCamera.get()));
+        distortionCamera = NULL;
       }
 
-      // new we need to add the texture to the Drawable, we do so by creating a
-      // StateSet to contain the Texture StateAttribute.
-      osg::StateSet* stateset = polyGeom->getOrCreateStateSet();
-      stateset->setTextureAttributeAndModes(0, texture, osg::StateAttribute::ON);
+      // the scene is rendered into the source texture on the gpu,
+      // only the warped image is read back
+      mainCamera->detach(osg::Camera::COLOR_BUFFER);
+      mainCamera->attach(osg::Camera::COLOR_BUFFER, source);
+
+      osg::Geometry *quad = osg::createTexturedQuadGeometry(osg::Vec3(0.0f, 0.0f, 0.0f),
+                                                            osg::Vec3(width, 0.0f, 0.0f),
+                                                            osg::Vec3(0.0f, height, 0.0f));
+      osg::StateSet *stateset = quad->getOrCreateStateSet();
+      osg::Program *program = new osg::Program();
+      program->addShader(new osg::Shader(osg::Shader::VERTEX, vertexSource));
+      program->addShader(new osg::Shader(osg::Shader::FRAGMENT, fragmentSource));
+      stateset->setAttributeAndModes(program, osg::StateAttribute::ON);
+      stateset->setTextureAttributeAndModes(0, source, osg::StateAttribute::ON);
+      stateset->setTextureAttributeAndModes(1, remap, osg::StateAttribute::ON);
+      stateset->addUniform(new osg::Uniform("sourceTexture", 0));
+      stateset->addUniform(new osg::Uniform("remapTexture", 1));
       stateset->setMode(GL_LIGHTING, osg::StateAttribute::OFF);
+      stateset->setMode(GL_DEPTH_TEST, osg::StateAttribute::OFF);
 
-      osg::Geode* geode = new osg::Geode();
-      geode->addDrawable(polyGeom);
-
-      // set up the camera to render the textured quad
-      osg::Camera* camera = new osg::Camera;
+      osg::Geode *geode = new osg::Geode();
+      geode->addDrawable(quad);
 
-      // just inherit the main cameras view
+      // the warp is a slave of the view and thus only rendered for the
+      // window of this camera and not as part of the shared scene
+      osg::Camera *camera = new osg::Camera;
       camera->setReferenceFrame(osg::Transform::ABSOLUTE_RF);
       camera->setViewMatrix(osg::Matrix::identity());
       camera->setViewport(0, 0, width, height);
-      camera->setProjectionMatrixAsOrtho2D(0,width,0,height);
+      camera->setProjectionMatrixAsOrtho2D(0, width, 0, height);
       camera->setRenderTargetImplementation(osg::Camera::FRAME_BUFFER_OBJECT);
       camera->setAllowEventFocus(false);
-      camera->setClearColor(osg::Vec4(1, 0, 0, 0.5));
-      camera->setClearMask(GL_COLOR_BUFFER_BIT|GL_DEPTH_BUFFER_BIT);
-
-      // set the camera to render before the main camera.
-      camera->setRenderOrder(osg::Camera::PRE_RENDER);
-      // add subgraph to render
-      camera->addChild(geode);
+      camera->setClearColor(osg::Vec4(0, 0, 0, 1));
+      camera->setClearMask(GL_COLOR_BUFFER_BIT);
+      camera->setRenderOrder(osg::Camera::POST_RENDER);
+      camera->setGraphicsContext(mainCamera->getGraphicsContext());
       camera->attach(osg::Camera::COLOR_BUFFER, image);
-      mainScene->addChild(camera);
+      camera->addChild(geode);
+      // follow the activation state of the main camera
+      camera->setNodeMask(mainCamera->getNodeMask());
+      view->addSlave(camera, false);
+      distortionCamera = camera;
     }
 
     void GraphicsCamera::setTrakingTransform(osg::ref_ptr<osg::PositionAttitudeTransform> t) {
@@ -33,9 +33,14 @@
 #endif
 
 #include <osg/Camera>
+#include <osg/Texture2D>
 #include <osgGA/KeySwitchMatrixManipulator>
 #include <mars/interfaces/graphics/GraphicsCameraInterface.h>
 
+namespace osgViewer {
+  class View;
+}
+
 #define MY_ZNEAR    0.01
 #define MY_ZFAR  1000.0
 
@@ -123,7 +128,13 @@ namespace mars {
       void activateCam();
       void setPivot(osg::Vec3f p);
       void toggleTrackball();
-      void setupDistortion(osg::Texture2D *texture, osg::Image *image, osg::Group *mainScene, double factor);
+      /**
+       * Renders the camera into the source texture and adds a slave
+       * camera to the view that warps it through the remap texture into
+       * the given image.
+       */
+      void setupDistortion(osgViewer::View *view, osg::Texture2D *source,
+                           osg::Texture2D *remap, osg::Image *image);
       void setTrakingTransform(osg::ref_ptr<osg::PositionAttitudeTransform> t);
       virtual bool isTracking();
       virtual void setTrackingLogRotation(bool b);
@@ -143,6 +154,7 @@ namespace mars {
 
       osg::ref_ptr<osg::Camera> mainCamera;
       osg::ref_ptr<osg::Camera> hudCamera;
+      osg::ref_ptr<osg::Camera> distortionCamera;
       osg::ref_ptr<osg::PositionAttitudeTransform> tracking;
       bool logTrackingRotation;
       osg::Matrixd myCameraMatrix;
@@ -41,6 +41,7 @@
 #include <osgParticle/FireEffect>
 
 #include <mars/utils/misc.h>
+#include <mars/osg_material_manager/TextureManager.h>
 
 #include "3d_objects/GridPrimitive.h"
 #include "3d_objects/DrawObject.h"
@@ -63,8 +64,10 @@
 #include "wrapper/OSGNodeStruct.h"
 #include "QtOsgMixGraphicsWidget.h"
 
+#include <algorithm>
 #include <iostream>
 #include <cassert>
+#include <cmath>
 #include <stdexcept>
 
 #define SINGLE_THREADED
@@ -208,6 +211,20 @@ namespace mars {
           vsyncProp = cfg->getOrCreateProperty("Graphics",
                                                "vsync",
                                                false, this);
+          // occlusion queries fall back to drawing everything if the
+          // driver doesn't support them
+          occlusionCullingProp = cfg->getOrCreateProperty("Graphics",
+                                                          "occlusionCulling",
+                                                          false, this);
+          occluderMinSizeProp = cfg->getOrCreateProperty("Graphics",
+                                                         "occluderMinSize",
+                                                         1.0, this);
+          smallFeatureCullingProp = cfg->getOrCreateProperty("Graphics",
+                                                             "smallFeatureCulling",
+                                                             2.0, this);
+          rttSmallFeatureCullingProp = cfg->getOrCreateProperty("Graphics",
+                                                                "rttSmallFeatureCulling",
+                                                                2.0, this);
         }
         else {
           marsShadow.bValue = false;
@@ -597,6 +614,7 @@ namespace mars {
       activeWindow = gw;
       gw->setName(name);
       gw->setClearColor(graphicOptions.clearColor);
+      setSmallFeatureCulling(gw);
       viewer->addView(gw->getView());
       graphicsWindows.push_back(gw);
 
@@ -771,6 +789,8 @@ namespace mars {
         }
       }
 
+      osg_material_manager::TextureManager::instance()->update();
+
       // Render a complete new frame.
       if(viewer) {
         viewer->frame();
@@ -928,6 +948,12 @@ namespace mars {
       }
 
       setDrawObjectMaterial(id, snode.material);
+      if(isStaticOccluder(snode)) {
+        staticOccluders.insert(id);
+      }
+      if(occlusionCullingProp.bValue) {
+        setOcclusionCulling(id, true);
+      }
       if(activated) {
         if(mask != 0) {
           drawObject->object()->show();
@@ -962,6 +988,41 @@ namespace mars {
         delete drawObject;
       }
       drawObjects_.erase(id);
+      staticOccluders.erase(id);
+    }
+
+    bool GraphicsManager::isStaticOccluder(const NodeData &node) const {
+      if(node.movable || node.material.transparency > 0.0) return false;
+      ConfigMap config = node.map;
+      if(config.hasKey("occluder")) return (bool)config["occluder"];
+      if(node.terrain) return true;
+      // the object has to cover a large area in two dimensions
+      Vector size = node.ext;
+      if(node.filename != "PRIMITIVE" && node.visual_size.squaredNorm() > 0.0) {
+        size = node.visual_size;
+      }
+      double dims[3] = {fabs(size.x()), fabs(size.y()), fabs(size.z())};
+      std::sort(dims, dims+3);
+      return dims[1] >= occluderMinSizeProp.dValue;
+    }
+
+    void GraphicsManager::setOcclusionCulling(unsigned long id, bool val) {
+      // a query costs about as much as drawing a few hundred vertices, so
+      // simple objects are always drawn
+      static const unsigned int minOccludeeVertices = 200;
+      OSGNodeStruct *ns = findDrawObject(id);
+      if(!ns || !ns->object()) return;
+      DrawObject *drawObject = ns->object();
+      if(val && (staticOccluders.count(id) ||
+                 drawObject->getNumVertices() < minOccludeeVertices)) {
+        val = false;
+      }
+      drawObject->setOcclusionQuery(val, 5, 0);
+    }
+
+    void GraphicsManager::setSmallFeatureCulling(GraphicsWidget *gw) {
+      if(gw->isRTT()) gw->setSmallFeatureCulling(rttSmallFeatureCullingProp.dValue);
+      else gw->setSmallFeatureCulling(smallFeatureCullingProp.dValue);
     }
 
     void GraphicsManager::exportDrawObject(unsigned long id,
@@ -2100,6 +2161,35 @@ namespace mars {
         return;
       }
 
+      if(_property.paramId == occlusionCullingProp.paramId) {
+        occlusionCullingProp.bValue = _property.bValue;
+        map<unsigned long, osg::ref_ptr<OSGNodeStruct> >::iterator it;
+        for(it=drawObjects_.begin(); it!=drawObjects_.end(); ++it) {
+          setOcclusionCulling(it->first, occlusionCullingProp.bValue);
+        }
+        return;
+      }
+
+      if(_property.paramId == occluderMinSizeProp.paramId) {
+        // only used for nodes that are created afterwards
+        occluderMinSizeProp.dValue = _property.dValue;
+        return;
+      }
+
+      if(_property.paramId == smallFeatureCullingProp.paramId ||
+         _property.paramId == rttSmallFeatureCullingProp.paramId) {
+        if(_property.paramId == smallFeatureCullingProp.paramId) {
+          smallFeatureCullingProp.dValue = _property.dValue;
+        }
+        else {
+          rttSmallFeatureCullingProp.dValue = _property.dValue;
+        }
+        for(size_t i=0; i<graphicsWindows.size(); ++i) {
+          setSmallFeatureCulling(graphicsWindows[i]);
+        }
+        return;
+      }
+
       if(_property.paramId == showSelectionProp.paramId) {
         showSelectionProp.bValue = _property.bValue;
         map<unsigned long, osg::ref_ptr<OSGNodeStruct> >::iterator it;
@@ -71,6 +71,8 @@
 
 #include "gui_helper_functions.h"
 
+#include <set>
+
 
 #define USE_LSPSM_SHADOW 0
 #define USE_PSSM_SHADOW 1
@@ -408,6 +410,8 @@ namespace mars {
         drawLineLaserProp, drawMainCamera, marsShadow, hudWidthProp,
         hudHeightProp, defaultMaxNumNodeLights, shadowTextureSize,
         showGridProp, showCoordsProp, showSelectionProp, vsyncProp, showFramesProp, scaleFramesProp;
+      cfg_manager::cfgPropertyStruct occlusionCullingProp, occluderMinSizeProp,
+        smallFeatureCullingProp, rttSmallFeatureCullingProp;
       cfg_manager::cfgPropertyStruct grab_frames;
       cfg_manager::cfgPropertyStruct resources_path;
       cfg_manager::cfgPropertyStruct configPath;
@@ -429,6 +433,12 @@ namespace mars {
       void showFrames(bool val);
       void scaleFrames(double x);
 
+      // large static nodes are drawn without occlusion query
+      std::set<unsigned long> staticOccluders;
+      bool isStaticOccluder(const mars::interfaces::NodeData &node) const;
+      void setOcclusionCulling(unsigned long id, bool val);
+      void setSmallFeatureCulling(GraphicsWidget *gw);
+
       void initDefaultLight();
       void setColor(utils::Color *c, const std::string &key,
                     const std::string &value);
@@ -22,6 +22,7 @@
 #include "GraphicsWidget.h"
 #include "HUD.h"
 #include "GraphicsManager.h"
+#include "DistortionRemap.h"
 
 #include <mars/utils/Color.h>
 
@@ -940,22 +941,56 @@ namespace mars {
     }
 
     void GraphicsWidget::setupDistortion(double factor) {
-      osg::Image *image = new osg::Image();
-      image->allocateImage(widgetWidth, widgetHeight,
-                           1, GL_RGBA, GL_UNSIGNED_INT_8_8_8_8_REV);
-      view->getCamera()->attach(osg::Camera::COLOR_BUFFER, image);
-      osg::Texture2D * texture = new osg::Texture2D;
-      texture->setResizeNonPowerOfTwoHint(false);
-      texture->setDataVariance(osg::Object::DYNAMIC);
-      texture->setTextureSize(widgetWidth, widgetHeight);
-      texture->setInternalFormat(GL_RGBA);
-      texture->setWrap(osg::Texture::WRAP_S, osg::Texture::REPEAT);
-      texture->setWrap(osg::Texture::WRAP_T, osg::Texture::REPEAT);
-      texture->setFilter(osg::Texture2D::MIN_FILTER,osg::Texture2D::LINEAR);
-      texture->setFilter(osg::Texture2D::MAG_FILTER,osg::Texture2D::LINEAR);
-
-      texture->setImage(image);
-      graphicsCamera->setupDistortion(texture, rttImage.get(), scene, factor);
+      osg::ref_ptr<osg::Image> remap = createDistortionRemap(factor, widgetWidth,
+                                                             widgetHeight);
+      setupDistortionRemap(remap.get());
+    }
+
+    void GraphicsWidget::setupDistortion(const interfaces::cameraDistortionStruct &distortion) {
+      double tangents[4];
+      std::vector<double> frustum;
+      osg::ref_ptr<osg::Image> remap = createDistortionRemap(distortion, widgetWidth,
+                                                             widgetHeight, tangents);
+      if(!remap.valid()) return;
+
+      // render the undistorted view that covers all rays of the lens
+      graphicsCamera->getFrustum(frustum);
+      double near = frustum[4];
+      graphicsCamera->setFrustum(tangents[0]*near, tangents[1]*near,
+                                 tangents[2]*near, tangents[3]*near,
+                                 near, frustum[5]);
+      setupDistortionRemap(remap.get());
+    }
+
+    void GraphicsWidget::setupDistortionRemap(osg::Image *remap) {
+      if(!isRTTWidget) {
+        fprintf(stderr, "GraphicsWidget: distortion is only supported for render to texture windows\n");
+        return;
+      }
+
+      osg::Texture2D *source = new osg::Texture2D;
+      source->setResizeNonPowerOfTwoHint(false);
+      source->setTextureSize(widgetWidth, widgetHeight);
+      source->setInternalFormat(GL_RGBA);
+      source->setWrap(osg::Texture::WRAP_S, osg::Texture::CLAMP_TO_EDGE);
+      source->setWrap(osg::Texture::WRAP_T, osg::Texture::CLAMP_TO_EDGE);
+      source->setFilter(osg::Texture2D::MIN_FILTER, osg::Texture2D::LINEAR);
+      source->setFilter(osg::Texture2D::MAG_FILTER, osg::Texture2D::LINEAR);
+
+      // the remap is sampled per output pixel and must not be interpolated
+      osg::Texture2D *remapTexture = new osg::Texture2D;
+      remapTexture->setResizeNonPowerOfTwoHint(false);
+      remapTexture->setInternalFormat(GL_RGB32F_ARB);
+      remapTexture->setSourceFormat(GL_RGB);
+      remapTexture->setSourceType(GL_FLOAT);
+      remapTexture->setWrap(osg::Texture::WRAP_S, osg::Texture::CLAMP_TO_EDGE);
+      remapTexture->setWrap(osg::Texture::WRAP_T, osg::Texture::CLAMP_TO_EDGE);
+      remapTexture->setFilter(osg::Texture2D::MIN_FILTER, osg::Texture2D::NEAREST);
+      remapTexture->setFilter(osg::Texture2D::MAG_FILTER, osg::Texture2D::NEAREST);
+      remapTexture->setImage(remap);
+
+      graphicsCamera->setupDistortion(view.get(), source, remapTexture,
+                                      rttImage.get());
     }
 
     unsigned long GraphicsWidget::getID(void) {
@@ -1091,6 +1126,18 @@ namespace mars {
       return clearColor;
     }
 
+    void GraphicsWidget::setSmallFeatureCulling(double pixelSize) {
+      osg::Camera *camera = graphicsCamera->getOSGCamera().get();
+      osg::CullSettings::CullingMode mode = camera->getCullingMode();
+      if(pixelSize > 0.0) {
+        camera->setCullingMode(mode | osg::CullSettings::SMALL_FEATURE_CULLING);
+        camera->setSmallFeatureCullingPixelSize(pixelSize);
+      }
+      else {
+        camera->setCullingMode(mode & ~osg::CullSettings::SMALL_FEATURE_CULLING);
+      }
+    }
+
     void GraphicsWidget::grabFocus() {
       hasFocus = true;
       getGraphicsWindow()->grabFocus();
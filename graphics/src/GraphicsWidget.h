@@ -108,6 +108,13 @@ namespace mars {
       void setClearColor(mars::utils::Color color);
       const mars::utils::Color& getClearColor() const;
 
+      /**
+       * \brief Objects that are smaller than \a pixelSize on the screen of
+       * this view are culled. Zero disables the small feature culling.
+       */
+      void setSmallFeatureCulling(double pixelSize);
+      bool isRTT() const {return isRTTWidget;}
+
       void setGrabFrames(bool grab);
       void setSaveFrames(bool grab);
 
@@ -207,6 +214,7 @@ namespace mars {
                                      double x2, double y2);
 
       virtual void setupDistortion(double factor);
+      virtual void setupDistortion(const interfaces::cameraDistortionStruct &distortion);
       void grabFocus();
       void unsetFocus();
 
@@ -275,6 +283,8 @@ namespace mars {
       void applyResize();
 
     private:
+      void setupDistortionRemap(osg::Image *remap);
+
       utils::Color clearColor;
       // toggle for fullscreen display
       bool isFullscreen;
@@ -22,6 +22,8 @@
 #include <iostream>
 #include <osg/TriangleFunctor>
 #include <osgDB/ReadFile>
+#include <osgDB/Registry>
+#include <osgDB/FileNameUtils>
 
 //#include <osgDB/WriteFile>
 #include <osg/MatrixTransform>
@@ -41,6 +43,10 @@
 #endif
 
 #include <mars/utils/mathUtils.h>
+#include <mars/utils/ArchiveFileSystem.h>
+#include <mars/osg_material_manager/TextureManager.h>
+
+#include <sstream>
 
 namespace mars {
   namespace graphics {
@@ -52,8 +58,17 @@ namespace mars {
     using mars::interfaces::snmesh;
 
     vector<nodeFileStruct> GuiHelper::nodeFiles;
-    vector<textureFileStruct> GuiHelper::textureFiles;
-    vector<imageFileStruct> GuiHelper::imageFiles;
+
+    // mesh formats whose files reference material files or textures
+    // next to them
+    static bool referencesSiblingFiles(const std::string &ext) {
+      static const char *formats[] = {"obj", "dae", "3ds", "fbx", "gltf",
+                                      "x", "lwo", "ac", "osg", "osgt", 0};
+      for(int i=0; formats[i]; ++i) {
+        if(ext == formats[i]) return true;
+      }
+      return false;
+    }
 
     /////////////
 
@@ -385,7 +400,29 @@ namespace mars {
       }
       nodeFileStruct newNodeFile;
       newNodeFile.fileName = fileName;
-      newNodeFile.node = osgDB::readNodeFile(fileName);
+      if(utils::isArchivePath(fileName)) {
+        // the osg plugins resolve material files and textures relative to
+        // the mesh, thus only these meshes are read from the extracted
+        // directory, the others are decoded from the archive data
+        std::string ext = osgDB::getLowerCaseFileExtension(fileName);
+        bool siblings = referencesSiblingFiles(ext);
+        osgDB::ReaderWriter *rw;
+        rw = osgDB::Registry::instance()->getReaderWriterForExtension(ext);
+        std::string content;
+        if(!siblings && rw && utils::readVirtualFile(fileName, &content)) {
+          std::istringstream stream(content);
+          osgDB::ReaderWriter::ReadResult result = rw->readNode(stream);
+          if(result.success()) newNodeFile.node = result.getNode();
+        }
+        // not every plugin can read from a stream
+        if(!newNodeFile.node.valid()) {
+          newNodeFile.node = osgDB::readNodeFile(utils::getRealFilePath(fileName, "",
+                                                                        siblings));
+        }
+      }
+      else {
+        newNodeFile.node = osgDB::readNodeFile(fileName);
+      }
       GuiHelper::nodeFiles.push_back(newNodeFile);
       return newNodeFile.node;
     }
@@ -402,7 +439,23 @@ namespace mars {
       nodeFileStruct newNodeFile;
       newNodeFile.fileName = filename;
 
-      FILE* input = fopen(filename.c_str(), "rb");
+      FILE* input;
+      std::string content;
+      if(utils::isArchivePath(filename)) {
+        // read the mesh from the archive without extracting it
+        if(!utils::readVirtualFile(filename, &content)) {
+          fprintf(stderr, "ERROR: reading file: %s\n", filename.c_str());
+          return 0;
+        }
+#ifdef WIN32
+        input = fopen(utils::getRealFilePath(filename, "", false).c_str(), "rb");
+#else
+        input = fmemopen(&content[0], content.size(), "rb");
+#endif
+      }
+      else {
+        input = fopen(filename.c_str(), "rb");
+      }
       if(!input) {
 	fprintf(stderr, "ERROR: reading file: %s\n", filename.c_str());
 	return 0;
@@ -622,7 +675,7 @@ namespace mars {
       }
 #endif
 
-      osg::Image* image = osgDB::readImageFile(terrain->srcname);
+      osg::Image* image = readImage(terrain->srcname);
 
       if(image) {
         terrain->width = image->s();
@@ -656,45 +709,15 @@ namespace mars {
     }
 
     osg::ref_ptr<osg::Texture2D> GuiHelper::loadTexture(string filename) {
-      std::vector<textureFileStruct>::iterator iter;
-
-      for (iter = textureFiles.begin();
-           iter != textureFiles.end(); iter++) {
-        if ((*iter).fileName == filename) {
-          return (*iter).texture;
-        }
-      }
-      textureFileStruct newTextureFile;
-      newTextureFile.fileName = filename;
-      newTextureFile.texture = new osg::Texture2D;
-      newTextureFile.texture->setDataVariance(osg::Object::DYNAMIC);
-      newTextureFile.texture->setWrap(osg::Texture::WRAP_S, osg::Texture::REPEAT);
-      newTextureFile.texture->setWrap(osg::Texture::WRAP_T, osg::Texture::REPEAT);
-      newTextureFile.texture->setWrap(osg::Texture::WRAP_R, osg::Texture::REPEAT);
-
-      osg::Image* textureImage = loadImage(filename);
-      newTextureFile.texture->setImage(textureImage);
-      textureFiles.push_back(newTextureFile);
-
-      return newTextureFile.texture;
+      return osg_material_manager::TextureManager::instance()->loadTexture(filename);
     }
 
     osg::ref_ptr<osg::Image> GuiHelper::loadImage(string filename) {
-      std::vector<imageFileStruct>::iterator iter;
-
-      for (iter = imageFiles.begin();
-           iter != imageFiles.end(); iter++) {
-        if ((*iter).fileName == filename) {
-          return (*iter).image;
-        }
-      }
-      imageFileStruct newImageFile;
-      newImageFile.fileName = filename;
-      osg::Image* image = osgDB::readImageFile(filename);
-      newImageFile.image = image;
-      imageFiles.push_back(newImageFile);
+      return osg_material_manager::TextureManager::instance()->loadImage(filename);
+    }
 
-      return newImageFile.image;
+    osg::Image* GuiHelper::readImage(const std::string &filename) {
+      return osg_material_manager::TextureManager::readImage(filename);
     }
 
   } // end of namespace graphics
@@ -67,16 +67,6 @@ namespace mars {
       osg::ref_ptr<osg::Node> node;
     }; // end of struct nodeFileStruct
 
-    struct textureFileStruct {
-      std::string fileName;
-      osg::ref_ptr<osg::Texture2D> texture;
-    }; // end of struct textureFileStruct
-
-    struct imageFileStruct {
-      std::string fileName;
-      osg::ref_ptr<osg::Image> image;
-    }; // end of struct imageFileStruct
-
     osg::Vec4 toOSGVec4(const mars::utils::Color &col);
     osg::Vec4 toOSGVec4(const mars::utils::Vector &v, float w);
 
@@ -125,6 +115,8 @@ namespace mars {
       static osg::ref_ptr<osg::Node> readBobjFromFile(const std::string &filename);
       static osg::ref_ptr<osg::Texture2D> loadTexture(std::string filename);
       static osg::ref_ptr<osg::Image> loadImage(std::string filename);
+      /** \brief reads an image from disk or from a mounted archive */
+      static osg::Image* readImage(const std::string &filename);
 
     private:
       osg::Geometry *my_geo;
@@ -134,10 +126,6 @@ namespace mars {
       //for compatibility
       mars::interfaces::GraphicData gs;
       static std::vector<nodeFileStruct> nodeFiles;
-      // vector to prevent double load of textures
-      static std::vector<textureFileStruct> textureFiles;
-      // vector to prevent double load of images
-      static std::vector<imageFileStruct> imageFiles;
       void getPhysicsFromNode(mars::interfaces::NodeData* node,
                               osg::ref_ptr<osg::Node> completeNode);
     }; // end of class GuiHelper
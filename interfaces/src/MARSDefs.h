@@ -93,7 +93,10 @@ namespace mars {
       MOTOR_TYPE_PID, // deprecated
       MOTOR_TYPE_DC, // deprecated
       MOTOR_TYPE_PID_FORCE, // deprecated
-      MOTOR_TYPE_DIRECT_EFFORT
+      MOTOR_TYPE_DIRECT_EFFORT,
+      // position drive with p as stiffness and d as damping that is
+      // solved implicitly by the physics
+      MOTOR_TYPE_IMPLICIT_PD
     };
 
     //Definition of Sensor Types
@@ -130,6 +130,8 @@ namespace mars {
       } else if (tmpmotortype=="7" || tmpmotortype=="direct_torque" ||
                  tmpmotortype=="direct_effort") {
         type = MOTOR_TYPE_DIRECT_EFFORT;
+      } else if (tmpmotortype=="8" || tmpmotortype=="implicit_pd") {
+        type = MOTOR_TYPE_IMPLICIT_PD;
       }
 
       GET_VALUE("p", p, Double);
@@ -165,6 +167,9 @@ namespace mars {
       else if (type == 7) {
         (*config)["type"] = "direct_torque";
       }
+      else if (type == 8) {
+        (*config)["type"] = "implicit_pd";
+      }
       else {
         (*config)["type"] = type;
       }
@@ -28,6 +28,7 @@
 #include "Logging.hpp"
 #include <iostream>
 #include <cstdio>
+#include <cstdlib>
 
 
 #define GET_VALUE(str, val, type)                    \
@@ -78,6 +79,49 @@ namespace mars {
       }
     }
 
+    static std::map<std::string, int> collisionGroups;
+
+    int NodeData::collisionGroupBits(const std::string &group) {
+      std::string name = trim(group);
+      char *end = 0;
+
+      if(name.empty()) return 0;
+      if(name == "all") return 65535 & ~COLLIDE_MASK_SENSOR;
+
+      long value = strtol(name.c_str(), &end, 0);
+      if(*end == '\0') return (int)value;
+
+      std::map<std::string, int>::iterator it = collisionGroups.find(name);
+      if(it != collisionGroups.end()) return it->second;
+
+      // bit 16 is reserved for the sensors
+      if(collisionGroups.size() >= 15) {
+        LOG_ERROR("NodeData: no collision bit left for group \"%s\"",
+                  name.c_str());
+        return 0;
+      }
+      int bits = 1 << collisionGroups.size();
+      collisionGroups[name] = bits;
+      return bits;
+    }
+
+    void NodeData::clearCollisionGroups() {
+      collisionGroups.clear();
+    }
+
+    static int collisionBitsFromConfigItem(ConfigItem &item) {
+      int bits = 0;
+      if(item.isVector()) {
+        for(ConfigVector::iterator it = item.begin(); it != item.end(); ++it) {
+          bits |= NodeData::collisionGroupBits((std::string)*it);
+        }
+      }
+      else {
+        bits = NodeData::collisionGroupBits((std::string)item);
+      }
+      return bits;
+    }
+
     NodeType NodeData::typeFromString(const std::string& str) {
       //search in array with strings
       int type;
@@ -237,10 +281,18 @@ namespace mars {
         GET_VALUE("cbounce", c_params.bounce, Double);
         GET_VALUE("cbounce_vel", c_params.bounce_vel, Double);
         GET_VALUE("capprox", c_params.approx_pyramid, Bool);
-        GET_VALUE("coll_bitmask", c_params.coll_bitmask, Int);
+        if((it = config->find("coll_bitmask")) != config->end()) {
+          c_params.coll_bitmask = collisionBitsFromConfigItem(it->second);
+        }
+        if((it = config->find("coll_category")) != config->end()) {
+          c_params.coll_category = collisionBitsFromConfigItem(it->second);
+        }
         GET_VALUE("rolling_friction", c_params.rolling_friction, Double);
         GET_VALUE("rolling_friction2", c_params.rolling_friction2, Double);
         GET_VALUE("spinning_friction", c_params.spinning_friction, Double);
+        if((it = config->find("contact_material")) != config->end()) {
+          c_params.contact_material = (std::string)it->second;
+        }
 
         if((it = config->find("cfdir1")) != config->end()) {
           if(!c_params.friction_direction1) {
@@ -357,9 +409,11 @@ namespace mars {
       SET_VALUE("cbounce_vel", c_params.bounce_vel, writeDefaults);
       SET_VALUE("capprox", c_params.approx_pyramid, writeDefaults);
       SET_VALUE("coll_bitmask", c_params.coll_bitmask, writeDefaults);
+      SET_VALUE("coll_category", c_params.coll_category, writeDefaults);
       SET_VALUE("rolling_friction", c_params.rolling_friction, writeDefaults);
       SET_VALUE("rolling_friction2", c_params.rolling_friction2, writeDefaults);
       SET_VALUE("spinning_friction", c_params.spinning_friction, writeDefaults);
+      SET_VALUE("contact_material", c_params.contact_material, writeDefaults);
       if(c_params.friction_direction1) {
         vectorToConfigItem((*config)["cfdir1"],
                            c_params.friction_direction1);
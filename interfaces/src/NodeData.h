@@ -111,6 +111,24 @@ namespace mars {
 
       static NodeType typeFromString(const std::string& str);
 
+      /**
+       * @brief returns the collision bits for a named collision group
+       *
+       * Every new group name gets the next free bit. Numbers are
+       * returned as given and "all" enables all non-sensor bits.
+       * The 16th bit is reserved for sensors (COLLIDE_MASK_SENSOR).
+       *
+       * @param group the name of the collision group or a number
+       * @return the collision bits, 0 if no bit is left for a new group
+       */
+      static int collisionGroupBits(const std::string &group);
+
+      /**
+       * @brief forgets the named collision groups, called when all nodes
+       * of the scene are removed
+       */
+      static void clearCollisionGroups();
+
       /**
        * @brief initialize the nodestruct for a primitive type
        *
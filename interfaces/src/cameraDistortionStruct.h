@@ -0,0 +1,64 @@
+/*
+ *  Copyright 2017, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef MARS_INTERFACES_CAMERA_DISTORTION_STRUCT_H
+#define MARS_INTERFACES_CAMERA_DISTORTION_STRUCT_H
+
+#include <vector>
+
+namespace mars {
+
+  namespace interfaces {
+
+    enum CameraDistortionModel {
+      DISTORTION_NONE,
+      /**
+       * Brown-Conrady model with the coefficients in OpenCV order
+       * (k1, k2, p1, p2[, k3[, k4, k5, k6]]), i.e. "plumb_bob" and
+       * "rational_polynomial" of ROS camera_info.
+       */
+      DISTORTION_BROWN_CONRADY,
+      /**
+       * equidistant fisheye model of OpenCV with the coefficients
+       * (k1, k2, k3, k4), i.e. "equidistant" of ROS camera_info.
+       */
+      DISTORTION_FISHEYE
+    };
+
+    /**
+     * The intrinsic calibration of a distorted camera. The values are
+     * given in pixels of the calibrated image size and are scaled to
+     * the size of the rendered image.
+     */
+    struct cameraDistortionStruct {
+      cameraDistortionStruct() : model(DISTORTION_NONE), width(0), height(0),
+                                 fx(0.0), fy(0.0), cx(0.0), cy(0.0) {}
+
+      CameraDistortionModel model;
+      int width, height;
+      double fx, fy, cx, cy;
+      std::vector<double> coefficients;
+    }; // end of struct cameraDistortionStruct
+
+  } // end of namespace interfaces
+
+} // end of namespace mars
+
+#endif /* MARS_INTERFACES_CAMERA_DISTORTION_STRUCT_H */
@@ -24,6 +24,9 @@
 #include "MARSDefs.h"
 #include <mars/utils/Vector.h>
 
+#include <string>
+#include <vector>
+
 namespace mars {
   namespace interfaces {
 
@@ -40,10 +43,13 @@ namespace mars {
         bounce = bounce_vel = 0;
         approx_pyramid = 1;
         coll_bitmask = 65535;
+        coll_category = -1;
+        coll_exclude.clear();
         depth_correction = 0.0;
         rolling_friction = 0.0;
         rolling_friction2 = 0.0;
         spinning_friction = 0.0;
+        contact_material.clear();
       }
 
       contact_params(){
@@ -58,9 +64,31 @@ namespace mars {
       sReal fds1, fds2;
       sReal bounce, bounce_vel;
       bool approx_pyramid;
+      /**
+       * The collide bits of the geom (the categories it wants to collide
+       * with). A pair of geoms only creates contacts if the category of each
+       * geom matches the bitmask of the other one.
+       */
       int coll_bitmask;
+      /**
+       * The category bits of the geom. If the value is negative the
+       * coll_bitmask is used as category as well (legacy behaviour).
+       */
+      int coll_category;
+      /**
+       * Sorted ids of nodes this node never creates contacts with. The list
+       * is checked before the narrow phase collision test.
+       */
+      std::vector<NodeId> coll_exclude;
       sReal depth_correction;
       sReal rolling_friction, rolling_friction2, spinning_friction;
+      /**
+       * Name of a contact material defined via
+       * PhysicsInterface::setContactMaterials. If set, the surface
+       * parameters of a contact are taken from the precomputed material
+       * pair table instead of being combined from the values above.
+       */
+      std::string contact_material;
     }; // end of struct contact_params
 
   } // end of namespace interfaces
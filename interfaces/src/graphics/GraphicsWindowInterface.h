@@ -34,6 +34,7 @@
 
 #include "GraphicsCameraInterface.h"
 #include "GraphicsEventInterface.h"
+#include "../cameraDistortionStruct.h"
 #include <mars/utils/Color.h>
 
 namespace osg{
@@ -87,6 +88,12 @@ namespace mars {
       virtual void setHUDViewOffsets(double x1, double y1,
                                      double x2, double y2) = 0;
       virtual void setupDistortion(double factor) = 0;
+      /**
+       * Renders the image of the window through the lens model of the
+       * given calibration. The frustum of the camera is adapted to cover
+       * the field of view of the distorted image.
+       */
+      virtual void setupDistortion(const cameraDistortionStruct &distortion) = 0;
 
     }; // end of class GraphicsWindowInterface
 
@@ -0,0 +1,66 @@
+/*
+ *  Copyright 2017, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef CABLE_INTERFACE_H
+#define CABLE_INTERFACE_H
+
+#ifdef _PRINT_HEADER_
+  #warning "CableInterface.h"
+#endif
+
+#include "NodeInterface.h"
+
+#include <configmaps/ConfigData.h>
+#include <vector>
+
+namespace mars {
+  namespace interfaces {
+
+    /**
+     * The physical representation of a cable or tether between two
+     * nodes. Each end can also be fixed to a world point or hang free.
+     */
+    class CableInterface {
+    public:
+      virtual ~CableInterface() {}
+      /**
+       * Creates the cable from its config. node1 and node2 are the nodes
+       * of the start and the end anchor, or 0 if that end is not attached
+       * to a node.
+       */
+      virtual bool createCable(const configmaps::ConfigMap &config,
+                               NodeInterface *node1,
+                               NodeInterface *node2) = 0;
+      virtual void setWorldObject(PhysicsInterface *world) = 0;
+      //! the length the winch moves to with its maximal speed
+      virtual void setTargetLength(sReal length) = 0;
+      virtual sReal getTargetLength(void) const = 0;
+      //! the current unstretched length of the cable
+      virtual sReal getLength(void) const = 0;
+      //! the tension at the start and the end of the cable in N
+      virtual void getTension(sReal *start, sReal *end) const = 0;
+      virtual sReal getMaxTension(void) const = 0;
+      virtual void getPoints(std::vector<utils::Vector> *points) const = 0;
+    };
+
+  } // end of namespace interfaces
+} // end of namespace mars
+
+#endif  // CABLE_INTERFACE_H
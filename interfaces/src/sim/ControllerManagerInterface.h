@@ -175,6 +175,12 @@ namespace mars {
        */
       virtual void updateControllers(double calc_ms) = 0;
 
+      /**
+       * \brief Pauses or resumes the update of a controller, e.g. while
+       * its entity is inactive. See SensorManagerInterface::setSensorActive.
+       */
+      virtual void setControllerActive(unsigned long id, bool active) = 0;
+
       /**
        * \brief Resets the data of all controllers.
        */
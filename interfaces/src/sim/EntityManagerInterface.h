@@ -32,6 +32,8 @@
 #include <string>
 #include <vector>
 #include <configmaps/ConfigData.h>
+#include <mars/utils/Vector.h>
+#include "../MARSDefs.h"
 
 namespace mars {
 
@@ -43,6 +45,13 @@ namespace mars {
 
     class EntitySubscriberInterface;
 
+    /**the dynamics levels of detail of an entity, see sim::EntityLOD*/
+    enum DynamicsLevel {
+      DYNAMICS_FULL = 0,
+      DYNAMICS_RIGID,
+      DYNAMICS_KINEMATIC
+    };
+
     class EntityManagerInterface
     {
     public:
@@ -127,6 +136,33 @@ namespace mars {
       virtual void printEntityControllers(const std::string &entityName) = 0;
       virtual void resetPose() = 0;
 
+      /**adds a sphere in which the entities are simulated with full
+       * dynamics; if nodeId is given the center is relative to the node
+       * and moves with it; returns the id of the region
+       */
+      virtual unsigned long addInterestRegion(const utils::Vector &center,
+                                              sReal radius,
+                                              unsigned long nodeId=0) = 0;
+      virtual void removeInterestRegion(unsigned long id) = 0;
+
+      /**fixes the dynamics level of the entity, a negative level selects
+       * the level by the distance to the interest regions again; returns
+       * false if the entity has no "lod" config or can't be reduced
+       */
+      virtual bool setDynamicsLevel(const std::string &entityName, int level) = 0;
+      virtual int getDynamicsLevel(const std::string &entityName) = 0;
+
+      /**sets the forward speed and turn rate of the reduced model of an
+       * entity without drive config
+       */
+      virtual void setBaseVelocity(const std::string &entityName,
+                                   sReal linear, sReal angular) = 0;
+
+      /**switches the levels of the entities and applies the drive
+       * commands of the reduced ones; called before each physics step
+       */
+      virtual void updateDynamicsLevels() = 0;
+
     };
 
   } // end of namespace interfaces
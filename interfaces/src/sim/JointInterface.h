@@ -76,6 +76,18 @@ namespace mars {
       virtual void setHighStop(sReal lowStop) = 0;
       virtual void setLowStop2(sReal lowStop) = 0;
       virtual void setHighStop2(sReal lowStop) = 0;
+      /**
+       * Sets the constraint force mixing of the velocity motor. With a cfm
+       * the motor acts as implicit damper towards its velocity. A cfm <= 0
+       * restores the cfm of the joint configuration.
+       */
+      virtual void setMotorCFM(sReal cfm) = 0;
+      virtual void setMotorCFM2(sReal cfm) = 0;
+      /**
+       * Enables or disables the joint without destroying it. A disabled
+       * joint does not constrain its bodies.
+       */
+      virtual void setActive(bool active) = 0;
     };
 
   } // end of namespace interfaces
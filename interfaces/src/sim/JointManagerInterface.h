@@ -130,6 +130,13 @@ namespace mars {
        */
       virtual void updateJoints(sReal calc_ms) = 0;
 
+      /**
+       * \brief Publishes the read-only view of the joint list used by
+       * the lookups of other threads. Called by the simulator at the
+       * end of every step.
+       */
+      virtual void publishSnapshot() = 0;
+
       /**
        * \brief Removes all joints from the simulation to clear the world.
        */
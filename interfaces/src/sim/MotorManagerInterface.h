@@ -250,6 +250,13 @@ namespace mars {
        */
       virtual void deactivateMotor(unsigned long id) = 0;
 
+      /**
+       * \brief Publishes the read-only view of the motor list used by
+       * the lookups of other threads. Called by the simulator at the
+       * end of every step.
+       */
+      virtual void publishSnapshot() = 0;
+
       /**
        * \brief Destroys all motors in the simulation.
        *
@@ -71,16 +71,48 @@ namespace mars {
       virtual void addTorque(const utils::Vector &t) = 0;
       virtual bool getGroundContact(void) const = 0;
       virtual void getContactPoints(std::vector<utils::Vector> *contact_points) const = 0;
+      /**
+       * \brief Returns the contact points of the last step that have a
+       * force feedback together with the force acting on this node.
+       */
+      virtual void getContactForces(std::vector<utils::Vector> *contact_points,
+                                    std::vector<utils::Vector> *forces) const = 0;
       virtual void getContactIDs(std::list<interfaces::NodeId> *ids) const = 0;
       virtual sReal getGroundContactForce(void) const = 0;
       virtual void setContactParams(contact_params &c_params) = 0;
       virtual void addSensor(BaseSensor *s_cfg) = 0;
       virtual void removeSensor(BaseSensor *s_cfg) = 0;
+      //! An inactive sensor casts no rays in handleSensorData().
+      virtual void setSensorActive(BaseSensor *s_cfg, bool active) = 0;
       virtual void handleSensorData(bool physics_thread = true) = 0;
       virtual void destroyNode(void) = 0;
       virtual void getMass(sReal *mass, sReal *inertia=0) const = 0;
       virtual const utils::Vector getContactForce(void) const = 0;
       virtual sReal getCollisionDepth(void) const = 0;
+      /**
+       * Enables or disables the node in the physics without destroying
+       * it. An inactive node neither moves nor collides.
+       */
+      virtual void setActive(bool active) = 0;
+      /**
+       * Sets the pose a kinematic node reaches at the end of the next
+       * physics step. Overrides its trajectory until the trajectory is
+       * set again. Has no effect on dynamic nodes.
+       */
+      virtual void setKinematicTarget(const utils::Vector &pos,
+                                      const utils::Quaternion &rot) = 0;
+      /**
+       * Carries the geom of the node rigidly on the body of \a carrier
+       * and disables the own body, its mass is added to the carrier.
+       * With 0 the own body takes over the pose and velocity of the geom
+       * again. Returns false if the node can't be carried.
+       */
+      virtual bool setCarrier(NodeInterface *carrier) = 0;
+      /**
+       * Makes the body kinematic, it keeps its velocity but ignores
+       * forces and contacts. With \a collide false the geom is disabled.
+       */
+      virtual void setKinematicBody(bool kinematic, bool collide) = 0;
     };
 
   } // end of namespace interfaces
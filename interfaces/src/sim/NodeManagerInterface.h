@@ -556,6 +556,13 @@ namespace mars {
        */
       virtual void updateDynamicNodes(sReal calc_ms, bool physics_thread=true) = 0;
 
+      /**
+       * \brief Publishes the read-only view of the node list used by
+       * the lookups of other threads. Called by the simulator at the
+       * end of every step.
+       */
+      virtual void publishSnapshot() = 0;
+
       /**
        * \brief This function destroys all nodes within the simulation.
        *
@@ -612,6 +619,22 @@ namespace mars {
        */
       virtual const contact_params getContactParams(NodeId id) const = 0;
 
+      /**
+       * \brief Sets the ids of the nodes a certain node never creates
+       * contacts with.
+       *
+       * The list is stored in the contact parameters of the node and is
+       * kept for the reload of the simulation. It is checked before the
+       * narrow phase collision test. Use the same list for both directions
+       * to get a symmetric exclusion.
+       *
+       * \param id The id of the node to edit.
+       * \param ids The ids of the nodes to exclude from collision.
+       * \sa contact_params::coll_exclude
+       */
+      virtual void setCollisionExclusions(NodeId id,
+                                          const std::vector<NodeId> &ids) = 0;
+
       /**
        * \brief Sets the linear velocity of a node.
        *
@@ -754,6 +777,15 @@ namespace mars {
       /** \todo write docs */
       virtual const utils::Vector getContactForce(NodeId id) const = 0;
 
+      /**
+       * \brief Fills the contact points of the node from the last step
+       * and the contact force acting on the node at each of these
+       * points. Contacts without force feedback are left out.
+       */
+      virtual void getContactForces(NodeId id,
+                                    std::vector<utils::Vector> *contact_points,
+                                    std::vector<utils::Vector> *forces) const = 0;
+
       /**
        * Retrieve the id of a node by name
        * \param node_name Name of the node to get the id for
@@ -790,6 +822,20 @@ namespace mars {
 
       virtual bool getIsMovable(NodeId id) const = 0;
       virtual void setIsMovable(NodeId id, bool isMovable) = 0;
+
+      /**
+       * \brief Deactivates a node without removing it from the simulation.
+       *
+       * The physics body and geom are disabled, the draw objects are
+       * hidden and the node is no longer updated. Reactivating the node
+       * is much cheaper than creating it again, which is used for
+       * pooled entities.
+       *
+       * \param id The id of the node.
+       * \param active \c false to deactivate the node.
+       */
+      virtual void setNodeActive(NodeId id, bool active) = 0;
+      virtual bool isNodeActive(NodeId id) const = 0;
       virtual void lock() = 0;
       virtual void unlock() = 0;
 
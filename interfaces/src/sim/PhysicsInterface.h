@@ -34,6 +34,7 @@
 #include "../MARSDefs.h"
 
 #include <mars/utils/Vector.h>
+#include <configmaps/ConfigData.h>
 
 #include <vector>
 
@@ -67,6 +68,18 @@ namespace mars {
       virtual const utils::Vector getCenterOfMass(const std::vector<NodeInterface*> &nodes) const = 0;
       virtual int checkCollisions(void) = 0;
       virtual sReal getVectorCollision(const utils::Vector &pos, const utils::Vector &ray) const = 0;
+      /**
+       * \brief Defines or updates named contact materials, the combine rules
+       * and explicit material pair overrides. The contact parameters of
+       * all material pairs are precomputed into a table that is used for
+       * geoms with a "contact_material".
+       */
+      virtual void setContactMaterials(configmaps::ConfigMap &config) = 0;
+      /**
+       * \brief Sets the density, the current and the surface height of the
+       * fluid that acts on the nodes with a "fluid" section.
+       */
+      virtual void setFluid(configmaps::ConfigMap &config) = 0;
     };
 
   } // end of namespace interfaces
@@ -34,6 +34,8 @@
 
 #include <mars/interfaces/MARSDefs.h> // for sReal
 
+#include <set>
+#include <sstream>
 #include <string>
 
 namespace mars {
@@ -41,6 +43,53 @@ namespace mars {
 
     class ControlCenter;
 
+    /**
+     * The data a plugin reads and writes in its update call. Plugins
+     * that declare their dependencies can be updated concurrently with
+     * all other plugins they don't conflict with. Two plugins conflict if
+     * one writes anything the other one reads or writes.
+     *
+     * The dependencies are only used to order the update calls; the
+     * manager interfaces stay thread safe on their own.
+     */
+    struct PluginDependencies {
+      std::set<std::string> reads, writes;
+
+      void readNode(unsigned long id) {reads.insert(key("nodes", id));}
+      void writeNode(unsigned long id) {writes.insert(key("nodes", id));}
+      void readMotor(unsigned long id) {reads.insert(key("motors", id));}
+      void writeMotor(unsigned long id) {writes.insert(key("motors", id));}
+      void readDataBroker(const std::string &groupName) {
+        reads.insert("data_broker/" + groupName);
+      }
+      void writeDataBroker(const std::string &groupName) {
+        writes.insert("data_broker/" + groupName);
+      }
+
+      bool conflicts(const PluginDependencies &other) const {
+        return intersects(writes, other.writes) ||
+          intersects(writes, other.reads) || intersects(reads, other.writes);
+      }
+
+    private:
+      static std::string key(const char *type, unsigned long id) {
+        std::stringstream s;
+        s << type << "/" << id;
+        return s.str();
+      }
+
+      static bool intersects(const std::set<std::string> &a,
+                             const std::set<std::string> &b) {
+        std::set<std::string>::const_iterator it = a.begin(), jt = b.begin();
+        while(it != a.end() && jt != b.end()) {
+          if(*it < *jt) ++it;
+          else if(*jt < *it) ++jt;
+          else return true;
+        }
+        return false;
+      }
+    };
+
     /**
      * The interface to load plugin dynamically into the simulation
      *
@@ -55,6 +104,15 @@ namespace mars {
       virtual void handleError(void) {};
       virtual void getSomeData(void* data) {(void)data;};
 
+      /**
+       * \brief Declares the data used in update(). Plugins returning
+       * \c false are updated alone, in the order they were added.
+       */
+      virtual bool getDependencies(PluginDependencies *deps) const {
+        (void)deps;
+        return false;
+      }
+
     protected:
       ControlCenter *control;
 
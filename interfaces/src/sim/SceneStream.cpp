@@ -0,0 +1,337 @@
+/*
+ *  Copyright 2017, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "SceneStream.h"
+
+#include <cmath>
+#include <cstring>
+
+namespace mars {
+  namespace interfaces {
+
+    using namespace utils;
+
+    static const int valuesPerNode = 7;
+    // scale of the smallest three quaternion components in [-1/sqrt(2), 1/sqrt(2)]
+    static const double rotationScale = 32767.0*M_SQRT2;
+
+    static void writeVarint(uint64_t value, std::string *out) {
+      while(value >= 0x80) {
+        out->push_back((char)((value & 0x7f) | 0x80));
+        value >>= 7;
+      }
+      out->push_back((char)value);
+    }
+
+    static void writeSigned(int64_t value, std::string *out) {
+      writeVarint(((uint64_t)value << 1) ^ (uint64_t)(value >> 63), out);
+    }
+
+    static void writeDouble(double value, std::string *out) {
+      uint64_t bits;
+      memcpy(&bits, &value, sizeof(bits));
+      for(int i=0; i<8; ++i) out->push_back((char)(bits >> (8*i)));
+    }
+
+    // bounds checked reading of a payload
+    struct StreamReader {
+      const unsigned char *data;
+      size_t size, pos;
+      bool ok;
+
+      StreamReader(const char *d, size_t s) :
+        data((const unsigned char*)d), size(s), pos(0), ok(true) {}
+
+      uint64_t varint() {
+        uint64_t value = 0;
+        for(int shift=0; shift<64; shift+=7) {
+          if(pos >= size) break;
+          unsigned char b = data[pos++];
+          value |= (uint64_t)(b & 0x7f) << shift;
+          if(!(b & 0x80)) return value;
+        }
+        ok = false;
+        return 0;
+      }
+
+      int64_t signedVarint() {
+        uint64_t v = varint();
+        return (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+      }
+
+      double real() {
+        if(pos+8 > size) {
+          ok = false;
+          return 0.0;
+        }
+        uint64_t bits = 0;
+        for(int i=0; i<8; ++i) bits |= (uint64_t)data[pos++] << (8*i);
+        double value;
+        memcpy(&value, &bits, sizeof(value));
+        return value;
+      }
+
+      unsigned char byte() {
+        if(pos >= size) {
+          ok = false;
+          return 0;
+        }
+        return data[pos++];
+      }
+    };
+
+    static int32_t quantize(double value, double step) {
+      return (int32_t)floor(value/step + 0.5);
+    }
+
+    static void quantizeRotation(const Quaternion &q, int32_t *out) {
+      double c[4] = {q.x(), q.y(), q.z(), q.w()};
+      int largest = 0;
+      for(int i=1; i<4; ++i) {
+        if(fabs(c[i]) > fabs(c[largest])) largest = i;
+      }
+      double sign = c[largest] < 0 ? -1.0 : 1.0;
+      out[0] = largest;
+      for(int i=0, k=1; i<4; ++i) {
+        if(i != largest) out[k++] = quantize(sign*c[i], 1.0/rotationScale);
+      }
+    }
+
+    static Quaternion dequantizeRotation(const int32_t *in) {
+      double c[4];
+      double sum = 0.0;
+      int largest = in[0] & 3;
+      for(int i=0, k=1; i<4; ++i) {
+        if(i == largest) continue;
+        c[i] = in[k++]/rotationScale;
+        sum += c[i]*c[i];
+      }
+      c[largest] = sum < 1.0 ? sqrt(1.0-sum) : 0.0;
+      Quaternion q(c[3], c[0], c[1], c[2]);
+      q.normalize();
+      return q;
+    }
+
+    void sceneStreamMessage(SceneStreamMessage type, const std::string &payload,
+                            std::string *message) {
+      uint32_t length = payload.size()+1;
+      for(int i=3; i>=0; --i) message->push_back((char)(length >> (8*i)));
+      message->push_back((char)type);
+      message->append(payload);
+    }
+
+    SceneStreamEncoder::SceneStreamEncoder(double positionStep,
+                                           double jointStep) :
+      positionStep(positionStep), jointStep(jointStep), hasFrame(false),
+      frame(0), time(0.0) {
+    }
+
+    void SceneStreamEncoder::reset() {
+      hasFrame = false;
+    }
+
+    void SceneStreamEncoder::encodeLines(const SceneStreamState &state) {
+      lines.clear();
+      writeVarint(state.lines.size(), &lines);
+      for(size_t i=0; i<state.lines.size(); ++i) {
+        const SceneStreamLine &line = state.lines[i];
+        for(int k=0; k<3; ++k) writeSigned(quantize(line.start[k], positionStep), &lines);
+        for(int k=0; k<3; ++k) writeSigned(quantize(line.end[k], positionStep), &lines);
+        lines.append((const char*)line.color, 3);
+      }
+    }
+
+    void SceneStreamEncoder::encodeHeader(std::string *payload,
+                                          bool keyframe) const {
+      writeVarint(frame, payload);
+      writeDouble(time, payload);
+      if(keyframe) {
+        writeDouble(positionStep, payload);
+        writeDouble(jointStep, payload);
+      }
+      writeVarint(nodeValues.size()/valuesPerNode, payload);
+      writeVarint(jointValues.size(), payload);
+    }
+
+    void SceneStreamEncoder::encodeFrame(const SceneStreamState &state,
+                                         std::string *message) {
+      const size_t nodeCount = state.positions.size();
+      newNodeValues.resize(nodeCount*valuesPerNode);
+      for(size_t i=0; i<nodeCount; ++i) {
+        int32_t *v = &newNodeValues[i*valuesPerNode];
+        for(int k=0; k<3; ++k) v[k] = quantize(state.positions[i][k], positionStep);
+        quantizeRotation(state.rotations[i], v+3);
+      }
+      newJointValues.resize(state.jointValues.size());
+      for(size_t i=0; i<state.jointValues.size(); ++i) {
+        newJointValues[i] = quantize(state.jointValues[i], jointStep);
+      }
+      encodeLines(state);
+      ++frame;
+      time = state.time;
+
+      bool keyframe = !hasFrame || newNodeValues.size() != nodeValues.size() ||
+        newJointValues.size() != jointValues.size();
+      if(keyframe) {
+        nodeValues.swap(newNodeValues);
+        jointValues.swap(newJointValues);
+        hasFrame = true;
+        encodeKeyframe(message);
+        return;
+      }
+
+      std::string payload;
+      encodeHeader(&payload, false);
+      // bit masks of the changed nodes and joints followed by the changes
+      size_t maskPos = payload.size();
+      payload.append((nodeCount+7)/8, 0);
+      for(size_t i=0; i<nodeCount; ++i) {
+        const int32_t *v = &newNodeValues[i*valuesPerNode];
+        int32_t *old = &nodeValues[i*valuesPerNode];
+        if(memcmp(v, old, valuesPerNode*sizeof(int32_t)) == 0) continue;
+        payload[maskPos+i/8] |= (char)(1 << (i%8));
+        for(int k=0; k<valuesPerNode; ++k) {
+          writeSigned((int64_t)v[k]-old[k], &payload);
+          old[k] = v[k];
+        }
+      }
+      const size_t jointCount = newJointValues.size();
+      maskPos = payload.size();
+      payload.append((jointCount+7)/8, 0);
+      for(size_t i=0; i<jointCount; ++i) {
+        if(newJointValues[i] == jointValues[i]) continue;
+        payload[maskPos+i/8] |= (char)(1 << (i%8));
+        writeSigned((int64_t)newJointValues[i]-jointValues[i], &payload);
+        jointValues[i] = newJointValues[i];
+      }
+      payload.append(lines);
+      sceneStreamMessage(SCENE_STREAM_DELTA, payload, message);
+    }
+
+    void SceneStreamEncoder::encodeKeyframe(std::string *message) const {
+      std::string payload;
+      encodeHeader(&payload, true);
+      for(size_t i=0; i<nodeValues.size(); ++i) {
+        writeSigned(nodeValues[i], &payload);
+      }
+      for(size_t i=0; i<jointValues.size(); ++i) {
+        writeSigned(jointValues[i], &payload);
+      }
+      payload.append(lines);
+      sceneStreamMessage(SCENE_STREAM_KEYFRAME, payload, message);
+    }
+
+    SceneStreamDecoder::SceneStreamDecoder() :
+      positionStep(0.0001), jointStep(0.00001), hasKeyframe(false) {
+    }
+
+    bool SceneStreamDecoder::decode(const char *data, size_t size,
+                                    SceneStreamState *state) {
+      if(size < 1) return false;
+      const unsigned char type = data[0];
+      if(type != SCENE_STREAM_KEYFRAME && type != SCENE_STREAM_DELTA) {
+        return false;
+      }
+      const bool keyframe = type == SCENE_STREAM_KEYFRAME;
+      if(!keyframe && !hasKeyframe) return false;
+
+      StreamReader reader(data+1, size-1);
+      reader.varint();
+      double time = reader.real();
+      if(keyframe) {
+        positionStep = reader.real();
+        jointStep = reader.real();
+      }
+      size_t nodeCount = reader.varint();
+      size_t jointCount = reader.varint();
+      // every node and joint needs at least one bit
+      if(!reader.ok || nodeCount > 8*size || jointCount > 8*size) return false;
+
+      if(keyframe) {
+        nodeValues.resize(nodeCount*valuesPerNode);
+        jointValues.resize(jointCount);
+        for(size_t i=0; i<nodeValues.size(); ++i) {
+          nodeValues[i] = reader.signedVarint();
+        }
+        for(size_t i=0; i<jointCount; ++i) {
+          jointValues[i] = reader.signedVarint();
+        }
+      }
+      else {
+        if(nodeCount*valuesPerNode != nodeValues.size() ||
+           jointCount != jointValues.size()) {
+          return false;
+        }
+        size_t maskPos = reader.pos;
+        reader.pos += (nodeCount+7)/8;
+        for(size_t i=0; i<nodeCount && reader.ok; ++i) {
+          if(maskPos+i/8 >= reader.size) reader.ok = false;
+          else if(reader.data[maskPos+i/8] & (1 << (i%8))) {
+            for(int k=0; k<valuesPerNode; ++k) {
+              nodeValues[i*valuesPerNode+k] += reader.signedVarint();
+            }
+          }
+        }
+        maskPos = reader.pos;
+        reader.pos += (jointCount+7)/8;
+        for(size_t i=0; i<jointCount && reader.ok; ++i) {
+          if(maskPos+i/8 >= reader.size) reader.ok = false;
+          else if(reader.data[maskPos+i/8] & (1 << (i%8))) {
+            jointValues[i] += reader.signedVarint();
+          }
+        }
+      }
+
+      size_t lineCount = reader.varint();
+      if(!reader.ok || lineCount > size) {
+        hasKeyframe = false;
+        return false;
+      }
+      state->lines.resize(lineCount);
+      for(size_t i=0; i<lineCount; ++i) {
+        SceneStreamLine &line = state->lines[i];
+        for(int k=0; k<3; ++k) line.start[k] = reader.signedVarint()*positionStep;
+        for(int k=0; k<3; ++k) line.end[k] = reader.signedVarint()*positionStep;
+        for(int k=0; k<3; ++k) line.color[k] = reader.byte();
+      }
+      if(!reader.ok) {
+        // the state of a broken delta can't be trusted anymore
+        hasKeyframe = false;
+        return false;
+      }
+      hasKeyframe = true;
+
+      state->time = time;
+      state->positions.resize(nodeCount);
+      state->rotations.resize(nodeCount);
+      for(size_t i=0; i<nodeCount; ++i) {
+        const int32_t *v = &nodeValues[i*valuesPerNode];
+        state->positions[i] = Vector(v[0], v[1], v[2])*positionStep;
+        state->rotations[i] = dequantizeRotation(v+3);
+      }
+      state->jointValues.resize(jointCount);
+      for(size_t i=0; i<jointCount; ++i) {
+        state->jointValues[i] = jointValues[i]*jointStep;
+      }
+      return true;
+    }
+
+  } // end of namespace interfaces
+} // end of namespace mars
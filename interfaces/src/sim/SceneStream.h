@@ -0,0 +1,134 @@
+/*
+ *  Copyright 2017, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * \file SceneStream.h
+ * \brief Wire format to stream the state of a running simulation to
+ *        remote viewers.
+ */
+
+#ifndef MARS_INTERFACES_SCENE_STREAM_H
+#define MARS_INTERFACES_SCENE_STREAM_H
+
+#ifdef _PRINT_HEADER_
+  #warning "SceneStream.h"
+#endif
+
+#include <mars/utils/Vector.h>
+#include <mars/utils/Quaternion.h>
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+namespace mars {
+  namespace interfaces {
+
+    /**
+     * Every message is sent as 32 bit length (big endian) of the rest of
+     * the message, one byte message type and the payload. A viewer first
+     * gets the scene as yaml text, followed by a keyframe and delta frames.
+     * The order of the nodes and joints in the frames is the order of the
+     * "nodelist" and "jointlist" of the scene.
+     */
+    enum SceneStreamMessage {
+      SCENE_STREAM_SCENE = 1,
+      SCENE_STREAM_KEYFRAME,
+      SCENE_STREAM_DELTA
+    };
+
+    struct SceneStreamLine {
+      utils::Vector start, end;
+      unsigned char color[3];
+    };
+
+    struct SceneStreamState {
+      double time;
+      std::vector<utils::Vector> positions;
+      std::vector<utils::Quaternion> rotations;
+      std::vector<double> jointValues;
+      std::vector<SceneStreamLine> lines;
+    };
+
+    //! appends the header and \a payload of a message to \a message
+    void sceneStreamMessage(SceneStreamMessage type, const std::string &payload,
+                            std::string *message);
+
+    /**
+     * Quantises the positions (\c positionStep), the orientations (smallest
+     * three components with 16 bit) and the joint values (\c jointStep) and
+     * encodes the changes to the last frame with variable length integers.
+     * Unchanged nodes cost one bit per frame.
+     */
+    class SceneStreamEncoder {
+    public:
+      explicit SceneStreamEncoder(double positionStep=0.0001,
+                                  double jointStep=0.00001);
+
+      //! the next frame will be a keyframe
+      void reset();
+
+      /**
+       * \brief Encodes \a state as delta to the last frame. A keyframe is
+       * created for the first frame and if the number of nodes or joints
+       * changed.
+       */
+      void encodeFrame(const SceneStreamState &state, std::string *message);
+
+      //! keyframe of the last encoded frame for viewers that join
+      void encodeKeyframe(std::string *message) const;
+
+    private:
+      double positionStep, jointStep;
+      bool hasFrame;
+      uint64_t frame;
+      double time;
+      // 7 values per node: position, largest component and smallest three
+      std::vector<int32_t> nodeValues, newNodeValues;
+      std::vector<int32_t> jointValues, newJointValues;
+      std::string lines;
+
+      void encodeLines(const SceneStreamState &state);
+      void encodeHeader(std::string *payload, bool keyframe) const;
+    };
+
+    /**
+     * Applies the keyframes and delta frames to a SceneStreamState.
+     */
+    class SceneStreamDecoder {
+    public:
+      SceneStreamDecoder();
+
+      /**
+       * \brief Decodes a keyframe or delta message without the length.
+       * Returns false for invalid data or a delta without keyframe.
+       */
+      bool decode(const char *data, size_t size, SceneStreamState *state);
+
+    private:
+      double positionStep, jointStep;
+      bool hasKeyframe;
+      std::vector<int32_t> nodeValues, jointValues;
+    };
+
+  } // end of namespace interfaces
+} // end of namespace mars
+
+#endif // MARS_INTERFACES_SCENE_STREAM_H
@@ -170,6 +170,13 @@ namespace mars {
        */
       virtual int getSensorCount() const = 0;
 
+      /**
+       * \brief Publishes the read-only view of the sensor list used by
+       * the lookups of other threads. Called by the simulator at the
+       * end of every step.
+       */
+      virtual void publishSnapshot() = 0;
+
       /**
        * \brief Destroys all sensors in the simulation.
        *
@@ -189,6 +196,21 @@ namespace mars {
        */
       virtual void reloadSensors(void) = 0;
 
+      /**
+       * \brief Feeds the current output of all sensors with a "filter"
+       * entry in their config into their filter stages. Called once per
+       * simulation step; getSensorData returns the filtered values for
+       * these sensors.
+       */
+      virtual void updateSensors(sReal calc_ms) = 0;
+
+      /**
+       * \brief Pauses or resumes the filter and the physics rays of a
+       * sensor, e.g. while its entity waits in a pool. See
+       * NodeManagerInterface::setNodeActive.
+       */
+      virtual void setSensorActive(unsigned long id, bool active) = 0;
+
       /**
        * Adds an sensor to the known sensors list
        */
@@ -73,6 +73,15 @@ namespace mars {
       virtual void disconnectNodes(unsigned long id1, unsigned long id2) = 0;
       virtual void rescaleEnvironment(sReal x, sReal y, sReal z) = 0;
 
+      // cables
+      /**
+       * \brief Adds a cable between two nodes, see CablePhysics for the
+       * config. Returns the id of the cable or 0 on failure.
+       */
+      virtual unsigned long addCable(const configmaps::ConfigMap &config) = 0;
+      virtual void removeCable(unsigned long id) = 0;
+      virtual void setCableLength(unsigned long id, sReal length) = 0;
+
       // scenes
       virtual int loadScene(const std::string &filename, const std::string &robotname, bool threadsave=false, bool blocking=false) = 0;
       virtual int loadScene(const std::string &filename, bool wasrunning=false,
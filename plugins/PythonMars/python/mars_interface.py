@@ -170,3 +170,24 @@ def editGraphics(key, value):
 
 def editGraphicsWindow(winid, key, value):
     edit("graphics", str(winid), key, value)
+
+def requestKinematics(entity, jacobians=[]):
+    global iDict
+    iDict["request"].append({"type": "Kinematics", "name": entity,
+                             "jacobians": list(jacobians)})
+
+def ikTarget(link, pos, rot=None):
+    target = {"link": link, "pos": [float(v) for v in pos]}
+    if rot is not None:
+        target["rot"] = [float(v) for v in rot]
+    return target
+
+def solveIK(entity, targets, apply=False, iterations=100, damping=0.05,
+            tolerance=1e-4):
+    global iDict
+    if not "solveIK" in iDict:
+        iDict["solveIK"] = {}
+    iDict["solveIK"][entity] = {"targets": targets, "apply": apply,
+                                "iterations": iterations,
+                                "damping": float(damping),
+                                "tolerance": float(tolerance)}
@@ -30,13 +30,17 @@
 #include "PythonMars.h"
 #include <mars/data_broker/DataBrokerInterface.h>
 #include <mars/interfaces/sim/MotorManagerInterface.h>
+#include <mars/interfaces/MotorData.h>
 #include <mars/interfaces/sim/SensorManagerInterface.h>
 #include <mars/interfaces/sim/NodeManagerInterface.h>
 #include <mars/interfaces/sim/JointManagerInterface.h>
+#include <mars/interfaces/sim/EntityManagerInterface.h>
 #include <mars/interfaces/graphics/GraphicsManagerInterface.h>
 #include <mars/data_broker/DataPackage.h>
 #include <mars/sim/CameraSensor.h>
 #include <mars/sim/SimNode.h>
+#include <mars/sim/SimEntity.h>
+#include <mars/sim/EntityKinematics.h>
 #include <mars/app/MARS.h>
 #include <mars/utils/misc.h>
 #ifdef __unix__
@@ -366,6 +370,14 @@ namespace mars {
             }
           }
 
+          if(map.hasKey("solveIK")) {
+            for(auto it: (ConfigMap&)(map["solveIK"])) {
+              solveIK(it.first, it.second);
+            }
+            ConfigMap::iterator iit = map.find("solveIK");
+            map.erase(iit);
+          }
+
           if(map.hasKey("request") && map["request"].isVector()) {
             requestMap = map["request"];
             ConfigMap::iterator it = map.find("request");
@@ -380,6 +392,56 @@ namespace mars {
         nextStep = true;
       }
 
+      void PythonMars::solveIK(const std::string &entityName,
+                               ConfigMap &config) {
+        sim::SimEntity *entity = control->entities->getEntity(entityName);
+        if(!entity) return;
+        sim::EntityKinematics *kinematics = entity->getKinematics();
+        if(!kinematics) return;
+        std::vector<sim::IKTarget> targets;
+        for(auto it: (ConfigVector&)config["targets"]) {
+          sim::IKTarget target;
+          target.nodeId = entity->getNode((std::string)it["link"]);
+          target.position = Vector((double)it["pos"][0], (double)it["pos"][1],
+                                   (double)it["pos"][2]);
+          if(it.hasKey("rot")) {
+            target.rotation = Quaternion((double)it["rot"][3],
+                                         (double)it["rot"][0],
+                                         (double)it["rot"][1],
+                                         (double)it["rot"][2]);
+            target.useRotation = true;
+          }
+          targets.push_back(target);
+        }
+        int iterations = config.get("iterations", 100);
+        double damping = config.get("damping", 0.05);
+        double tolerance = config.get("tolerance", 1e-4);
+        std::vector<sReal> q;
+        sReal error;
+        kinematics->update();
+        bool converged = kinematics->solveIK(targets, &q, iterations, damping,
+                                             tolerance, &error);
+        std::vector<unsigned long> jointIds = kinematics->getJointIds();
+        ConfigMap &result = ikResults[entityName];
+        result["converged"] = converged;
+        result["error"] = error;
+        for(size_t i=0; i<q.size() && i<jointIds.size(); ++i) {
+          result["joints"][entity->getJoint(jointIds[i])] = q[i];
+        }
+        if(!config.get("apply", false) || q.size() != jointIds.size()) return;
+        std::vector<core_objects_exchange> motorList;
+        control->motors->getListMotors(&motorList);
+        for(size_t i=0; i<motorList.size(); ++i) {
+          MotorData motor = control->motors->getFullMotor(motorList[i].index);
+          for(size_t j=0; j<jointIds.size(); ++j) {
+            if(motor.jointIndex == jointIds[j]) {
+              control->motors->setMotorValue(motor.index, q[j]);
+              break;
+            }
+          }
+        }
+      }
+
       void PythonMars::interpreteGuiMaps() {
         if(!control->graphics) return;
         guiMapMutex.lock();
@@ -579,6 +641,7 @@ namespace mars {
       void PythonMars::reset() {
         motorMap.clear();
         nodeMap.clear();
+        ikResults.clear();
         //plugin->reload();
         try {
           ConfigItem map;
@@ -656,6 +719,51 @@ namespace mars {
               if(num) free(data);
             }
 
+            if(type == "Kinematics") {
+              sim::SimEntity *entity = control->entities->getEntity(name);
+              if(!entity) continue;
+              sim::EntityKinematics *kinematics = entity->getKinematics();
+              if(!kinematics) continue;
+              kinematics->update();
+              std::map<unsigned long, Vector> positions;
+              std::map<unsigned long, Quaternion> rotations;
+              kinematics->getLinkPoses(&positions, &rotations);
+              ConfigMap &kMap = sendMap["Kinematics"][name];
+              for(auto pit: positions) {
+                ConfigMap &link = kMap["links"][entity->getNode(pit.first)];
+                const Quaternion &rot = rotations[pit.first];
+                link["pos"]["x"] = pit.second.x();
+                link["pos"]["y"] = pit.second.y();
+                link["pos"]["z"] = pit.second.z();
+                link["rot"]["x"] = rot.x();
+                link["rot"]["y"] = rot.y();
+                link["rot"]["z"] = rot.z();
+                link["rot"]["w"] = rot.w();
+              }
+              std::vector<unsigned long> jointIds = kinematics->getJointIds();
+              std::vector<sReal> q;
+              kinematics->getJointPositions(&q);
+              for(size_t i=0; i<jointIds.size(); ++i) {
+                kMap["joints"][i]["name"] = entity->getJoint(jointIds[i]);
+                kMap["joints"][i]["position"] = q[i];
+              }
+              if(it->hasKey("jacobians")) {
+                std::vector<std::string> names;
+                std::vector<unsigned long> ids;
+                for(auto jit: (ConfigVector&)(*it)["jacobians"]) {
+                  names.push_back((std::string)jit);
+                  ids.push_back(entity->getNode(names.back()));
+                }
+                std::vector<std::vector<sReal> > jacobians;
+                kinematics->getJacobians(ids, &jacobians);
+                for(size_t i=0; i<names.size(); ++i) {
+                  for(size_t k=0; k<jacobians[i].size(); ++k) {
+                    kMap["jacobians"][names[i]][k] = jacobians[i][k];
+                  }
+                }
+              }
+            }
+
             if(type == "Config") {
               if(!it->hasKey("group")) continue;
               std::string group = (*it)["group"];
@@ -696,6 +804,10 @@ namespace mars {
             }
 
           }
+          if(!ikResults.empty()) {
+            sendMap["IK"] = ikResults;
+            ikResults.clear();
+          }
           try {
             iMap = ConfigItem();
             mutexCamera.lock();
@@ -102,6 +102,8 @@ namespace mars {
 
         void interpreteMap(configmaps::ConfigItem &map);
         void interpreteGuiMaps();
+        void solveIK(const std::string &entityName,
+                     configmaps::ConfigMap &config);
 
         // DataBrokerReceiver methods
         virtual void receiveData(const data_broker::DataInfo &info,
@@ -122,6 +124,7 @@ namespace mars {
         shared_ptr<Module> plugin;
         std::map<std::string, unsigned long> motorMap, nodeMap;
         configmaps::ConfigItem requestMap;
+        configmaps::ConfigMap ikResults;
         bool pythonException;
         std::map<std::string, PointStruct> points;
         std::map<std::string, LineStruct> lines;
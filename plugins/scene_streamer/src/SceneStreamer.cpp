@@ -0,0 +1,337 @@
+/*
+ *  Copyright 2017, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * \file SceneStreamer.cpp
+ * \brief Streams the state of the running simulation to remote viewers.
+ *
+ * Version 0.1
+ */
+
+
+#include "SceneStreamer.h"
+#include <mars/interfaces/sim/NodeManagerInterface.h>
+#include <mars/interfaces/sim/JointManagerInterface.h>
+#include <mars/interfaces/sim/SimulatorInterface.h>
+#include <mars/interfaces/sim/PhysicsInterface.h>
+#include <mars/interfaces/graphics/draw_structs.h>
+#include <mars/interfaces/NodeData.h>
+#include <mars/interfaces/JointData.h>
+#include <mars/interfaces/Logging.hpp>
+#include <mars/sim/SimJoint.h>
+#include <mars/utils/MutexLocker.h>
+
+namespace mars {
+  namespace plugins {
+    namespace scene_streamer {
+
+      using namespace mars::utils;
+      using namespace mars::interfaces;
+
+      // frames that may wait for a slow viewer before they are dropped
+      static const size_t maxQueuedFrames = 8;
+
+      SceneStreamViewer::SceneStreamViewer(TCPConnection *connection) :
+        connection(connection), closed(false), keyframeRequested(false) {
+      }
+
+      SceneStreamViewer::~SceneStreamViewer() {
+        close();
+        if(wait(1000)) wait();
+        else cancel(true);
+        connection->close();
+        delete connection;
+      }
+
+      void SceneStreamViewer::sendScene(const std::string &message) {
+        MutexLocker locker(&mutex);
+        frames.clear();
+        scene = message;
+        keyframeRequested = false;
+        condition.wakeAll();
+      }
+
+      void SceneStreamViewer::sendFrame(const std::string &message) {
+        MutexLocker locker(&mutex);
+        if(closed) return;
+        if(frames.size() >= maxQueuedFrames) {
+          frames.clear();
+          keyframeRequested = true;
+          return;
+        }
+        frames.push_back(message);
+        condition.wakeAll();
+      }
+
+      bool SceneStreamViewer::takeKeyframeRequest() {
+        MutexLocker locker(&mutex);
+        bool requested = keyframeRequested;
+        keyframeRequested = false;
+        return requested;
+      }
+
+      bool SceneStreamViewer::isClosed() {
+        MutexLocker locker(&mutex);
+        return closed;
+      }
+
+      void SceneStreamViewer::close() {
+        MutexLocker locker(&mutex);
+        closed = true;
+        condition.wakeAll();
+      }
+
+      void SceneStreamViewer::run() {
+        std::string message;
+        while(true) {
+          mutex.lock();
+          while(!closed && scene.empty() && frames.empty()) {
+            condition.wait(&mutex);
+          }
+          if(closed) {
+            mutex.unlock();
+            return;
+          }
+          if(!scene.empty()) {
+            message.swap(scene);
+            scene.clear();
+          }
+          else {
+            message.swap(frames.front());
+            frames.pop_front();
+          }
+          mutex.unlock();
+
+          // the viewer closed the connection
+          if(connection->sendAll(message) != SOCKET_SUCCESS) {
+            close();
+            return;
+          }
+        }
+      }
+
+      SceneStreamer::SceneStreamer(lib_manager::LibManager *theManager)
+        : MarsPluginTemplate(theManager, "SceneStreamer"),
+          pendingConnection(NULL), simTime(0.0), timeSinceFrame(0.0) {
+      }
+
+      void SceneStreamer::init() {
+        if(control->cfg) {
+          cfgPort = control->cfg->getOrCreateProperty("SceneStreamer", "port",
+                                                      5757, this);
+          cfgUpdateTime = control->cfg->getOrCreateProperty("SceneStreamer",
+                                                            "update ms",
+                                                            40.0, this);
+          cfgContacts = control->cfg->getOrCreateProperty("SceneStreamer",
+                                                          "stream contacts",
+                                                          false, this);
+        }
+        else {
+          cfgPort.iValue = 5757;
+          cfgUpdateTime.dValue = 40.0;
+          cfgContacts.bValue = false;
+        }
+
+        if(server.open(cfgPort.iValue) != SOCKET_SUCCESS) {
+          LOG_ERROR("SceneStreamer: can not open port %d", cfgPort.iValue);
+          return;
+        }
+        start();
+        LOG_INFO("SceneStreamer: waiting for viewers on port %d",
+                 cfgPort.iValue);
+      }
+
+      void SceneStreamer::run() {
+        while(true) {
+          pendingConnection = new TCPConnection();
+          if(server.acceptConnection(pendingConnection) != SOCKET_SUCCESS) {
+            delete pendingConnection;
+            pendingConnection = NULL;
+            msleep(100);
+            continue;
+          }
+          SceneStreamViewer *viewer = new SceneStreamViewer(pendingConnection);
+          pendingConnection = NULL;
+          viewer->start();
+          MutexLocker locker(&viewerMutex);
+          newViewers.push_back(viewer);
+        }
+      }
+
+      void SceneStreamer::reset() {
+        // the scene is created again for the next frame
+        sceneMessage.clear();
+      }
+
+      SceneStreamer::~SceneStreamer() {
+        if(server.isOpen()) {
+          cancel(true);
+          server.close();
+        }
+        delete pendingConnection;
+        MutexLocker locker(&viewerMutex);
+        for(size_t i=0; i<viewers.size(); ++i) delete viewers[i];
+        for(size_t i=0; i<newViewers.size(); ++i) delete newViewers[i];
+      }
+
+      void SceneStreamer::removeClosedViewers() {
+        std::vector<SceneStreamViewer*>::iterator it = viewers.begin();
+        while(it != viewers.end()) {
+          if((*it)->isClosed()) {
+            delete *it;
+            it = viewers.erase(it);
+          }
+          else ++it;
+        }
+      }
+
+      bool SceneStreamer::sceneChanged(const std::vector<sim::SimJoint*> &joints) const {
+        if(sceneMessage.empty() || nodeList.size() != nodeIds.size() ||
+           joints.size() != jointIds.size()) {
+          return true;
+        }
+        for(size_t i=0; i<nodeList.size(); ++i) {
+          if(nodeList[i].index != nodeIds[i]) return true;
+        }
+        for(size_t i=0; i<joints.size(); ++i) {
+          if(joints[i]->getIndex() != jointIds[i]) return true;
+        }
+        return false;
+      }
+
+      void SceneStreamer::createScene(const std::vector<sim::SimJoint*> &joints) {
+        configmaps::ConfigMap scene;
+        nodeIds.resize(nodeList.size());
+        for(size_t i=0; i<nodeList.size(); ++i) {
+          nodeIds[i] = nodeList[i].index;
+          NodeData node = control->nodes->getFullNode(nodeIds[i]);
+          configmaps::ConfigMap map, material;
+          node.toConfigMap(&map);
+          node.material.toConfigMap(&material);
+          map["material_data"] = material;
+          scene["nodelist"].push_back(map);
+        }
+        jointIds.resize(joints.size());
+        for(size_t i=0; i<joints.size(); ++i) {
+          jointIds[i] = joints[i]->getIndex();
+          JointData joint = joints[i]->getSJoint();
+          configmaps::ConfigMap map;
+          joint.toConfigMap(&map);
+          scene["jointlist"].push_back(map);
+        }
+        sceneMessage.clear();
+        sceneStreamMessage(SCENE_STREAM_SCENE, scene.toYamlString(),
+                           &sceneMessage);
+      }
+
+      void SceneStreamer::collectContacts() {
+        state.lines.clear();
+        if(!cfgContacts.bValue) return;
+        // the contact lines are only created while the contacts are drawn
+        DrawInterface *draw = dynamic_cast<DrawInterface*>(control->sim->getPhysics());
+        if(!draw) return;
+        std::vector<draw_item> items;
+        draw->update(&items);
+        for(size_t i=0; i<items.size(); ++i) {
+          if(items[i].type != DRAW_LINE) continue;
+          SceneStreamLine line;
+          line.start = items[i].start;
+          line.end = items[i].end;
+          line.color[0] = (unsigned char)(items[i].myColor.r*255);
+          line.color[1] = (unsigned char)(items[i].myColor.g*255);
+          line.color[2] = (unsigned char)(items[i].myColor.b*255);
+          state.lines.push_back(line);
+        }
+      }
+
+      void SceneStreamer::update(sReal time_ms) {
+        simTime += time_ms;
+        std::vector<SceneStreamViewer*> joined;
+        {
+          MutexLocker locker(&viewerMutex);
+          joined.swap(newViewers);
+        }
+        removeClosedViewers();
+        // nothing is serialised as long as nobody is watching
+        if(viewers.empty() && joined.empty()) return;
+
+        timeSinceFrame += time_ms;
+        if(joined.empty() && timeSinceFrame < cfgUpdateTime.dValue) return;
+        timeSinceFrame = 0.0;
+
+        control->nodes->getListNodes(&nodeList);
+        std::vector<sim::SimJoint*> joints = control->joints->getSimJoints();
+        bool newScene = sceneChanged(joints);
+        if(newScene) {
+          createScene(joints);
+          encoder.reset();
+        }
+
+        state.time = simTime*0.001;
+        state.positions.resize(nodeList.size());
+        state.rotations.resize(nodeList.size());
+        for(size_t i=0; i<nodeList.size(); ++i) {
+          const core_objects_exchange &node = nodeList[i];
+          state.positions[i] = node.pos + node.rot*node.visOffsetPos;
+          state.rotations[i] = node.rot*node.visOffsetRot;
+        }
+        state.jointValues.resize(joints.size());
+        for(size_t i=0; i<joints.size(); ++i) {
+          state.jointValues[i] = joints[i]->getPosition();
+        }
+        collectContacts();
+
+        // one serialisation pass for all viewers
+        std::string frame, keyframe;
+        encoder.encodeFrame(state, &frame);
+        for(size_t i=0; i<viewers.size(); ++i) {
+          if(newScene) viewers[i]->sendScene(sceneMessage);
+          if(viewers[i]->takeKeyframeRequest()) {
+            if(keyframe.empty()) encoder.encodeKeyframe(&keyframe);
+            viewers[i]->sendFrame(keyframe);
+          }
+          else viewers[i]->sendFrame(frame);
+        }
+        if(!joined.empty()) {
+          if(keyframe.empty()) encoder.encodeKeyframe(&keyframe);
+          for(size_t i=0; i<joined.size(); ++i) {
+            joined[i]->sendScene(sceneMessage);
+            joined[i]->sendFrame(keyframe);
+            viewers.push_back(joined[i]);
+          }
+        }
+      }
+
+      void SceneStreamer::cfgUpdateProperty(cfg_manager::cfgPropertyStruct _property) {
+
+        if(_property.paramId == cfgUpdateTime.paramId) {
+          cfgUpdateTime.dValue = _property.dValue;
+        }
+        else if(_property.paramId == cfgContacts.paramId) {
+          cfgContacts.bValue = _property.bValue;
+        }
+      }
+
+    } // end of namespace scene_streamer
+  } // end of namespace plugins
+} // end of namespace mars
+
+DESTROY_LIB(mars::plugins::scene_streamer::SceneStreamer);
+CREATE_LIB(mars::plugins::scene_streamer::SceneStreamer);
@@ -0,0 +1,141 @@
+/*
+ *  Copyright 2017, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * \file SceneStreamer.h
+ * \brief Streams the state of the running simulation to remote viewers.
+ *
+ * Version 0.1
+ */
+
+#ifndef MARS_PLUGINS_SCENE_STREAMER_H
+#define MARS_PLUGINS_SCENE_STREAMER_H
+
+#ifdef _PRINT_HEADER_
+  #warning "SceneStreamer.h"
+#endif
+
+#include <mars/interfaces/sim/MarsPluginTemplate.h>
+#include <mars/interfaces/MARSDefs.h>
+#include <mars/interfaces/core_objects_exchange.h>
+#include <mars/interfaces/sim/SceneStream.h>
+#include <mars/cfg_manager/CFGManagerInterface.h>
+
+#include <mars/utils/Thread.h>
+#include <mars/utils/Mutex.h>
+#include <mars/utils/WaitCondition.h>
+#include <mars/utils/Socket.h>
+
+#include <deque>
+#include <string>
+#include <vector>
+
+namespace mars {
+
+  namespace sim {
+    class SimJoint;
+  }
+
+  namespace plugins {
+    namespace scene_streamer {
+
+      /**
+       * Sends the queued messages to one viewer. The simulation never waits
+       * for a viewer, if a viewer can't keep up its queued frames are
+       * dropped and it gets a keyframe instead of the next delta.
+       */
+      class SceneStreamViewer : public mars::utils::Thread {
+      public:
+        explicit SceneStreamViewer(mars::utils::TCPConnection *connection);
+        ~SceneStreamViewer();
+
+        //! replaces all queued messages by a new scene description
+        void sendScene(const std::string &message);
+        void sendFrame(const std::string &message);
+        //! returns true once after frames were dropped
+        bool takeKeyframeRequest();
+        bool isClosed();
+        void close();
+
+      protected:
+        void run();
+
+      private:
+        mars::utils::TCPConnection *connection;
+        mars::utils::Mutex mutex;
+        mars::utils::WaitCondition condition;
+        std::string scene;
+        std::deque<std::string> frames;
+        bool closed, keyframeRequested;
+      };
+
+      class SceneStreamer: public mars::interfaces::MarsPluginTemplate,
+        public mars::cfg_manager::CFGClient,
+        public mars::utils::Thread {
+
+      public:
+        SceneStreamer(lib_manager::LibManager *theManager);
+        ~SceneStreamer();
+
+        // LibInterface methods
+        int getLibVersion() const
+        { return 1; }
+        const std::string getLibName() const
+        { return std::string("scene_streamer"); }
+        CREATE_MODULE_INFO();
+
+        // MarsPlugin methods
+        void init();
+        void reset();
+        void update(mars::interfaces::sReal time_ms);
+
+        // CFGClient methods
+        virtual void cfgUpdateProperty(cfg_manager::cfgPropertyStruct _property);
+
+      protected:
+        //! accepts the connections of new viewers
+        void run();
+
+      private:
+        cfg_manager::cfgPropertyStruct cfgPort, cfgUpdateTime, cfgContacts;
+        mars::utils::TCPServer server;
+        mars::utils::TCPConnection *pendingConnection;
+        mars::utils::Mutex viewerMutex;
+        std::vector<SceneStreamViewer*> newViewers, viewers;
+
+        mars::interfaces::SceneStreamEncoder encoder;
+        mars::interfaces::SceneStreamState state;
+        std::vector<mars::interfaces::core_objects_exchange> nodeList;
+        std::vector<unsigned long> nodeIds, jointIds;
+        std::string sceneMessage;
+        double simTime, timeSinceFrame;
+
+        bool sceneChanged(const std::vector<sim::SimJoint*> &joints) const;
+        void createScene(const std::vector<sim::SimJoint*> &joints);
+        void collectContacts();
+        void removeClosedViewers();
+
+      }; // end of class definition SceneStreamer
+
+    } // end of namespace scene_streamer
+  } // end of namespace plugins
+} // end of namespace mars
+
+#endif // MARS_PLUGINS_SCENE_STREAMER_H
@@ -19,7 +19,6 @@
  */
 
 #include "Load.h"
-#include "zipit.h"
 
 
 #include <QtXml>
@@ -38,6 +37,7 @@
 #include <mars/interfaces/sim/EntityManagerInterface.h>
 #include <mars/interfaces/sim/LoadSceneInterface.h>
 #include <mars/utils/misc.h>
+#include <mars/utils/ArchiveFileSystem.h>
 #include <mars/interfaces/Logging.hpp>
 
 //#define DEBUG_PARSE 1
@@ -76,13 +76,14 @@ namespace mars {
         control->entities->addEntity(mRobotName);
       }
 
-      // need to unzip into a temporary directory
+      // the archive is read in place, its content is addressed as
+      // sub directory of the archive file
       if (mFileSuffix == ".scn" || mFileSuffix == ".zip") {
-        if(unzip(tmpPath, mFileName) == 0)
+        if(mountArchive(mFileName) == 0)
           return 0;
+        tmpPath = mFileName + "/";
       }
       else {
-        // can parse file without unzipping
         tmpPath = utils::getPathOfFile(mFileName);
       }
 
@@ -105,15 +106,15 @@ namespace mars {
       return 1;
     }
 
-    unsigned int Load::unzip(const std::string& destinationDir,
-                             const std::string& zipFilename) {
-      if(!utils::createDirectory(destinationDir)) return 0;
-
-      Zipit myZipFile(zipFilename);
-      LOG_INFO("Load: unzipping scene: %s", zipFilename.c_str());
-
-      if (!myZipFile.unpackWholeZipTo(destinationDir)) return 0;
-
+    unsigned int Load::mountArchive(const std::string& zipFilename) {
+      LOG_INFO("Load: mounting scene archive: %s", zipFilename.c_str());
+      // the archive stays mounted, meshes and textures of the scene are
+      // loaded later on by the graphics and may be reloaded on reset
+      if(!utils::mountArchive(zipFilename)) {
+        LOG_ERROR("Load: could not open scene archive: %s",
+                  zipFilename.c_str());
+        return 0;
+      }
       return 1;
     }
 
@@ -126,15 +127,13 @@ namespace mars {
       QString xmlErrorMsg="";
       int xmlErrorLine, xmlErrorCol =0;
 
-      //creating a handle for the xmlfile
-      QFile file(sceneFilename.c_str());
-
       QLocale::setDefault(QLocale::C);
 
       LOG_INFO("Load: loading scene: %s", sceneFilename.c_str());
 
-      //test to open the xmlfile
-      if (!file.open(QIODevice::ReadOnly)) {
+      //read the xmlfile, either from disk or from the scene archive
+      std::string content;
+      if (!utils::readVirtualFile(sceneFilename, &content)) {
         std::cout<<"Error while opening scene file content "
                  << sceneFilename << " in Load.cpp->parseScene"
                  << std::endl;
@@ -146,9 +145,8 @@ namespace mars {
 
       //test to pass the content from the xmlfile to the DOM-Object
       QDomDocument doc;
-      if (!doc.setContent(&file, false, &xmlErrorMsg,
-                          &xmlErrorLine, &xmlErrorCol)) {
-        file.close();
+      if (!doc.setContent(QByteArray(content.data(), (int)content.size()),
+                          false, &xmlErrorMsg, &xmlErrorLine, &xmlErrorCol)) {
         std::cout<<"error passing the file content in->Load.cpp->parseScene"
                  <<std::endl;
         std::cout<<"Message: "<<xmlErrorMsg.toStdString()<<"\n"<<"Line: "
@@ -220,8 +218,6 @@ namespace mars {
         getGenericConfig(&graphicList, xmlnodelist.at(0).toElement());
       }
 
-      file.close();
-
       return 1;
     }
 
@@ -229,7 +225,17 @@ namespace mars {
       LOG_INFO("Load: loading scene: %s", sceneFilename.c_str());
       configmaps::ConfigMap map;
       configmaps::ConfigVector::iterator it;
-      map = configmaps::ConfigMap::fromYamlFile(sceneFilename, true);
+      if(utils::isArchivePath(sceneFilename)) {
+        std::string content;
+        if(!utils::readVirtualFile(sceneFilename, &content)) {
+          LOG_ERROR("Load: could not read scene: %s", sceneFilename.c_str());
+          return 0;
+        }
+        map = configmaps::ConfigMap::fromYamlString(content);
+      }
+      else {
+        map = configmaps::ConfigMap::fromYamlFile(sceneFilename, true);
+      }
 
       for(it=map["nodelist"].begin(); it!=map["nodelist"].end(); ++it) {
         nodeList.push_back(*it);
@@ -386,6 +392,8 @@ namespace mars {
 
     BaseSensor* Load::loadSensor(configmaps::ConfigMap config) {
       config["mapIndex"] = mapIndex;
+      // the sensors resolve their file references against the scene path
+      config["filePrefix"] = tmpPath;
       unsigned long sceneID = config["index"];
       BaseSensor *sensor = control->sensors->createAndAddSensor(&config);
       if (sensor != 0) {
@@ -513,36 +521,19 @@ namespace mars {
     }
 
     void Load::checkEncodings(){
-        bool existing = true;
+        // parsed from memory, the scene directory may be a read only
+        // archive
         QString str("<xml><easter_egg>3.1418</easter_egg></xml>");
-        QString tmpFilename = QString(tmpPath.c_str()) + QString("mars-encoding-check");
-        QFile tmpFile(tmpFilename);
-        if(!QFile::exists(tmpFilename)){
-            tmpFile.open(QIODevice::WriteOnly);
-            QTextStream out(&tmpFile);
-            out << str;
-            tmpFile.close();
-            existing = false;
-        }
-        if(!tmpFile.open(QIODevice::ReadOnly)){
-            LOG_FATAL("Cannot open language checking file\n");
-            exit(-1);
-        }
         QDomDocument doc;
-        if(!doc.setContent(&tmpFile, false)){
+        if(!doc.setContent(str, false)){
             LOG_FATAL("Cannot parse language checking file\n");
             exit(-2);
         }
         QDomElement root = doc.documentElement();
-        QDomElement tmpElement;
         if(root.elementsByTagName(QString("easter_egg")).at(0).toElement().text().toDouble() != 3.1418){
             LOG_ERROR("Encoding of the system is invalid, therefore Scene loading will fail quitting here to prevent errors later");
             exit(-3);
         }
-        tmpFile.close();
-        if(!existing){
-           tmpFile.remove();
-        }
     }
 
   } // end of namespace scene_loader
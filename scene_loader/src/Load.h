@@ -68,8 +68,7 @@ namespace mars {
       unsigned long groupIDOffset;
       bool useYAML;
 
-      unsigned int unzip(const std::string& destinationDir,
-                         const std::string& zipFilename);
+      unsigned int mountArchive(const std::string& zipFilename);
 
       void getGenericConfig(std::vector<configmaps::ConfigMap> *configList,
                             const QDomElement &elementNode);
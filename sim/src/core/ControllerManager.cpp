@@ -124,6 +124,7 @@ namespace mars {
       if (iter != simController.end()) {
         tmpController = iter->second;
         simController.erase(iter);
+        inactiveControllers.erase(index);
         if (tmpController)
           delete tmpController;
       }
@@ -264,8 +265,18 @@ namespace mars {
       MutexLocker locker(&iMutex);
 
       map<unsigned long, Controller*>::iterator iter;
-      for(iter = simController.begin(); iter != simController.end(); iter++)
+      for(iter = simController.begin(); iter != simController.end(); iter++) {
+        if(inactiveControllers.count(iter->first)) continue;
         iter->second->update(calc_ms);
+      }
+    }
+
+    void ControllerManager::setControllerActive(unsigned long id, bool active) {
+      MutexLocker locker(&iMutex);
+      if(active) inactiveControllers.erase(id);
+      else if(simController.find(id) != simController.end()) {
+        inactiveControllers.insert(id);
+      }
     }
 
 
@@ -299,6 +310,7 @@ namespace mars {
         delete iter->second;
         simController.clear();
       */
+      inactiveControllers.clear();
       next_controller_id = 1;
     }
 
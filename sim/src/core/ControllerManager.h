@@ -44,6 +44,8 @@
 #include <mars/interfaces/sim/ControllerManagerInterface.h>
 #include <mars/utils/Mutex.h>
 
+#include <set>
+
 namespace mars {
   namespace sim {
 
@@ -182,6 +184,8 @@ namespace mars {
        */
       virtual void updateControllers(interfaces::sReal calc_ms);
 
+      virtual void setControllerActive(unsigned long id, bool active);
+
       /**
        * \brief Resets the data of all controllers.
        */
@@ -249,6 +253,9 @@ namespace mars {
       //! a containter holding all controllers in the simulation
       std::map<unsigned long, Controller*> simController;
 
+      //! the controllers that are not updated
+      std::set<unsigned long> inactiveControllers;
+
       //! a pointer to the control center
       interfaces::ControlCenter *control;
 
@@ -0,0 +1,459 @@
+/*
+ *  Copyright 2011, 2012, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "EntityKinematics.h"
+#include "SimEntity.h"
+#include "SimNode.h"
+#include "SimJoint.h"
+
+#include <mars/interfaces/NodeData.h>
+#include <mars/interfaces/JointData.h>
+#include <mars/interfaces/sim/ControlCenter.h>
+#include <mars/interfaces/sim/NodeManagerInterface.h>
+#include <mars/interfaces/sim/JointManagerInterface.h>
+#include <mars/utils/MutexLocker.h>
+#include <mars/interfaces/Logging.hpp>
+
+#include <Eigen/Cholesky>
+#include <cmath>
+
+namespace mars {
+  namespace sim {
+
+    using namespace utils;
+    using namespace interfaces;
+
+    EntityKinematics::EntityKinematics(ControlCenter *control,
+                                       SimEntity *entity)
+      : control(control), entity(entity) {
+    }
+
+    EntityKinematics::~EntityKinematics() {
+    }
+
+    bool EntityKinematics::build() {
+      MutexLocker locker(&iMutex);
+      links.clear();
+      linkIndex.clear();
+      dofJoints.clear();
+      jointPositions.clear();
+      linkStates.clear();
+      if(!control || !entity) return false;
+
+      // collect the nodes and the joints connecting two nodes of the entity
+      std::map<unsigned long, std::string> nodes = entity->getAllNodes();
+      std::map<unsigned long, std::string> joints = entity->getAllJoints();
+      std::map<unsigned long, SimNode*> simNodes;
+      std::map<unsigned long, int> groups;
+      for(std::map<unsigned long, std::string>::iterator it = nodes.begin();
+          it != nodes.end(); ++it) {
+        SimNode *node = control->nodes->getSimNode(it->first);
+        if(!node) continue;
+        simNodes[it->first] = node;
+        groups[it->first] = control->nodes->getFullNode(it->first).groupID;
+      }
+      if(simNodes.empty()) return false;
+
+      // child node -> joint attaching it to its parent
+      std::map<unsigned long, SimJoint*> parentJoint;
+      std::multimap<unsigned long, unsigned long> children;
+      for(std::map<unsigned long, std::string>::iterator it = joints.begin();
+          it != joints.end(); ++it) {
+        SimJoint *joint = control->joints->getSimJoint(it->first);
+        if(!joint) continue;
+        unsigned long id1 = joint->getNodeId(1);
+        unsigned long id2 = joint->getNodeId(2);
+        if(simNodes.find(id1) == simNodes.end() ||
+           simNodes.find(id2) == simNodes.end()) continue;
+        if(parentJoint.find(id2) != parentJoint.end()) {
+          LOG_WARN("EntityKinematics: node %lu of \"%s\" has more than one parent joint; loop closures are ignored",
+                   id2, entity->getName().c_str());
+          continue;
+        }
+        parentJoint[id2] = joint;
+        children.insert(std::make_pair(id1, id2));
+      }
+
+      // nodes of one group are rigidly attached to the first group member
+      // that has a parent joint (or to the member with the smallest id)
+      std::map<int, unsigned long> groupHead;
+      for(std::map<unsigned long, int>::iterator it = groups.begin();
+          it != groups.end(); ++it) {
+        if(it->second <= 0) continue;
+        std::map<int, unsigned long>::iterator head = groupHead.find(it->second);
+        if(head == groupHead.end()) {
+          groupHead[it->second] = it->first;
+        }
+        else if(parentJoint.find(head->second) == parentJoint.end() &&
+                parentJoint.find(it->first) != parentJoint.end()) {
+          head->second = it->first;
+        }
+      }
+      std::map<unsigned long, unsigned long> groupParent;
+      for(std::map<unsigned long, int>::iterator it = groups.begin();
+          it != groups.end(); ++it) {
+        if(it->second <= 0) continue;
+        if(parentJoint.find(it->first) != parentJoint.end()) continue;
+        unsigned long head = groupHead[it->second];
+        if(head == it->first) continue;
+        groupParent[it->first] = head;
+        children.insert(std::make_pair(head, it->first));
+      }
+
+      // breadth first from the roots, so that parents precede children
+      std::vector<unsigned long> order;
+      for(std::map<unsigned long, SimNode*>::iterator it = simNodes.begin();
+          it != simNodes.end(); ++it) {
+        if(parentJoint.find(it->first) == parentJoint.end() &&
+           groupParent.find(it->first) == groupParent.end()) {
+          order.push_back(it->first);
+        }
+      }
+      for(size_t i = 0; i < order.size(); ++i) {
+        std::pair<std::multimap<unsigned long, unsigned long>::iterator,
+                  std::multimap<unsigned long, unsigned long>::iterator> range;
+        range = children.equal_range(order[i]);
+        for(; range.first != range.second; ++range.first) {
+          order.push_back(range.first->second);
+        }
+      }
+      if(order.size() != simNodes.size()) {
+        LOG_WARN("EntityKinematics: joint tree of \"%s\" contains a cycle; unreachable nodes are ignored",
+                 entity->getName().c_str());
+      }
+
+      std::vector<sReal> q;
+      std::vector<Vector> pos(order.size());
+      std::vector<Quaternion> rot(order.size());
+      std::vector<Vector> anchor(order.size());
+      std::vector<Vector> axis(order.size());
+      links.resize(order.size());
+      control->nodes->lock();
+      for(size_t i = 0; i < order.size(); ++i) {
+        Link &link = links[i];
+        link.nodeId = order[i];
+        link.node = simNodes[order[i]];
+        link.parent = -1;
+        link.dof = -1;
+        link.type = JOINT_TYPE_FIXED;
+        link.joint = NULL;
+        link.lowerLimit = link.upperLimit = 0.0;
+        linkIndex[order[i]] = (int)i;
+        pos[i] = link.node->getPosition();
+        rot[i] = link.node->getRotation();
+
+        std::map<unsigned long, SimJoint*>::iterator pj = parentJoint.find(order[i]);
+        if(pj != parentJoint.end()) {
+          link.joint = pj->second;
+          link.parent = linkIndex[link.joint->getNodeId(1)];
+          link.type = link.joint->getJointType();
+          anchor[i] = link.joint->getAnchor();
+          axis[i] = link.joint->getAxis(1);
+          if(link.type == JOINT_TYPE_HINGE || link.type == JOINT_TYPE_SLIDER) {
+            link.dof = (int)dofJoints.size();
+            dofJoints.push_back(link.joint->getIndex());
+            q.push_back(link.joint->getPosition(1));
+            link.lowerLimit = link.joint->getLowerLimit(1);
+            link.upperLimit = link.joint->getUpperLimit(1);
+          }
+          else if(link.type != JOINT_TYPE_FIXED) {
+            LOG_WARN("EntityKinematics: joint type %d of \"%s\" is handled as fixed",
+                     (int)link.type, entity->getName().c_str());
+            link.type = JOINT_TYPE_FIXED;
+          }
+        }
+        else if(groupParent.find(order[i]) != groupParent.end()) {
+          link.parent = linkIndex[groupParent[order[i]]];
+        }
+      }
+      control->nodes->unlock();
+
+      // express anchors, axes and link offsets in the parent frames and
+      // move the links back to joint position zero
+      for(size_t i = 0; i < links.size(); ++i) {
+        Link &link = links[i];
+        if(link.parent < 0) continue;
+        Quaternion parentInv = rot[link.parent].inverse();
+        Vector relPos = parentInv * (pos[i] - pos[link.parent]);
+        Quaternion relRot = parentInv * rot[i];
+        link.anchor = parentInv * (anchor[i] - pos[link.parent]);
+        // the physics measures the position of the first node relative to
+        // the second one, the child therefore moves against the axis
+        link.axis = -(parentInv * axis[i]);
+        if(link.axis.norm() > 0.0) link.axis.normalize();
+        link.offsetPos = relPos;
+        link.offsetRot = relRot;
+        if(link.dof < 0) continue;
+        if(link.type == JOINT_TYPE_HINGE) {
+          Quaternion back(Eigen::AngleAxisd(-q[link.dof], link.axis));
+          link.offsetPos = link.anchor + back * (relPos - link.anchor);
+          link.offsetRot = back * relRot;
+        }
+        else {
+          link.offsetPos = relPos - link.axis * q[link.dof];
+        }
+      }
+      jointPositions = q;
+      linkStates.resize(links.size());
+      for(size_t i = 0; i < links.size(); ++i) {
+        linkStates[i].pos = pos[i];
+        linkStates[i].rot = rot[i];
+      }
+      computeLinkStates(jointPositions, &linkStates);
+      return true;
+    }
+
+    bool EntityKinematics::isValid() const {
+      MutexLocker locker(&iMutex);
+      return !links.empty();
+    }
+
+    void EntityKinematics::update() {
+      MutexLocker locker(&iMutex);
+      if(links.empty()) return;
+      control->nodes->lock();
+      for(size_t i = 0; i < links.size(); ++i) {
+        const Link &link = links[i];
+        if(link.parent < 0) {
+          linkStates[i].pos = link.node->getPosition();
+          linkStates[i].rot = link.node->getRotation();
+        }
+        if(link.dof >= 0) {
+          jointPositions[link.dof] = link.joint->getPosition(1);
+        }
+      }
+      control->nodes->unlock();
+      computeLinkStates(jointPositions, &linkStates);
+    }
+
+    size_t EntityKinematics::getDOFCount() const {
+      MutexLocker locker(&iMutex);
+      return dofJoints.size();
+    }
+
+    std::vector<unsigned long> EntityKinematics::getJointIds() const {
+      MutexLocker locker(&iMutex);
+      return dofJoints;
+    }
+
+    void EntityKinematics::getJointPositions(std::vector<sReal> *q) const {
+      MutexLocker locker(&iMutex);
+      *q = jointPositions;
+    }
+
+    void EntityKinematics::setJointPositions(const std::vector<sReal> &q) {
+      MutexLocker locker(&iMutex);
+      if(q.size() != jointPositions.size()) {
+        LOG_ERROR("EntityKinematics::setJointPositions: expected %lu values, got %lu",
+                  (unsigned long)jointPositions.size(), (unsigned long)q.size());
+        return;
+      }
+      jointPositions = q;
+      computeLinkStates(jointPositions, &linkStates);
+    }
+
+    bool EntityKinematics::getLinkPose(unsigned long nodeId, Vector *pos,
+                                       Quaternion *rot) const {
+      MutexLocker locker(&iMutex);
+      std::map<unsigned long, int>::const_iterator it = linkIndex.find(nodeId);
+      if(it == linkIndex.end()) return false;
+      if(pos) *pos = linkStates[it->second].pos;
+      if(rot) *rot = linkStates[it->second].rot;
+      return true;
+    }
+
+    void EntityKinematics::getLinkPoses(std::map<unsigned long, Vector> *positions,
+                                        std::map<unsigned long, Quaternion> *rotations) const {
+      MutexLocker locker(&iMutex);
+      for(size_t i = 0; i < links.size(); ++i) {
+        if(positions) (*positions)[links[i].nodeId] = linkStates[i].pos;
+        if(rotations) (*rotations)[links[i].nodeId] = linkStates[i].rot;
+      }
+    }
+
+    bool EntityKinematics::getJacobian(unsigned long nodeId, const Vector &offset,
+                                       std::vector<sReal> *jacobian) const {
+      MutexLocker locker(&iMutex);
+      std::map<unsigned long, int>::const_iterator it = linkIndex.find(nodeId);
+      if(it == linkIndex.end()) return false;
+      const LinkState &state = linkStates[it->second];
+      computeJacobian(linkStates, it->second, state.pos + state.rot * offset,
+                      jacobian);
+      return true;
+    }
+
+    void EntityKinematics::getJacobians(const std::vector<unsigned long> &nodeIds,
+                                        std::vector<std::vector<sReal> > *jacobians) const {
+      MutexLocker locker(&iMutex);
+      jacobians->resize(nodeIds.size());
+      for(size_t i = 0; i < nodeIds.size(); ++i) {
+        std::map<unsigned long, int>::const_iterator it = linkIndex.find(nodeIds[i]);
+        if(it == linkIndex.end()) {
+          (*jacobians)[i].clear();
+          continue;
+        }
+        computeJacobian(linkStates, it->second, linkStates[it->second].pos,
+                        &(*jacobians)[i]);
+      }
+    }
+
+    bool EntityKinematics::solveIK(const std::vector<IKTarget> &targets,
+                                   std::vector<sReal> *q, int maxIterations,
+                                   sReal damping, sReal tolerance,
+                                   sReal *error) const {
+      MutexLocker locker(&iMutex);
+      const size_t n = dofJoints.size();
+      if(q->empty()) *q = jointPositions;
+      if(q->size() != n) {
+        LOG_ERROR("EntityKinematics::solveIK: expected %lu joint values, got %lu",
+                  (unsigned long)n, (unsigned long)q->size());
+        return false;
+      }
+
+      std::vector<int> targetLinks;
+      size_t rows = 0;
+      for(size_t i = 0; i < targets.size(); ++i) {
+        std::map<unsigned long, int>::const_iterator it = linkIndex.find(targets[i].nodeId);
+        if(it == linkIndex.end()) {
+          LOG_ERROR("EntityKinematics::solveIK: node %lu is not part of \"%s\"",
+                    targets[i].nodeId, entity->getName().c_str());
+          return false;
+        }
+        targetLinks.push_back(it->second);
+        rows += targets[i].useRotation ? 6 : 3;
+      }
+      if(rows == 0 || n == 0) return false;
+
+      std::vector<LinkState> states;
+      std::vector<sReal> jac;
+      Eigen::MatrixXd J(rows, n);
+      Eigen::VectorXd e(rows);
+      Eigen::MatrixXd A(rows, rows);
+      sReal err = 0.0;
+      bool converged = false;
+      for(int iteration = 0; iteration <= maxIterations; ++iteration) {
+        computeLinkStates(*q, &states);
+        size_t row = 0;
+        for(size_t i = 0; i < targets.size(); ++i) {
+          const LinkState &state = states[targetLinks[i]];
+          computeJacobian(states, targetLinks[i], state.pos, &jac);
+          Vector dp = targets[i].position - state.pos;
+          e.segment<3>(row) = dp;
+          for(size_t c = 0; c < n; ++c) {
+            J(row, c) = jac[c];
+            J(row+1, c) = jac[n+c];
+            J(row+2, c) = jac[2*n+c];
+          }
+          row += 3;
+          if(targets[i].useRotation) {
+            Quaternion dq = targets[i].rotation * state.rot.inverse();
+            if(dq.w() < 0.0) dq.coeffs() *= -1.0;
+            e.segment<3>(row) = 2.0 * dq.vec();
+            for(size_t c = 0; c < n; ++c) {
+              J(row, c) = jac[3*n+c];
+              J(row+1, c) = jac[4*n+c];
+              J(row+2, c) = jac[5*n+c];
+            }
+            row += 3;
+          }
+        }
+        err = e.norm();
+        if(err < tolerance) {
+          converged = true;
+          break;
+        }
+        if(iteration == maxIterations) break;
+
+        // dq = J^T (J J^T + lambda^2 I)^-1 e
+        A.noalias() = J * J.transpose();
+        A.diagonal().array() += damping * damping;
+        Eigen::VectorXd step = J.transpose() * A.ldlt().solve(e);
+        for(size_t i = 0; i < links.size(); ++i) {
+          const Link &link = links[i];
+          if(link.dof < 0) continue;
+          sReal &v = (*q)[link.dof];
+          v += step[link.dof];
+          if(link.lowerLimit < link.upperLimit) {
+            if(v < link.lowerLimit) v = link.lowerLimit;
+            else if(v > link.upperLimit) v = link.upperLimit;
+          }
+        }
+      }
+      if(error) *error = err;
+      return converged;
+    }
+
+    void EntityKinematics::computeLinkStates(const std::vector<sReal> &q,
+                                             std::vector<LinkState> *states) const {
+      states->resize(links.size());
+      for(size_t i = 0; i < links.size(); ++i) {
+        const Link &link = links[i];
+        LinkState &state = (*states)[i];
+        if(link.parent < 0) {
+          // root poses are only read in update()
+          if(states != &linkStates) state = linkStates[i];
+          continue;
+        }
+        const LinkState &parent = (*states)[link.parent];
+        Vector relPos = link.offsetPos;
+        Quaternion relRot = link.offsetRot;
+        if(link.dof >= 0) {
+          if(link.type == JOINT_TYPE_HINGE) {
+            Quaternion r(Eigen::AngleAxisd(q[link.dof], link.axis));
+            relPos = link.anchor + r * (link.offsetPos - link.anchor);
+            relRot = r * link.offsetRot;
+          }
+          else {
+            relPos = link.offsetPos + link.axis * q[link.dof];
+          }
+        }
+        state.pos = parent.pos + parent.rot * relPos;
+        state.rot = parent.rot * relRot;
+        state.anchor = parent.pos + parent.rot * link.anchor;
+        state.axis = parent.rot * link.axis;
+      }
+    }
+
+    void EntityKinematics::computeJacobian(const std::vector<LinkState> &states,
+                                           int link, const Vector &point,
+                                           std::vector<sReal> *jacobian) const {
+      const size_t n = dofJoints.size();
+      jacobian->assign(6*n, 0.0);
+      for(int i = link; i >= 0; i = links[i].parent) {
+        const Link &l = links[i];
+        if(l.dof < 0) continue;
+        const LinkState &state = states[i];
+        Vector v, w(0.0, 0.0, 0.0);
+        if(l.type == JOINT_TYPE_HINGE) {
+          v = state.axis.cross(point - state.anchor);
+          w = state.axis;
+        }
+        else {
+          v = state.axis;
+        }
+        for(int r = 0; r < 3; ++r) {
+          (*jacobian)[r*n+l.dof] = v[r];
+          (*jacobian)[(r+3)*n+l.dof] = w[r];
+        }
+      }
+    }
+
+  } // end of namespace sim
+} // end of namespace mars
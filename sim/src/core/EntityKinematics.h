@@ -0,0 +1,208 @@
+/*
+ *  Copyright 2011, 2012, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * \file EntityKinematics.h
+ * \brief Forward kinematics, Jacobians and inverse kinematics computed
+ *        from the joint tree of a SimEntity.
+ *
+ */
+
+#ifndef ENTITYKINEMATICS_H
+#define ENTITYKINEMATICS_H
+
+#ifdef _PRINT_HEADER_
+#warning "EntityKinematics.h"
+#endif
+
+#include <map>
+#include <vector>
+#include <mars/interfaces/MARSDefs.h>
+#include <mars/utils/Vector.h>
+#include <mars/utils/Quaternion.h>
+#include <mars/utils/Mutex.h>
+
+namespace mars {
+
+  namespace interfaces {
+    class ControlCenter;
+  }
+
+  namespace sim {
+
+    class SimEntity;
+    class SimNode;
+    class SimJoint;
+
+    /**
+     * A pose or position goal for one link of the entity.
+     * If \c useRotation is false only the position is solved for.
+     */
+    struct IKTarget {
+      IKTarget() : nodeId(0), position(0.0, 0.0, 0.0),
+                   rotation(1.0, 0.0, 0.0, 0.0), useRotation(false) {}
+      unsigned long nodeId;
+      utils::Vector position;
+      utils::Quaternion rotation;
+      bool useRotation;
+    };
+
+    /**
+     * EntityKinematics holds the kinematic tree of one SimEntity.
+     *
+     * The tree is built once from the joints of the entity: for every
+     * node the parent node, the joint axis and anchor in the parent frame
+     * and the pose of the node at joint position zero are stored. Hinge
+     * and slider joints are degrees of freedom, all other joint types and
+     * nodes sharing a group with another node are treated as fixed.
+     *
+     * update() reads the poses of the root nodes and the joint positions
+     * while holding the node manager lock and computes the poses of all
+     * links in that one pass. All further queries (link poses, Jacobians,
+     * inverse kinematics) work on this snapshot and do not touch the
+     * simulation.
+     *
+     * Joint positions use the same sign convention as SimJoint::getPosition
+     * and MotorManager::setMotorValue, so IK results can be passed to the
+     * motors directly.
+     */
+    class EntityKinematics {
+    public:
+      EntityKinematics(interfaces::ControlCenter *control, SimEntity *entity);
+      ~EntityKinematics();
+
+      /**
+       * \brief Builds the kinematic tree from the current state of the
+       * entity. Has to be called again if nodes or joints are added
+       * to or removed from the entity.
+       * \return false if the entity has no node in the simulation
+       */
+      bool build();
+      bool isValid() const;
+
+      /**
+       * \brief Reads root poses and joint positions in one locked pass
+       * and updates all link poses.
+       */
+      void update();
+
+      /** \brief Number of degrees of freedom of the tree. */
+      size_t getDOFCount() const;
+
+      /** \brief Joint ids in the order of the joint position vector. */
+      std::vector<unsigned long> getJointIds() const;
+
+      /** \brief Joint positions of the last update(). */
+      void getJointPositions(std::vector<interfaces::sReal> *q) const;
+
+      /**
+       * \brief Recomputes all link poses for the given joint positions
+       * keeping the root poses of the last update().
+       */
+      void setJointPositions(const std::vector<interfaces::sReal> &q);
+
+      bool getLinkPose(unsigned long nodeId, utils::Vector *pos,
+                       utils::Quaternion *rot) const;
+
+      /**
+       * \brief Returns the poses of all links of the entity.
+       */
+      void getLinkPoses(std::map<unsigned long, utils::Vector> *positions,
+                        std::map<unsigned long, utils::Quaternion> *rotations) const;
+
+      /**
+       * \brief Computes the geometric Jacobian of a point of a link.
+       * \param offset point in link coordinates
+       * \param jacobian row-major 6 x getDOFCount() matrix; the rows are
+       *        the linear velocity (x, y, z) followed by the angular
+       *        velocity (x, y, z) in world coordinates
+       */
+      bool getJacobian(unsigned long nodeId, const utils::Vector &offset,
+                       std::vector<interfaces::sReal> *jacobian) const;
+
+      /**
+       * \brief Computes the Jacobians of several links at their origin.
+       */
+      void getJacobians(const std::vector<unsigned long> &nodeIds,
+                        std::vector<std::vector<interfaces::sReal> > *jacobians) const;
+
+      /**
+       * \brief Solves for all targets at once with damped least squares.
+       *
+       * The targets are stacked into one system so that several end
+       * effectors of the entity are solved together. The solution is
+       * clamped to the joint limits in every iteration.
+       * \param q start configuration on input, solution on output; if
+       *        empty, the joint positions of the last update() are used
+       * \param error if not NULL, set to the remaining error norm
+       * \return true if the error fell below \c tolerance
+       */
+      bool solveIK(const std::vector<IKTarget> &targets,
+                   std::vector<interfaces::sReal> *q,
+                   int maxIterations = 100,
+                   interfaces::sReal damping = 0.05,
+                   interfaces::sReal tolerance = 1e-4,
+                   interfaces::sReal *error = NULL) const;
+
+    private:
+      struct Link {
+        unsigned long nodeId;
+        int parent;
+        int dof;
+        interfaces::JointType type;
+        // joint anchor and axis in the parent link frame
+        utils::Vector anchor;
+        utils::Vector axis;
+        // link pose relative to the parent at joint position zero
+        utils::Vector offsetPos;
+        utils::Quaternion offsetRot;
+        interfaces::sReal lowerLimit, upperLimit;
+        SimNode *node;
+        SimJoint *joint;
+      };
+
+      struct LinkState {
+        utils::Vector pos;
+        utils::Quaternion rot;
+        // joint anchor and axis in world coordinates
+        utils::Vector anchor;
+        utils::Vector axis;
+      };
+
+      interfaces::ControlCenter *control;
+      SimEntity *entity;
+      std::vector<Link> links;
+      std::map<unsigned long, int> linkIndex;
+      std::vector<unsigned long> dofJoints;
+      std::vector<interfaces::sReal> jointPositions;
+      std::vector<LinkState> linkStates;
+      mutable utils::Mutex iMutex;
+
+      void computeLinkStates(const std::vector<interfaces::sReal> &q,
+                             std::vector<LinkState> *states) const;
+      void computeJacobian(const std::vector<LinkState> &states, int link,
+                           const utils::Vector &point,
+                           std::vector<interfaces::sReal> *jacobian) const;
+    };
+
+  } // end of namespace sim
+} // end of namespace mars
+
+#endif // ENTITYKINEMATICS_H
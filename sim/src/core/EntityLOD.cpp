@@ -0,0 +1,252 @@
+/*
+ *  Copyright 2011, 2012, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "EntityLOD.h"
+#include "SimEntity.h"
+#include "SimNode.h"
+#include "SimJoint.h"
+#include "SimMotor.h"
+
+#include <mars/interfaces/sim/ControlCenter.h>
+#include <mars/interfaces/sim/NodeManagerInterface.h>
+#include <mars/interfaces/sim/JointManagerInterface.h>
+#include <mars/interfaces/sim/MotorManagerInterface.h>
+#include <mars/interfaces/Logging.hpp>
+#include <mars/utils/mathUtils.h>
+
+#include <cmath>
+
+namespace mars {
+  namespace sim {
+
+    using namespace utils;
+    using namespace interfaces;
+    using namespace configmaps;
+
+    EntityLOD::EntityLOD(ControlCenter *control, SimEntity *entity,
+                         const ConfigMap &config)
+      : control(control), entity(entity), level(DYNAMICS_FULL),
+        forcedLevel(-1), paused(false), forward(1.0, 0.0, 0.0),
+        baseVelocitySet(false), baseLinear(0.0), baseAngular(0.0) {
+      ConfigMap map = config;
+      if(map.hasKey("distances")) {
+        ConfigVector::iterator it = map["distances"].begin();
+        for(; it!=map["distances"].end(); ++it) {
+          distances.push_back((double)*it);
+        }
+      }
+      hysteresis = map.get("hysteresis", 1.0);
+      suspendData = map.get("suspend_data", true);
+      wheelRadius = trackWidth = 0.0;
+      if(map.hasKey("drive")) {
+        ConfigMap &drive = map["drive"];
+        const char *sides[2] = {"left", "right"};
+        std::vector<unsigned long> *motors[2] = {&leftMotors, &rightMotors};
+        for(int i=0; i<2; ++i) {
+          if(!drive.hasKey(sides[i])) continue;
+          ConfigVector::iterator it = drive[sides[i]].begin();
+          for(; it!=drive[sides[i]].end(); ++it) {
+            std::string name = *it;
+            unsigned long id = entity->getMotor(name);
+            if(id) motors[i]->push_back(id);
+            else {
+              LOG_WARN("EntityLOD: drive motor \"%s\" of entity \"%s\" not found",
+                       name.c_str(), entity->getName().c_str());
+            }
+          }
+        }
+        wheelRadius = drive.get("wheel_radius", 0.1);
+        trackWidth = drive.get("track_width", 0.5);
+        if(drive.hasKey("forward")) {
+          vectorFromConfigItem(&drive["forward"], &forward);
+        }
+      }
+    }
+
+    EntityLOD::~EntityLOD() {
+    }
+
+    NodeInterface* EntityLOD::getNodeInterface(unsigned long id) const {
+      SimNode *node = control->nodes->getSimNode(id);
+      return node ? node->getInterface() : NULL;
+    }
+
+    bool EntityLOD::setLevel(DynamicsLevel newLevel) {
+      if(newLevel == level) return true;
+      unsigned long rootId = entity->getRootNode();
+      NodeInterface *root = getNodeInterface(rootId);
+      if(!root || !control->nodes->getIsMovable(rootId)) {
+        LOG_WARN("EntityLOD: entity \"%s\" has no movable root node",
+                 entity->getName().c_str());
+        return false;
+      }
+
+      if(level == DYNAMICS_FULL) {
+        setJointsActive(false);
+        if(!setCarried(true)) {
+          setCarried(false);
+          setJointsActive(true);
+          LOG_WARN("EntityLOD: entity \"%s\" has links in composite bodies and can't be reduced",
+                   entity->getName().c_str());
+          return false;
+        }
+        if(suspendData) setPaused(true);
+      }
+
+      std::map<unsigned long, std::string> nodes = entity->getAllNodes();
+      std::map<unsigned long, std::string>::iterator it;
+      if(newLevel == DYNAMICS_KINEMATIC || level == DYNAMICS_KINEMATIC) {
+        bool kinematic = (newLevel == DYNAMICS_KINEMATIC);
+        for(it=nodes.begin(); it!=nodes.end(); ++it) {
+          NodeInterface *node = getNodeInterface(it->first);
+          if(node) node->setKinematicBody(kinematic, !kinematic);
+        }
+      }
+
+      if(newLevel == DYNAMICS_FULL) {
+        setCarried(false);
+        setJointsActive(true);
+        if(paused) setPaused(false);
+      }
+      level = newLevel;
+
+      if(level == DYNAMICS_KINEMATIC) {
+        // the unicycle stays in its plane
+        Vector v;
+        root->getLinearVelocity(&v);
+        v.z() = 0.0;
+        root->setLinearVelocity(v);
+        root->getAngularVelocity(&v);
+        v.x() = v.y() = 0.0;
+        root->setAngularVelocity(v);
+      }
+      return true;
+    }
+
+    void EntityLOD::setJointsActive(bool active) {
+      std::map<unsigned long, std::string> joints = entity->getAllJoints();
+      std::map<unsigned long, std::string>::iterator it;
+      for(it=joints.begin(); it!=joints.end(); ++it) {
+        SimJoint *joint = control->joints->getSimJoint(it->first);
+        if(joint) joint->setActive(active);
+      }
+    }
+
+    bool EntityLOD::setCarried(bool carried) {
+      unsigned long rootId = entity->getRootNode();
+      NodeInterface *root = getNodeInterface(rootId);
+      std::map<unsigned long, std::string> nodes = entity->getAllNodes();
+      std::map<unsigned long, std::string>::iterator it;
+      bool ok = true;
+      for(it=nodes.begin(); it!=nodes.end(); ++it) {
+        if(it->first == rootId) continue;
+        NodeInterface *node = getNodeInterface(it->first);
+        if(node && !node->setCarrier(carried ? root : NULL)) ok = false;
+      }
+      return ok;
+    }
+
+    void EntityLOD::setPaused(bool paused) {
+      this->paused = paused;
+      entity->updatePause();
+    }
+
+    DynamicsLevel EntityLOD::levelForDistance(sReal distance) const {
+      // a boundary is crossed outwards only beyond the hysteresis
+      int result = DYNAMICS_FULL;
+      for(size_t i=0; i<distances.size() && i<2; ++i) {
+        sReal threshold = distances[i];
+        if((int)i >= (int)level) threshold += hysteresis;
+        if(distance > threshold) result = i+1;
+      }
+      return (DynamicsLevel)result;
+    }
+
+    bool EntityLOD::getRootPosition(Vector *pos) const {
+      unsigned long rootId = entity->getRootNode();
+      if(!control->nodes->exists(rootId)) return false;
+      *pos = control->nodes->getPosition(rootId);
+      return true;
+    }
+
+    void EntityLOD::setBaseVelocity(sReal linear, sReal angular) {
+      baseVelocitySet = true;
+      baseLinear = linear;
+      baseAngular = angular;
+    }
+
+    bool EntityLOD::getDriveCommand(sReal *linear, sReal *angular) const {
+      if(hasDrive()) {
+        sReal left = 0.0, right = 0.0;
+        for(size_t i=0; i<leftMotors.size(); ++i) {
+          SimMotor *motor = control->motors->getSimMotor(leftMotors[i]);
+          if(motor) left += motor->getControlValue();
+        }
+        for(size_t i=0; i<rightMotors.size(); ++i) {
+          SimMotor *motor = control->motors->getSimMotor(rightMotors[i]);
+          if(motor) right += motor->getControlValue();
+        }
+        left *= wheelRadius/leftMotors.size();
+        right *= wheelRadius/rightMotors.size();
+        *linear = 0.5*(left+right);
+        *angular = trackWidth > 0 ? (right-left)/trackWidth : 0.0;
+        return true;
+      }
+      if(baseVelocitySet) {
+        *linear = baseLinear;
+        *angular = baseAngular;
+        return true;
+      }
+      return false;
+    }
+
+    void EntityLOD::applyDrive() {
+      if(level == DYNAMICS_FULL) return;
+      sReal linear, angular;
+      if(!getDriveCommand(&linear, &angular)) return;
+      NodeInterface *root = getNodeInterface(entity->getRootNode());
+      if(!root) return;
+      Quaternion q;
+      root->getRotation(&q);
+      Vector heading = q*forward;
+      heading.z() = 0.0;
+      if(heading.norm() < 1e-6) return;
+      heading.normalize();
+
+      // the rigid model keeps its vertical motion from gravity and contacts
+      Vector vel(0.0, 0.0, 0.0), avel(0.0, 0.0, 0.0);
+      if(level == DYNAMICS_RIGID) {
+        root->getLinearVelocity(&vel);
+        root->getAngularVelocity(&avel);
+      }
+      vel.x() = linear*heading.x();
+      vel.y() = linear*heading.y();
+      avel.z() = angular;
+      root->setLinearVelocity(vel);
+      root->setAngularVelocity(avel);
+    }
+
+    void EntityLOD::reset() {
+      level = DYNAMICS_FULL;
+      if(paused) setPaused(false);
+    }
+
+  } // end of namespace sim
+} // end of namespace mars
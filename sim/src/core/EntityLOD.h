@@ -0,0 +1,168 @@
+/*
+ *  Copyright 2011, 2012, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * \file EntityLOD.h
+ * \brief Switches an entity between full and reduced dynamics models.
+ *
+ */
+
+#ifndef ENTITYLOD_H
+#define ENTITYLOD_H
+
+#ifdef _PRINT_HEADER_
+#warning "EntityLOD.h"
+#endif
+
+#include <vector>
+#include <configmaps/ConfigData.h>
+#include <mars/interfaces/MARSDefs.h>
+#include <mars/interfaces/sim/EntityManagerInterface.h>
+#include <mars/utils/Vector.h>
+
+namespace mars {
+
+  namespace interfaces {
+    class ControlCenter;
+    class NodeInterface;
+  }
+
+  namespace sim {
+
+    class SimEntity;
+
+    /**
+     * EntityLOD holds the dynamics level of detail of one SimEntity.
+     *
+     * - DYNAMICS_FULL: all links are simulated with their joints.
+     * - DYNAMICS_RIGID: the joints are disabled and the geoms of all links
+     *   are carried by the body of the root node, which gets the mass of
+     *   the whole entity. The wheels or legs are kinematic: the planar
+     *   velocity of the root follows the drive command, gravity and
+     *   contacts still act on it.
+     * - DYNAMICS_KINEMATIC: additionally the root body is kinematic and
+     *   the geoms are disabled, the entity moves as unicycle in the plane
+     *   without any collision.
+     *
+     * The links keep their relative poses of the moment the entity left
+     * the full level and take over the velocity of the root when they are
+     * released again. Below the full level the entity is paused like an
+     * inactive one, see SimEntity::updatePause(): the motors, the sensor
+     * filters and rays and the controllers stop and the timed DataBroker
+     * callbacks are suspended. With a drive the controllers keep running,
+     * they set the drive command.
+     *
+     * The "lod" section of the entity config:
+     * \code
+     * lod:
+     *   distances: [20.0, 60.0]  # distance to the nearest interest region
+     *                            # from which the rigid and the kinematic
+     *                            # level are used
+     *   hysteresis: 2.0
+     *   suspend_data: true       # pause the entity below full level
+     *   drive:                   # optional differential drive, the wheel
+     *     left: [motor_fl, motor_rl]    # speeds are the control values
+     *     right: [motor_fr, motor_rr]   # of the velocity motors
+     *     wheel_radius: 0.1
+     *     track_width: 0.4
+     *     forward: {x: 1, y: 0, z: 0}   # in the root frame
+     * \endcode
+     * Without drive the reduced entity follows the base velocity that is
+     * set by setBaseVelocity() or keeps its velocity.
+     */
+    class EntityLOD {
+    public:
+      EntityLOD(interfaces::ControlCenter *control, SimEntity *entity,
+                const configmaps::ConfigMap &config);
+      ~EntityLOD();
+
+      interfaces::DynamicsLevel getLevel() const {return level;}
+
+      /**
+       * \brief Switches the entity to the given level.
+       * \return false if the entity can't be reduced, e.g. if its root is
+       *         not movable or a link is part of a composite body
+       */
+      bool setLevel(interfaces::DynamicsLevel level);
+
+      /**
+       * \brief Fixes the level, a negative level returns to the selection
+       * by distance.
+       */
+      void setForcedLevel(int level) {forcedLevel = level;}
+      int getForcedLevel() const {return forcedLevel;}
+
+      /**
+       * \brief Returns the level for the distance to the nearest interest
+       * region with the hysteresis around the current level.
+       */
+      interfaces::DynamicsLevel levelForDistance(interfaces::sReal distance) const;
+
+      bool getRootPosition(utils::Vector *pos) const;
+
+      /**
+       * \brief Sets the velocities of the root node of a reduced entity
+       * from the drive command. Called before the physics step.
+       */
+      void applyDrive();
+
+      //! forward speed in m/s and turn rate in rad/s of the reduced model
+      void setBaseVelocity(interfaces::sReal linear, interfaces::sReal angular);
+
+      /**
+       * \brief Forgets the reduced state after the physics objects of the
+       * entity have been recreated.
+       */
+      void reset();
+
+      //! true while the entity has to be paused, see SimEntity::updatePause()
+      bool isPaused() const {return paused;}
+
+      //! true if the drive command comes from the motors
+      bool hasDrive() const {
+        return !leftMotors.empty() && !rightMotors.empty();
+      }
+
+    private:
+      interfaces::ControlCenter *control;
+      SimEntity *entity;
+      interfaces::DynamicsLevel level;
+      int forcedLevel;
+      std::vector<interfaces::sReal> distances;
+      interfaces::sReal hysteresis;
+      bool suspendData, paused;
+      std::vector<unsigned long> leftMotors, rightMotors;
+      interfaces::sReal wheelRadius, trackWidth;
+      utils::Vector forward;
+      bool baseVelocitySet;
+      interfaces::sReal baseLinear, baseAngular;
+
+      interfaces::NodeInterface* getNodeInterface(unsigned long id) const;
+      void setJointsActive(bool active);
+      bool setCarried(bool carried);
+      void setPaused(bool paused);
+      bool getDriveCommand(interfaces::sReal *linear,
+                           interfaces::sReal *angular) const;
+    };
+
+  } // end of namespace sim
+} // end of namespace mars
+
+#endif // ENTITYLOD_H
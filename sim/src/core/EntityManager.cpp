@@ -20,9 +20,12 @@
 
 #include "EntityManager.h"
 #include "SimEntity.h"
+#include "EntityLOD.h"
 #include <configmaps/ConfigData.h>
 #include <mars/interfaces/graphics/GraphicsManagerInterface.h>
 #include <mars/interfaces/sim/EntitySubscriberInterface.h>
+#include <mars/interfaces/sim/NodeManagerInterface.h>
+#include <mars/interfaces/Logging.hpp>
 #include <mars/utils/MutexLocker.h>
 #include <mars/utils/misc.h>
 
@@ -39,6 +42,7 @@ namespace mars {
 
       control = c;
       next_entity_id = 1;
+      next_region_id = 1;
       if (control->graphics)
         control->graphics->addEventClient((GraphicsEventClient*) this);
     }
@@ -363,6 +367,103 @@ namespace mars {
       for (auto iter: entities) {
         iter.second->setInitialPose(true);
       }
+      // the physics objects are recreated with full dynamics
+      for (auto iter: entities) {
+        EntityLOD *lod = iter.second->getLOD();
+        if (lod) lod->reset();
+      }
+    }
+
+    unsigned long EntityManager::addInterestRegion(const Vector &center,
+                                                   sReal radius,
+                                                   unsigned long nodeId) {
+      MutexLocker locker(&iMutex);
+      InterestRegion region;
+      region.id = next_region_id++;
+      region.center = center;
+      region.radius = radius;
+      region.nodeId = nodeId;
+      interestRegions.push_back(region);
+      return region.id;
+    }
+
+    void EntityManager::removeInterestRegion(unsigned long id) {
+      MutexLocker locker(&iMutex);
+      for (auto it = interestRegions.begin(); it != interestRegions.end(); ++it) {
+        if (it->id == id) {
+          interestRegions.erase(it);
+          return;
+        }
+      }
+    }
+
+    bool EntityManager::setDynamicsLevel(const std::string &entityName,
+                                         int level) {
+      MutexLocker locker(&iMutex);
+      SimEntity *entity = getEntity(entityName);
+      if (!entity) return false;
+      EntityLOD *lod = entity->getLOD();
+      if (!lod) {
+        LOG_WARN("EntityManager: entity \"%s\" has no lod config",
+                 entityName.c_str());
+        return false;
+      }
+      if (level > DYNAMICS_KINEMATIC) level = DYNAMICS_KINEMATIC;
+      lod->setForcedLevel(level);
+      // switch immediately to report whether the entity can be reduced
+      if (level >= 0 && !lod->setLevel((DynamicsLevel)level)) {
+        lod->setForcedLevel(DYNAMICS_FULL);
+        return false;
+      }
+      return true;
+    }
+
+    int EntityManager::getDynamicsLevel(const std::string &entityName) {
+      MutexLocker locker(&iMutex);
+      SimEntity *entity = getEntity(entityName);
+      if (!entity || !entity->getLOD()) return DYNAMICS_FULL;
+      return entity->getLOD()->getLevel();
+    }
+
+    void EntityManager::setBaseVelocity(const std::string &entityName,
+                                        sReal linear, sReal angular) {
+      MutexLocker locker(&iMutex);
+      SimEntity *entity = getEntity(entityName);
+      if (!entity || !entity->getLOD()) return;
+      entity->getLOD()->setBaseVelocity(linear, angular);
+    }
+
+    void EntityManager::updateDynamicsLevels() {
+      MutexLocker locker(&iMutex);
+      std::vector<InterestRegion> regions = interestRegions;
+      for (auto &region: regions) {
+        if (region.nodeId) {
+          region.center += control->nodes->getPosition(region.nodeId);
+        }
+      }
+      for (auto iter: entities) {
+        EntityLOD *lod = iter.second->getLOD();
+        if (!lod) continue;
+        DynamicsLevel level = DYNAMICS_FULL;
+        if (lod->getForcedLevel() >= 0) {
+          level = (DynamicsLevel)lod->getForcedLevel();
+        }
+        else if (!regions.empty()) {
+          Vector pos;
+          if (!lod->getRootPosition(&pos)) continue;
+          // distance to the surface of the nearest region
+          sReal distance = (pos - regions[0].center).norm() - regions[0].radius;
+          for (auto &region: regions) {
+            sReal d = (pos - region.center).norm() - region.radius;
+            if (d < distance) distance = d;
+          }
+          level = lod->levelForDistance(distance < 0.0 ? 0.0 : distance);
+        }
+        if (!lod->setLevel(level)) {
+          lod->setForcedLevel(DYNAMICS_FULL);
+        }
+        lod->applyDrive();
+      }
     }
 
   } // end of namespace sim
@@ -134,13 +134,34 @@ namespace mars {
       virtual void printEntityControllers(const std::string &entityName);
       virtual void resetPose();
 
+      virtual unsigned long addInterestRegion(const utils::Vector &center,
+                                              interfaces::sReal radius,
+                                              unsigned long nodeId=0);
+      virtual void removeInterestRegion(unsigned long id);
+      virtual bool setDynamicsLevel(const std::string &entityName, int level);
+      virtual int getDynamicsLevel(const std::string &entityName);
+      virtual void setBaseVelocity(const std::string &entityName,
+                                   interfaces::sReal linear,
+                                   interfaces::sReal angular);
+      virtual void updateDynamicsLevels();
+
     private:
+      struct InterestRegion {
+        unsigned long id;
+        utils::Vector center;
+        interfaces::sReal radius;
+        unsigned long nodeId;
+      };
+
+
       std::vector<interfaces::EntitySubscriberInterface*> subscribers;
       void notifySubscribers(SimEntity* entity);
       interfaces::ControlCenter *control;
       /**the id assigned to the next created entity; use getNextId function*/
       unsigned long next_entity_id;
       std::map<unsigned long, SimEntity*> entities;
+      std::vector<InterestRegion> interestRegions;
+      unsigned long next_region_id;
 
       /**returns the id to be assigned to the next entity*/
       unsigned long getNextId() {
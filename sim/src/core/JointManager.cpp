@@ -137,6 +137,7 @@ namespace mars {
         //    newJoint->setSJoint(*jointS);
         newJoint->setPhysicalJoint(newJointInterface);
         simJoints[jointS->index] = newJoint;
+        snapshot.invalidate();
         iMutex.unlock();
         control->sim->sceneHasChanged(false);
         return jointS->index;
@@ -151,12 +152,15 @@ namespace mars {
     }
 
     int JointManager::getJointCount() {
+      std::shared_ptr<const ObjectListView> view = snapshot.read();
+      if(view) return view->objects.size();
       MutexLocker locker(&iMutex);
       return simJoints.size();
     }
 
     void JointManager::editJoint(JointData *jointS) {
       MutexLocker locker(&iMutex);
+      snapshot.invalidate();
       std::map<unsigned long, SimJoint*>::iterator iter = simJoints.find(jointS->index);
       if (iter != simJoints.end()) {
         iter->second->setAnchor(jointS->anchor);
@@ -170,6 +174,11 @@ namespace mars {
     }
 
     void JointManager::getListJoints(std::vector<core_objects_exchange>* jointList) {
+      std::shared_ptr<const ObjectListView> view = snapshot.read();
+      if(view) {
+        *jointList = view->objects;
+        return;
+      }
       core_objects_exchange obj;
       std::map<unsigned long, SimJoint*>::iterator iter;
       MutexLocker locker(&iMutex);
@@ -182,6 +191,12 @@ namespace mars {
 
     void JointManager::getJointExchange(unsigned long id,
                                         core_objects_exchange* obj) {
+      std::shared_ptr<const ObjectListView> view = snapshot.read();
+      if(view) {
+        const core_objects_exchange *found = view->find(id);
+        if(found) *obj = *found;
+        return;
+      }
       MutexLocker locker(&iMutex);
       std::map<unsigned long, SimJoint*>::iterator iter = simJoints.find(id);
       if (iter != simJoints.end())
@@ -211,6 +226,7 @@ namespace mars {
       if (iter != simJoints.end()) {
         tmpJoint = iter->second;
         simJoints.erase(iter);
+        snapshot.invalidate();
       }
 
       control->motors->removeJointFromMotors(index);
@@ -274,6 +290,22 @@ namespace mars {
       }
     }
 
+    void JointManager::publishSnapshot() {
+      if(!snapshot.beginStep()) return;
+      std::shared_ptr<ObjectListView> view(new ObjectListView);
+      core_objects_exchange obj;
+      map<unsigned long, SimJoint*>::const_iterator iter;
+      MutexLocker locker(&iMutex);
+      view->version = snapshot.getVersion();
+      view->objects.reserve(simJoints.size());
+      for(iter = simJoints.begin(); iter != simJoints.end(); ++iter) {
+        iter->second->getCoreExchange(&obj);
+        view->add(obj);
+      }
+      locker.unlock();
+      snapshot.publish(view);
+    }
+
     void JointManager::clearAllJoints(bool clear_all) {
       map<unsigned long, SimJoint*>::iterator iter;
       MutexLocker locker(&iMutex);
@@ -284,6 +316,7 @@ namespace mars {
         delete simJoints.begin()->second;
         simJoints.erase(simJoints.begin());
       }
+      snapshot.invalidate();
       control->sim->sceneHasChanged(false);
 
       next_joint_id = 1;
@@ -386,6 +419,8 @@ namespace mars {
 
 
     unsigned long JointManager::getID(const std::string& joint_name) const {
+      std::shared_ptr<const ObjectListView> view = snapshot.read();
+      if(view) return view->getID(joint_name);
       map<unsigned long, SimJoint*>::const_iterator iter;
       MutexLocker locker(&iMutex);
       for(iter = simJoints.begin(); iter != simJoints.end(); iter++) {
@@ -503,6 +538,7 @@ namespace mars {
     void JointManager::edit(interfaces::JointId id, const std::string &key,
                             const std::string &value) {
       MutexLocker locker(&iMutex);
+      snapshot.invalidate();
       std::map<unsigned long, SimJoint*>::iterator iter = simJoints.find(id);
       if (iter != simJoints.end()) {
         if(matchPattern("*/type", key)) {
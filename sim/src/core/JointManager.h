@@ -37,6 +37,8 @@
 #include <mars/interfaces/sim/JointManagerInterface.h>
 #include <mars/utils/Mutex.h>
 
+#include "ObjectListSnapshot.h"
+
 namespace mars {
   namespace sim {
 
@@ -62,6 +64,7 @@ namespace mars {
       virtual void reattacheJoints(unsigned long node_id);
       virtual void reloadJoints(void);
       virtual void updateJoints(interfaces::sReal calc_ms);
+      virtual void publishSnapshot();
       virtual void clearAllJoints(bool clear_all=false);
       virtual void setReloadJointOffset(unsigned long id, interfaces::sReal offset);
       virtual void setReloadJointAxis(unsigned long id, const utils::Vector &axis);
@@ -100,6 +103,7 @@ namespace mars {
       std::list<interfaces::JointData> simJointsReload;
       interfaces::ControlCenter *control;
       mutable utils::Mutex iMutex;
+      ObjectListSnapshot snapshot;
       interfaces::JointManagerInterface* getJointInterface(unsigned long node_id);
       std::list<interfaces::JointData>::iterator getReloadJoint(unsigned long id);
 
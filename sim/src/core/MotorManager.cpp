@@ -96,6 +96,7 @@ namespace mars {
       newMotor->setSMotor(*motorS);
       iMutex.lock();
       simMotors[newMotor->getIndex()] = newMotor;
+      snapshot.invalidate();
       iMutex.unlock();
       control->sim->sceneHasChanged(false);
 
@@ -150,6 +151,8 @@ namespace mars {
      *\return The number of all motors.
      */
     int MotorManager::getMotorCount() const {
+      std::shared_ptr<const ObjectListView> view = snapshot.read();
+      if(view) return view->objects.size();
       MutexLocker locker(&iMutex);
       return simMotors.size();
     }
@@ -167,6 +170,7 @@ namespace mars {
      */
     void MotorManager::editMotor(const MotorData &motorS) {
       MutexLocker locker(&iMutex);
+      snapshot.invalidate();
       map<unsigned long, SimMotor*>::iterator iter = simMotors.find(motorS.index);
       if (iter != simMotors.end())
         iter->second->setSMotor(motorS);
@@ -181,6 +185,11 @@ namespace mars {
      * in the beginning of this function.
      */
     void MotorManager::getListMotors(vector<core_objects_exchange> *motorList)const{
+      std::shared_ptr<const ObjectListView> view = snapshot.read();
+      if(view) {
+        *motorList = view->objects;
+        return;
+      }
       core_objects_exchange obj;
       map<unsigned long, SimMotor*>::const_iterator iter;
       motorList->clear();
@@ -226,6 +235,7 @@ namespace mars {
       if (iter != simMotors.end()) {
         tmpMotor = iter->second;
         simMotors.erase(iter);
+        snapshot.invalidate();
         if (tmpMotor)
           delete tmpMotor;
       }
@@ -387,6 +397,8 @@ namespace mars {
      * \return Id of the motor if it exists, otherwise 0
      */
     unsigned long MotorManager::getID(const std::string& name) const {
+      std::shared_ptr<const ObjectListView> view = snapshot.read();
+      if(view) return view->getID(name);
       map<unsigned long, SimMotor*>::const_iterator iter;
       MutexLocker locker(&iMutex);
 
@@ -432,6 +444,7 @@ namespace mars {
       for(iter = simMotors.begin(); iter != simMotors.end(); iter++)
         delete iter->second;
       simMotors.clear();
+      snapshot.invalidate();
       mimicmotors.clear();
       if(clear_all) simMotorsReload.clear();
       next_motor_id = 1;
@@ -472,6 +485,32 @@ namespace mars {
     }
 
 
+    /**
+     * \brief Publishes the motor list of this step for the lookups from
+     * other threads.
+     *
+     * \details Only adding, removing and editing motors invalidates the
+     * published list, the values of the motors are updated once per
+     * step. Thus a value set by a controller is listed after the next
+     * step.
+     */
+    void MotorManager::publishSnapshot() {
+      if(!snapshot.beginStep()) return;
+      std::shared_ptr<ObjectListView> view(new ObjectListView);
+      core_objects_exchange obj;
+      map<unsigned long, SimMotor*>::const_iterator iter;
+      MutexLocker locker(&iMutex);
+      view->version = snapshot.getVersion();
+      view->objects.reserve(simMotors.size());
+      for(iter = simMotors.begin(); iter != simMotors.end(); ++iter) {
+        iter->second->getCoreExchange(&obj);
+        view->add(obj);
+      }
+      locker.unlock();
+      snapshot.publish(view);
+    }
+
+
     sReal MotorManager::getActualPosition(unsigned long motorId) const {
       MutexLocker locker(&iMutex);
       map<unsigned long, SimMotor*>::const_iterator iter;
@@ -554,6 +593,7 @@ namespace mars {
     void MotorManager::edit(interfaces::MotorId id, const std::string &key,
                             const std::string &value) {
       MutexLocker locker(&iMutex);
+      snapshot.invalidate();
       map<unsigned long, SimMotor*>::iterator iter = simMotors.find(id);
       if(iter != simMotors.end()) {
         if(matchPattern("*/p", key)) {
@@ -581,6 +621,9 @@ namespace mars {
           if(value == "DC" || value == "2") {
             iter->second->setType(MOTOR_TYPE_VELOCITY);
           }
+          else if(value == "implicit_pd" || value == "8") {
+            iter->second->setType(MOTOR_TYPE_IMPLICIT_PD);
+          }
           else {
             iter->second->setType(MOTOR_TYPE_POSITION);
           }
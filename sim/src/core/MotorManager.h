@@ -42,6 +42,8 @@
 #include <mars/interfaces/sim/MotorManagerInterface.h>
 #include <mars/utils/Mutex.h>
 
+#include "ObjectListSnapshot.h"
+
 namespace mars {
   namespace sim {
 
@@ -263,6 +265,12 @@ namespace mars {
        */
       virtual void updateMotors(interfaces::sReal calc_ms);
 
+      /**
+       * \brief Publishes the motor list of this step for the lookups
+       * from other threads, see ObjectListSnapshot.
+       */
+      virtual void publishSnapshot();
+
       /**
        * \returns the actual position of the motor with the given Id.
        *          returns 0 if a motor with the given Id doesn't exist.
@@ -335,6 +343,9 @@ namespace mars {
       //! a mutex for the motor containters
       mutable utils::Mutex iMutex;
 
+      //! the motor list published for lookups from other threads
+      ObjectListSnapshot snapshot;
+
       // map of mimicmotors
       std::map<unsigned long, std::string> mimicmotors;
     }; // class MotorManager
@@ -44,6 +44,7 @@
 #include <mars/utils/misc.h>
 
 #include <stdexcept>
+#include <algorithm>
 
 #include <mars/utils/MutexLocker.h>
 
@@ -260,6 +261,7 @@ namespace mars {
         simNodes[nodeS->index] = newNode;
         if (nodeS->movable)
           simNodesDyn[nodeS->index] = newNode;
+        snapshot.invalidate();
         iMutex.unlock();
         control->sim->sceneHasChanged(false);
         NodeId id;
@@ -327,6 +329,7 @@ namespace mars {
           if (nodeS->movable) {
             simNodesDyn[nodeS->index] = newNode;
           }
+          snapshot.invalidate();
           iMutex.unlock();
         }
         control->sim->sceneHasChanged(false);
@@ -423,6 +426,8 @@ namespace mars {
      *
      */
     int NodeManager::getNodeCount() const {
+      std::shared_ptr<const ObjectListView> view = snapshot.read();
+      if(view) return view->objects.size();
       MutexLocker locker(&iMutex);
       return simNodes.size();
     }
@@ -446,6 +451,7 @@ namespace mars {
       //cout << "NodeManager::editNode !!!" << endl;
       // first lock all core functions
       iMutex.lock();
+      snapshot.invalidate();
 
       iter = simNodes.find(nodeS->index);
       if(iter == simNodes.end()) {
@@ -598,6 +604,11 @@ namespace mars {
      * iformations.
      */
     void NodeManager::getListNodes(vector<core_objects_exchange>* nodeList) const {
+      std::shared_ptr<const ObjectListView> view = snapshot.read();
+      if(view) {
+        *nodeList = view->objects;
+        return;
+      }
       core_objects_exchange obj;
       NodeMap::const_iterator iter;
       MutexLocker locker(&iMutex);
@@ -613,6 +624,12 @@ namespace mars {
      * of the node with the given id.
      */
     void NodeManager::getNodeExchange(NodeId id, core_objects_exchange* obj) const {
+      std::shared_ptr<const ObjectListView> view = snapshot.read();
+      if(view) {
+        const core_objects_exchange *found = view->find(id);
+        if(found) *obj = *found;
+        return;
+      }
       MutexLocker locker(&iMutex);
       NodeMap::const_iterator iter = simNodes.find(id);
       if (iter != simNodes.end())
@@ -673,6 +690,7 @@ namespace mars {
       if (iter != simNodes.end()) {
         tmpNode = iter->second; //iter->second is a pointer to the SimNode associated with the map
         simNodes.erase(iter);
+        snapshot.invalidate();
       }
 
       iter = vizNodes.find(id);
@@ -693,6 +711,7 @@ namespace mars {
           simNodesDyn.erase(iter);
         }
       }
+      inactiveNodes.erase(id);
 
       iMutex.unlock();
       if(!lock) iMutex.lock();
@@ -712,6 +731,7 @@ namespace mars {
      */
     void NodeManager::setNodeState(NodeId id, const nodeState &state) {
       MutexLocker locker(&iMutex);
+      snapshot.invalidate();
       NodeMap::iterator iter = simNodes.find(id);
       if (iter != simNodes.end())
         iter->second->setPhysicalState(state);
@@ -752,6 +772,7 @@ namespace mars {
      */
     void NodeManager::setPosition(NodeId id, const Vector &pos) {
       MutexLocker locker(&iMutex);
+      snapshot.invalidate();
       NodeMap::iterator iter = simNodes.find(id);
       if (iter != simNodes.end()) {
         iter->second->setPosition(pos, 1);
@@ -825,6 +846,7 @@ namespace mars {
      */
     void NodeManager::setRotation(NodeId id, const Quaternion &rot) {
       MutexLocker locker(&iMutex);
+      snapshot.invalidate();
       NodeMap::iterator iter = simNodes.find(id);
       if (iter != simNodes.end())
         iter->second->setRotation(rot, 1);
@@ -1089,6 +1111,7 @@ namespace mars {
     void NodeManager::rotateNode(NodeId id, Vector pivot, Quaternion q,
                                  unsigned long excludeJointId, bool includeConnected) {
       std::vector<int> gids;
+      snapshot.invalidate();
       NodeMap::iterator iter = simNodes.find(id);
       if(iter == simNodes.end()) {
         iMutex.unlock();
@@ -1125,6 +1148,7 @@ namespace mars {
     void NodeManager::positionNode(NodeId id, Vector pos,
                                    unsigned long excludeJointId) {
       std::vector<int> gids;
+      snapshot.invalidate();
       NodeMap::iterator iter = simNodes.find(id);
       if(iter == simNodes.end()) {
         iMutex.unlock();
@@ -1276,6 +1300,22 @@ namespace mars {
       }
     }
 
+    void NodeManager::publishSnapshot() {
+      if(!snapshot.beginStep()) return;
+      std::shared_ptr<ObjectListView> view(new ObjectListView);
+      core_objects_exchange obj;
+      NodeMap::const_iterator iter;
+      MutexLocker locker(&iMutex);
+      view->version = snapshot.getVersion();
+      view->objects.reserve(simNodes.size());
+      for(iter = simNodes.begin(); iter != simNodes.end(); ++iter) {
+        iter->second->getCoreExchange(&obj);
+        view->add(obj);
+      }
+      locker.unlock();
+      snapshot.publish(view);
+    }
+
     void NodeManager::preGraphicsUpdate() {
       NodeMap::iterator iter;
       if(!control->graphics)
@@ -1334,7 +1374,12 @@ namespace mars {
       simNodes.clear();
       vizNodes.clear();
       simNodesDyn.clear();
-      if(clear_all) simNodesReload.clear();
+      inactiveNodes.clear();
+      // the reload nodes keep the bits of their groups
+      if(clear_all) {
+        simNodesReload.clear();
+        NodeData::clearCollisionGroups();
+      }
       next_node_id = 1;
       iMutex.unlock();
     }
@@ -1430,6 +1475,7 @@ namespace mars {
 
     void NodeManager::addRotation(NodeId id, const Quaternion &q) {
       MutexLocker locker(&iMutex);
+      snapshot.invalidate();
       NodeMap::iterator iter = simNodes.find(id);
       if (iter != simNodes.end())
         iter->second->addRotation(q);
@@ -1445,6 +1491,29 @@ namespace mars {
       return a;
     }
 
+    /**
+     *\brief Set the nodes a node never collides with. The list is also
+     * stored for the reload of the node.
+     */
+    void NodeManager::setCollisionExclusions(NodeId id,
+                                             const std::vector<NodeId> &ids) {
+      MutexLocker locker(&iMutex);
+      std::vector<NodeId> sorted = ids;
+      std::sort(sorted.begin(), sorted.end());
+      sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+
+      std::list<NodeData>::iterator rIter = getReloadNode(id);
+      if (rIter != simNodesReload.end())
+        rIter->c_params.coll_exclude = sorted;
+
+      NodeMap::iterator iter = simNodes.find(id);
+      if (iter != simNodes.end()) {
+        contact_params cp = iter->second->getContactParams();
+        cp.coll_exclude = sorted;
+        iter->second->setContactParams(cp);
+      }
+    }
+
 
 
 
@@ -1531,6 +1600,20 @@ namespace mars {
     }
 
 
+    void NodeManager::getContactForces(NodeId id,
+                                       std::vector<Vector> *contact_points,
+                                       std::vector<Vector> *forces) const {
+      MutexLocker locker(&iMutex);
+      NodeMap::const_iterator iter = simNodes.find(id);
+      if (iter != simNodes.end()) {
+        iter->second->getContactForces(contact_points, forces);
+      }
+      else {
+        contact_points->clear();
+        forces->clear();
+      }
+    }
+
     double NodeManager::getCollisionDepth(NodeId id) const {
       MutexLocker locker(&iMutex);
       NodeMap::const_iterator iter = simNodes.find(id);
@@ -1569,6 +1652,8 @@ namespace mars {
     }
 
     NodeId NodeManager::getID(const std::string& node_name) const {
+      std::shared_ptr<const ObjectListView> view = snapshot.read();
+      if(view) return view->getID(node_name);
 
       iMutex.lock();
       NodeMap::const_iterator iter;
@@ -1583,9 +1668,19 @@ namespace mars {
     }
 
     std::vector<interfaces::NodeId> NodeManager::getNodeIDs(const std::string& str_in_name) const {
+      std::vector<interfaces::NodeId> out;
+      std::shared_ptr<const ObjectListView> view = snapshot.read();
+      if(view) {
+        std::vector<core_objects_exchange>::const_iterator it;
+        for(it = view->objects.begin(); it != view->objects.end(); ++it) {
+          if(it->name.find(str_in_name) != std::string::npos) {
+            out.push_back(it->index);
+          }
+        }
+        return out;
+      }
       iMutex.lock();
       NodeMap::const_iterator iter;
-      std::vector<interfaces::NodeId> out;
       for(iter = simNodes.begin(); iter != simNodes.end(); iter++) {
         if (iter->second->getName().find(str_in_name) != std::string::npos)  {
           out.push_back(iter->first);
@@ -1673,6 +1768,7 @@ namespace mars {
 
       if (iter != simNodes.end()) {
         iter->second->updatePR(pos, rot, visOffsetPos, visOffsetRot);
+        snapshot.invalidate();
         if(doLock) MutexLocker locker(&iMutex);
         nodesToUpdate[id] = iter->second;
       }
@@ -1691,6 +1787,40 @@ namespace mars {
         iter->second->setMovable(isMovable);
     }
 
+    void NodeManager::setNodeActive(NodeId id, bool active) {
+      MutexLocker locker(&iMutex);
+      NodeMap::iterator iter = simNodes.find(id);
+      if(iter == simNodes.end()) return;
+      SimNode *node = iter->second;
+      if(active == (inactiveNodes.find(id) == inactiveNodes.end())) return;
+
+      if(node->getInterface()) node->getInterface()->setActive(active);
+      if(active) {
+        inactiveNodes.erase(id);
+        if(node->isMovable()) simNodesDyn[id] = node;
+      }
+      else {
+        inactiveNodes.insert(id);
+        simNodesDyn.erase(id);
+      }
+      if(control->graphics) {
+        if(node->getGraphicsID()) {
+          control->graphics->setDrawObjectShow(node->getGraphicsID(),
+                                               active && (visual_rep & 1));
+        }
+        if(node->getGraphicsID2()) {
+          control->graphics->setDrawObjectShow(node->getGraphicsID2(),
+                                               active && (visual_rep & 2));
+        }
+      }
+    }
+
+    bool NodeManager::isNodeActive(NodeId id) const {
+      MutexLocker locker(&iMutex);
+      return (simNodes.find(id) != simNodes.end() &&
+              inactiveNodes.find(id) == inactiveNodes.end());
+    }
+
     void NodeManager::moveRelativeNodes(const SimNode &node, NodeMap *nodes,
                                         Vector v) {
       NodeMap::iterator iter;
@@ -1742,6 +1872,7 @@ namespace mars {
     void NodeManager::edit(NodeId id, const std::string &key,
                            const std::string &value) {
       iMutex.lock();
+      snapshot.invalidate();
       NodeMap::iterator iter;
 
       // todo: cfdir1 is a vector
@@ -1868,7 +1999,8 @@ namespace mars {
           if(value == "true" || value == "True") c.approx_pyramid = true;
           else c.approx_pyramid = false;
         }
-        else if(matchPattern("*/coll_bitmask", key)) c.coll_bitmask = atoi(value.c_str());
+        else if(matchPattern("*/coll_bitmask", key)) c.coll_bitmask = NodeData::collisionGroupBits(value);
+        else if(matchPattern("*/coll_category", key)) c.coll_category = NodeData::collisionGroupBits(value);
         else if(matchPattern("*/cfdir1*", key)) {
           double v = atof(value.c_str());
           if(!c.friction_direction1) c.friction_direction1 = new Vector(0,0,0);
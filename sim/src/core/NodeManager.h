@@ -32,11 +32,15 @@
   #warning "NodeManager.h"
 #endif
 
+#include "ObjectListSnapshot.h"
+
 #include <mars/utils/Mutex.h>
 #include <mars/interfaces/graphics/GraphicsUpdateInterface.h>
 #include <mars/interfaces/sim/ControlCenter.h>
 #include <mars/interfaces/sim/NodeManagerInterface.h>
 
+#include <set>
+
 namespace mars {
   namespace sim {
 
@@ -107,10 +111,13 @@ namespace mars {
       virtual void setReloadFriction(interfaces::NodeId id, interfaces::sReal friction1,
                                      interfaces::sReal friction2);
       virtual void updateDynamicNodes(interfaces::sReal calc_ms, bool physics_thread = true);
+      virtual void publishSnapshot();
       virtual void clearAllNodes(bool clear_all=false, bool clearGraphics=true);
       virtual void setReloadAngle(interfaces::NodeId id, const utils::sRotation &angle);
       virtual void setContactParams(interfaces::NodeId id, const interfaces::contact_params &cp);
       virtual const interfaces::contact_params getContactParams(interfaces::NodeId id) const;
+      virtual void setCollisionExclusions(interfaces::NodeId id,
+                                          const std::vector<interfaces::NodeId> &ids);
       virtual void setVelocity(interfaces::NodeId id, const utils::Vector& vel);
       virtual void setAngularVelocity(interfaces::NodeId id, const utils::Vector &vel);
       virtual void scaleReloadNodes(interfaces::sReal x, interfaces::sReal y, interfaces::sReal z);
@@ -129,6 +136,9 @@ namespace mars {
       virtual interfaces::NodeId getDrawID2(interfaces::NodeId id) const;
       virtual void setVisualRep(interfaces::NodeId id, int val);
       virtual const utils::Vector getContactForce(interfaces::NodeId id) const;
+      virtual void getContactForces(interfaces::NodeId id,
+                                    std::vector<utils::Vector> *contact_points,
+                                    std::vector<utils::Vector> *forces) const;
       virtual void setVisualQOffset(interfaces::NodeId id, const utils::Quaternion &q);
 
       virtual void updatePR(interfaces::NodeId id, const utils::Vector &pos,
@@ -151,6 +161,8 @@ namespace mars {
 
       virtual bool getIsMovable(interfaces::NodeId id) const;
       virtual void setIsMovable(interfaces::NodeId id, bool isMovable);
+      virtual void setNodeActive(interfaces::NodeId id, bool active);
+      virtual bool isNodeActive(interfaces::NodeId id) const;
       virtual void lock() {iMutex.lock();}
       virtual void unlock() {iMutex.unlock();}
       virtual void rotateNode(interfaces::NodeId id, utils::Vector pivot,
@@ -170,10 +182,14 @@ namespace mars {
       NodeMap simNodesDyn;
       NodeMap nodesToUpdate;
       NodeMap vizNodes;
+      // nodes deactivated via setNodeActive, they are not part of simNodesDyn
+      std::set<interfaces::NodeId> inactiveNodes;
       std::list<interfaces::NodeData> simNodesReload;
       unsigned long maxGroupID;
       lib_manager::LibManager *libManager;
       mutable utils::Mutex iMutex;
+      // the node list of the last step for lookups from other threads
+      ObjectListSnapshot snapshot;
 
       interfaces::ControlCenter *control;
 
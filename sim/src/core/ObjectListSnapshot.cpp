@@ -0,0 +1,77 @@
+/*
+ *  Copyright 2017, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "ObjectListSnapshot.h"
+
+#include <algorithm>
+
+namespace mars {
+  namespace sim {
+
+    using namespace interfaces;
+
+    // number of steps a view is still published after its last read
+    static const unsigned long snapshotKeepAlive = 1000;
+
+    static bool indexLess(const core_objects_exchange &obj, unsigned long id) {
+      return obj.index < id;
+    }
+
+    void ObjectListView::add(const core_objects_exchange &obj) {
+      objects.push_back(obj);
+      ids.insert(std::make_pair(obj.name, obj.index));
+    }
+
+    const core_objects_exchange* ObjectListView::find(unsigned long id) const {
+      std::vector<core_objects_exchange>::const_iterator it;
+      it = std::lower_bound(objects.begin(), objects.end(), id, indexLess);
+      if(it != objects.end() && it->index == id) return &(*it);
+      return 0;
+    }
+
+    unsigned long ObjectListView::getID(const std::string &name) const {
+      std::map<std::string, unsigned long>::const_iterator it = ids.find(name);
+      if(it != ids.end()) return it->second;
+      return 0;
+    }
+
+    ObjectListSnapshot::ObjectListSnapshot() : version(1), steps(0),
+                                               lastReadStep(0) {
+    }
+
+    std::shared_ptr<const ObjectListView> ObjectListSnapshot::read() const {
+      lastReadStep = steps.load();
+      std::shared_ptr<const ObjectListView> v = std::atomic_load(&view);
+      if(v && v->version == version) return v;
+      return std::shared_ptr<const ObjectListView>();
+    }
+
+    bool ObjectListSnapshot::beginStep() {
+      ++version;
+      unsigned long step = ++steps;
+      return step - lastReadStep <= snapshotKeepAlive;
+    }
+
+    void ObjectListSnapshot::publish(std::shared_ptr<const ObjectListView> v) {
+      std::atomic_store(&view, v);
+    }
+
+  } // end of namespace sim
+} // end of namespace mars
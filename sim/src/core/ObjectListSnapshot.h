@@ -0,0 +1,107 @@
+/*
+ *  Copyright 2017, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * \file ObjectListSnapshot.h
+ * \brief Immutable per step views of the object lists of the managers.
+ *
+ */
+
+#ifndef OBJECTLISTSNAPSHOT_H
+#define OBJECTLISTSNAPSHOT_H
+
+#ifdef _PRINT_HEADER_
+#warning "ObjectListSnapshot.h"
+#endif
+
+#include <mars/interfaces/core_objects_exchange.h>
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace mars {
+  namespace sim {
+
+    /**
+     * The core exchange data of all objects of one manager at the end of
+     * a simulation step. A view is never changed after it is published.
+     */
+    struct ObjectListView {
+      //! sorted by index
+      std::vector<interfaces::core_objects_exchange> objects;
+      //! name to the lowest index with that name
+      std::map<std::string, unsigned long> ids;
+      //! the snapshot version the view was built for
+      unsigned long version;
+
+      //! objects have to be added in ascending index order
+      void add(const interfaces::core_objects_exchange &obj);
+      const interfaces::core_objects_exchange* find(unsigned long id) const;
+      unsigned long getID(const std::string &name) const;
+    };
+
+    /**
+     * ObjectListSnapshot lets threads other than the simulation thread
+     * answer list, count and name lookups without taking the lock of a
+     * manager.
+     *
+     * The manager calls beginStep() at the end of every simulation step
+     * and, if it returns true, builds a new ObjectListView under its
+     * lock and hands it to publish(). Readers get the current view via
+     * read(). Old views are freed by the last reader that releases its
+     * reference, thus the simulation thread never waits for a reader.
+     *
+     * Every structural change (adding, removing, renaming or moving an
+     * object outside of a step) has to call invalidate() while holding
+     * the manager lock. read() returns no view until the next step
+     * published a fresh one, in that case the caller falls back to the
+     * locked lookup. This keeps a lookup right after e.g. addNode()
+     * correct. Views are only built while someone reads them, a
+     * simulation without readers does not pay for the copies.
+     */
+    class ObjectListSnapshot {
+    public:
+      ObjectListSnapshot();
+
+      std::shared_ptr<const ObjectListView> read() const;
+      void invalidate() {++version;}
+      unsigned long getVersion() const {return version;}
+
+      /**
+       * \brief Invalidates the current view and returns whether a new
+       * one should be built.
+       */
+      bool beginStep();
+      void publish(std::shared_ptr<const ObjectListView> view);
+
+    private:
+      std::shared_ptr<const ObjectListView> view;
+      std::atomic<unsigned long> version;
+      std::atomic<unsigned long> steps;
+      mutable std::atomic<unsigned long> lastReadStep;
+    }; // end of class ObjectListSnapshot
+
+  } // end of namespace sim
+} // end of namespace mars
+
+#endif // OBJECTLISTSNAPSHOT_H
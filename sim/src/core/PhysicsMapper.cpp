@@ -45,5 +45,9 @@ namespace mars {
       return (JointInterface*) (new JointPhysics(worldPhysics));
     }
 
+    CableInterface* PhysicsMapper::newCablePhysics(PhysicsInterface *worldPhysics) {
+      return (CableInterface*) (new CablePhysics(worldPhysics));
+    }
+
   } // end of namespace sim
 } // end of namespace mars
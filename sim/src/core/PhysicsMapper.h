@@ -36,6 +36,7 @@
 #include "WorldPhysics.h"
 #include "NodePhysics.h"
 #include "JointPhysics.h"
+#include "CablePhysics.h"
 
 namespace mars {
   namespace sim {
@@ -45,6 +46,7 @@ namespace mars {
       static interfaces::PhysicsInterface* newWorldPhysics(interfaces::ControlCenter *control);
       static interfaces::NodeInterface* newNodePhysics(interfaces::PhysicsInterface *worldPhysics);
       static interfaces::JointInterface* newJointPhysics(interfaces::PhysicsInterface *worldPhysics);
+      static interfaces::CableInterface* newCablePhysics(interfaces::PhysicsInterface *worldPhysics);
     };
 
   } // end of namespace sim
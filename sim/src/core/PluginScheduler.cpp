@@ -0,0 +1,147 @@
+/*
+ *  Copyright 2017, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "PluginScheduler.h"
+
+#include <mars/utils/misc.h>
+
+namespace mars {
+  namespace sim {
+
+    using namespace interfaces;
+
+    PluginScheduler::PluginScheduler() : numThreads(3), tasks(0),
+                                         taskTimes(0), taskCalcMs(0),
+                                         nextTask(0), finishedTasks(0),
+                                         generation(0), quit(false) {
+    }
+
+    PluginScheduler::~PluginScheduler() {
+      stopWorkers();
+    }
+
+    void PluginScheduler::buildBatches(const std::vector<pluginStruct> &plugins,
+                                       std::vector<PluginBatch> *batches) {
+      std::vector<PluginDependencies> batchDeps;
+      batches->clear();
+      for(size_t i = 0; i < plugins.size(); ++i) {
+        PluginInterface *plugin = plugins[i].p_interface;
+        PluginDependencies deps;
+        bool declared = plugin->getDependencies(&deps);
+        bool append = declared && !batches->empty() && batches->back().parallel;
+        for(size_t k = 0; append && k < batchDeps.size(); ++k) {
+          if(deps.conflicts(batchDeps[k])) append = false;
+        }
+        if(!append) {
+          batches->push_back(PluginBatch());
+          batches->back().parallel = declared;
+          batchDeps.clear();
+        }
+        batches->back().plugins.push_back(plugin);
+        batchDeps.push_back(deps);
+      }
+    }
+
+    void PluginScheduler::setNumThreads(int n) {
+      if(n < 0) n = 0;
+      if(n == numThreads) return;
+      stopWorkers();
+      numThreads = n;
+    }
+
+    void PluginScheduler::startWorkers() {
+      quit = false;
+      for(int i = 0; i < numThreads; ++i) {
+        workers.push_back(new Worker(this));
+        workers.back()->start();
+      }
+    }
+
+    void PluginScheduler::stopWorkers() {
+      if(workers.empty()) return;
+      mutex.lock();
+      quit = true;
+      taskCondition.wakeAll();
+      mutex.unlock();
+      for(size_t i = 0; i < workers.size(); ++i) {
+        workers[i]->wait();
+        delete workers[i];
+      }
+      workers.clear();
+    }
+
+    void PluginScheduler::update(const std::vector<PluginInterface*> &plugins,
+                                 sReal calc_ms, std::vector<double> *times) {
+      times->assign(plugins.size(), 0.0);
+      if(plugins.empty()) return;
+      if(workers.empty() && numThreads > 0) startWorkers();
+
+      mutex.lock();
+      tasks = &plugins;
+      taskTimes = times;
+      taskCalcMs = calc_ms;
+      nextTask = finishedTasks = 0;
+      ++generation;
+      taskCondition.wakeAll();
+      processTasks();
+      while(finishedTasks < plugins.size()) {
+        doneCondition.wait(&mutex);
+      }
+      tasks = 0;
+      taskTimes = 0;
+      mutex.unlock();
+    }
+
+    void PluginScheduler::processTasks() {
+      while(tasks && nextTask < tasks->size()) {
+        size_t i = nextTask++;
+        PluginInterface *plugin = (*tasks)[i];
+        mutex.unlock();
+        long long time = utils::getTime();
+        plugin->update(taskCalcMs);
+        double diff = (double)utils::getTimeDiff(time);
+        mutex.lock();
+        (*taskTimes)[i] = diff;
+        if(++finishedTasks == tasks->size()) {
+          doneCondition.wakeAll();
+        }
+      }
+    }
+
+    void PluginScheduler::workerLoop() {
+      unsigned long seen = 0;
+      mutex.lock();
+      while(!quit) {
+        if(generation == seen) {
+          taskCondition.wait(&mutex);
+          continue;
+        }
+        seen = generation;
+        processTasks();
+      }
+      mutex.unlock();
+    }
+
+    void PluginScheduler::Worker::run() {
+      scheduler->workerLoop();
+    }
+
+  } // end of namespace sim
+} // end of namespace mars
@@ -0,0 +1,120 @@
+/*
+ *  Copyright 2017, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * \file PluginScheduler.h
+ * \brief Groups the simulation plugins into batches that can be updated
+ *        concurrently and runs these batches on a worker pool.
+ *
+ */
+
+#ifndef PLUGINSCHEDULER_H
+#define PLUGINSCHEDULER_H
+
+#ifdef _PRINT_HEADER_
+#warning "PluginScheduler.h"
+#endif
+
+#include <mars/interfaces/sim/PluginInterface.h>
+#include <mars/utils/Mutex.h>
+#include <mars/utils/Thread.h>
+#include <mars/utils/WaitCondition.h>
+
+#include <vector>
+
+namespace mars {
+  namespace sim {
+
+    /**
+     * Plugins whose update calls may run at the same time. A batch of a
+     * plugin without declared dependencies contains only that plugin.
+     */
+    struct PluginBatch {
+      std::vector<interfaces::PluginInterface*> plugins;
+      bool parallel;
+    };
+
+    /**
+     * The PluginScheduler splits the active plugins into batches. The
+     * batches keep the order in which the plugins were added: a plugin
+     * is put into the current batch if it declared its dependencies and
+     * doesn't conflict with any plugin of the batch, otherwise a new
+     * batch is started. Thus two conflicting plugins are still updated
+     * in their original order and legacy plugins behave like before.
+     *
+     * update() runs the plugins of one batch on the worker threads and
+     * the calling thread and returns when all of them are finished.
+     */
+    class PluginScheduler {
+    public:
+      PluginScheduler();
+      ~PluginScheduler();
+
+      static void buildBatches(const std::vector<interfaces::pluginStruct> &plugins,
+                               std::vector<PluginBatch> *batches);
+
+      /**
+       * \brief Sets the number of worker threads in addition to the
+       * simulation thread. With zero workers all plugins are updated
+       * serially. The threads are started on the first parallel batch.
+       */
+      void setNumThreads(int n);
+      int getNumThreads() const {return numThreads;}
+
+      /**
+       * \brief Calls update(calc_ms) of all \a plugins concurrently and
+       * stores the time of each call in ms in \a times.
+       */
+      void update(const std::vector<interfaces::PluginInterface*> &plugins,
+                  interfaces::sReal calc_ms, std::vector<double> *times);
+
+    private:
+      class Worker : public utils::Thread {
+      public:
+        explicit Worker(PluginScheduler *scheduler) : scheduler(scheduler) {}
+      protected:
+        void run();
+      private:
+        PluginScheduler *scheduler;
+      };
+
+      std::vector<Worker*> workers;
+      int numThreads;
+
+      utils::Mutex mutex;
+      utils::WaitCondition taskCondition, doneCondition;
+      const std::vector<interfaces::PluginInterface*> *tasks;
+      std::vector<double> *taskTimes;
+      interfaces::sReal taskCalcMs;
+      size_t nextTask, finishedTasks;
+      unsigned long generation;
+      bool quit;
+
+      void startWorkers();
+      void stopWorkers();
+      void workerLoop();
+      //! takes tasks until none are left, expects the mutex to be locked
+      void processTasks();
+    }; // end of class PluginScheduler
+
+  } // end of namespace sim
+} // end of namespace mars
+
+#endif // PLUGINSCHEDULER_H
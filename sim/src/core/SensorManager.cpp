@@ -32,6 +32,7 @@
  */
 
 #include "SensorManager.h"
+#include "SimNode.h"
 
 // sensor includes
 #include "JointAVGTorqueSensor.h"
@@ -53,15 +54,21 @@
 #include "NodeAngularVelocitySensor.h"
 #include "MotorCurrentSensor.h"
 #include "HapticFieldSensor.h"
+#include "TactileArraySensor.h"
 #include "Joint6DOFSensor.h"
 #include "JointTorqueSensor.h"
 #include "ScanningSonar.h"
+#include "SensorFilter.h"
 
 #include <mars/interfaces/sim/SimulatorInterface.h>
+#include <mars/interfaces/sim/NodeManagerInterface.h>
+#include <mars/data_broker/DataBrokerInterface.h>
 #include <mars/utils/MutexLocker.h>
 #include <mars/interfaces/Logging.hpp>
 
 #include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <stdexcept>
 
 namespace mars {
@@ -101,6 +108,7 @@ namespace mars {
       addSensorType("NodeAngularVelocity",&NodeAngularVelocitySensor::instanciate);
       addSensorType("MotorCurrent",&MotorCurrentSensor::instanciate);
       addSensorType("HapticField",&HapticFieldSensor::instanciate);
+      addSensorType("TactileArray",&TactileArraySensor::instanciate);
 
       addMarsParser("RaySensor",&RaySensor::parseConfig);
       addMarsParser("RotatingRaySensor",&RotatingRaySensor::parseConfig);
@@ -123,6 +131,7 @@ namespace mars {
       addMarsParser("NodeAngularVelocity",&NodeArraySensor::parseConfig);
       addMarsParser("MotorCurrent",&MotorCurrentSensor::parseConfig);
       addMarsParser("HapticField",&HapticFieldSensor::parseConfig);
+      addMarsParser("TactileArray",&TactileArraySensor::parseConfig);
 
       // missing sensors:
       //   RayGridSensor
@@ -150,6 +159,11 @@ namespace mars {
      * in the beginning of this function.
      */
     void SensorManager::getListSensors(vector<core_objects_exchange> *sensorList) const {
+      std::shared_ptr<const ObjectListView> view = snapshot.read();
+      if(view) {
+        *sensorList = view->objects;
+        return;
+      }
       core_objects_exchange obj;
       map<unsigned long, BaseSensor*>::const_iterator iter;
       sensorList->clear();
@@ -184,6 +198,12 @@ namespace mars {
     }
 
     unsigned long SensorManager::getSensorID(std::string name) const {
+      std::shared_ptr<const ObjectListView> view = snapshot.read();
+      if(view) {
+        unsigned long id = view->getID(name);
+        if(!id) printf("Cannot find Sensor with name: \"%s\"\n",name.c_str());
+        return id;
+      }
       MutexLocker locker(&iMutex);
       std::map<unsigned long, BaseSensor*>::const_iterator it;
       for(it = simSensors.begin(); it != simSensors.end(); it++){
@@ -207,9 +227,12 @@ namespace mars {
       if (iter != simSensors.end()) {
         tmpSensor = iter->second;
         simSensors.erase(iter);
+        snapshot.invalidate();
         if (tmpSensor)
           delete tmpSensor;
       }
+      removeSensorFilter(index);
+      inactiveSensors.erase(index);
       iMutex.unlock();
 
       control->sim->sceneHasChanged(false);
@@ -245,8 +268,19 @@ namespace mars {
       map<unsigned long, BaseSensor*>::const_iterator iter;
 
       iter = simSensors.find(id);
-      if (iter != simSensors.end())
+      if (iter != simSensors.end()) {
+        map<unsigned long, FilteredSensor>::const_iterator fIter;
+        fIter = sensorFilters.find(id);
+        if (fIter != sensorFilters.end()) {
+          const std::vector<sReal> &output = fIter->second.filter->getOutput();
+          if (output.empty())
+            return iter->second->getSensorData(data);
+          *data = (sReal*)malloc(output.size()*sizeof(sReal));
+          memcpy(*data, output.data(), output.size()*sizeof(sReal));
+          return output.size();
+        }
         return iter->second->getSensorData(data);
+      }
 
       LOG_DEBUG("Cannot Find Sensor wirh id: %lu\n",id);
       return 0;
@@ -259,6 +293,8 @@ namespace mars {
      *\return The number of all sensors.
      */
     int SensorManager::getSensorCount() const {
+      std::shared_ptr<const ObjectListView> view = snapshot.read();
+      if(view) return view->objects.size();
       MutexLocker locker(&iMutex);
       return simSensors.size();
     }
@@ -282,6 +318,11 @@ namespace mars {
         delete sensor;
       }
       simSensors.clear();
+      snapshot.invalidate();
+      while(!sensorFilters.empty()) {
+        removeSensorFilter(sensorFilters.begin()->first);
+      }
+      inactiveSensors.clear();
       if(clear_all) simSensorsReload.clear();
       next_sensor_id = 1;
     }
@@ -300,7 +341,10 @@ namespace mars {
       for(iter=simSensorsReload.begin(); iter!=simSensorsReload.end(); ++iter) {
         iMutex.unlock();
 
-        createAndAddSensor(iter->type, iter->config, true);
+        BaseSensor *sensor = createAndAddSensor(iter->type, iter->config, true);
+        if(sensor && (iter->filter.isVector() || iter->filter.isMap())) {
+          setSensorFilter(sensor->getID(), iter->filter);
+        }
         iMutex.lock();
       }
       iMutex.unlock();
@@ -339,6 +383,7 @@ namespace mars {
       BaseSensor *sensor = ((*it).second)(this->control,config);
       iMutex.lock();
       simSensors[id] = sensor;
+      snapshot.invalidate();
       iMutex.unlock();
 
       if(!reload) {
@@ -361,7 +406,112 @@ namespace mars {
       //LOG_DEBUG("found sensor: %s", type.c_str());
       BaseConfig *cfg = ((*it).second)(control, config);
       cfg->name = (*config)["name"][0].getString();
-      return createAndAddSensor(type, cfg);
+      BaseSensor *sensor = createAndAddSensor(type, cfg);
+      if(sensor && config->hasKey("filter")) {
+        setSensorFilter(sensor->getID(), (*config)["filter"]);
+        iMutex.lock();
+        simSensorsReload.back().filter = (*config)["filter"];
+        iMutex.unlock();
+      }
+      return sensor;
+    }
+
+    void SensorManager::setSensorFilter(unsigned long id, ConfigItem &config) {
+      SensorFilter *filter = new SensorFilter();
+      if(!filter->fromConfigItem(config)) {
+        delete filter;
+        return;
+      }
+      MutexLocker locker(&iMutex);
+      map<unsigned long, BaseSensor*>::iterator iter = simSensors.find(id);
+      if(iter == simSensors.end()) {
+        delete filter;
+        return;
+      }
+      removeSensorFilter(id);
+      FilteredSensor &fs = sensorFilters[id];
+      fs.filter = filter;
+      fs.dbId = 0;
+      if(control->dataBroker) {
+        fs.dbId = control->dataBroker->pushData("mars_sim",
+                                                "Sensors/" + iter->second->getName() + "/filtered",
+                                                fs.dbPackage, NULL,
+                                                data_broker::DATA_PACKAGE_READ_FLAG);
+      }
+    }
+
+    void SensorManager::removeSensorFilter(unsigned long id) {
+      map<unsigned long, FilteredSensor>::iterator iter = sensorFilters.find(id);
+      if(iter == sensorFilters.end()) return;
+      if(control->dataBroker && iter->second.dbId) {
+        control->dataBroker->removeData(iter->second.dbId);
+      }
+      delete iter->second.filter;
+      sensorFilters.erase(iter);
+    }
+
+    void SensorManager::publishSnapshot() {
+      if(!snapshot.beginStep()) return;
+      std::shared_ptr<ObjectListView> view(new ObjectListView);
+      core_objects_exchange obj;
+      map<unsigned long, BaseSensor*>::const_iterator iter;
+      MutexLocker locker(&iMutex);
+      view->version = snapshot.getVersion();
+      view->objects.reserve(simSensors.size());
+      for(iter = simSensors.begin(); iter != simSensors.end(); ++iter) {
+        iter->second->getCoreExchange(&obj);
+        view->add(obj);
+      }
+      locker.unlock();
+      snapshot.publish(view);
+    }
+
+    void SensorManager::setSensorActive(unsigned long id, bool active) {
+      MutexLocker locker(&iMutex);
+      map<unsigned long, BaseSensor*>::iterator iter = simSensors.find(id);
+      if(iter == simSensors.end()) return;
+      if(active) inactiveSensors.erase(id);
+      else inactiveSensors.insert(id);
+      BaseNodeSensor *nodeSensor = dynamic_cast<BaseNodeSensor*>(iter->second);
+      locker.unlock();
+      // the ray sensors are cast by the physics of their node
+      if(!nodeSensor) return;
+      SimNode *node = control->nodes->getSimNode(nodeSensor->getAttachedNode());
+      if(node && node->getInterface()) {
+        node->getInterface()->setSensorActive(nodeSensor, active);
+      }
+    }
+
+    void SensorManager::updateSensors(sReal calc_ms) {
+      (void)calc_ms;
+      MutexLocker locker(&iMutex);
+      map<unsigned long, FilteredSensor>::iterator iter;
+      for(iter = sensorFilters.begin(); iter != sensorFilters.end(); ++iter) {
+        map<unsigned long, BaseSensor*>::iterator sIter = simSensors.find(iter->first);
+        if(sIter == simSensors.end()) continue;
+        if(inactiveSensors.count(iter->first)) continue;
+        sReal *data = NULL;
+        int num = sIter->second->getSensorData(&data);
+        if(num <= 0) continue;
+        const std::vector<sReal> &output = iter->second.filter->process(data, num);
+        free(data);
+        if(!control->dataBroker || !iter->second.dbId) continue;
+        data_broker::DataPackage &dbPackage = iter->second.dbPackage;
+        if(dbPackage.size() != output.size()) {
+          dbPackage.clear();
+          char text[20];
+          for(size_t i = 0; i < output.size(); ++i) {
+            sprintf(text, "value%lu", (unsigned long)i);
+            dbPackage.add(text, output[i]);
+          }
+        }
+        else {
+          for(size_t i = 0; i < output.size(); ++i) {
+            dbPackage.set((long)i, output[i]);
+          }
+        }
+        control->dataBroker->pushData(iter->second.dbId, dbPackage);
+      }
     }
 
   } // end of namespace sim
@@ -41,7 +41,10 @@
 #include <mars/interfaces/sim/SensorManagerInterface.h>
 #include <mars/interfaces/sim/ControlCenter.h>
 #include <mars/utils/Mutex.h>
+#include "ObjectListSnapshot.h"
+#include <mars/data_broker/DataPackage.h>
 #include <configmaps/ConfigData.h>
+#include <set>
 
 namespace mars {
   namespace sim {
@@ -53,6 +56,15 @@ namespace mars {
 
       std::string type;
       interfaces::BaseConfig *config;
+      configmaps::ConfigItem filter;
+    };
+
+    class SensorFilter;
+
+    struct FilteredSensor {
+      SensorFilter *filter;
+      unsigned long dbId;
+      data_broker::DataPackage dbPackage;
     };
 
 
@@ -203,6 +215,30 @@ namespace mars {
        */
       virtual void reloadSensors(void) ;
 
+      /**
+       * \brief Feeds the current sensor outputs into the filter stages
+       * declared in the sensor configs.
+       *
+       * \details The filtered values are returned by getSensorData and
+       * published on the DataBroker as "mars_sim/Sensors/<name>/filtered".
+       * The item is removed from the DataBroker with its sensor.
+       */
+      virtual void updateSensors(interfaces::sReal calc_ms);
+
+      /**
+       * \brief Publishes the sensor list of this step for the lookups
+       * from other threads, see ObjectListSnapshot.
+       */
+      virtual void publishSnapshot();
+
+      virtual void setSensorActive(unsigned long id, bool active);
+
+      /**
+       * \brief Attaches the filter stages described by \c config to a
+       * sensor. See SensorFilter for the format.
+       */
+      void setSensorFilter(unsigned long id, configmaps::ConfigItem &config);
+
       //virtual void addSensorType(const std::string &name,  BaseSensor* (*func)(interfaces::ControlCenter*,const unsigned long int,const std::string,QDomElement*));
       //void addSensorType(const std::string &name, BaseSensor* (*func)(interfaces::ControlCenter*,const unsigned long int, const std::string, mars::ConfigMap*));
       void addSensorType(const std::string &name, interfaces::BaseSensor* (*func)(interfaces::ControlCenter*, interfaces::BaseConfig*));
@@ -227,6 +263,14 @@ namespace mars {
       //! a containter for all sensors that are loaded after a reset of the simulation
       std::vector<SensorReloadHelper> simSensorsReload;
 
+      //! the post-processing stages of the sensors that declare a filter
+      std::map<unsigned long, FilteredSensor> sensorFilters;
+
+      void removeSensorFilter(unsigned long id);
+
+      //! the sensors whose filters are not updated
+      std::set<unsigned long> inactiveSensors;
+
 
       //! a pointer to the control center
       interfaces::ControlCenter *control;
@@ -234,6 +278,9 @@ namespace mars {
       //! a mutex fot the sensor containters
       mutable utils::Mutex iMutex;
 
+      //! the sensor list published for lookups from other threads
+      ObjectListSnapshot snapshot;
+
       //std::map<const std::string,BaseSensor* (*)(interfaces::ControlCenter*,const unsigned long int,const std::string,QDomElement*)> availibleSensors;
       //std::map<const std::string,BaseSensor* (*)(interfaces::ControlCenter*,const unsigned long int, const std::string, mars::ConfigMap*)> availableSensors2;
       std::map<const std::string, interfaces::BaseSensor* (*)(interfaces::ControlCenter*, interfaces::BaseConfig*)> availableSensors;
@@ -0,0 +1,157 @@
+/*
+ *  Copyright 2017, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "SimCable.h"
+#include "SimNode.h"
+#include "PhysicsMapper.h"
+
+#include <mars/interfaces/sim/ControlCenter.h>
+#include <mars/interfaces/sim/SimulatorInterface.h>
+#include <mars/interfaces/sim/NodeManagerInterface.h>
+#include <mars/interfaces/Logging.hpp>
+#include <mars/data_broker/DataBrokerInterface.h>
+
+#include <cstdio>
+
+namespace mars {
+  namespace sim {
+
+    using namespace interfaces;
+    using namespace configmaps;
+
+    SimCable::SimCable(ControlCenter *control, unsigned long id,
+                       const ConfigMap &config)
+      : control(control), id(id), config(config), cable(0),
+        registered(false) {
+      name = this->config.get("name", std::string("cable"));
+    }
+
+    SimCable::~SimCable(void) {
+      if(registered && control->dataBroker) {
+        std::string groupName, dataName;
+        getDataBrokerNames(&groupName, &dataName);
+        control->dataBroker->unregisterTimedProducer(this, groupName, dataName,
+                                                     "mars_sim/simTimer");
+        control->dataBroker->unregisterSyncReceiver(this, "*", "*");
+      }
+      delete cable;
+    }
+
+    NodeInterface* SimCable::getAnchorNode(const std::string &key) {
+      if(!config.hasKey(key) || !config[key].hasKey("node")) return 0;
+      std::string nodeName = config[key]["node"];
+      SimNode *node = 0;
+      NodeId nodeId = control->nodes->getID(nodeName);
+      if(nodeId) node = control->nodes->getSimNode(nodeId);
+      if(!node) {
+        LOG_WARN("SimCable: node \"%s\" of cable \"%s\" not found",
+                 nodeName.c_str(), name.c_str());
+        return 0;
+      }
+      return node->getInterface();
+    }
+
+    bool SimCable::create(void) {
+      NodeInterface *node1 = getAnchorNode("start");
+      NodeInterface *node2 = getAnchorNode("end");
+      cable = PhysicsMapper::newCablePhysics(control->sim->getPhysics());
+      if(!cable->createCable(config, node1, node2)) {
+        LOG_ERROR("SimCable: could not create cable \"%s\"", name.c_str());
+        delete cable;
+        cable = 0;
+        return false;
+      }
+
+      cmdPackage.add("length", (double)cable->getTargetLength());
+      dbPackage.add("id", (long)id);
+      dbPackage.add("length", (double)cable->getLength());
+      dbPackage.add("targetLength", (double)cable->getTargetLength());
+      dbPackage.add("tension/start", 0.0);
+      dbPackage.add("tension/end", 0.0);
+
+      dbIdIndex = dbPackage.getIndexByName("id");
+      dbLengthIndex = dbPackage.getIndexByName("length");
+      dbTargetLengthIndex = dbPackage.getIndexByName("targetLength");
+      dbTensionStartIndex = dbPackage.getIndexByName("tension/start");
+      dbTensionEndIndex = dbPackage.getIndexByName("tension/end");
+
+      std::string groupName, dataName;
+      getDataBrokerNames(&groupName, &dataName);
+      if(control->dataBroker) {
+        control->dataBroker->pushData(groupName, dataName,
+                                      dbPackage, NULL,
+                                      data_broker::DATA_PACKAGE_READ_FLAG);
+        control->dataBroker->registerTimedProducer(this, groupName, dataName,
+                                                   "mars_sim/simTimer", 0);
+        control->dataBroker->pushData(groupName, "cmd/"+dataName,
+                                      cmdPackage, NULL,
+                                      data_broker::DATA_PACKAGE_READ_WRITE_FLAG);
+        control->dataBroker->registerSyncReceiver(this, groupName,
+                                                  "cmd/"+dataName, 0);
+        registered = true;
+      }
+      return true;
+    }
+
+    void SimCable::setTargetLength(sReal length) {
+      if(cable) cable->setTargetLength(length);
+    }
+
+    sReal SimCable::getLength(void) const {
+      return cable ? cable->getLength() : 0.0;
+    }
+
+    void SimCable::getTension(sReal *start, sReal *end) const {
+      if(cable) cable->getTension(start, end);
+      else *start = *end = 0.0;
+    }
+
+    void SimCable::getDataBrokerNames(std::string *groupName,
+                                      std::string *dataName) const {
+      char format[] = "Cables/%05lu_%s";
+      int size = snprintf(0, 0, format, id, name.c_str());
+      char buffer[size+1];
+      sprintf(buffer, format, id, name.c_str());
+      *groupName = "mars_sim";
+      *dataName = buffer;
+    }
+
+    void SimCable::produceData(const data_broker::DataInfo &info,
+                               data_broker::DataPackage *dbPackage,
+                               int callbackParam) {
+      sReal start, end;
+      cable->getTension(&start, &end);
+      dbPackage->set(dbIdIndex, (long)id);
+      dbPackage->set(dbLengthIndex, (double)cable->getLength());
+      dbPackage->set(dbTargetLengthIndex, (double)cable->getTargetLength());
+      dbPackage->set(dbTensionStartIndex, (double)start);
+      dbPackage->set(dbTensionEndIndex, (double)end);
+    }
+
+    void SimCable::receiveData(const data_broker::DataInfo &info,
+                               const data_broker::DataPackage &package,
+                               int callbackParam) {
+      double length;
+      package.get(0, &length);
+      setTargetLength(length);
+    }
+
+  } // end of namespace sim
+} // end of namespace mars
@@ -0,0 +1,103 @@
+/*
+ *  Copyright 2017, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef SIMCABLE_H
+#define SIMCABLE_H
+
+#ifdef _PRINT_HEADER_
+#warning "SimCable.h"
+#endif
+
+#include <mars/interfaces/sim/CableInterface.h>
+
+#include <mars/data_broker/ProducerInterface.h>
+#include <mars/data_broker/ReceiverInterface.h>
+#include <mars/data_broker/DataPackage.h>
+
+#include <configmaps/ConfigData.h>
+#include <string>
+
+namespace mars {
+
+  namespace interfaces {
+    class ControlCenter;
+  }
+
+  namespace sim {
+
+    /**
+     * A cable or tether between two nodes, see CablePhysics for the
+     * config. The "start" and "end" sections name the anchor nodes with
+     * the key "node".
+     *
+     * Each SimCable publishes its state on the dataBroker in the group
+     * "mars_sim" as "Cables/<id>_<name>" with the items:
+     *  - "id" (long)
+     *  - "length" (double)
+     *  - "targetLength" (double)
+     *  - "tension/start" (double)
+     *  - "tension/end" (double)
+     * The winch is commanded with the item "length" of the package
+     * "cmd/Cables/<id>_<name>".
+     */
+    class SimCable : public data_broker::ProducerInterface,
+                     public data_broker::ReceiverInterface {
+    public:
+      SimCable(interfaces::ControlCenter *control, unsigned long id,
+               const configmaps::ConfigMap &config);
+      ~SimCable(void);
+
+      //! creates the physical cable, returns false if that failed
+      bool create(void);
+
+      unsigned long getID(void) const {return id;}
+      const std::string& getName(void) const {return name;}
+      const configmaps::ConfigMap& getConfig(void) const {return config;}
+      void setTargetLength(interfaces::sReal length);
+      interfaces::sReal getLength(void) const;
+      void getTension(interfaces::sReal *start, interfaces::sReal *end) const;
+      void getDataBrokerNames(std::string *groupName,
+                              std::string *dataName) const;
+
+      virtual void produceData(const data_broker::DataInfo &info,
+                               data_broker::DataPackage *package,
+                               int callbackParam);
+      virtual void receiveData(const data_broker::DataInfo &info,
+                               const data_broker::DataPackage &package,
+                               int callbackParam);
+
+    private:
+      interfaces::ControlCenter *control;
+      unsigned long id;
+      std::string name;
+      configmaps::ConfigMap config;
+      interfaces::CableInterface *cable;
+      data_broker::DataPackage dbPackage, cmdPackage;
+      long dbIdIndex, dbLengthIndex, dbTargetLengthIndex;
+      long dbTensionStartIndex, dbTensionEndIndex;
+      bool registered;
+
+      interfaces::NodeInterface* getAnchorNode(const std::string &key);
+    };
+
+  } // end of namespace sim
+} // end of namespace mars
+
+#endif // SIMCABLE_H
@@ -20,6 +20,10 @@
 
 #include "SimEntity.h"
 #include "SimJoint.h"
+#include "SimMotor.h"
+#include "SimNode.h"
+#include "EntityKinematics.h"
+#include "EntityLOD.h"
 #include <configmaps/ConfigData.h>
 #include <iostream>
 #include <mars/utils/mathUtils.h>
@@ -33,6 +37,8 @@
 #include <mars/interfaces/sim/SensorManagerInterface.h>
 #include <mars/interfaces/sim/ControllerManagerInterface.h>
 #include <mars/interfaces/sim/EntityManagerInterface.h>
+#include <mars/interfaces/sensor_bases.h>
+#include <mars/data_broker/DataBrokerInterface.h>
 #include <math.h>
 #include <float.h>
 #include <iterator> // ostream_iterator
@@ -63,12 +69,22 @@ namespace mars {
       this->name = (std::string) config["name"];
     }
 
+    SimEntity::~SimEntity() {
+      delete kinematics;
+      delete lod;
+    }
+
     void SimEntity::appendConfig(const configmaps::ConfigMap& parameters) {
       configmaps::ConfigMap map = parameters;
       config.append(map);
     }
 
     void SimEntity::removeEntity() {
+      delete kinematics;
+      kinematics = nullptr;
+      delete lod;
+      lod = nullptr;
+      lodChecked = false;
       for (auto it = nodeIds.begin(); it != nodeIds.end(); ++it) {
         std::vector<unsigned long> joints = control->joints->getIDsByNodeID(it->first);
         for (auto j: joints) control->joints->removeJoint(j);
@@ -166,6 +182,18 @@ namespace mars {
       return nodeIds;
     }
 
+    std::map<unsigned long, std::string> SimEntity::getAllJoints() {
+      return jointIds;
+    }
+
+    std::map<unsigned long, std::string> SimEntity::getAllMotors() {
+      return motorIds;
+    }
+
+    std::map<unsigned long, std::string> SimEntity::getAllSensors() {
+      return sensorIds;
+    }
+
     std::vector<unsigned long> SimEntity::getNodes(const std::string& name) {
       std::vector<unsigned long> out;
       for (std::map<unsigned long, std::string>::const_iterator iter = nodeIds.begin();
@@ -483,6 +511,203 @@ namespace mars {
       }
     }
 
+    void SimEntity::initCollisionExclusions() {
+      if(!control) return;
+      // nodes with the same group share one body and are handled as a link;
+      // nodes without a group form a link on their own
+      std::map<unsigned long, long> linkOf;
+      std::map<long, std::vector<unsigned long> > linkNodes;
+      for (std::map<unsigned long, std::string>::const_iterator iter = nodeIds.begin();
+           iter != nodeIds.end(); ++iter) {
+        if (!control->nodes->exists(iter->first)) continue;
+        NodeData node = control->nodes->getFullNode(iter->first);
+        if (node.noPhysical) continue;
+        long link = node.groupID > 0 ? node.groupID : -(long)iter->first;
+        linkOf[iter->first] = link;
+        linkNodes[link].push_back(iter->first);
+      }
+
+      std::set<std::pair<long, long> > excludedLinks;
+      bool selfCollision = config.get("self_collision", true);
+      if (!selfCollision) {
+        std::map<long, std::vector<unsigned long> >::iterator it, it2;
+        for (it = linkNodes.begin(); it != linkNodes.end(); ++it) {
+          for (it2 = linkNodes.begin(); it2 != linkNodes.end(); ++it2) {
+            if (it->first != it2->first) {
+              excludedLinks.insert(std::make_pair(it->first, it2->first));
+            }
+          }
+        }
+      }
+      else {
+        if (config.get("collision_exclude_adjacent", true)) {
+          for (std::map<unsigned long, std::string>::const_iterator iter = jointIds.begin();
+               iter != jointIds.end(); ++iter) {
+            JointData joint = control->joints->getFullJoint(iter->first);
+            std::map<unsigned long, long>::iterator l1 = linkOf.find(joint.nodeIndex1);
+            std::map<unsigned long, long>::iterator l2 = linkOf.find(joint.nodeIndex2);
+            if (l1 == linkOf.end() || l2 == linkOf.end()) continue;
+            if (l1->second == l2->second) continue;
+            excludedLinks.insert(std::make_pair(l1->second, l2->second));
+            excludedLinks.insert(std::make_pair(l2->second, l1->second));
+          }
+        }
+        if (config.hasKey("collision_exclusions")) {
+          configmaps::ConfigVector::iterator it;
+          for (it = config["collision_exclusions"].begin();
+               it != config["collision_exclusions"].end(); ++it) {
+            if (it->size() != 2) {
+              fprintf(stderr, "SimEntity: collision exclusion of %s needs a pair of links\n",
+                      name.c_str());
+              continue;
+            }
+            std::map<unsigned long, long>::iterator l1 = linkOf.find(getNode((std::string)(*it)[0]));
+            std::map<unsigned long, long>::iterator l2 = linkOf.find(getNode((std::string)(*it)[1]));
+            if (l1 == linkOf.end() || l2 == linkOf.end()) {
+              fprintf(stderr, "SimEntity: unknown link in collision exclusion of %s\n",
+                      name.c_str());
+              continue;
+            }
+            excludedLinks.insert(std::make_pair(l1->second, l2->second));
+            excludedLinks.insert(std::make_pair(l2->second, l1->second));
+          }
+        }
+      }
+
+      std::map<unsigned long, std::vector<NodeId> > exclusions;
+      std::set<std::pair<long, long> >::iterator it;
+      for (it = excludedLinks.begin(); it != excludedLinks.end(); ++it) {
+        const std::vector<unsigned long> &from = linkNodes[it->first];
+        const std::vector<unsigned long> &to = linkNodes[it->second];
+        for (size_t i = 0; i < from.size(); ++i) {
+          exclusions[from[i]].insert(exclusions[from[i]].end(),
+                                     to.begin(), to.end());
+        }
+      }
+      std::map<unsigned long, std::vector<NodeId> >::iterator eIt;
+      for (eIt = exclusions.begin(); eIt != exclusions.end(); ++eIt) {
+        control->nodes->setCollisionExclusions(eIt->first, eIt->second);
+      }
+    }
+
+    void SimEntity::setPose(const utils::Vector &pos,
+                            const utils::Quaternion &rot) {
+      if(!control) return;
+      NodeId id = getRootNode();
+      if(!control->nodes->exists(id)) return;
+      NodeData rootNode = control->nodes->getFullNode(id);
+      rootNode.pos = pos;
+      rootNode.rot = rot;
+      control->nodes->editNode(&rootNode, EDIT_NODE_POS | EDIT_NODE_MOVE_ALL);
+      control->nodes->editNode(&rootNode, EDIT_NODE_ROT | EDIT_NODE_MOVE_ALL);
+    }
+
+    unsigned long SimEntity::getRootNode() {
+      NodeId id = 0;
+      if(config.hasKey("rootNode")) {
+        id = getNode((std::string)config["rootNode"]);
+      }
+      if(!id) id = getRootestId();
+      return id;
+    }
+
+    void SimEntity::setActive(bool active) {
+      this->active = active;
+      if(!control) return;
+      for(auto it = nodeIds.begin(); it != nodeIds.end(); ++it) {
+        control->nodes->setNodeActive(it->first, active);
+      }
+      // a reduced LOD keeps its joints disabled
+      if(!lod || lod->getLevel() == DYNAMICS_FULL) {
+        for(auto it = jointIds.begin(); it != jointIds.end(); ++it) {
+          SimJoint *joint = control->joints->getSimJoint(it->first);
+          if(joint) joint->setActive(active);
+        }
+      }
+      updatePause();
+    }
+
+    void SimEntity::updatePause() {
+      if(!control) return;
+      bool pause = !active || (lod && lod->isPaused());
+      if(pause != paused) {
+        paused = pause;
+        // no torques accumulate on the disabled bodies, motors that were
+        // deactivated before stay deactivated
+        for(auto it = motorIds.begin(); it != motorIds.end(); ++it) {
+          SimMotor *motor = control->motors->getSimMotor(it->first);
+          if(!motor) continue;
+          if(pause && motor->isActive()) {
+            motor->deactivate();
+            pausedMotors.insert(it->first);
+          }
+          else if(!pause && pausedMotors.count(it->first)) {
+            motor->activate();
+          }
+        }
+        if(!pause) pausedMotors.clear();
+        for(auto it = sensorIds.begin(); it != sensorIds.end(); ++it) {
+          control->sensors->setSensorActive(it->first, !pause);
+        }
+      }
+      // the controllers of a reduced entity with drive set its command
+      bool pauseControllers = pause && (!active || !lod->hasDrive());
+      for(auto it = controllerIds.begin(); it != controllerIds.end(); ++it) {
+        control->controllers->setControllerActive(*it, !pauseControllers);
+      }
+
+      if(!control->dataBroker) return;
+      data_broker::DataBrokerInterface *dataBroker = control->dataBroker;
+
+      for(auto it = nodeIds.begin(); it != nodeIds.end(); ++it) {
+        SimNode *node = control->nodes->getSimNode(it->first);
+        if(node) dataBroker->setTimedProducerSuspended(node, pause);
+      }
+      for(auto it = jointIds.begin(); it != jointIds.end(); ++it) {
+        SimJoint *joint = control->joints->getSimJoint(it->first);
+        if(joint) dataBroker->setTimedProducerSuspended(joint, pause);
+      }
+      for(auto it = motorIds.begin(); it != motorIds.end(); ++it) {
+        SimMotor *motor = control->motors->getSimMotor(it->first);
+        if(motor) dataBroker->setTimedProducerSuspended(motor, pause);
+      }
+      // the sensors are timed receivers of the node or joint data and
+      // producers of their own packages
+      for(auto it = sensorIds.begin(); it != sensorIds.end(); ++it) {
+        BaseSensor *sensor = control->sensors->getSimSensor(it->first);
+        if(!sensor) continue;
+        data_broker::ReceiverInterface *receiver;
+        data_broker::ProducerInterface *producer;
+        receiver = dynamic_cast<data_broker::ReceiverInterface*>(sensor);
+        producer = dynamic_cast<data_broker::ProducerInterface*>(sensor);
+        if(receiver) dataBroker->setTimedReceiverSuspended(receiver, pause);
+        if(producer) dataBroker->setTimedProducerSuspended(producer, pause);
+      }
+    }
+
+    EntityKinematics* SimEntity::getKinematics() {
+      if (!control) return NULL;
+      if (!kinematics) {
+        kinematics = new EntityKinematics(control, this);
+        if (!kinematics->build()) {
+          delete kinematics;
+          kinematics = nullptr;
+        }
+      }
+      return kinematics;
+    }
+
+    EntityLOD* SimEntity::getLOD() {
+      if (!control) return NULL;
+      if (!lodChecked) {
+        lodChecked = true;
+        if (config.hasKey("lod") && config["lod"].isMap()) {
+          lod = new EntityLOD(control, this, config["lod"]);
+        }
+      }
+      return lod;
+    }
+
     sReal SimEntity::getEntityMass() {
       sReal entity_mass=0.0;
       //sReal inertia=0.0;//TODO calculate Entity inertia with steiner for each node, needs current position and rotation of each node
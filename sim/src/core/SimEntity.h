@@ -45,6 +45,9 @@ namespace mars {
   }
   namespace sim {
 
+    class EntityKinematics;
+    class EntityLOD;
+
     class SimEntity {
     public:
       SimEntity(const std::string& name);
@@ -52,6 +55,7 @@ namespace mars {
       SimEntity(interfaces::ControlCenter *c, const std::string& name);
       SimEntity(interfaces::ControlCenter *c,
                 const configmaps::ConfigMap& parameters);
+      ~SimEntity();
 
       void appendConfig(const configmaps::ConfigMap& parameters);
 
@@ -111,6 +115,23 @@ namespace mars {
        */
       std::map<unsigned long, std::string> getAllNodes();
 
+      /**returns the ids of all joints
+       */
+      std::map<unsigned long, std::string> getAllJoints();
+
+      /**returns the ids of all motors
+       */
+      std::map<unsigned long, std::string> getAllMotors();
+
+      /**returns the ids of all sensors
+       */
+      std::map<unsigned long, std::string> getAllSensors();
+
+      /**returns the id of the root node; the root node is given by
+       * "rootNode" in the config or is the node with the smallest id
+       */
+      unsigned long getRootNode();
+
       /**returns the ids of all node that contain the given name string
        */
       std::vector<unsigned long> getNodes(const std::string& name);
@@ -154,6 +175,52 @@ namespace mars {
 
       void setInitialPose(bool reset=false, configmaps::ConfigMap* pPoseCfg=NULL);
 
+      /**moves the root node and all nodes connected to it to the given
+       * pose, see getRootNode()
+       */
+      void setPose(const utils::Vector &pos, const utils::Quaternion &rot);
+
+      /**activates or deactivates the entity
+       * inactive nodes keep their physics and graphics objects but are
+       * neither simulated nor drawn, see NodeManagerInterface::setNodeActive;
+       * the joints are disabled and the entity is paused, see updatePause()
+       */
+      void setActive(bool active);
+
+      bool isActive() {
+        return active;
+      }
+
+      /**computes the collision exclusion lists of the entity nodes
+       * from the entity config and passes them to the node manager:
+       *   - "self_collision": false excludes all pairs of the entity
+       *   - "collision_exclude_adjacent": true (default) excludes links
+       *     connected by a joint of the entity
+       *   - "collision_exclusions": list of link name pairs that never touch
+       * Nodes with the same group id are handled as one link.
+       */
+      void initCollisionExclusions();
+
+      /**returns the kinematics service of the entity
+       * the kinematic tree is built on the first call; call
+       * EntityKinematics::update() to read the current state
+       * \return NULL if the entity has no control center or no nodes
+       */
+      EntityKinematics* getKinematics();
+
+      /**returns the dynamics level of detail of the entity, it is created
+       * from the "lod" section of the entity config on the first call
+       * \return NULL if the entity has no "lod" config
+       */
+      EntityLOD* getLOD();
+
+      /**pauses the motors, sensors and controllers and suspends the timed
+       * DataBroker callbacks of the nodes, joints, motors and sensors if
+       * the entity is inactive or its LOD asks for it, resumes them
+       * otherwise
+       */
+      void updatePause();
+
       interfaces::sReal getEntityMass();
 
       utils::Vector getEntityCOM();
@@ -168,6 +235,9 @@ namespace mars {
       interfaces::ControlCenter *control;
       configmaps::ConfigMap config;
       unsigned long anchorJointId = 0;
+      EntityKinematics *kinematics = nullptr;
+      EntityLOD *lod = nullptr;
+      bool lodChecked = false;
 
       // stores the ids of the nodes belonging to the robot
       std::map<unsigned long, std::string> nodeIds;
@@ -190,6 +260,15 @@ namespace mars {
       // the selection state of the robot; true if selected, false otherwise
       bool selected;
 
+      // false if the entity is deactivated, e.g. while it waits in a pool
+      bool active = true;
+
+      // true while the motors, sensors and data of the entity are paused
+      bool paused = false;
+
+      // the motors that were active when the entity was paused
+      std::set<unsigned long> pausedMotors;
+
     };
 
   } // end of namespace sim
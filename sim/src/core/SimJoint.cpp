@@ -354,6 +354,19 @@ namespace mars {
       }
     }
 
+    void SimJoint::setMotorCFM(interfaces::sReal cfm,
+                               unsigned char axis_index) {
+      if (axis_index == 1) {
+        physical_joint->setMotorCFM(cfm);
+      } else {
+        physical_joint->setMotorCFM2(cfm);
+      }
+    }
+
+    void SimJoint::setActive(bool active) {
+      physical_joint->setActive(active);
+    }
+
     void SimJoint::setVelocity2(sReal velocity) { // deprecated
       setVelocity(velocity, 1);
     }
@@ -143,6 +143,13 @@ namespace mars {
       void setSDParams(interfaces::JointData *sJoint);
       void setSJoint(const interfaces::JointData &sJoint);
       void setVelocity(interfaces::sReal velocity, unsigned char axis_index=1);
+      /**
+       * \brief makes the velocity motor an implicit damper with 1/cfm,
+       *        a cfm <= 0 restores the rigid motor
+       */
+      void setMotorCFM(interfaces::sReal cfm, unsigned char axis_index=1);
+      //! a disabled joint does not constrain its nodes
+      void setActive(bool active);
       void setEffort(interfaces::sReal torque, unsigned char axis_index=1);
       void setLowerLimit(interfaces::sReal limit, unsigned char axis_index=1);
       void setUpperLimit(interfaces::sReal limit, unsigned char axis_index=1);
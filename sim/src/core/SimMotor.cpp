@@ -143,6 +143,9 @@ namespace mars {
       }
       // if we have to delete something we can do it here
       if(myJoint) {
+        if(sMotor.type == MOTOR_TYPE_IMPLICIT_PD) {
+          myJoint->setMotorCFM(0.0, sMotor.axis);
+        }
         myJoint->setEffortLimit(0, sMotor.axis);
         myJoint->detachMotor(sMotor.axis);
       }
@@ -261,6 +264,13 @@ namespace mars {
           setJointControlParameter = &SimJoint::setVelocity;
           runController = &SimMotor::runPositionController;
           break;
+        case MOTOR_TYPE_IMPLICIT_PD:
+          controlParameter = &velocity;
+          controlValue = sMotor.value;
+          controlLimit = &(sMotor.maxSpeed);
+          setJointControlParameter = &SimJoint::setVelocity;
+          runController = &SimMotor::runImplicitPDController;
+          break;
         case MOTOR_TYPE_VELOCITY:
         case MOTOR_TYPE_DC: //deprecated
           controlParameter = &velocity;
@@ -414,6 +424,35 @@ namespace mars {
       }
     }
 
+    /**
+     * The drive torque p*(target-x) - d*v is applied implicitly: with the
+     * position at the end of the step x + h*v it equals (p*h+d)*(w - v)
+     * with w = p*(target-x)/(p*h+d). This is a velocity motor towards w
+     * with the damping p*h+d, which ode solves in the motor row of the
+     * joint with a cfm of 1/(p*h+d). Thus the stiffness is not limited by
+     * the step size and the effort limit stays the force limit of the row.
+     * Without a positive damping there is nothing to solve implicitly and
+     * the motor falls back to the explicit position controller.
+     */
+    void SimMotor::runImplicitPDController(sReal time) {
+      double damping = sMotor.p*time/1000.0 + sMotor.d;
+      if(damping <= 0.0) {
+        myJoint->setMotorCFM(0.0, sMotor.axis);
+        runPositionController(time);
+        return;
+      }
+
+      controlValue = mimic_multiplier * controlValue + mimic_offset;
+
+      // limit to range of motion
+      controlValue = std::max(sMotor.minValue,
+        std::min(controlValue, sMotor.maxValue));
+
+      error = controlValue - *position;
+      velocity = sMotor.p*error/damping;
+      myJoint->setMotorCFM(1.0/damping, sMotor.axis);
+    }
+
     void SimMotor::update(sReal time_ms) {
       time = time_ms;// / 1000;
       sReal play_position = 0.0;
@@ -590,6 +629,7 @@ namespace mars {
         case MOTOR_TYPE_POSITION:
         case MOTOR_TYPE_PID_FORCE:
         case MOTOR_TYPE_EFFORT:
+        case MOTOR_TYPE_IMPLICIT_PD:
           controlValue = angle;
           break;
         case MOTOR_TYPE_VELOCITY:
@@ -612,6 +652,7 @@ namespace mars {
         case MOTOR_TYPE_EFFORT:
         case MOTOR_TYPE_UNDEFINED:
         case MOTOR_TYPE_DIRECT_EFFORT:
+        case MOTOR_TYPE_IMPLICIT_PD:
           break;
       }
     }
@@ -622,6 +663,7 @@ namespace mars {
         case MOTOR_TYPE_POSITION:
         case MOTOR_TYPE_PID_FORCE:
         case MOTOR_TYPE_EFFORT:
+        case MOTOR_TYPE_IMPLICIT_PD:
           return controlValue;
           break;
         case MOTOR_TYPE_DC:
@@ -689,6 +731,11 @@ namespace mars {
     }
 
     void SimMotor::setType(interfaces::MotorType mtype){
+      if(sMotor.type == MOTOR_TYPE_IMPLICIT_PD &&
+         mtype != MOTOR_TYPE_IMPLICIT_PD && myJoint) {
+        // give the joint its rigid velocity motor back
+        myJoint->setMotorCFM(0.0, sMotor.axis);
+      }
       sMotor.type = mtype;
       updateController();
     }
@@ -705,6 +752,7 @@ namespace mars {
         case MOTOR_TYPE_EFFORT:
         case MOTOR_TYPE_UNDEFINED:
         case MOTOR_TYPE_DIRECT_EFFORT:
+        case MOTOR_TYPE_IMPLICIT_PD:
           break;
       }
     }
@@ -791,7 +839,8 @@ namespace mars {
         LOG_WARN("SimMotor: Setting the \"offline\" position if the simulation is running can produce bad simulation states!");
       }
       if(sMotor.type == MOTOR_TYPE_POSITION ||
-         sMotor.type == MOTOR_TYPE_PID) {
+         sMotor.type == MOTOR_TYPE_PID ||
+         sMotor.type == MOTOR_TYPE_IMPLICIT_PD) {
         controlValue = value;
       }
       myJoint->setOfflinePosition(value);
@@ -839,6 +888,7 @@ namespace mars {
       case MOTOR_TYPE_POSITION:
       case MOTOR_TYPE_PID_FORCE: // deprecated
       case MOTOR_TYPE_EFFORT:
+      case MOTOR_TYPE_IMPLICIT_PD:
         sMotor.p = mP;
         sMotor.i = mI;
         sMotor.d = mD;
@@ -928,6 +978,7 @@ namespace mars {
         case MOTOR_TYPE_EFFORT:
         case MOTOR_TYPE_UNDEFINED:
         case MOTOR_TYPE_DIRECT_EFFORT:
+        case MOTOR_TYPE_IMPLICIT_PD:
           break;
         }
       };
@@ -72,6 +72,7 @@ namespace mars {
       void updateController();
       void activate(void);
       void deactivate(void);
+      bool isActive(void) const {return active;}
       void attachJoint(SimJoint *joint);
       void attachPlayJoint(SimJoint *joint);
       void estimateCurrent();
@@ -86,6 +87,7 @@ namespace mars {
       void runVelocityController(interfaces::sReal time_ms);
       void runEffortController(interfaces::sReal time_ms);
       void runEffortPipe(interfaces::sReal time);
+      void runImplicitPDController(interfaces::sReal time_ms);
       void addMimic(SimMotor* mimic);
       void removeMimic(std::string mimicname);
       void clearMimics();
@@ -97,6 +97,16 @@ namespace mars {
           }
         }
       }
+      // kinematic nodes can follow the poses of a data broker stream, e.g.
+      // the package of another node or a replayed log
+      if(map.hasKey("kinematic") && map["kinematic"].isMap() &&
+         map["kinematic"].hasKey("stream") && control->dataBroker) {
+        configmaps::ConfigMap &stream = map["kinematic"]["stream"];
+        control->dataBroker->registerSyncReceiver(this,
+                                                  (std::string)stream["group"],
+                                                  (std::string)stream["data"],
+                                                  1);
+      }
       if(map.hasKey("noDataPackage") && (bool)map["noDataPackage"] == true) {
         pushToDataBroker = 0;
       }
@@ -834,6 +844,14 @@ namespace mars {
       }
     }
 
+    void SimNode::getContactForces(std::vector<Vector> *contact_points,
+                                   std::vector<Vector> *forces) const {
+      MutexLocker locker(&iMutex);
+      if(my_interface) {
+        my_interface->getContactForces(contact_points, forces);
+      }
+    }
+
     void SimNode::getContactIDs(std::list<interfaces::NodeId> *ids) const {
       MutexLocker locker(&iMutex);
       if(my_interface) {
@@ -913,6 +931,20 @@ namespace mars {
                               const data_broker::DataPackage& package,
                               int id) {
       sReal value;
+      if(id == 1) {
+        // kinematic stream with the position and rotation items of a node
+        Vector pos = sNode.pos;
+        Quaternion rot = sNode.rot;
+        package.get("position/x", &pos.x());
+        package.get("position/y", &pos.y());
+        package.get("position/z", &pos.z());
+        package.get("rotation/x", &rot.x());
+        package.get("rotation/y", &rot.y());
+        package.get("rotation/z", &rot.z());
+        package.get("rotation/w", &rot.w());
+        if(my_interface) my_interface->setKinematicTarget(pos, rot);
+        return;
+      }
       package.get(4, &value);
       fRotation.x() = value;
       package.get(5, &value);
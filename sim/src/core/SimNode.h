@@ -122,6 +122,8 @@ namespace mars {
       bool getGroundContact(void) const;      
       void getMass(interfaces::sReal *mass, interfaces::sReal *inertia) const;
       void getContactPoints(std::vector<utils::Vector> *contact_points) const;
+      void getContactForces(std::vector<utils::Vector> *contact_points,
+                            std::vector<utils::Vector> *forces) const;
       void getContactIDs(std::list<interfaces::NodeId> *ids) const;
       int getVisualRep(void) const;
       void getDataBrokerNames(std::string *groupName, std::string *dataName) const;
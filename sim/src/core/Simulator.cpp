@@ -79,7 +79,8 @@ namespace mars {
       lib_manager::LibInterface(theManager),
       exit_sim(false), allow_draw(true),
       sync_graphics(false), physics_mutex_count(0), physics(0),
-      haveNewPlugin(false) {
+      next_cable_id(1), haveNewPlugin(false), pluginBatchesChanged(true),
+      parallelPluginUpdate(false) {
 
       config_dir = DEFAULT_CONFIG_DIR;
       calc_time = 0;
@@ -98,6 +99,7 @@ namespace mars {
       // set the calculation step size in ms
       calc_ms      = 10; //defaultCFG->getInt("physics", "calc_ms", 10);
       avg_count_steps = 20;
+      pluginThreads = pluginScheduler.getNumThreads();
       my_real_time = 0;
       // to synchronise drawing and physics
       sync_time = 40;
@@ -277,6 +279,18 @@ namespace mars {
       gravity.z() = cfgGZ.dValue;
       physics->world_gravity = gravity;
       physics->draw_contact_points = cfgDrawContact.bValue;
+      if(control->cfg) {
+        std::string materialFile = configPath.sValue+"/contact_materials.yml";
+        if(pathExists(materialFile)) {
+          configmaps::ConfigMap materials = configmaps::ConfigMap::fromYamlFile(materialFile);
+          physics->setContactMaterials(materials);
+        }
+        std::string fluidFile = configPath.sValue+"/fluid.yml";
+        if(pathExists(fluidFile)) {
+          configmaps::ConfigMap fluid = configmaps::ConfigMap::fromYamlFile(fluidFile);
+          physics->setFluid(fluid);
+        }
+      }
 #ifndef __linux__
       this->setStackSize(16777216);
       fprintf(stderr, "INFO: set physics stack size to: %lu\n", getStackSize());
@@ -374,6 +388,8 @@ namespace mars {
       if(control->dataBroker) {
         control->dataBroker->trigger("mars_sim/prePhysicsUpdate");
       }
+      // after the controllers set the commands of the full models
+      control->entities->updateDynamicsLevels();
       physics->stepTheWorld();
 
       avg_step_time += getTimeDiff(time);
@@ -381,7 +397,13 @@ namespace mars {
       control->nodes->updateDynamicNodes(calc_ms); //Moved update to here, otherwise RaySensor is one step behind the world every time
       control->joints->updateJoints(calc_ms);
       control->motors->updateMotors(calc_ms);
+      control->sensors->updateSensors(calc_ms);
       control->controllers->updateControllers(calc_ms);
+      // publish the object lists of this step for the lookups of other threads
+      control->nodes->publishSnapshot();
+      control->joints->publishSnapshot();
+      control->motors->publishSnapshot();
+      control->sensors->publishSnapshot();
 
       time = utils::getTime();
 
@@ -403,36 +425,7 @@ namespace mars {
         dbSimDebugPackage[2].d = avg_log_time;
         avg_step_time = avg_log_time = 0.0;
       }
-      pluginLocker.lockForRead();
-
-      // It is possible for plugins to call switchPluginUpdateMode during
-      // the update call and get removed from the activePlugins list there.
-      // We use erased_active to notify this loop about an erasure.
-      for(unsigned int i = 0; i < activePlugins.size();) {
-        erased_active = false;
-        time = utils::getTime();
-
-        activePlugins[i].p_interface->update(calc_ms);
-
-        if(!erased_active) {
-          time = getTimeDiff(time);
-          activePlugins[i].timer += time;
-          activePlugins[i].t_count++;
-          if(activePlugins[i].t_count > avg_count_steps) {
-            activePlugins[i].timer /= activePlugins[i].t_count;
-            activePlugins[i].t_count = 0;
-            //fprintf(stderr, "debug_time: %s: %g\n",
-            //        activePlugins[i].name.c_str(),
-            //        activePlugins[i].timer);
-            getTimeMutex.lock();
-            dbSimDebugPackage[i+3].d = activePlugins[i].timer;
-            getTimeMutex.unlock();
-            activePlugins[i].timer = 0.0;
-          }
-          ++i;
-        }
-      }
-      pluginLocker.unlock();
+      updatePlugins();
       if(control->dataBroker) {
         control->dataBroker->pushData(dbSimDebugId,
                                       dbSimDebugPackage);
@@ -707,6 +700,7 @@ namespace mars {
         }
         newPlugins.clear();
         haveNewPlugin = false;
+        pluginBatchesChanged = true;
         pluginLocker.unlock();
       }
 
@@ -745,6 +739,7 @@ namespace mars {
       realStartTime = utils::getTime();
       dbSimTimePackage[0].set(0.);
       control->controllers->clearAllControllers();
+      clearAllCables(clear_all);
       control->sensors->clearAllSensors(clear_all);
       control->motors->clearAllMotors(clear_all);
       control->joints->clearAllJoints(clear_all);
@@ -786,6 +781,60 @@ namespace mars {
       control->joints->reloadJoints();
       control->motors->reloadMotors();
       control->sensors->reloadSensors();
+      reloadCables();
+    }
+
+    unsigned long Simulator::addCable(const configmaps::ConfigMap &config) {
+      MutexLocker locker(&cableMutex);
+      SimCable *cable = new SimCable(control, next_cable_id, config);
+      if(!cable->create()) {
+        delete cable;
+        return 0;
+      }
+      cables[next_cable_id] = cable;
+      cableConfigs[next_cable_id] = config;
+      return next_cable_id++;
+    }
+
+    void Simulator::removeCable(unsigned long id) {
+      MutexLocker locker(&cableMutex);
+      std::map<unsigned long, SimCable*>::iterator it = cables.find(id);
+      if(it != cables.end()) {
+        delete it->second;
+        cables.erase(it);
+      }
+      cableConfigs.erase(id);
+    }
+
+    void Simulator::setCableLength(unsigned long id, sReal length) {
+      MutexLocker locker(&cableMutex);
+      std::map<unsigned long, SimCable*>::iterator it = cables.find(id);
+      if(it != cables.end()) {
+        it->second->setTargetLength(length);
+      }
+    }
+
+    void Simulator::clearAllCables(bool clear_all) {
+      MutexLocker locker(&cableMutex);
+      std::map<unsigned long, SimCable*>::iterator it;
+      for(it=cables.begin(); it!=cables.end(); ++it) {
+        delete it->second;
+      }
+      cables.clear();
+      if(clear_all) {
+        cableConfigs.clear();
+        next_cable_id = 1;
+      }
+    }
+
+    void Simulator::reloadCables(void) {
+      MutexLocker locker(&cableMutex);
+      std::map<unsigned long, configmaps::ConfigMap>::iterator it;
+      for(it=cableConfigs.begin(); it!=cableConfigs.end(); ++it) {
+        SimCable *cable = new SimCable(control, it->first, it->second);
+        if(cable->create()) cables[it->first] = cable;
+        else delete cable;
+      }
     }
 
     void Simulator::readArguments(int argc, char **argv) {
@@ -952,6 +1001,94 @@ namespace mars {
       stepping_mutex.unlock();
     }
 
+    /**
+     * Updates the plugins batch by batch. The plugins of a parallel batch
+     * are updated concurrently on the plugin scheduler, all other
+     * plugins are updated one after the other in the simulation thread.
+     *
+     * It is possible for plugins to call switchPluginUpdateMode during
+     * the update call and get removed from the activePlugins list there.
+     * Thus the index of a plugin is looked up again before and after its
+     * update call.
+     */
+    void Simulator::updatePlugins() {
+      pluginLocker.lockForRead();
+      int threads = pluginThreads;
+      if(threads != pluginScheduler.getNumThreads()) {
+        pluginScheduler.setNumThreads(threads);
+      }
+      if(pluginBatchesChanged) {
+        PluginScheduler::buildBatches(activePlugins, &pluginBatches);
+        pluginBatchesChanged = false;
+      }
+      // switchPluginUpdateMode may rebuild the batches while we iterate
+      std::vector<PluginBatch> batches = pluginBatches;
+      std::vector<PluginInterface*> plugins;
+      std::vector<double> times;
+      for(size_t b = 0; b < batches.size(); ++b) {
+        const PluginBatch &batch = batches[b];
+        if(!batch.parallel || batch.plugins.size() == 1 ||
+           pluginScheduler.getNumThreads() == 0) {
+          for(size_t k = 0; k < batch.plugins.size(); ++k) {
+            PluginInterface *pl = batch.plugins[k];
+            // the plugin may have been switched off by an earlier one
+            if(findActivePlugin(pl) < 0) continue;
+            long long time = utils::getTime();
+            pl->update(calc_ms);
+            int index = findActivePlugin(pl);
+            if(index >= 0) updatePluginTime(index, getTimeDiff(time));
+          }
+          continue;
+        }
+
+        plugins.clear();
+        for(size_t k = 0; k < batch.plugins.size(); ++k) {
+          if(findActivePlugin(batch.plugins[k]) >= 0) {
+            plugins.push_back(batch.plugins[k]);
+          }
+        }
+        parallelPluginUpdate = true;
+        pluginScheduler.update(plugins, calc_ms, &times);
+        parallelPluginUpdate = false;
+
+        pendingPluginSwitchMutex.lock();
+        std::vector<std::pair<int, PluginInterface*> > switches;
+        switches.swap(pendingPluginSwitches);
+        pendingPluginSwitchMutex.unlock();
+        for(size_t k = 0; k < switches.size(); ++k) {
+          switchPluginUpdateMode(switches[k].first, switches[k].second);
+        }
+        for(size_t k = 0; k < plugins.size(); ++k) {
+          int index = findActivePlugin(plugins[k]);
+          if(index >= 0) updatePluginTime(index, times[k]);
+        }
+      }
+      pluginLocker.unlock();
+    }
+
+    int Simulator::findActivePlugin(const PluginInterface *pl) const {
+      for(size_t i = 0; i < activePlugins.size(); ++i) {
+        if(activePlugins[i].p_interface == pl) return (int)i;
+      }
+      return -1;
+    }
+
+    void Simulator::updatePluginTime(int i, double time) {
+      activePlugins[i].timer += time;
+      activePlugins[i].t_count++;
+      if(activePlugins[i].t_count > avg_count_steps) {
+        activePlugins[i].timer /= activePlugins[i].t_count;
+        activePlugins[i].t_count = 0;
+        //fprintf(stderr, "debug_time: %s: %g\n",
+        //        activePlugins[i].name.c_str(),
+        //        activePlugins[i].timer);
+        getTimeMutex.lock();
+        dbSimDebugPackage[i+3].d = activePlugins[i].timer;
+        getTimeMutex.unlock();
+        activePlugins[i].timer = 0.0;
+      }
+    }
+
     void Simulator::switchPluginUpdateMode(int mode, PluginInterface *pl) {
       std::vector<pluginStruct>::iterator p_iter;
       bool afound = false;
@@ -959,6 +1096,13 @@ namespace mars {
       bool bfound = false;
       data_broker::DataPackage tmpPackage;
 
+      if(parallelPluginUpdate) {
+        MutexLocker locker(&pendingPluginSwitchMutex);
+        pendingPluginSwitches.push_back(std::make_pair(mode, pl));
+        return;
+      }
+      pluginBatchesChanged = true;
+
       size_t i=0;
       for(p_iter=activePlugins.begin(); p_iter!=activePlugins.end();
           p_iter++, ++i) {
@@ -966,7 +1110,6 @@ namespace mars {
           afound = true;
           if(!(mode & PLUGIN_SIM_MODE)) {
             activePlugins.erase(p_iter);
-            erased_active = true;
             bfound = true;
           }
           break;
@@ -1137,6 +1280,7 @@ namespace mars {
           break;
         }
       }
+      pluginBatchesChanged = true;
 
       pluginLocker.unlock();
     }
@@ -1291,6 +1435,12 @@ namespace mars {
         return;
       }
 
+      if(_property.paramId == cfgPluginThreads.paramId) {
+        // applied by the simulation thread before the next plugin update
+        pluginThreads = _property.iValue;
+        return;
+      }
+
     }
 
     void Simulator::initCfgParams(void) {
@@ -1341,6 +1491,10 @@ namespace mars {
       cfgAvgCountSteps = control->cfg->getOrCreateProperty("Simulator", "avg count steps",
                                                            avg_count_steps, this);
       avg_count_steps = cfgAvgCountSteps.iValue;
+
+      cfgPluginThreads = control->cfg->getOrCreateProperty("Simulator", "plugin threads",
+                                                           pluginThreads.load(), this);
+      pluginThreads = cfgPluginThreads.iValue;
       control->cfg->getOrCreateProperty("Simulator", "onPhysicsError",
                                         "abort", this);
 
@@ -45,6 +45,10 @@
 #include <mars/interfaces/sim/ControlCenter.h>
 #include <mars/interfaces/graphics/GraphicsUpdateInterface.h>
 
+#include "PluginScheduler.h"
+#include "SimCable.h"
+
+#include <atomic>
 #include <iostream>
 
 
@@ -140,6 +144,11 @@ namespace mars {
       virtual void disconnectNodes(unsigned long id1, unsigned long id2);
       virtual void rescaleEnvironment(interfaces::sReal x, interfaces::sReal y, interfaces::sReal z);
 
+      // cables
+      virtual unsigned long addCable(const configmaps::ConfigMap &config);
+      virtual void removeCable(unsigned long id);
+      virtual void setCableLength(unsigned long id, interfaces::sReal length);
+
       // scenes
       virtual int loadScene(const std::string &filename,
                             const std::string &robotname,bool threadsave=false, bool blocking=false);
@@ -245,7 +254,6 @@ namespace mars {
       int cameraMenuCheckedIndex;
 
       // threads
-      bool erased_active;
       utils::ReadWriteLock pluginLocker;
       int sync_count;
       utils::Mutex externalMutex;
@@ -270,11 +278,32 @@ namespace mars {
       unsigned long dbSimTimeId, dbSimDebugId;
       unsigned long realStartTime;
 
+      // cables, the configs are kept to recreate them on reset
+      std::map<unsigned long, SimCable*> cables;
+      std::map<unsigned long, configmaps::ConfigMap> cableConfigs;
+      unsigned long next_cable_id;
+      utils::Mutex cableMutex;
+      void clearAllCables(bool clear_all);
+      void reloadCables(void);
+
       // plugins
       std::vector<interfaces::pluginStruct> allPlugins;
       std::vector<interfaces::pluginStruct> newPlugins;
       std::vector<interfaces::pluginStruct> activePlugins;
       std::vector<interfaces::pluginStruct> guiPlugins;
+      PluginScheduler pluginScheduler;
+      std::vector<PluginBatch> pluginBatches;
+      bool pluginBatchesChanged;
+      // set by the cfg callback, applied in updatePlugins()
+      std::atomic<int> pluginThreads;
+      // switchPluginUpdateMode calls from plugins updated concurrently,
+      // they are applied after the batch is finished
+      bool parallelPluginUpdate;
+      std::vector<std::pair<int, interfaces::PluginInterface*> > pendingPluginSwitches;
+      utils::Mutex pendingPluginSwitchMutex;
+      int findActivePlugin(const interfaces::PluginInterface *pl) const;
+      void updatePluginTime(int index, double time);
+      void updatePlugins();
 
       // scenes
       int loadScene_internal(const std::string &filename, bool wasrunning, const std::string &robotname);
@@ -296,6 +325,7 @@ namespace mars {
       cfg_manager::cfgPropertyStruct configPath;
       cfg_manager::cfgPropertyStruct cfgUseNow;
       cfg_manager::cfgPropertyStruct cfgAvgCountSteps;
+      cfg_manager::cfgPropertyStruct cfgPluginThreads;
       
       // data
       data_broker::DataPackage dbPhysicsUpdatePackage;
@@ -0,0 +1,566 @@
+/*
+ *  Copyright 2017, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "Articulation.h"
+#include "JointPhysics.h"
+
+#include <mars/interfaces/Logging.hpp>
+
+#include <Eigen/Dense>
+#include <cmath>
+#include <map>
+#include <set>
+
+namespace mars {
+  namespace sim {
+
+    using namespace utils;
+    using namespace interfaces;
+
+    namespace {
+
+      // maximal number of solves to find the saturated velocity motors
+      const int maxMotorIterations = 4;
+
+      Tensor skew(const Vector &v) {
+        Tensor m;
+        m << 0, -v.z(), v.y(),
+             v.z(), 0, -v.x(),
+             -v.y(), v.x(), 0;
+        return m;
+      }
+
+      // spatial cross product for motion vectors
+      SpatialVector crossMotion(const SpatialVector &v, const SpatialVector &m) {
+        Vector w = v.head<3>(), vo = v.tail<3>();
+        Vector mw = m.head<3>(), mv = m.tail<3>();
+        SpatialVector r;
+        r << w.cross(mw), w.cross(mv) + vo.cross(mw);
+        return r;
+      }
+
+      // spatial cross product for force vectors
+      SpatialVector crossForce(const SpatialVector &v, const SpatialVector &f) {
+        Vector w = v.head<3>(), vo = v.tail<3>();
+        Vector n = f.head<3>(), lin = f.tail<3>();
+        SpatialVector r;
+        r << w.cross(n) + vo.cross(lin), w.cross(lin);
+        return r;
+      }
+
+      SpatialMatrix spatialInertia(double m, const Vector &com, const Tensor &Ic) {
+        Tensor C = skew(com);
+        SpatialMatrix I;
+        I.topLeftCorner<3, 3>() = Ic - m*C*C;
+        I.topRightCorner<3, 3>() = m*C;
+        I.bottomLeftCorner<3, 3>() = -m*C;
+        I.bottomRightCorner<3, 3>() = m*Tensor::Identity();
+        return I;
+      }
+
+      Vector toVector(const dReal *v) {
+        return Vector(v[0], v[1], v[2]);
+      }
+
+    } // end of anonymous namespace
+
+    Articulation::Articulation() : fixedBase(false), enabled(false) {
+    }
+
+    Articulation::~Articulation() {
+      for(size_t i = 0; i < links.size(); ++i) {
+        if(links[i].joint) dJointEnable(links[i].joint->jointId);
+      }
+    }
+
+    dBodyID Articulation::getJointBody(const JointPhysics *joint, int index) {
+      return dJointGetBody(joint->jointId, index);
+    }
+
+    void Articulation::build(const std::vector<JointPhysics*> &joints,
+                             std::vector<Articulation*> *articulations) {
+      std::map<dBodyID, std::vector<JointPhysics*> > adjacency;
+      for(size_t i = 0; i < joints.size(); ++i) {
+        dBodyID b1 = getJointBody(joints[i], 0);
+        dBodyID b2 = getJointBody(joints[i], 1);
+        if(b1) adjacency[b1].push_back(joints[i]);
+        if(b2) adjacency[b2].push_back(joints[i]);
+      }
+
+      std::set<dBodyID> visited;
+      std::map<dBodyID, std::vector<JointPhysics*> >::iterator it;
+      for(it = adjacency.begin(); it != adjacency.end(); ++it) {
+        if(visited.count(it->first)) continue;
+
+        // collect the connected bodies and joints
+        std::vector<dBodyID> bodies, stack(1, it->first);
+        std::set<JointPhysics*> treeJoints;
+        std::vector<JointPhysics*> worldJoints;
+        visited.insert(it->first);
+        while(!stack.empty()) {
+          dBodyID body = stack.back();
+          stack.pop_back();
+          bodies.push_back(body);
+          std::vector<JointPhysics*> &bodyJoints = adjacency[body];
+          for(size_t k = 0; k < bodyJoints.size(); ++k) {
+            JointPhysics *joint = bodyJoints[k];
+            if(!treeJoints.insert(joint).second) continue;
+            dBodyID other = getJointBody(joint, 0) == body ?
+              getJointBody(joint, 1) : getJointBody(joint, 0);
+            if(!other) worldJoints.push_back(joint);
+            else if(!visited.count(other)) {
+              visited.insert(other);
+              stack.push_back(other);
+            }
+          }
+        }
+        if(worldJoints.size() > 1 ||
+           treeJoints.size() != bodies.size() - 1 + worldJoints.size()) {
+          LOG_WARN("Articulation: %lu articulated joints form a loop, they are solved by ode",
+                   (unsigned long)treeJoints.size());
+          continue;
+        }
+
+        // order the links from the root to the leaves
+        Articulation *articulation = new Articulation();
+        articulation->fixedBase = !worldJoints.empty();
+        dBodyID root = it->first;
+        JointPhysics *rootJoint = 0;
+        if(articulation->fixedBase) {
+          rootJoint = worldJoints[0];
+          root = getJointBody(rootJoint, 0) ? getJointBody(rootJoint, 0) :
+            getJointBody(rootJoint, 1);
+        }
+        else {
+          // the heaviest body makes the best floating base
+          dReal maxMass = -1.0;
+          for(size_t k = 0; k < bodies.size(); ++k) {
+            dMass m;
+            dBodyGetMass(bodies[k], &m);
+            if(m.mass > maxMass) {
+              maxMass = m.mass;
+              root = bodies[k];
+            }
+          }
+        }
+        std::set<JointPhysics*> used;
+        if(rootJoint) used.insert(rootJoint);
+        std::vector<std::pair<dBodyID, std::pair<int, JointPhysics*> > > queue;
+        queue.push_back(std::make_pair(root, std::make_pair(-1, rootJoint)));
+        for(size_t n = 0; n < queue.size(); ++n) {
+          Link link;
+          link.body = queue[n].first;
+          link.parent = queue[n].second.first;
+          link.joint = queue[n].second.second;
+          link.dof = 0;
+          link.prismatic = false;
+          link.sign = 1.0;
+          if(link.joint) {
+            link.dof = link.joint->joint_type == JOINT_TYPE_FIXED ? 0 : 1;
+            link.prismatic = link.joint->joint_type == JOINT_TYPE_SLIDER;
+            link.sign = getJointBody(link.joint, 0) == link.body ? 1.0 : -1.0;
+          }
+          articulation->links.push_back(link);
+          std::vector<JointPhysics*> &bodyJoints = adjacency[link.body];
+          for(size_t k = 0; k < bodyJoints.size(); ++k) {
+            JointPhysics *joint = bodyJoints[k];
+            if(!used.insert(joint).second) continue;
+            dBodyID child = getJointBody(joint, 0) == link.body ?
+              getJointBody(joint, 1) : getJointBody(joint, 0);
+            queue.push_back(std::make_pair(child, std::make_pair((int)n, joint)));
+          }
+        }
+        std::set<JointPhysics*>::iterator jIt;
+        for(jIt = treeJoints.begin(); jIt != treeJoints.end(); ++jIt) {
+          dJointDisable((*jIt)->jointId);
+        }
+        articulations->push_back(articulation);
+      }
+    }
+
+    void Articulation::beginStep(dReal stepSize) {
+      // a disabled tree is neither moved by ode nor by the articulation
+      enabled = !links.empty() && dBodyIsEnabled(links[0].body);
+      if(!enabled) return;
+      ref = toVector(dBodyGetPosition(links[0].body));
+      for(size_t i = 0; i < links.size(); ++i) {
+        Link &l = links[i];
+        const dReal *q = dBodyGetQuaternion(l.body);
+        l.pos = toVector(dBodyGetPosition(l.body));
+        l.rot = Quaternion(q[0], q[1], q[2], q[3]);
+        l.linVel = toVector(dBodyGetLinearVel(l.body));
+        l.angVel = toVector(dBodyGetAngularVel(l.body));
+        dBodyGetMass(l.body, &l.odeMass);
+        l.mass = l.odeMass.mass;
+        for(int r = 0; r < 3; ++r) {
+          for(int c = 0; c < 3; ++c) l.inertia(r, c) = l.odeMass.I[r*4+c];
+        }
+        const Tensor R = l.rot.toRotationMatrix();
+        l.I = spatialInertia(l.mass, l.pos - ref, R*l.inertia*R.transpose());
+        l.contactMass = 0.0;
+
+        l.q = l.qd = 0.0;
+        l.lo = -dInfinity;
+        l.hi = dInfinity;
+        l.motor = false;
+        l.motorDamping = 0.0;
+        if(!l.joint) continue;
+        dJointID id = l.joint->jointId;
+        dReal cfm = 0.0;
+        if(l.dof && l.prismatic) {
+          l.q = dJointGetSliderPosition(id);
+          l.qd = dJointGetSliderPositionRate(id);
+          l.lo = dJointGetSliderParam(id, dParamLoStop);
+          l.hi = dJointGetSliderParam(id, dParamHiStop);
+          l.motorVel = dJointGetSliderParam(id, dParamVel);
+          l.motorFMax = dJointGetSliderParam(id, dParamFMax);
+          cfm = dJointGetSliderParam(id, dParamCFM);
+        }
+        else if(l.dof) {
+          l.q = dJointGetHingeAngle(id);
+          l.qd = dJointGetHingeAngleRate(id);
+          l.lo = dJointGetHingeParam(id, dParamLoStop);
+          l.hi = dJointGetHingeParam(id, dParamHiStop);
+          l.motorVel = dJointGetHingeParam(id, dParamVel);
+          l.motorFMax = dJointGetHingeParam(id, dParamFMax);
+          cfm = dJointGetHingeParam(id, dParamCFM);
+        }
+        l.motor = l.dof && l.motorFMax > 0.0;
+        if(l.motor && cfm > dWorldGetCFM(dBodyGetWorld(l.body))) {
+          l.motorDamping = 1.0/cfm;
+        }
+
+        // the joint geometry of the pose before the step, the parents
+        // are stored before their children
+        Vector parentPos = Vector::Zero();
+        Quaternion parentRot = Quaternion::Identity();
+        if(l.parent >= 0) {
+          parentPos = links[l.parent].pos;
+          parentRot = links[l.parent].rot;
+        }
+        dVector3 anchor, axis;
+        anchor[0] = anchor[1] = anchor[2] = 0.0;
+        if(l.prismatic) {
+          dJointGetSliderAxis(id, axis);
+        }
+        else if(l.dof) {
+          dJointGetHingeAnchor(id, anchor);
+          dJointGetHingeAxis(id, axis);
+        }
+        else {
+          axis[0] = axis[1] = axis[2] = 0.0;
+        }
+        Vector anchorW = toVector(anchor), axisW = toVector(axis);
+        Quaternion parentInv = parentRot.inverse();
+        l.anchor = parentInv*(anchorW - parentPos);
+        l.axis = parentInv*axisW;
+        l.relPos = parentInv*(l.pos - parentPos);
+        l.relRot = parentInv*l.rot;
+        if(l.prismatic) l.S << Vector::Zero(), axisW;
+        else l.S << axisW, (anchorW-ref).cross(axisW);
+        l.S *= l.sign;
+      }
+      setContactInertia(stepSize);
+    }
+
+    /**
+     * The tree joints add no rows to the ode step. Instead every link
+     * body gets the articulated inertia of its subtree during the step,
+     * thus ode solves the contacts of a link against the inertia that the
+     * tree puts behind it. The coupling between the linear and the angular
+     * part is dropped, the mass is the mean of the linear part.
+     */
+    void Articulation::setContactInertia(double dt) {
+      const size_t n = links.size();
+      for(size_t i = 0; i < n; ++i) links[i].IA = links[i].I;
+      for(size_t k = n; k-- > 0;) {
+        Link &l = links[k];
+        if(l.parent < 0) continue;
+        SpatialMatrix Ia = l.IA;
+        // a rigid motor passes the whole subtree to the parent
+        if(l.dof && !(l.motor && l.motorDamping <= 0.0)) {
+          SpatialVector U = l.IA*l.S;
+          double D = l.S.dot(U);
+          if(l.motor) D += l.motorDamping*dt;
+          if(D > 1e-12) Ia -= U*U.transpose()/D;
+        }
+        links[l.parent].IA += Ia;
+      }
+
+      for(size_t i = 0; i < n; ++i) {
+        Link &l = links[i];
+        // the inertia about the center of mass of the link
+        const Tensor C = skew(l.pos - ref);
+        const Tensor A = l.IA.topLeftCorner<3, 3>();
+        const Tensor B = l.IA.topRightCorner<3, 3>();
+        const Tensor M = l.IA.bottomRightCorner<3, 3>();
+        Tensor Ic = A + B*C - C*B.transpose() - C*M*C;
+        Ic = 0.5*(Ic + Ic.transpose());
+        const dReal mass = M.trace()/3.0;
+        if(mass <= l.mass) continue;
+        const Tensor R = l.rot.toRotationMatrix();
+        const Tensor Ib = R.transpose()*Ic*R;
+        dMass m;
+        dMassSetParameters(&m, mass, 0, 0, 0, Ib(0, 0), Ib(1, 1), Ib(2, 2),
+                           Ib(0, 1), Ib(0, 2), Ib(1, 2));
+        if(!dMassCheck(&m)) continue;
+        dBodySetMass(l.body, &m);
+        l.contactMass = mass;
+        l.contactInertia = Ic;
+      }
+    }
+
+    void Articulation::endStep(dReal stepSize) {
+      if(!enabled || stepSize <= 0) return;
+      const double dt = stepSize;
+      dVector3 gravity;
+      dWorldGetGravity(dBodyGetWorld(links[0].body), gravity);
+
+      for(size_t i = 0; i < links.size(); ++i) {
+        Link &l = links[i];
+        const Vector com = l.pos - ref;
+        const Tensor R = l.rot.toRotationMatrix();
+        Tensor Iw = R*l.inertia*R.transpose();
+        dReal mass = l.mass;
+        Vector f = Vector::Zero();
+        if(l.contactMass > 0.0) {
+          // ode applied the gravity to the contact mass
+          dBodySetMass(l.body, &l.odeMass);
+          mass = l.contactMass;
+          Iw = l.contactInertia;
+          f = (l.mass - mass)*toVector(gravity);
+        }
+
+        // with the tree joints disabled the velocity change of the ode
+        // step is caused by the applied forces, gravity, the contacts and
+        // all other constraints on the link
+        Vector linVel = toVector(dBodyGetLinearVel(l.body));
+        Vector angVel = toVector(dBodyGetAngularVel(l.body));
+        f += mass*(linVel - l.linVel)/dt;
+        Vector n = Iw*(angVel - l.angVel)/dt + l.angVel.cross(Iw*l.angVel);
+        l.fext << n + com.cross(f), f;
+      }
+      computeDynamics(dt);
+      integrate(dt);
+      writeFeedback();
+    }
+
+    void Articulation::computeDynamics(double dt) {
+      const size_t n = links.size();
+
+      // velocities and velocity dependent terms from the root to the leaves
+      for(size_t i = 0; i < n; ++i) {
+        Link &l = links[i];
+        if(!l.joint) {
+          l.v << l.angVel, l.linVel - l.angVel.cross(l.pos - ref);
+          l.c.setZero();
+        }
+        else {
+          SpatialVector vp = SpatialVector::Zero();
+          if(l.parent >= 0) vp = links[l.parent].v;
+          SpatialVector vj = l.S*(l.dof ? l.qd : 0.0);
+          l.v = vp + vj;
+          l.c = crossMotion(l.v, vj);
+        }
+        l.bias = crossForce(l.v, l.I*l.v) - l.fext;
+        l.prescribed = l.motor && l.motorDamping <= 0.0;
+        l.damped = l.motor && l.motorDamping > 0.0;
+        l.tau = l.damped ? l.motorDamping*(l.motorVel - l.qd) : 0.0;
+      }
+
+      for(int iteration = 0; iteration < maxMotorIterations; ++iteration) {
+        for(size_t i = 0; i < n; ++i) {
+          links[i].IA = links[i].I;
+          links[i].pA = links[i].bias;
+        }
+        // articulated inertias from the leaves to the root
+        for(size_t k = n; k-- > 0;) {
+          Link &l = links[k];
+          if(!l.joint) continue;
+          SpatialMatrix Ia = l.IA;
+          SpatialVector pa = l.pA;
+          if(l.dof && l.prescribed) {
+            l.qdd = (l.motorVel - l.qd)/dt;
+            pa += l.IA*(l.c + l.S*l.qdd);
+          }
+          else if(l.dof) {
+            l.U = l.IA*l.S;
+            l.D = l.S.dot(l.U);
+            // the damper acts on the velocity at the end of the step
+            if(l.damped) l.D += l.motorDamping*dt;
+            l.u = l.tau - l.S.dot(l.pA);
+            if(l.D > 1e-12) {
+              Ia -= l.U*l.U.transpose()/l.D;
+              pa += l.U*l.u/l.D;
+            }
+            pa += Ia*l.c;
+          }
+          else {
+            pa += Ia*l.c;
+          }
+          if(l.parent >= 0) {
+            links[l.parent].IA += Ia;
+            links[l.parent].pA += pa;
+          }
+        }
+        // accelerations from the root to the leaves
+        for(size_t i = 0; i < n; ++i) {
+          Link &l = links[i];
+          if(!l.joint) {
+            l.a = -l.IA.ldlt().solve(l.pA);
+            continue;
+          }
+          SpatialVector ap = SpatialVector::Zero();
+          if(l.parent >= 0) ap = links[l.parent].a;
+          l.a = ap + l.c;
+          if(l.dof && !l.prescribed) {
+            l.qdd = l.D > 1e-12 ? (l.u - l.U.dot(l.a))/l.D : 0.0;
+          }
+          if(l.dof) l.a += l.S*l.qdd;
+        }
+        // velocity motors that can't reach their velocity are saturated
+        bool saturated = false;
+        for(size_t i = 0; i < n; ++i) {
+          Link &l = links[i];
+          if(l.dof && l.damped) {
+            double torque = l.motorDamping*(l.motorVel - l.qd - dt*l.qdd);
+            if(fabs(torque) > l.motorFMax) {
+              l.damped = false;
+              l.tau = torque > 0 ? l.motorFMax : -l.motorFMax;
+              saturated = true;
+            }
+            continue;
+          }
+          if(!l.dof || !l.prescribed) continue;
+          double torque = l.S.dot(l.IA*l.a + l.pA);
+          if(fabs(torque) > l.motorFMax) {
+            l.prescribed = false;
+            l.tau = torque > 0 ? l.motorFMax : -l.motorFMax;
+            saturated = true;
+          }
+          else {
+            l.tau = torque;
+          }
+        }
+        if(!saturated) break;
+      }
+      // the torque of the damped motors for the joint feedback
+      for(size_t i = 0; i < n; ++i) {
+        Link &l = links[i];
+        if(l.dof && l.damped) {
+          l.tau = l.motorDamping*(l.motorVel - l.qd - dt*l.qdd);
+        }
+      }
+    }
+
+    void Articulation::integrate(double dt) {
+      for(size_t i = 0; i < links.size(); ++i) {
+        Link &l = links[i];
+        l.dq = 0.0;
+        if(!l.dof) continue;
+        l.qd += l.qdd*dt;
+        l.dq = l.qd*dt;
+        if(l.q + l.dq > l.hi) {
+          l.dq = std::max(0.0, l.hi - l.q);
+          if(l.qd > 0.0) l.qd = 0.0;
+        }
+        else if(l.q + l.dq < l.lo) {
+          l.dq = std::min(0.0, l.lo - l.q);
+          if(l.qd < 0.0) l.qd = 0.0;
+        }
+      }
+
+      for(size_t i = 0; i < links.size(); ++i) {
+        Link &l = links[i];
+        if(!l.joint) {
+          l.v += l.a*dt;
+          Vector w = l.v.head<3>();
+          Vector comVel = l.v.tail<3>() + w.cross(l.pos - ref);
+          l.pos += comVel*dt;
+          double angle = w.norm()*dt;
+          if(angle > 1e-12) {
+            l.rot = Quaternion(Eigen::AngleAxisd(angle, w.normalized()))*l.rot;
+            l.rot.normalize();
+          }
+        }
+        else {
+          Vector parentPos = Vector::Zero();
+          Quaternion parentRot = Quaternion::Identity();
+          SpatialVector vp = SpatialVector::Zero();
+          if(l.parent >= 0) {
+            parentPos = links[l.parent].pos;
+            parentRot = links[l.parent].rot;
+            vp = links[l.parent].v;
+          }
+          if(l.dof && l.prismatic) {
+            l.relPos += l.axis*l.sign*l.dq;
+          }
+          else if(l.dof) {
+            Quaternion dr(Eigen::AngleAxisd(l.sign*l.dq, l.axis.normalized()));
+            l.relPos = l.anchor + dr*(l.relPos - l.anchor);
+            l.relRot = dr*l.relRot;
+          }
+          l.pos = parentPos + parentRot*l.relPos;
+          l.rot = parentRot*l.relRot;
+          l.rot.normalize();
+          Vector axisW = parentRot*l.axis;
+          if(l.prismatic) l.S << Vector::Zero(), axisW;
+          else l.S << axisW, (parentPos + parentRot*l.anchor - ref).cross(axisW);
+          l.S *= l.sign;
+          l.v = vp + l.S*(l.dof ? l.qd : 0.0);
+        }
+
+        Vector w = l.v.head<3>();
+        Vector comVel = l.v.tail<3>() + w.cross(l.pos - ref);
+        dBodySetPosition(l.body, l.pos.x(), l.pos.y(), l.pos.z());
+        dQuaternion q = {l.rot.w(), l.rot.x(), l.rot.y(), l.rot.z()};
+        dBodySetQuaternion(l.body, q);
+        dBodySetLinearVel(l.body, comVel.x(), comVel.y(), comVel.z());
+        dBodySetAngularVel(l.body, w.x(), w.y(), w.z());
+      }
+    }
+
+    void Articulation::writeFeedback() {
+      for(size_t i = 0; i < links.size(); ++i) {
+        Link &l = links[i];
+        if(!l.joint) continue;
+        // the force the parent applies to the subtree of the link
+        SpatialVector f = l.IA*l.a + l.pA;
+        Vector force = f.tail<3>(), moment = f.head<3>();
+        Vector parentPos = l.parent >= 0 ? Vector(links[l.parent].pos) : ref;
+        Vector t = moment - (l.pos - ref).cross(force);
+        Vector tp = -moment + (parentPos - ref).cross(force);
+        dJointFeedback &fb = l.joint->feedback;
+        Vector f1 = l.sign > 0 ? force : Vector(-force);
+        Vector f2 = -f1;
+        Vector t1 = l.sign > 0 ? t : tp;
+        Vector t2 = l.sign > 0 ? tp : t;
+        for(int k = 0; k < 3; ++k) {
+          fb.f1[k] = f1[k];
+          fb.t1[k] = t1[k];
+          fb.f2[k] = f2[k];
+          fb.t2[k] = t2[k];
+        }
+        fb.lambda = l.dof ? l.tau : 0.0;
+      }
+    }
+
+  } // end of namespace sim
+} // end of namespace mars
@@ -0,0 +1,152 @@
+/*
+ *  Copyright 2017, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * \file Articulation.h
+ * \brief Joint space dynamics of a kinematic tree of ode bodies using the
+ *        articulated body algorithm.
+ */
+
+#ifndef ARTICULATION_H
+#define ARTICULATION_H
+
+#ifdef _PRINT_HEADER_
+  #warning "Articulation.h"
+#endif
+
+#include <mars/utils/Vector.h>
+#include <mars/utils/Quaternion.h>
+
+#include <ode/ode.h>
+#include <vector>
+
+namespace mars {
+  namespace sim {
+
+    class JointPhysics;
+
+    // spatial vectors are stored as [angular; linear]
+    typedef Eigen::Matrix<double, 6, 1, Eigen::DontAlign> SpatialVector;
+    typedef Eigen::Matrix<double, 6, 6, Eigen::DontAlign> SpatialMatrix;
+
+    /**
+     * An Articulation integrates a tree of bodies connected by hinge,
+     * slider and fixed joints in joint space with Featherstone's
+     * articulated body algorithm. The ode joints of the tree are disabled,
+     * thus ode only integrates the links as free bodies with their
+     * contacts. During the ode step every link body carries the
+     * articulated inertia of its subtree, thus a contact pushes against
+     * the inertia the tree puts behind the link. After the ode step the
+     * change of the link velocities is taken as external impulse
+     * (contacts, other joints, damping) and the tree is integrated from
+     * the state before the step. The result is written back to the ode
+     * bodies. Trees with a disabled root body are skipped.
+     *
+     * All forces added to the link bodies, including the torques of
+     * JointPhysics::setTorque, act on the tree. Velocity motors are solved
+     * implicitly with their force limit, a motor cfm above the one of the
+     * world makes them a damper with the coefficient 1/cfm like in the
+     * ode motor row. The joint positions and
+     * velocities are still read from the disabled ode joints and the joint
+     * feedback is filled with the force transmitted by the joint.
+     *
+     * All spatial quantities are expressed in world orientation relative to
+     * the position of the root link at the begin of the step.
+     */
+    class Articulation {
+    public:
+      ~Articulation();
+
+      /**
+       * \brief Splits the \a joints into trees and creates an Articulation
+       * for each of them. Joints that form a loop are left to ode.
+       */
+      static void build(const std::vector<JointPhysics*> &joints,
+                        std::vector<Articulation*> *articulations);
+
+      /**
+       * \brief Stores the state of the links and sets their contact
+       * inertia. Has to be called right before the ode step.
+       */
+      void beginStep(dReal stepSize);
+
+      /**
+       * \brief Integrates the tree by \a stepSize and overwrites the result
+       * of the ode step for the links.
+       */
+      void endStep(dReal stepSize);
+
+    private:
+      struct Link {
+        dBodyID body;
+        // index of the parent link, -1 for the root and for links that
+        // are connected to the world
+        int parent;
+        // 0 for a floating root
+        JointPhysics *joint;
+        int dof;
+        bool prismatic;
+        // +1 if the link is the first body of the joint
+        double sign;
+
+        // state at the begin of the step
+        utils::Vector pos, linVel, angVel;
+        utils::Quaternion rot;
+        dReal mass;
+        utils::Tensor inertia;
+        // the ode mass of the body and the articulated inertia (in world
+        // orientation) it carries during the ode step, 0 if it keeps its
+        // own mass
+        dMass odeMass;
+        dReal contactMass;
+        utils::Tensor contactInertia;
+        double q, qd, lo, hi;
+        bool motor, prescribed, damped;
+        // 0 for rigid velocity motors
+        double motorVel, motorFMax, motorDamping;
+
+        // joint geometry in the parent frame and pose relative to the parent
+        utils::Vector anchor, axis, relPos;
+        utils::Quaternion relRot;
+
+        // algorithm quantities
+        SpatialVector S, v, c, fext, bias, pA, U, a;
+        SpatialMatrix I, IA;
+        double D, u, tau, qdd, dq;
+      };
+
+      std::vector<Link> links;
+      bool fixedBase;
+      // false if the root body was disabled at the begin of the step
+      bool enabled;
+      utils::Vector ref;
+
+      Articulation();
+      static dBodyID getJointBody(const JointPhysics *joint, int index);
+      void setContactInertia(double dt);
+      void computeDynamics(double dt);
+      void integrate(double dt);
+      void writeFeedback();
+    };
+
+  } // end of namespace sim
+} // end of namespace mars
+
+#endif  // ARTICULATION_H
@@ -0,0 +1,427 @@
+/*
+ *  Copyright 2017, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "CablePhysics.h"
+#include "NodePhysics.h"
+
+#include <mars/interfaces/Logging.hpp>
+#include <mars/utils/MutexLocker.h>
+#include <mars/utils/mathUtils.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace mars {
+  namespace sim {
+
+    using namespace utils;
+    using namespace interfaces;
+    using namespace configmaps;
+
+    CablePhysics::CablePhysics(PhysicsInterface *world) {
+      theWorld = (WorldPhysics*)world;
+      created = false;
+      probe = 0;
+      probeIndex = 0;
+      length = targetLength = 0;
+      tension[0] = tension[1] = 0;
+      for(int k=0; k<2; ++k) {
+        anchors[k].type = Anchor::FREE;
+        anchors[k].body = 0;
+      }
+    }
+
+    CablePhysics::~CablePhysics() {
+      MutexLocker locker(&(theWorld->iMutex));
+      if(created) theWorld->removeCable(this);
+      if(probe) dGeomDestroy(probe);
+    }
+
+    void CablePhysics::setWorldObject(PhysicsInterface *world) {
+      theWorld = (WorldPhysics*)world;
+    }
+
+    bool CablePhysics::createCable(const ConfigMap &config,
+                                   NodeInterface *node1,
+                                   NodeInterface *node2) {
+      ConfigMap map = config;
+      NodeInterface *nodes[2] = {node1, node2};
+      const char *keys[2] = {"start", "end"};
+      Vector points[2];
+
+      // the node poses are read before the world is locked
+      for(int k=0; k<2; ++k) {
+        Anchor &anchor = anchors[k];
+        anchor.type = Anchor::FREE;
+        anchor.body = 0;
+        ConfigMap end;
+        if(map.hasKey(keys[k]) && map[keys[k]].isMap()) end = map[keys[k]];
+        Vector offset = Vector::Zero();
+        if(end.hasKey("offset")) vectorFromConfigItem(&end["offset"], &offset);
+        if(nodes[k]) {
+          Vector pos;
+          Quaternion rot;
+          nodes[k]->getPosition(&pos);
+          nodes[k]->getRotation(&rot);
+          points[k] = pos + rot*offset;
+          anchor.body = ((NodePhysics*)nodes[k])->getBody();
+          anchor.type = anchor.body ? Anchor::BODY : Anchor::WORLD;
+        }
+        else if(end.hasKey("position")) {
+          vectorFromConfigItem(&end["position"], &points[k]);
+          anchor.type = Anchor::WORLD;
+        }
+      }
+      if(anchors[0].type == Anchor::FREE && anchors[1].type == Anchor::FREE) {
+        LOG_ERROR("CablePhysics: a cable needs at least one fixed end");
+        return false;
+      }
+
+      length = map.get("length", 1.0);
+      int segments = map.get("segments", 20);
+      massPerLength = map.get("mass_per_length", 0.1);
+      radius = map.get("radius", 0.01);
+      stiffness = map.get("stiffness", 1e5);
+      bending = map.get("bending", 0.0);
+      damping = map.get("damping", 0.0);
+      dragNormal = map.get("drag", 1.2);
+      dragTangential = map.get("tangential_drag", 0.01);
+      friction = std::max(0.0, std::min(1.0, map.get("friction", 0.5)));
+      collision = map.get("collision", true);
+      substeps = std::max(1, (int)map.get("substeps", 10));
+      winchSpeed = 0;
+      minLength = 0.01;
+      maxLength = dInfinity;
+      if(map.hasKey("winch") && map["winch"].isMap()) {
+        ConfigMap &winch = map["winch"];
+        winchSpeed = winch.get("speed", 0.0);
+        minLength = winch.get("min_length", minLength);
+        maxLength = winch.get("max_length", maxLength);
+      }
+      if(length <= 0 || segments < 1 || massPerLength <= 0 || radius <= 0) {
+        LOG_ERROR("CablePhysics: invalid length, segments, mass or radius");
+        return false;
+      }
+      length = std::max(minLength, std::min(length, maxLength));
+      targetLength = length;
+
+      // a free end hangs down from the fixed one
+      if(anchors[0].type == Anchor::FREE) {
+        points[0] = points[1] - Vector(0, 0, length);
+      }
+      if(anchors[1].type == Anchor::FREE) {
+        points[1] = points[0] - Vector(0, 0, length);
+      }
+
+      MutexLocker locker(&(theWorld->iMutex));
+      for(int k=0; k<2; ++k) {
+        Anchor &anchor = anchors[k];
+        anchor.point = points[k];
+        if(anchor.type == Anchor::BODY) {
+          dVector3 local;
+          dBodyGetPosRelPoint(anchor.body, points[k].x(), points[k].y(),
+                              points[k].z(), local);
+          anchor.point = Vector(local[0], local[1], local[2]);
+        }
+        anchor.start = anchor.end = points[k];
+      }
+      x.resize(segments+1);
+      for(int i=0; i<=segments; ++i) {
+        x[i] = points[0] + (points[1]-points[0])*((double)i/segments);
+      }
+      v.assign(x.size(), Vector::Zero());
+      prev = x;
+      lambda.assign(segments, 0.0);
+      tension[0] = tension[1] = 0;
+      if(!probe) probe = dCreateSphere(0, radius);
+      else dGeomSphereSetRadius(probe, radius);
+      if(!created) theWorld->addCable(this);
+      created = true;
+      return true;
+    }
+
+    void CablePhysics::setTargetLength(sReal l) {
+      MutexLocker locker(&(theWorld->iMutex));
+      targetLength = std::max(minLength, std::min((double)l, maxLength));
+      // without winch speed the length changes at once
+      if(winchSpeed <= 0) length = targetLength;
+    }
+
+    sReal CablePhysics::getTargetLength(void) const {
+      MutexLocker locker(&(theWorld->iMutex));
+      return targetLength;
+    }
+
+    sReal CablePhysics::getLength(void) const {
+      MutexLocker locker(&(theWorld->iMutex));
+      return length;
+    }
+
+    void CablePhysics::getTension(sReal *start, sReal *end) const {
+      MutexLocker locker(&(theWorld->iMutex));
+      *start = tension[0];
+      *end = tension[1];
+    }
+
+    sReal CablePhysics::getMaxTension(void) const {
+      MutexLocker locker(&(theWorld->iMutex));
+      return std::max(tension[0], tension[1]);
+    }
+
+    void CablePhysics::getPoints(std::vector<Vector> *points) const {
+      MutexLocker locker(&(theWorld->iMutex));
+      *points = x;
+    }
+
+    void CablePhysics::detachBody(dBodyID body) {
+      for(int k=0; k<2; ++k) {
+        if(anchors[k].type == Anchor::BODY && anchors[k].body == body) {
+          anchors[k].type = Anchor::FREE;
+          anchors[k].body = 0;
+        }
+      }
+    }
+
+    bool CablePhysics::isPinned(size_t i) const {
+      return ((i == 0 && anchors[0].type != Anchor::FREE) ||
+              (i+1 == x.size() && anchors[1].type != Anchor::FREE));
+    }
+
+    Vector CablePhysics::anchorPosition(const Anchor &anchor) const {
+      if(anchor.type != Anchor::BODY) return anchor.point;
+      dVector3 p;
+      dBodyGetRelPointPos(anchor.body, anchor.point.x(), anchor.point.y(),
+                          anchor.point.z(), p);
+      return Vector(p[0], p[1], p[2]);
+    }
+
+    // the anchor moves with the velocity of the body point during the step
+    void CablePhysics::updateAnchor(Anchor *anchor, dReal stepSize) {
+      anchor->start = anchor->end = anchorPosition(*anchor);
+      if(anchor->type == Anchor::BODY) {
+        dVector3 vel;
+        dBodyGetRelPointVel(anchor->body, anchor->point.x(),
+                            anchor->point.y(), anchor->point.z(), vel);
+        anchor->end += Vector(vel[0], vel[1], vel[2])*stepSize;
+      }
+    }
+
+    void CablePhysics::step(dReal stepSize, const dReal *gravity,
+                            const FluidDescription &fluid) {
+      if(!created || x.size() < 2 || stepSize <= 0) return;
+      const size_t n = x.size()-1;
+
+      // winch
+      if(length != targetLength) {
+        double diff = targetLength - length;
+        double maxDiff = winchSpeed*stepSize;
+        length += std::max(-maxDiff, std::min(diff, maxDiff));
+      }
+      const double rest = length/n;
+      for(int k=0; k<2; ++k) updateAnchor(anchors+k, stepSize);
+
+      const double dt = stepSize/substeps;
+      // compliance of a segment (rest/EA) and of the bending constraint
+      const double stretchCompliance = stiffness > 0 ? rest/stiffness : 0.0;
+      const double bendCompliance = bending > 0 ? rest/bending : 0.0;
+      std::vector<double> bendLambda(n > 1 ? n-1 : 0);
+      double tensionSum[2] = {0, 0};
+
+      for(int s=0; s<substeps; ++s) {
+        const double f = (double)(s+1)/substeps;
+        prev = x;
+        addExternal(dt, gravity, fluid);
+        for(size_t i=0; i<=n; ++i) {
+          if(!isPinned(i)) x[i] += v[i]*dt;
+        }
+        if(isPinned(0)) {
+          x[0] = anchors[0].start + (anchors[0].end-anchors[0].start)*f;
+        }
+        if(isPinned(n)) {
+          x[n] = anchors[1].start + (anchors[1].end-anchors[1].start)*f;
+        }
+
+        std::fill(lambda.begin(), lambda.end(), 0.0);
+        std::fill(bendLambda.begin(), bendLambda.end(), 0.0);
+        for(size_t i=0; i<n; ++i) {
+          solveDistance(i, i+1, rest, stretchCompliance, dt, 1, &lambda[i]);
+        }
+        if(bending > 0) {
+          // keeps every second particle apart, thus the chain can't fold
+          for(size_t i=0; i+2<=n; ++i) {
+            solveDistance(i, i+2, 2*rest, bendCompliance, dt, -1,
+                          &bendLambda[i]);
+          }
+        }
+        if(collision) collide();
+
+        const double keep = std::max(0.0, 1.0 - damping*dt);
+        for(size_t i=0; i<=n; ++i) {
+          v[i] = (x[i]-prev[i])/dt*keep;
+        }
+        tensionSum[0] += fabs(lambda[0])/(dt*dt);
+        tensionSum[1] += fabs(lambda[n-1])/(dt*dt);
+      }
+      tension[0] = tensionSum[0]/substeps;
+      tension[1] = tensionSum[1]/substeps;
+
+      // the end segments pull the bodies towards the cable by a one sided
+      // row in the ode step, the soft erp and cfm make it an implicit
+      // spring with the stiffness and damping of the segment
+      const double k = stiffness/rest;
+      const double c = damping*massPerLength*rest;
+      for(int i=0; i<2; ++i) {
+        const Anchor &anchor = anchors[i];
+        if(anchor.type != Anchor::BODY) continue;
+        // the neighbour particle stays where the cable step left it
+        Vector dir = (i == 0 ? x[1] : x[n-1]) - anchor.start;
+        double l = dir.norm();
+        if(l <= rest || l < 1e-12) continue;
+        dir /= l;
+        dContact contact;
+        memset(&contact, 0, sizeof(dContact));
+        contact.surface.mu = 0;
+        if(stiffness > 0) {
+          contact.surface.mode = dContactSoftERP | dContactSoftCFM;
+          contact.surface.soft_erp = stepSize*k/(stepSize*k + c);
+          contact.surface.soft_cfm = 1.0/(stepSize*k + c);
+        }
+        contact.geom.pos[0] = anchor.start.x();
+        contact.geom.pos[1] = anchor.start.y();
+        contact.geom.pos[2] = anchor.start.z();
+        contact.geom.normal[0] = dir.x();
+        contact.geom.normal[1] = dir.y();
+        contact.geom.normal[2] = dir.z();
+        contact.geom.depth = l - rest;
+        dJointID joint = dJointCreateContact(theWorld->getWorld(),
+                                             theWorld->getContactGroup(),
+                                             &contact);
+        dJointAttach(joint, anchor.body, 0);
+      }
+    }
+
+    void CablePhysics::solveDistance(size_t i, size_t j, double rest,
+                                     double compliance, double dt, int side,
+                                     double *lambda) {
+      const double particleMass = massPerLength*length/(x.size()-1);
+      const double wi = isPinned(i) ? 0.0 : 1.0/particleMass;
+      const double wj = isPinned(j) ? 0.0 : 1.0/particleMass;
+      Vector d = x[i]-x[j];
+      double l = d.norm();
+      if(l < 1e-12) return;
+      double c = l - rest;
+      if((side > 0 && c <= 0) || (side < 0 && c >= 0)) return;
+      double alpha = compliance/(dt*dt);
+      double w = wi + wj + alpha;
+      if(w <= 0) return;
+      double dLambda = (-c - alpha*(*lambda))/w;
+      *lambda += dLambda;
+      d /= l;
+      x[i] += d*(wi*dLambda);
+      x[j] -= d*(wj*dLambda);
+    }
+
+    /**
+     * \brief Gravity, buoyancy and drag of the free particles.
+     *
+     * The drag is applied semi-implicitly per direction, thus it damps the
+     * velocity relative to the fluid but never reverses it.
+     */
+    void CablePhysics::addExternal(double dt, const dReal *gravity,
+                                   const FluidDescription &fluid) {
+      const size_t n = x.size()-1;
+      const double rest = length/n;
+      const double mass = massPerLength*rest;
+      const double diameter = 2*radius;
+      const double volume = M_PI*radius*radius*rest;
+      const Vector g(gravity[0], gravity[1], gravity[2]);
+
+      for(size_t i=0; i<=n; ++i) {
+        if(isPinned(i)) continue;
+        bool submerged = !fluid.hasSurface || x[i].z() < fluid.surface;
+        double density = submerged ? fluid.density : 0.0;
+
+        Vector t = x[std::min(i+1, n)] - x[i > 0 ? i-1 : 0];
+        double tl = t.norm();
+        t = tl > 1e-12 ? Vector(t/tl) : Vector(0, 0, 1);
+        Vector current = submerged ? fluid.current : Vector::Zero();
+        Vector u = v[i] - current;
+        Vector ut = t*u.dot(t);
+        Vector un = u - ut;
+        double kn = 0.5*density*dragNormal*diameter*rest*un.norm()/mass*dt;
+        double kt = 0.5*density*dragTangential*M_PI*diameter*rest*
+          ut.norm()/mass*dt;
+        v[i] = current + un/(1.0+kn) + ut/(1.0+kt);
+        v[i] += (g - g*(density*volume/mass))*dt;
+      }
+    }
+
+    void CablePhysics::collide() {
+      dSpaceID space = theWorld->getSpace();
+      for(probeIndex=0; probeIndex<x.size(); ++probeIndex) {
+        if(isPinned(probeIndex)) continue;
+        const Vector &p = x[probeIndex];
+        dGeomSetPosition(probe, p.x(), p.y(), p.z());
+        dSpaceCollide2(probe, (dGeomID)space, this,
+                       &CablePhysics::probeCallback);
+      }
+    }
+
+    /**
+     * \brief Pushes the tested particle out of the geom and removes the
+     * part of its tangential motion given by the friction.
+     */
+    void CablePhysics::probeCallback(void *data, dGeomID o1, dGeomID o2) {
+      CablePhysics *cable = (CablePhysics*)data;
+      if(dGeomIsSpace(o1) || dGeomIsSpace(o2)) {
+        dSpaceCollide2(o1, o2, data, &CablePhysics::probeCallback);
+        return;
+      }
+      dGeomID other = o1 == cable->probe ? o2 : o1;
+      if(!dGeomGetCollideBits(other)) return;
+      geom_data *gd = (geom_data*)dGeomGetData(other);
+      if(gd && gd->ray_sensor) return;
+
+      // the cable leaves its anchor bodies without touching them
+      const size_t i = cable->probeIndex;
+      const size_t n = cable->x.size()-1;
+      dBodyID body = dGeomGetBody(other);
+      if(body) {
+        if(i <= 2 && cable->anchors[0].body == body) return;
+        if(i+2 >= n && cable->anchors[1].body == body) return;
+      }
+
+      dContactGeom contact;
+      if(!dCollide(cable->probe, other, 1, &contact, sizeof(dContactGeom))) {
+        return;
+      }
+      // the normal points out of the other geom
+      Vector normal(contact.normal[0], contact.normal[1], contact.normal[2]);
+      Vector &p = cable->x[i];
+      p += normal*contact.depth;
+      Vector motion = p - cable->prev[i];
+      Vector tangential = motion - normal*motion.dot(normal);
+      p -= tangential*cable->friction;
+      dGeomSetPosition(cable->probe, p.x(), p.y(), p.z());
+    }
+
+  } // end of namespace sim
+} // end of namespace mars
@@ -0,0 +1,145 @@
+/*
+ *  Copyright 2017, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * \file CablePhysics.h
+ * \brief A cable as position based segment chain coupled to the ode bodies.
+ */
+
+#ifndef CABLE_PHYSICS_H
+#define CABLE_PHYSICS_H
+
+#ifdef _PRINT_HEADER_
+  #warning "CablePhysics.h"
+#endif
+
+#include "WorldPhysics.h"
+
+#include <mars/interfaces/sim/CableInterface.h>
+
+#include <vector>
+
+namespace mars {
+  namespace sim {
+
+    /**
+     * A cable is a chain of point masses that is integrated with extended
+     * position based dynamics (XPBD) in several substeps of the physics
+     * step. The segments only resist stretching, a slack cable bends
+     * freely except for the optional bending stiffness. The particles
+     * collide as spheres with the geoms of the ode space, fluid drag and
+     * buoyancy use the fluid of the world.
+     *
+     * The ends are pinned to anchor points of ode bodies, which move with
+     * the velocity of the body during the step. The tension of the end
+     * segments is applied to the bodies as force at the anchor before the
+     * ode step. Thus the cable does not add rows to the ode solver and a
+     * taut cable stays stable at the usual step sizes.
+     *
+     * Config:
+     * \code
+     * start: {node: vehicle, offset: {x: 0, y: 0, z: 0.2}}  # offset in
+     * end: {position: {x: 0, y: 0, z: 5}}                  # node frame
+     * length: 10.0            # initial unstretched length in m
+     * segments: 20
+     * mass_per_length: 0.1    # kg/m
+     * radius: 0.01            # m, for collision, drag and buoyancy
+     * stiffness: 1e5          # axial stiffness EA in N
+     * bending: 0.0            # bending stiffness, 0 is a free chain
+     * damping: 0.0            # relative velocity damping per second
+     * drag: 1.2               # normal drag coefficient
+     * tangential_drag: 0.01
+     * friction: 0.5           # 0..1 of the tangential motion in contacts
+     * collision: true
+     * winch: {speed: 0.5, min_length: 0.5, max_length: 50}
+     * substeps: 10
+     * \endcode
+     * An end without node and position hangs free. A stiffness of 0 makes
+     * the end rows rigid with the erp and cfm of the world.
+     */
+    class CablePhysics : public interfaces::CableInterface {
+    public:
+      CablePhysics(interfaces::PhysicsInterface *world);
+      virtual ~CablePhysics();
+
+      virtual bool createCable(const configmaps::ConfigMap &config,
+                               interfaces::NodeInterface *node1,
+                               interfaces::NodeInterface *node2);
+      virtual void setWorldObject(interfaces::PhysicsInterface *world);
+      virtual void setTargetLength(interfaces::sReal length);
+      virtual interfaces::sReal getTargetLength(void) const;
+      virtual interfaces::sReal getLength(void) const;
+      virtual void getTension(interfaces::sReal *start,
+                              interfaces::sReal *end) const;
+      virtual interfaces::sReal getMaxTension(void) const;
+      virtual void getPoints(std::vector<utils::Vector> *points) const;
+
+      /**
+       * \brief Integrates the cable over the coming ode step and adds the
+       * rows of the taut ends to the contact group. Called by WorldPhysics
+       * before the step, the iMutex has to be locked by the caller.
+       */
+      void step(dReal stepSize, const dReal *gravity,
+                const FluidDescription &fluid);
+      //! The iMutex has to be locked by the caller.
+      void detachBody(dBodyID body);
+      //! The iMutex has to be locked by the caller.
+      const std::vector<utils::Vector>& getPointsIntern() const {return x;}
+
+    private:
+      struct Anchor {
+        enum {FREE, WORLD, BODY} type;
+        dBodyID body;
+        // world point or offset in the body frame
+        utils::Vector point;
+        utils::Vector start, end;
+      };
+
+      WorldPhysics *theWorld;
+      bool created;
+      Anchor anchors[2];
+      std::vector<utils::Vector> x, v, prev;
+      std::vector<double> lambda;
+      double tension[2];
+      double length, targetLength, winchSpeed, minLength, maxLength;
+      double massPerLength, radius, stiffness, bending, damping;
+      double dragNormal, dragTangential, friction;
+      bool collision;
+      int substeps;
+      dGeomID probe;
+      // the particle that is tested by the probe geom
+      size_t probeIndex;
+
+      void updateAnchor(Anchor *anchor, dReal stepSize);
+      utils::Vector anchorPosition(const Anchor &anchor) const;
+      // side > 0 only resists stretching, side < 0 only compression
+      void solveDistance(size_t i, size_t j, double rest, double compliance,
+                         double dt, int side, double *lambda);
+      void addExternal(double dt, const dReal *gravity,
+                       const FluidDescription &fluid);
+      void collide();
+      bool isPinned(size_t i) const;
+      static void probeCallback(void *data, dGeomID o1, dGeomID o2);
+    };
+
+  } // end of namespace sim
+} // end of namespace mars
+
+#endif  // CABLE_PHYSICS_H
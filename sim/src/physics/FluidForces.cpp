@@ -0,0 +1,241 @@
+/*
+ *  Copyright 2017, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "FluidForces.h"
+
+#include <mars/utils/mathUtils.h>
+
+#include <Eigen/Dense>
+#include <algorithm>
+#include <cmath>
+
+namespace mars {
+  namespace sim {
+
+    using namespace utils;
+    using namespace interfaces;
+    using namespace configmaps;
+
+    // reads a vector that can also be given as single value
+    static void vectorFromFluidItem(ConfigItem &item, Vector *v) {
+      if(item.isMap()) vectorFromConfigItem(&item, v);
+      else {
+        double value = item;
+        *v = Vector(value, value, value);
+      }
+    }
+
+    static Tensor geomRotation(dGeomID geom) {
+      const dReal *R = dGeomGetRotation(geom);
+      Tensor r;
+      r << R[0], R[1], R[2],
+           R[4], R[5], R[6],
+           R[8], R[9], R[10];
+      return r;
+    }
+
+    // inertia tensor of the body in the frame R
+    static Tensor bodyInertia(dBodyID body, const dMass &m, const Tensor &R) {
+      const dReal *br = dBodyGetRotation(body);
+      Tensor bodyR, inertia;
+      bodyR << br[0], br[1], br[2],
+               br[4], br[5], br[6],
+               br[8], br[9], br[10];
+      inertia << m.I[0], m.I[1], m.I[2],
+                 m.I[4], m.I[5], m.I[6],
+                 m.I[8], m.I[9], m.I[10];
+      return R.transpose()*bodyR*inertia*bodyR.transpose()*R;
+    }
+
+    bool fluidNodeParamsFromConfig(const NodeData &node, dReal meshVolume,
+                                   FluidNodeParams *params) {
+      ConfigMap map = node.map;
+      if(!map.hasKey("fluid")) return false;
+      // "fluid: true" enables the defaults
+      ConfigMap defaults;
+      if(!map["fluid"].isMap() && !(bool)map["fluid"]) return false;
+      ConfigMap &fluid = map["fluid"].isMap() ? (ConfigMap&)map["fluid"] : defaults;
+
+      // geometry defaults, cylinders and capsules are aligned to z
+      const Vector &ext = node.ext;
+      const double r = ext.x();
+      switch(node.physicMode) {
+      case NODE_TYPE_SPHERE:
+        params->volume = 4.0/3.0*M_PI*r*r*r;
+        params->halfExtents = Vector(r, r, r);
+        params->areas = Vector(M_PI*r*r, M_PI*r*r, M_PI*r*r);
+        break;
+      case NODE_TYPE_CYLINDER:
+        params->volume = M_PI*r*r*ext.y();
+        params->halfExtents = Vector(r, r, 0.5*ext.y());
+        params->areas = Vector(2*r*ext.y(), 2*r*ext.y(), M_PI*r*r);
+        break;
+      case NODE_TYPE_CAPSULE:
+        params->volume = M_PI*r*r*ext.y() + 4.0/3.0*M_PI*r*r*r;
+        params->halfExtents = Vector(r, r, 0.5*ext.y()+r);
+        params->areas = Vector(2*r*ext.y()+M_PI*r*r, 2*r*ext.y()+M_PI*r*r,
+                               M_PI*r*r);
+        break;
+      default:
+        params->volume = ext.x()*ext.y()*ext.z();
+        if(node.physicMode == NODE_TYPE_MESH && meshVolume > 0) {
+          params->volume = meshVolume;
+        }
+        params->halfExtents = 0.5*ext;
+        params->areas = Vector(ext.y()*ext.z(), ext.x()*ext.z(),
+                               ext.x()*ext.y());
+        break;
+      }
+
+      params->dragCoefficients = Vector(1.0, 1.0, 1.0);
+      params->linearDrag = Vector::Zero();
+      params->angularDrag = Vector::Zero();
+      params->angularLinearDrag = Vector::Zero();
+      params->buoyancyOffset = Vector::Zero();
+      params->addedMass = 0.0;
+      params->addedInertia = Vector::Zero();
+      if(fluid.hasKey("volume")) params->volume = fluid["volume"];
+      if(fluid.hasKey("drag")) {
+        vectorFromFluidItem(fluid["drag"], &params->dragCoefficients);
+      }
+      if(fluid.hasKey("linear_drag")) {
+        vectorFromFluidItem(fluid["linear_drag"], &params->linearDrag);
+      }
+      if(fluid.hasKey("angular_drag")) {
+        vectorFromFluidItem(fluid["angular_drag"], &params->angularDrag);
+      }
+      if(fluid.hasKey("angular_linear_drag")) {
+        vectorFromFluidItem(fluid["angular_linear_drag"],
+                            &params->angularLinearDrag);
+      }
+      if(fluid.hasKey("buoyancy_offset")) {
+        vectorFromFluidItem(fluid["buoyancy_offset"], &params->buoyancyOffset);
+      }
+      if(fluid.hasKey("added_mass")) params->addedMass = fluid["added_mass"];
+      if(fluid.hasKey("added_inertia")) {
+        vectorFromFluidItem(fluid["added_inertia"], &params->addedInertia);
+      }
+      return true;
+    }
+
+    void fluidDescriptionFromConfig(ConfigMap &config,
+                                    FluidDescription *fluid) {
+      if(config.hasKey("density")) fluid->density = config["density"];
+      if(config.hasKey("current")) {
+        vectorFromFluidItem(config["current"], &fluid->current);
+      }
+      if(config.hasKey("surface")) {
+        fluid->hasSurface = true;
+        fluid->surface = config["surface"];
+      }
+    }
+
+    void addFluidForces(const FluidDescription &fluid,
+                        const FluidNodeParams &params,
+                        dBodyID body, dGeomID geom, const dReal *gravity,
+                        dReal stepSize) {
+      const dReal *pos = dGeomGetPosition(geom);
+      const Tensor R = geomRotation(geom);
+      const Vector center = Vector(pos[0], pos[1], pos[2]) +
+        R*params.buoyancyOffset;
+
+      // the submerged part is estimated from the vertical extent of the
+      // bounding box
+      double submerged = 1.0;
+      if(fluid.hasSurface) {
+        double h = 0.0;
+        for(int i=0; i<3; ++i) h += fabs(R(2, i))*params.halfExtents[i];
+        if(h <= 0.0) submerged = center.z() < fluid.surface ? 1.0 : 0.0;
+        else submerged = (fluid.surface - (center.z() - h))/(2*h);
+        if(submerged <= 0.0) return;
+        if(submerged > 1.0) submerged = 1.0;
+      }
+
+      Vector force = -fluid.density*params.volume*submerged*
+        Vector(gravity[0], gravity[1], gravity[2]);
+
+      dVector3 vel;
+      dBodyGetPointVel(body, center.x(), center.y(), center.z(), vel);
+      const Vector v = R.transpose()*(Vector(vel[0], vel[1], vel[2]) -
+                                      fluid.current);
+      // the damping is limited to what stops the body within one step,
+      // otherwise large steps would reverse the motion
+      dMass m;
+      dBodyGetMass(body, &m);
+      const Tensor inertia = bodyInertia(body, m, R);
+      Vector drag;
+      for(int i=0; i<3; ++i) {
+        double k = (0.5*fluid.density*params.dragCoefficients[i]*
+                    params.areas[i]*fabs(v[i]) + params.linearDrag[i]);
+        drag[i] = -std::min(k, m.mass/stepSize)*v[i];
+      }
+      force += submerged*(R*drag);
+      dBodyAddForceAtPos(body, force.x(), force.y(), force.z(),
+                         center.x(), center.y(), center.z());
+
+      const dReal *av = dBodyGetAngularVel(body);
+      const Vector w = R.transpose()*Vector(av[0], av[1], av[2]);
+      Vector torque;
+      for(int i=0; i<3; ++i) {
+        double k = (params.angularDrag[i]*fabs(w[i]) +
+                    params.angularLinearDrag[i]);
+        torque[i] = -std::min(k, inertia(i, i)/stepSize)*w[i];
+      }
+      torque = submerged*(R*torque);
+      dBodyAddTorque(body, torque.x(), torque.y(), torque.z());
+    }
+
+    void addAddedMass(const FluidNodeParams &params, dGeomID geom,
+                      FluidAddedMass *added) {
+      added->mass += params.addedMass;
+      const Tensor R = geomRotation(geom);
+      added->inertia += R*params.addedInertia.asDiagonal()*R.transpose();
+    }
+
+    void applyAddedMass(const FluidAddedMass &added, dBodyID body,
+                        const dReal *gravity) {
+      if(added.mass <= 0.0 && added.inertia.squaredNorm() <= 0.0) {
+        return;
+      }
+      dMass m;
+      dBodyGetMass(body, &m);
+      Vector weight = Vector::Zero();
+      if(dBodyGetGravityMode(body)) {
+        weight = m.mass*Vector(gravity[0], gravity[1], gravity[2]);
+      }
+      // ode adds the weight of the body during the step
+      const dReal *f = dBodyGetForce(body);
+      Vector force = Vector(f[0], f[1], f[2]) + weight;
+      force *= m.mass/(m.mass+added.mass);
+      force -= weight;
+      dBodySetForce(body, force.x(), force.y(), force.z());
+
+      // ode accelerates by I^-1*t', thus t' = I*(I+Ia)^-1*t gives the
+      // acceleration of the body with the added inertia
+      if(added.inertia.squaredNorm() <= 0.0) return;
+      const Tensor inertia = bodyInertia(body, m, Tensor::Identity());
+      const dReal *t = dBodyGetTorque(body);
+      Vector torque(t[0], t[1], t[2]);
+      torque = inertia*(inertia+added.inertia).ldlt().solve(torque);
+      dBodySetTorque(body, torque.x(), torque.y(), torque.z());
+    }
+
+  } // end of namespace sim
+} // end of namespace mars
@@ -0,0 +1,147 @@
+/*
+ *  Copyright 2017, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * \file FluidForces.h
+ * \brief Buoyancy, drag and added mass of bodies moving in water or air.
+ */
+
+#ifndef FLUID_FORCES_H
+#define FLUID_FORCES_H
+
+#ifdef _PRINT_HEADER_
+  #warning "FluidForces.h"
+#endif
+
+#include <mars/interfaces/NodeData.h>
+#include <mars/utils/Vector.h>
+
+#include <configmaps/ConfigData.h>
+#include <ode/ode.h>
+
+namespace mars {
+  namespace sim {
+
+    /**
+     * The fluid of the scene. Without a surface the whole world is filled
+     * with the fluid, otherwise only the space below the height
+     * \c surface. The default is air without a current.
+     */
+    struct FluidDescription {
+      FluidDescription() : density(1.225), current(0.0, 0.0, 0.0),
+                           hasSurface(false), surface(0.0) {}
+      dReal density;
+      utils::Vector current;
+      bool hasSurface;
+      dReal surface;
+    };
+
+    /**
+     * The fluid parameters of a node. All vectors are given in the node
+     * frame. The quadratic drag of an axis is
+     * 0.5 * density * dragCoefficient * area * |v| * v, where the
+     * projected areas are taken from the geometry of the node.
+     */
+    struct FluidNodeParams {
+      dReal volume;
+      // half extents of the bounding box to estimate the submerged part
+      utils::Vector halfExtents;
+      utils::Vector areas;
+      utils::Vector dragCoefficients;
+      utils::Vector linearDrag;
+      utils::Vector angularDrag;
+      utils::Vector angularLinearDrag;
+      utils::Vector buoyancyOffset;
+      dReal addedMass;
+      utils::Vector addedInertia;
+    };
+
+    /**
+     * \brief Reads the "fluid" section of the node config. Returns false
+     * if the node has no fluid section or it is disabled.
+     *
+     * \code
+     * fluid:
+     *   volume: 0.02            # default: volume of the geometry
+     *   drag: {x: 1.0, y: 1.0, z: 1.2}
+     *   linear_drag: 0.5
+     *   angular_drag: 0.1
+     *   angular_linear_drag: 0.0
+     *   added_mass: 4.0
+     *   added_inertia: {x: 0.01, y: 0.01, z: 0.02}
+     *   buoyancy_offset: {x: 0.0, y: 0.0, z: 0.05}
+     * \endcode
+     *
+     * Each vector can also be given as single value for all axes.
+     * \a meshVolume is used as default volume for meshes if it is positive.
+     */
+    bool fluidNodeParamsFromConfig(const interfaces::NodeData &node,
+                                   dReal meshVolume, FluidNodeParams *params);
+
+    /**
+     * \brief Overwrites the values of \a fluid that are given in the map:
+     *
+     * \code
+     * density: 1025.0
+     * current: {x: 0.2, y: 0.0, z: 0.0}
+     * surface: 0.0
+     * \endcode
+     */
+    void fluidDescriptionFromConfig(configmaps::ConfigMap &config,
+                                    FluidDescription *fluid);
+
+    /**
+     * \brief Adds buoyancy and drag of a node to its body. Has to be called
+     * before the world step of \a stepSize seconds.
+     */
+    void addFluidForces(const FluidDescription &fluid,
+                        const FluidNodeParams &params,
+                        dBodyID body, dGeomID geom, const dReal *gravity,
+                        dReal stepSize);
+
+    /**
+     * The added mass and the added inertia tensor in world orientation of
+     * all fluid nodes of one body.
+     */
+    struct FluidAddedMass {
+      FluidAddedMass() : mass(0.0), inertia(utils::Tensor::Zero()) {}
+      dReal mass;
+      utils::Tensor inertia;
+    };
+
+    /**
+     * \brief Adds the added mass of a node to the sum of its body.
+     */
+    void addAddedMass(const FluidNodeParams &params, dGeomID geom,
+                      FluidAddedMass *added);
+
+    /**
+     * \brief Takes the added mass of a body into account by scaling the
+     * forces and torques that are accumulated on it, thus the body is
+     * accelerated as if it had the additional mass. Has to be called once
+     * per body after all forces of the step were added to the body.
+     */
+    void applyAddedMass(const FluidAddedMass &added, dBodyID body,
+                        const dReal *gravity);
+
+  } // end of namespace sim
+} // end of namespace mars
+
+#endif  // FLUID_FORCES_H
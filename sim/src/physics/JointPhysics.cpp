@@ -33,6 +33,8 @@
 #include "JointPhysics.h"
 #include "NodePhysics.h"
 
+#include <mars/interfaces/Logging.hpp>
+
 #include <cstdio>
 
 namespace mars {
@@ -55,6 +57,10 @@ namespace mars {
       spring = 0;
       body1 = 0;
       body2 = 0;
+      motorCFM[0] = motorCFM[1] = 0;
+      motorCFMSet[0] = motorCFMSet[1] = false;
+      articulated = false;
+      active = true;
     }
 
     /**
@@ -68,6 +74,7 @@ namespace mars {
      */
     JointPhysics::~JointPhysics(void) {
       MutexLocker locker(&(theWorld->iMutex));
+      theWorld->removeArticulatedJoint(this);
       if (jointId) {
         dJointDestroy(jointId);
       }
@@ -166,6 +173,17 @@ namespace mars {
         // of the forces the joint attached to the bodies
         // we need to set a feedback pointer for the joint (ode stuff)
         dJointSetFeedback(jointId, &feedback);
+        if(jointS->config.get("articulated", false)) {
+          if(joint_type == JOINT_TYPE_HINGE || joint_type == JOINT_TYPE_SLIDER ||
+             joint_type == JOINT_TYPE_FIXED) {
+            theWorld->addArticulatedJoint(this);
+            articulated = true;
+          }
+          else {
+            LOG_WARN("JointPhysics: only hinge, slider and fixed joints can be articulated, \"%s\" is solved by ode",
+                     jointS->name.c_str());
+          }
+        }
         return 1;
       }
       return 0;
@@ -865,6 +883,8 @@ namespace mars {
         dJointAttach(jointId, body1, body2);
         dJointSetFixed(jointId);
         dJointSetFeedback(jointId, &feedback);
+        // the new joint has to be disabled again by its articulation
+        theWorld->setArticulationsDirty();
         // used for the integration study of the SpaceClimber
         //dJointSetFixedParam(jointId, dParamCFM, cfm1);//0.0002);
         break;
@@ -1411,5 +1431,72 @@ namespace mars {
       }
     }
 
+    /**
+     * \brief Enables or disables the joint in the physics without
+     * destroying it. A disabled joint adds no constraint rows, an
+     * articulated joint leaves its tree while it is disabled.
+     */
+    void JointPhysics::setActive(bool active) {
+      MutexLocker locker(&(theWorld->iMutex));
+      if(!jointId || active == this->active) return;
+      this->active = active;
+      if(active) {
+        dJointEnable(jointId);
+        if(ball_motor) dJointEnable(ball_motor);
+        // the rebuilt articulation disables the ode joint again
+        if(articulated) theWorld->addArticulatedJoint(this);
+      }
+      else {
+        // removing the joint enables the joints of the old articulation
+        if(articulated) theWorld->removeArticulatedJoint(this);
+        dJointDisable(jointId);
+        if(ball_motor) dJointDisable(ball_motor);
+      }
+    }
+
+    void JointPhysics::setMotorCFM(interfaces::sReal cfm) {
+      setMotorCFM(cfm, 0);
+    }
+
+    void JointPhysics::setMotorCFM2(interfaces::sReal cfm) {
+      setMotorCFM(cfm, 1);
+    }
+
+    void JointPhysics::setMotorCFM(interfaces::sReal cfm, int axis) {
+      MutexLocker locker(&(theWorld->iMutex));
+      int param = axis ? dParamCFM2 : dParamCFM;
+      dReal value = (dReal)cfm;
+
+      // ode uses the cfm of the motor row as implicit damping, the
+      // configured value is restored once the motor releases the joint
+      switch(joint_type) {
+      case  JOINT_TYPE_HINGE:
+        if(axis) return;
+        if(!motorCFMSet[axis]) motorCFM[axis] = dJointGetHingeParam(jointId, param);
+        if(cfm <= 0) value = motorCFM[axis];
+        dJointSetHingeParam(jointId, param, value);
+        break;
+      case JOINT_TYPE_HINGE2:
+        if(!motorCFMSet[axis]) motorCFM[axis] = dJointGetHinge2Param(jointId, param);
+        if(cfm <= 0) value = motorCFM[axis];
+        dJointSetHinge2Param(jointId, param, value);
+        break;
+      case JOINT_TYPE_SLIDER:
+        if(axis) return;
+        if(!motorCFMSet[axis]) motorCFM[axis] = dJointGetSliderParam(jointId, param);
+        if(cfm <= 0) value = motorCFM[axis];
+        dJointSetSliderParam(jointId, param, value);
+        break;
+      case JOINT_TYPE_UNIVERSAL:
+        if(!motorCFMSet[axis]) motorCFM[axis] = dJointGetUniversalParam(jointId, param);
+        if(cfm <= 0) value = motorCFM[axis];
+        dJointSetUniversalParam(jointId, param, value);
+        break;
+      default:
+        return;
+      }
+      motorCFMSet[axis] = cfm > 0;
+    }
+
   } // end of namespace sim
 } // end of namespace mars
@@ -86,8 +86,12 @@ namespace mars {
       virtual void setHighStop(interfaces::sReal highStop);
       virtual void setLowStop2(interfaces::sReal lowStop2);
       virtual void setHighStop2(interfaces::sReal highStop2);
+      virtual void setMotorCFM(interfaces::sReal cfm);
+      virtual void setMotorCFM2(interfaces::sReal cfm);
+      virtual void setActive(bool active);
 
     private:
+      friend class Articulation;
       WorldPhysics* theWorld;
       dJointID jointId, ball_motor;
       dJointFeedback feedback;
@@ -96,10 +100,16 @@ namespace mars {
       dReal cfm, cfm1, cfm2, erp1, erp2;
       dReal lo1, lo2, hi1, hi2;
       dReal damping, spring, jointCFM;
+      // the motor cfm of the joint configuration per axis, it is stored
+      // by the first call of setMotorCFM
+      dReal motorCFM[2];
+      bool motorCFMSet[2];
+      bool articulated, active;
       utils::Vector axis1_torque, axis2_torque, joint_load;
       dReal motor_torque;
 
       void calculateCfmErp(const interfaces::JointData *jointS);
+      void setMotorCFM(interfaces::sReal cfm, int axis);
 
       ///create a joint from type Hing
       void createHinge(interfaces::JointData* jointS,
@@ -0,0 +1,167 @@
+/*
+ *  Copyright 2017, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "KinematicTrajectory.h"
+
+#include <mars/utils/mathUtils.h>
+#include <mars/interfaces/Logging.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace mars {
+  namespace sim {
+
+    using namespace utils;
+    using namespace configmaps;
+
+    static bool waypointBefore(const KinematicWaypoint &a,
+                               const KinematicWaypoint &b) {
+      return a.time < b.time;
+    }
+
+    static bool timeBefore(double time, const KinematicWaypoint &w) {
+      return time < w.time;
+    }
+
+    KinematicTrajectory::KinematicTrajectory() : spline(false),
+                                                 mode(KINEMATIC_ONCE) {
+    }
+
+    bool KinematicTrajectory::fromConfig(ConfigMap &config,
+                                         const Vector &startPos,
+                                         const Quaternion &startRot) {
+      waypoints.clear();
+      spline = false;
+      mode = KINEMATIC_ONCE;
+      if(config.hasKey("interpolation")) {
+        spline = ((std::string)config["interpolation"] == "spline");
+      }
+      if(config.hasKey("mode")) {
+        std::string m = config["mode"];
+        if(m == "loop") mode = KINEMATIC_LOOP;
+        else if(m == "pingpong") mode = KINEMATIC_PINGPONG;
+        else if(m != "once") {
+          LOG_WARN("KinematicTrajectory: unknown mode \"%s\"", m.c_str());
+        }
+      }
+      bool relative = config.hasKey("relative") && (bool)config["relative"];
+      if(!config.hasKey("waypoints")) return false;
+
+      ConfigVector::iterator it = config["waypoints"].begin();
+      for(; it!=config["waypoints"].end(); ++it) {
+        KinematicWaypoint w;
+        w.time = it->hasKey("time") ? (double)(*it)["time"] : 0.0;
+        w.position = relative ? Vector::Zero() : startPos;
+        w.rotation = relative ? Quaternion::Identity() : startRot;
+        if(it->hasKey("position")) {
+          vectorFromConfigItem(&(*it)["position"], &w.position);
+        }
+        if(it->hasKey("rotation")) {
+          quaternionFromConfigItem(&(*it)["rotation"], &w.rotation);
+          w.rotation.normalize();
+        }
+        else if(it->hasKey("euler")) {
+          Vector euler;
+          vectorFromConfigItem(&(*it)["euler"], &euler);
+          w.rotation = eulerToQuaternion(euler);
+        }
+        if(relative) {
+          w.position = startPos + startRot*w.position;
+          w.rotation = startRot*w.rotation;
+        }
+        waypoints.push_back(w);
+      }
+      std::stable_sort(waypoints.begin(), waypoints.end(), waypointBefore);
+      // keep the slerp on the short path
+      for(size_t i=1; i<waypoints.size(); ++i) {
+        if(waypoints[i].rotation.dot(waypoints[i-1].rotation) < 0) {
+          waypoints[i].rotation.coeffs() *= -1;
+        }
+      }
+      return !waypoints.empty();
+    }
+
+    double KinematicTrajectory::mapTime(double time) const {
+      const double start = waypoints.front().time;
+      const double duration = waypoints.back().time - start;
+      if(duration <= 0.0 || time <= start) return start;
+      double t = time - start;
+      switch(mode) {
+      case KINEMATIC_ONCE:
+        t = std::min(t, duration);
+        break;
+      case KINEMATIC_LOOP:
+        t = fmod(t, duration);
+        break;
+      case KINEMATIC_PINGPONG:
+        t = fmod(t, 2.0*duration);
+        if(t > duration) t = 2.0*duration - t;
+        break;
+      }
+      return start + t;
+    }
+
+    // finite difference tangent in units per second
+    Vector KinematicTrajectory::tangent(size_t i) const {
+      size_t a = i > 0 ? i-1 : i;
+      size_t b = i+1 < waypoints.size() ? i+1 : i;
+      double dt = waypoints[b].time - waypoints[a].time;
+      if(dt <= 0.0) return Vector::Zero();
+      return (waypoints[b].position - waypoints[a].position)/dt;
+    }
+
+    void KinematicTrajectory::getPose(double time, Vector *pos,
+                                      Quaternion *rot) const {
+      if(waypoints.empty()) return;
+      const double t = mapTime(time);
+      std::vector<KinematicWaypoint>::const_iterator it;
+      it = std::upper_bound(waypoints.begin(), waypoints.end(), t,
+                            timeBefore);
+      if(it == waypoints.begin()) {
+        *pos = waypoints.front().position;
+        *rot = waypoints.front().rotation;
+        return;
+      }
+      if(it == waypoints.end()) {
+        *pos = waypoints.back().position;
+        *rot = waypoints.back().rotation;
+        return;
+      }
+      const size_t i = (it - waypoints.begin()) - 1;
+      const KinematicWaypoint &w0 = waypoints[i];
+      const KinematicWaypoint &w1 = waypoints[i+1];
+      const double h = w1.time - w0.time;
+      const double s = h > 0.0 ? (t - w0.time)/h : 1.0;
+      if(spline) {
+        const double s2 = s*s, s3 = s2*s;
+        *pos = (2*s3 - 3*s2 + 1)*w0.position +
+          (s3 - 2*s2 + s)*h*tangent(i) +
+          (-2*s3 + 3*s2)*w1.position +
+          (s3 - s2)*h*tangent(i+1);
+      }
+      else {
+        *pos = (1.0-s)*w0.position + s*w1.position;
+      }
+      *rot = w0.rotation.slerp(s, w1.rotation);
+    }
+
+  } // end of namespace sim
+} // end of namespace mars
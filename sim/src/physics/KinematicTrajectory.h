@@ -0,0 +1,101 @@
+/*
+ *  Copyright 2017, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * \file KinematicTrajectory.h
+ * \brief Prescribed pose trajectories of kinematic nodes.
+ */
+
+#ifndef KINEMATIC_TRAJECTORY_H
+#define KINEMATIC_TRAJECTORY_H
+
+#ifdef _PRINT_HEADER_
+  #warning "KinematicTrajectory.h"
+#endif
+
+#include <mars/utils/Vector.h>
+#include <mars/utils/Quaternion.h>
+
+#include <configmaps/ConfigData.h>
+#include <vector>
+
+namespace mars {
+  namespace sim {
+
+    struct KinematicWaypoint {
+      double time;
+      utils::Vector position;
+      utils::Quaternion rotation;
+    };
+
+    enum KinematicTrajectoryMode {
+      KINEMATIC_ONCE,
+      KINEMATIC_LOOP,
+      KINEMATIC_PINGPONG
+    };
+
+    /**
+     * A pose trajectory through time stamped waypoints. The positions are
+     * interpolated linearly or by a cubic hermite spline with finite
+     * difference tangents, the rotations by slerp. After the last waypoint
+     * the trajectory stops, starts again or runs backwards.
+     *
+     * The config of the "kinematic" section of a node:
+     * \code
+     * kinematic:
+     *   interpolation: spline   # or linear (default)
+     *   mode: loop              # once (default), loop or pingpong
+     *   relative: true          # waypoints in the frame of the start pose
+     *   waypoints:
+     *     - {time: 0.0, position: {x: 0, y: 0, z: 0}}
+     *     - {time: 2.0, position: {x: 0, y: 0, z: 1.5},
+     *        rotation: {x: 0, y: 0, z: 0.707, w: 0.707}}
+     * \endcode
+     * A rotation can also be given as "euler" in degrees. Missing
+     * positions or rotations keep the start pose.
+     */
+    class KinematicTrajectory {
+    public:
+      KinematicTrajectory();
+
+      /**
+       * \brief Reads the waypoints from the config, returns false if there
+       * are none.
+       */
+      bool fromConfig(configmaps::ConfigMap &config,
+                      const utils::Vector &startPos,
+                      const utils::Quaternion &startRot);
+      bool empty() const {return waypoints.empty();}
+      void getPose(double time, utils::Vector *pos,
+                   utils::Quaternion *rot) const;
+
+    private:
+      std::vector<KinematicWaypoint> waypoints;
+      bool spline;
+      KinematicTrajectoryMode mode;
+
+      double mapTime(double time) const;
+      utils::Vector tangent(size_t i) const;
+    };
+
+  } // end of namespace sim
+} // end of namespace mars
+
+#endif // KINEMATIC_TRAJECTORY_H
@@ -0,0 +1,727 @@
+/*
+ *  Copyright 2017, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "MeshSDF.h"
+
+#include <mars/interfaces/Logging.hpp>
+#include <mars/utils/mathUtils.h>
+#include <mars/utils/Mutex.h>
+#include <mars/utils/MutexLocker.h>
+#include <mars/utils/misc.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <thread>
+
+#ifndef WIN32
+#include <unistd.h>
+#endif
+
+namespace mars {
+  namespace sim {
+
+    using namespace utils;
+
+    namespace {
+
+      // increase if the field computation or the file layout changes
+      const uint32_t sdfFormatVersion = 1;
+
+      struct FileHeader {
+        char magic[4];
+        uint32_t version;
+        uint64_t hash;
+        double cellSize, bandWidth;
+        double origin[3];
+        double bounds[6];
+        int32_t dims[3];
+        uint32_t blockCount;
+      };
+
+      uint64_t fnv1a(uint64_t hash, const void *data, size_t size) {
+        const unsigned char *bytes = (const unsigned char*)data;
+        for(size_t i = 0; i < size; ++i) {
+          hash ^= bytes[i];
+          hash *= 1099511628211ULL;
+        }
+        return hash;
+      }
+
+      uint64_t hashMesh(const dVector3 *vertices, int vertexCount,
+                        const dTriIndex *indices, int indexCount,
+                        dReal cellSize, dReal bandWidth) {
+        uint64_t hash = 14695981039346656037ULL;
+        hash = fnv1a(hash, &sdfFormatVersion, sizeof(sdfFormatVersion));
+        for(int i = 0; i < vertexCount; ++i) {
+          double v[3] = {vertices[i][0], vertices[i][1], vertices[i][2]};
+          hash = fnv1a(hash, v, sizeof(v));
+        }
+        for(int i = 0; i < indexCount; ++i) {
+          int32_t index = (int32_t)indices[i];
+          hash = fnv1a(hash, &index, sizeof(index));
+        }
+        double params[2] = {cellSize, bandWidth};
+        return fnv1a(hash, params, sizeof(params));
+      }
+
+      std::string cacheFilename(uint64_t hash) {
+        const char *tmp = getenv("TMPDIR");
+        std::stringstream s;
+        s << (tmp ? tmp : "/tmp") << "/mars_sdf_cache/" << std::hex << hash
+          << ".sdf";
+        return s.str();
+      }
+
+      /*
+       * Closest point on the triangle abc to p. region is 0 for the face,
+       * 1-3 for the vertices a, b, c and 4-6 for the edges ab, bc, ca.
+       */
+      Vector closestPoint(const Vector &p, const Vector &a, const Vector &b,
+                          const Vector &c, int *region) {
+        Vector ab = b-a, ac = c-a, ap = p-a;
+        double d1 = ab.dot(ap), d2 = ac.dot(ap);
+        if(d1 <= 0.0 && d2 <= 0.0) {*region = 1; return a;}
+        Vector bp = p-b;
+        double d3 = ab.dot(bp), d4 = ac.dot(bp);
+        if(d3 >= 0.0 && d4 <= d3) {*region = 2; return b;}
+        double vc = d1*d4 - d3*d2;
+        if(vc <= 0.0 && d1 >= 0.0 && d3 <= 0.0) {
+          *region = 4;
+          return a + ab*(d1/(d1-d3));
+        }
+        Vector cp = p-c;
+        double d5 = ab.dot(cp), d6 = ac.dot(cp);
+        if(d6 >= 0.0 && d5 <= d6) {*region = 3; return c;}
+        double vb = d5*d2 - d1*d6;
+        if(vb <= 0.0 && d2 >= 0.0 && d6 <= 0.0) {
+          *region = 6;
+          return a + ac*(d2/(d2-d6));
+        }
+        double va = d3*d6 - d5*d4;
+        if(va <= 0.0 && d4-d3 >= 0.0 && d5-d6 >= 0.0) {
+          *region = 5;
+          return b + (c-b)*((d4-d3)/((d4-d3)+(d5-d6)));
+        }
+        double denom = 1.0/(va+vb+vc);
+        *region = 0;
+        return a + ab*(vb*denom) + ac*(vc*denom);
+      }
+
+      std::pair<int, int> edgeKey(int i, int j) {
+        return i < j ? std::make_pair(i, j) : std::make_pair(j, i);
+      }
+
+      Mutex registryMutex;
+      std::map<uint64_t, std::weak_ptr<MeshSDF> > registry;
+
+    } // end of anonymous namespace
+
+    MeshSDF::MeshSDF() : cellSize(1.0), bandWidth(0.0) {
+      for(int i = 0; i < 3; ++i) {
+        origin[i] = 0.0;
+        dims[i] = 0;
+      }
+      for(int i = 0; i < 6; ++i) bounds[i] = 0.0;
+    }
+
+    std::shared_ptr<MeshSDF> MeshSDF::get(const dVector3 *vertices, int vertexCount,
+                                          const dTriIndex *indices, int indexCount,
+                                          dReal cellSize, dReal bandWidth) {
+      uint64_t hash = hashMesh(vertices, vertexCount, indices, indexCount,
+                               cellSize, bandWidth);
+      MutexLocker locker(&registryMutex);
+      std::shared_ptr<MeshSDF> sdf = registry[hash].lock();
+      if(sdf) return sdf;
+
+      sdf.reset(new MeshSDF());
+      std::string filename = cacheFilename(hash);
+      if(!sdf->load(filename, hash)) {
+        long long time = getTime();
+        sdf->build(vertices, vertexCount, indices, indexCount,
+                   cellSize, bandWidth);
+        LOG_INFO("MeshSDF: computed distance field of %d triangles with %lu blocks in %lld ms",
+                 indexCount/3, (unsigned long)sdf->getBlockCount(),
+                 getTimeDiff(time));
+        createDirectory(getPathOfFile(filename));
+        if(!sdf->save(filename, hash)) {
+          LOG_WARN("MeshSDF: could not write cache file %s", filename.c_str());
+        }
+      }
+      registry[hash] = sdf;
+      return sdf;
+    }
+
+    uint64_t MeshSDF::blockKey(int bx, int by, int bz) {
+      return ((uint64_t)bx << 42) | ((uint64_t)by << 21) | (uint64_t)bz;
+    }
+
+    float MeshSDF::getValue(int x, int y, int z) const {
+      if(x < 0 || y < 0 || z < 0 ||
+         x >= dims[0] || y >= dims[1] || z >= dims[2]) {
+        return (float)bandWidth;
+      }
+      std::unordered_map<uint64_t, int>::const_iterator it;
+      it = blockIndex.find(blockKey(x/blockSize, y/blockSize, z/blockSize));
+      if(it == blockIndex.end()) return (float)bandWidth;
+      return values[(size_t)it->second*blockVolume +
+                    ((z%blockSize)*blockSize + y%blockSize)*blockSize + x%blockSize];
+    }
+
+    float* MeshSDF::getOrCreateValue(int x, int y, int z) {
+      uint64_t key = blockKey(x/blockSize, y/blockSize, z/blockSize);
+      std::unordered_map<uint64_t, int>::iterator it = blockIndex.find(key);
+      int block;
+      if(it == blockIndex.end()) {
+        block = (int)blockIndex.size();
+        blockIndex[key] = block;
+        values.resize(values.size()+blockVolume, (float)bandWidth);
+      }
+      else {
+        block = it->second;
+      }
+      return &values[(size_t)block*blockVolume +
+                     ((z%blockSize)*blockSize + y%blockSize)*blockSize + x%blockSize];
+    }
+
+    void MeshSDF::build(const dVector3 *vertices, int vertexCount,
+                        const dTriIndex *indices, int indexCount,
+                        dReal cellSize, dReal bandWidth) {
+      this->cellSize = cellSize;
+      this->bandWidth = bandWidth;
+      blockIndex.clear();
+      values.clear();
+      for(int k = 0; k < 3; ++k) dims[k] = 0;
+      if(vertexCount == 0 || indexCount < 3) return;
+
+      std::vector<Vector> v(vertexCount);
+      for(int i = 0; i < vertexCount; ++i) {
+        v[i] = Vector(vertices[i][0], vertices[i][1], vertices[i][2]);
+        for(int k = 0; k < 3; ++k) {
+          if(i == 0 || v[i][k] < bounds[2*k]) bounds[2*k] = v[i][k];
+          if(i == 0 || v[i][k] > bounds[2*k+1]) bounds[2*k+1] = v[i][k];
+        }
+      }
+      for(int k = 0; k < 3; ++k) {
+        origin[k] = bounds[2*k] - bandWidth - cellSize;
+        dims[k] = (int)ceil((bounds[2*k+1] - origin[k] + bandWidth + cellSize)/cellSize) + 1;
+      }
+
+      // angle weighted pseudo normals of the faces, edges and vertices
+      const int triCount = indexCount/3;
+      std::vector<Vector> faceNormals(triCount, Vector::Zero());
+      std::vector<Vector> vertexNormals(vertexCount, Vector::Zero());
+      std::map<std::pair<int, int>, Vector> edgeNormals;
+      for(int t = 0; t < triCount; ++t) {
+        const dTriIndex *tri = indices + 3*t;
+        Vector n = (v[tri[1]]-v[tri[0]]).cross(v[tri[2]]-v[tri[0]]);
+        if(n.norm() < 1e-12) continue;
+        n.normalize();
+        faceNormals[t] = n;
+        for(int k = 0; k < 3; ++k) {
+          int i0 = tri[k], i1 = tri[(k+1)%3], i2 = tri[(k+2)%3];
+          Vector e1 = (v[i1]-v[i0]).normalized();
+          Vector e2 = (v[i2]-v[i0]).normalized();
+          double angle = acos(std::max(-1.0, std::min(1.0, e1.dot(e2))));
+          vertexNormals[i0] += angle*n;
+          std::pair<int, int> key = edgeKey(i0, i1);
+          if(edgeNormals.find(key) == edgeNormals.end()) {
+            edgeNormals[key] = n;
+          }
+          else {
+            edgeNormals[key] += n;
+          }
+        }
+      }
+
+      // every triangle writes its distance to the grid vertices in its
+      // band, the closest triangle wins
+      for(int t = 0; t < triCount; ++t) {
+        if(faceNormals[t].squaredNorm() == 0.0) continue;
+        const dTriIndex *tri = indices + 3*t;
+        const Vector &a = v[tri[0]], &b = v[tri[1]], &c = v[tri[2]];
+        Vector normals[7];
+        normals[0] = faceNormals[t];
+        for(int k = 0; k < 3; ++k) {
+          normals[1+k] = vertexNormals[tri[k]];
+          normals[4+k] = edgeNormals[edgeKey(tri[k], tri[(k+1)%3])];
+        }
+        int lo[3], hi[3];
+        for(int k = 0; k < 3; ++k) {
+          double minv = std::min(a[k], std::min(b[k], c[k])) - bandWidth;
+          double maxv = std::max(a[k], std::max(b[k], c[k])) + bandWidth;
+          lo[k] = std::max(0, (int)ceil((minv-origin[k])/cellSize));
+          hi[k] = std::min(dims[k]-1, (int)floor((maxv-origin[k])/cellSize));
+        }
+        for(int z = lo[2]; z <= hi[2]; ++z) {
+          for(int y = lo[1]; y <= hi[1]; ++y) {
+            for(int x = lo[0]; x <= hi[0]; ++x) {
+              Vector p(origin[0]+x*cellSize, origin[1]+y*cellSize,
+                       origin[2]+z*cellSize);
+              int region;
+              Vector d = p - closestPoint(p, a, b, c, &region);
+              double dist = d.norm();
+              if(dist >= bandWidth) continue;
+              float *value = getOrCreateValue(x, y, z);
+              if(dist >= fabs(*value)) continue;
+              *value = (float)(d.dot(normals[region]) < 0.0 ? -dist : dist);
+            }
+          }
+        }
+      }
+    }
+
+    bool MeshSDF::load(const std::string &filename, uint64_t hash) {
+      std::ifstream file(filename.c_str(), std::ios::binary);
+      if(!file.is_open()) return false;
+      FileHeader header;
+      if(!file.read((char*)&header, sizeof(header))) return false;
+      if(strncmp(header.magic, "MSDF", 4) || header.version != sdfFormatVersion ||
+         header.hash != hash) {
+        return false;
+      }
+      std::vector<uint64_t> keys(header.blockCount);
+      std::vector<float> data((size_t)header.blockCount*blockVolume);
+      if(header.blockCount &&
+         (!file.read((char*)&keys[0], keys.size()*sizeof(uint64_t)) ||
+          !file.read((char*)&data[0], data.size()*sizeof(float)))) {
+        return false;
+      }
+      cellSize = header.cellSize;
+      bandWidth = header.bandWidth;
+      for(int k = 0; k < 3; ++k) {
+        origin[k] = header.origin[k];
+        dims[k] = header.dims[k];
+      }
+      for(int k = 0; k < 6; ++k) bounds[k] = header.bounds[k];
+      blockIndex.clear();
+      for(size_t i = 0; i < keys.size(); ++i) blockIndex[keys[i]] = (int)i;
+      values.swap(data);
+      return true;
+    }
+
+    bool MeshSDF::save(const std::string &filename, uint64_t hash) const {
+      // the cache file only appears complete by the rename below, other
+      // processes and threads may write the same file concurrently
+      std::stringstream tmp;
+      tmp << filename << ".tmp";
+#ifndef WIN32
+      tmp << getpid();
+#endif
+      tmp << "_" << std::this_thread::get_id();
+      std::ofstream file(tmp.str().c_str(), std::ios::binary);
+      if(!file.is_open()) return false;
+      FileHeader header;
+      memset(&header, 0, sizeof(header));
+      memcpy(header.magic, "MSDF", 4);
+      header.version = sdfFormatVersion;
+      header.hash = hash;
+      header.cellSize = cellSize;
+      header.bandWidth = bandWidth;
+      for(int k = 0; k < 3; ++k) {
+        header.origin[k] = origin[k];
+        header.dims[k] = dims[k];
+      }
+      for(int k = 0; k < 6; ++k) header.bounds[k] = bounds[k];
+      header.blockCount = (uint32_t)blockIndex.size();
+      // keys in the order of the blocks in values
+      std::vector<uint64_t> keys(blockIndex.size());
+      std::unordered_map<uint64_t, int>::const_iterator it;
+      for(it = blockIndex.begin(); it != blockIndex.end(); ++it) {
+        keys[it->second] = it->first;
+      }
+      file.write((const char*)&header, sizeof(header));
+      if(!keys.empty()) {
+        file.write((const char*)&keys[0], keys.size()*sizeof(uint64_t));
+        file.write((const char*)&values[0], values.size()*sizeof(float));
+      }
+      file.close();
+      if(file.fail() || rename(tmp.str().c_str(), filename.c_str()) != 0) {
+        remove(tmp.str().c_str());
+        return false;
+      }
+      return true;
+    }
+
+    dReal MeshSDF::getDistance(const dReal *p) const {
+      dReal g[3];
+      int i[3];
+      for(int k = 0; k < 3; ++k) {
+        g[k] = (p[k]-origin[k])/cellSize;
+        if(g[k] < 0.0 || g[k] >= dims[k]-1) return bandWidth;
+        i[k] = (int)g[k];
+        g[k] -= i[k];
+      }
+      dReal c00 = getValue(i[0], i[1], i[2])*(1-g[0]) + getValue(i[0]+1, i[1], i[2])*g[0];
+      dReal c10 = getValue(i[0], i[1]+1, i[2])*(1-g[0]) + getValue(i[0]+1, i[1]+1, i[2])*g[0];
+      dReal c01 = getValue(i[0], i[1], i[2]+1)*(1-g[0]) + getValue(i[0]+1, i[1], i[2]+1)*g[0];
+      dReal c11 = getValue(i[0], i[1]+1, i[2]+1)*(1-g[0]) + getValue(i[0]+1, i[1]+1, i[2]+1)*g[0];
+      dReal c0 = c00*(1-g[1]) + c10*g[1];
+      dReal c1 = c01*(1-g[1]) + c11*g[1];
+      return c0*(1-g[2]) + c1*g[2];
+    }
+
+    void MeshSDF::getNormal(const dReal *p, dVector3 n) const {
+      const dReal h = 0.5*cellSize;
+      dReal length = 0.0;
+      for(int k = 0; k < 3; ++k) {
+        dVector3 p1 = {p[0], p[1], p[2]}, p2 = {p[0], p[1], p[2]};
+        p1[k] += h;
+        p2[k] -= h;
+        n[k] = getDistance(p1) - getDistance(p2);
+        length += n[k]*n[k];
+      }
+      if(length < 1e-20) {
+        n[0] = n[1] = 0.0;
+        n[2] = 1.0;
+        return;
+      }
+      length = 1.0/sqrt(length);
+      for(int k = 0; k < 3; ++k) n[k] *= length;
+    }
+
+
+    /*
+     * ode integration: the collider samples points of the other geom and
+     * tests them against the field of the static sdf geom
+     */
+    namespace {
+
+      int sdfGeomClass = -1;
+
+      struct SDFContact {
+        dVector3 pos, normal;
+        dReal depth;
+        bool operator<(const SDFContact &other) const {
+          return depth > other.depth;
+        }
+      };
+
+      struct SDFSample {
+        dVector3 pos;
+        dReal radius;
+      };
+
+      MeshSDF* getSDF(dGeomID geom) {
+        return *(MeshSDF**)dGeomGetClassData(geom);
+      }
+
+      void worldToLocal(dGeomID geom, const dReal *p, dVector3 local) {
+        const dReal *pos = dGeomGetPosition(geom);
+        const dReal *R = dGeomGetRotation(geom);
+        dVector3 d = {p[0]-pos[0], p[1]-pos[1], p[2]-pos[2]};
+        dMULTIPLY1_331(local, R, d);
+      }
+
+      void addLocalSample(dGeomID geom, dReal x, dReal y, dReal z,
+                          dReal radius, std::vector<SDFSample> *samples) {
+        const dReal *pos = dGeomGetPosition(geom);
+        const dReal *R = dGeomGetRotation(geom);
+        dVector3 local = {x, y, z}, world;
+        dMULTIPLY0_331(world, R, local);
+        SDFSample sample;
+        for(int k = 0; k < 3; ++k) sample.pos[k] = world[k] + pos[k];
+        sample.radius = radius;
+        samples->push_back(sample);
+      }
+
+      // points on the surface of a sphere, used if the sphere is too large
+      // to be handled by the distance of its center alone
+      void addSphereSurface(dGeomID geom, dReal x, dReal y, dReal z,
+                            dReal r, std::vector<SDFSample> *samples) {
+        const dReal d = r/sqrt(3.0);
+        for(int k = 0; k < 3; ++k) {
+          for(int s = -1; s <= 1; s += 2) {
+            dReal o[3] = {0, 0, 0};
+            o[k] = s*r;
+            addLocalSample(geom, x+o[0], y+o[1], z+o[2], 0, samples);
+          }
+        }
+        for(int i = 0; i < 8; ++i) {
+          addLocalSample(geom, x+(i&1 ? d : -d), y+(i&2 ? d : -d),
+                         z+(i&4 ? d : -d), 0, samples);
+        }
+      }
+
+      int divisions(dReal length, dReal step, int maxDivisions) {
+        return std::max(1, std::min(maxDivisions, (int)ceil(length/step)));
+      }
+
+      void sampleGeom(dGeomID geom, const MeshSDF *sdf,
+                      std::vector<SDFSample> *samples) {
+        const dReal step = 2.0*sdf->getCellSize();
+        const dReal band = sdf->getBandWidth();
+        switch(dGeomGetClass(geom)) {
+        case dSphereClass: {
+          dReal r = dGeomSphereGetRadius(geom);
+          addLocalSample(geom, 0, 0, 0, r, samples);
+          if(r >= band) addSphereSurface(geom, 0, 0, 0, r, samples);
+          break;
+        }
+        case dCapsuleClass: {
+          dReal r, l;
+          dGeomCapsuleGetParams(geom, &r, &l);
+          int n = divisions(l, std::min(r, step), 32);
+          for(int i = 0; i <= n; ++i) {
+            dReal z = -0.5*l + l*i/n;
+            addLocalSample(geom, 0, 0, z, r, samples);
+            if(r >= band) addSphereSurface(geom, 0, 0, z, r, samples);
+          }
+          break;
+        }
+        case dBoxClass: {
+          // the grid points on the surface of the box
+          dVector3 sides;
+          dGeomBoxGetLengths(geom, sides);
+          int n[3];
+          for(int k = 0; k < 3; ++k) n[k] = divisions(sides[k], step, 8);
+          for(int i = 0; i <= n[0]; ++i) {
+            for(int j = 0; j <= n[1]; ++j) {
+              for(int k = 0; k <= n[2]; ++k) {
+                if(i > 0 && i < n[0] && j > 0 && j < n[1] && k > 0 && k < n[2]) {
+                  continue;
+                }
+                addLocalSample(geom, sides[0]*((dReal)i/n[0]-0.5),
+                               sides[1]*((dReal)j/n[1]-0.5),
+                               sides[2]*((dReal)k/n[2]-0.5), 0, samples);
+              }
+            }
+          }
+          break;
+        }
+        case dCylinderClass: {
+          dReal r, l;
+          dGeomCylinderGetParams(geom, &r, &l);
+          const int segments = 16;
+          int nl = divisions(l, step, 8);
+          int nr = divisions(r, step, 4);
+          for(int s = 0; s < segments; ++s) {
+            dReal a = 2.0*M_PI*s/segments;
+            dReal x = cos(a), y = sin(a);
+            for(int i = 0; i <= nl; ++i) {
+              addLocalSample(geom, r*x, r*y, -0.5*l + l*i/nl, 0, samples);
+            }
+            for(int i = 1; i < nr; ++i) {
+              dReal ri = r*i/nr;
+              addLocalSample(geom, ri*x, ri*y, -0.5*l, 0, samples);
+              addLocalSample(geom, ri*x, ri*y, 0.5*l, 0, samples);
+            }
+          }
+          addLocalSample(geom, 0, 0, -0.5*l, 0, samples);
+          addLocalSample(geom, 0, 0, 0.5*l, 0, samples);
+          break;
+        }
+        case dTriMeshClass: {
+          int count = dGeomTriMeshGetTriangleCount(geom);
+          dVector3 v[3];
+          for(int i = 0; i < count; ++i) {
+            dGeomTriMeshGetTriangle(geom, i, &v[0], &v[1], &v[2]);
+            for(int k = 0; k < 3; ++k) {
+              SDFSample sample;
+              memcpy(sample.pos, v[k], sizeof(dVector3));
+              sample.radius = 0;
+              samples->push_back(sample);
+            }
+          }
+          break;
+        }
+        default:
+          break;
+        }
+      }
+
+      int writeContacts(dGeomID o1, dGeomID o2, int flags,
+                        std::vector<SDFContact> *contacts,
+                        dContactGeom *contact, int skip) {
+        int maxContacts = std::max(1, flags & 0xffff);
+        int num = std::min((int)contacts->size(), maxContacts);
+        if(num < (int)contacts->size()) {
+          std::partial_sort(contacts->begin(), contacts->begin()+num,
+                            contacts->end());
+        }
+        for(int i = 0; i < num; ++i) {
+          dContactGeom *c = (dContactGeom*)((char*)contact + i*skip);
+          const SDFContact &sc = (*contacts)[i];
+          for(int k = 0; k < 3; ++k) {
+            c->pos[k] = sc.pos[k];
+            c->normal[k] = sc.normal[k];
+          }
+          c->depth = sc.depth;
+          c->g1 = o1;
+          c->g2 = o2;
+          c->side1 = c->side2 = -1;
+        }
+        return num;
+      }
+
+      int collideSDFGeom(dGeomID o1, dGeomID o2, int flags,
+                         dContactGeom *contact, int skip) {
+        const MeshSDF *sdf = getSDF(o1);
+        const dReal *R = dGeomGetRotation(o1);
+        const dReal band = sdf->getBandWidth();
+        std::vector<SDFSample> samples;
+        std::vector<SDFContact> contacts;
+        sampleGeom(o2, sdf, &samples);
+        for(size_t i = 0; i < samples.size(); ++i) {
+          dVector3 local, n, normal;
+          worldToLocal(o1, samples[i].pos, local);
+          dReal d = sdf->getDistance(local);
+          // outside of the band nothing is known about the surface
+          if(d >= band) continue;
+          dReal depth = samples[i].radius - d;
+          if(depth <= 0.0) continue;
+          sdf->getNormal(local, n);
+          dMULTIPLY0_331(normal, R, n);
+          SDFContact c;
+          for(int k = 0; k < 3; ++k) {
+            c.pos[k] = samples[i].pos[k] - normal[k]*samples[i].radius;
+            // ode expects the normal to point from o2 into o1
+            c.normal[k] = -normal[k];
+          }
+          c.depth = depth;
+          contacts.push_back(c);
+          if(flags & CONTACTS_UNIMPORTANT) break;
+        }
+        return writeContacts(o1, o2, flags, &contacts, contact, skip);
+      }
+
+      int collideSDFRay(dGeomID o1, dGeomID o2, int flags,
+                        dContactGeom *contact, int skip) {
+        const MeshSDF *sdf = getSDF(o1);
+        const dReal *R = dGeomGetRotation(o1);
+        const dReal *bounds = sdf->getBounds();
+        const dReal band = sdf->getBandWidth();
+        dVector3 start, dir, localStart, localDir;
+        dGeomRayGet(o2, start, dir);
+        dReal length = dGeomRayGetLength(o2);
+        worldToLocal(o1, start, localStart);
+        dMULTIPLY1_331(localDir, R, dir);
+
+        // clip the ray to the bounding box of the field
+        dReal t0 = 0.0, t1 = length;
+        for(int k = 0; k < 3; ++k) {
+          dReal lo = bounds[2*k]-band, hi = bounds[2*k+1]+band;
+          if(fabs(localDir[k]) < 1e-12) {
+            if(localStart[k] < lo || localStart[k] > hi) return 0;
+            continue;
+          }
+          dReal ta = (lo-localStart[k])/localDir[k];
+          dReal tb = (hi-localStart[k])/localDir[k];
+          if(ta > tb) std::swap(ta, tb);
+          t0 = std::max(t0, ta);
+          t1 = std::min(t1, tb);
+        }
+        if(t0 > t1) return 0;
+
+        // sphere tracing, the step is never smaller than a quarter cell
+        const dReal minStep = 0.25*sdf->getCellSize();
+        dReal t = t0, lastT = t0;
+        dVector3 p;
+        for(int k = 0; k < 3; ++k) p[k] = localStart[k] + localDir[k]*t;
+        dReal d = sdf->getDistance(p);
+        if(d <= 0.0) return 0;
+        while(d > 0.0) {
+          lastT = t;
+          t += std::max(d, minStep);
+          if(t > t1) return 0;
+          for(int k = 0; k < 3; ++k) p[k] = localStart[k] + localDir[k]*t;
+          d = sdf->getDistance(p);
+        }
+        // refine the crossing between lastT and t
+        for(int i = 0; i < 8; ++i) {
+          dReal m = 0.5*(lastT+t);
+          for(int k = 0; k < 3; ++k) p[k] = localStart[k] + localDir[k]*m;
+          if(sdf->getDistance(p) > 0.0) lastT = m;
+          else t = m;
+        }
+        for(int k = 0; k < 3; ++k) p[k] = localStart[k] + localDir[k]*t;
+        dVector3 n, normal;
+        sdf->getNormal(p, n);
+        dMULTIPLY0_331(normal, R, n);
+        std::vector<SDFContact> contacts(1);
+        for(int k = 0; k < 3; ++k) {
+          contacts[0].pos[k] = start[k] + dir[k]*t;
+          contacts[0].normal[k] = -normal[k];
+        }
+        contacts[0].depth = t;
+        return writeContacts(o1, o2, flags, &contacts, contact, skip);
+      }
+
+      dColliderFn* getSDFCollider(int num) {
+        switch(num) {
+        case dSphereClass:
+        case dCapsuleClass:
+        case dBoxClass:
+        case dCylinderClass:
+        case dTriMeshClass:
+          return collideSDFGeom;
+        case dRayClass:
+          return collideSDFRay;
+        default:
+          return 0;
+        }
+      }
+
+      void getSDFAABB(dGeomID geom, dReal aabb[6]) {
+        const MeshSDF *sdf = getSDF(geom);
+        const dReal *bounds = sdf->getBounds();
+        const dReal *pos = dGeomGetPosition(geom);
+        const dReal *R = dGeomGetRotation(geom);
+        for(int k = 0; k < 3; ++k) {
+          aabb[2*k] = dInfinity;
+          aabb[2*k+1] = -dInfinity;
+        }
+        for(int i = 0; i < 8; ++i) {
+          dVector3 corner = {bounds[i&1 ? 1 : 0], bounds[i&2 ? 3 : 2],
+                             bounds[i&4 ? 5 : 4]}, world;
+          dMULTIPLY0_331(world, R, corner);
+          for(int k = 0; k < 3; ++k) {
+            aabb[2*k] = std::min(aabb[2*k], world[k]+pos[k]);
+            aabb[2*k+1] = std::max(aabb[2*k+1], world[k]+pos[k]);
+          }
+        }
+      }
+
+    } // end of anonymous namespace
+
+    dGeomID createMeshSDFGeom(dSpaceID space, MeshSDF *sdf) {
+      // ode keeps the custom classes until the process ends
+      if(sdfGeomClass == -1) {
+        dGeomClass c;
+        c.bytes = sizeof(MeshSDF*);
+        c.collider = getSDFCollider;
+        c.aabb = getSDFAABB;
+        c.aabb_test = 0;
+        c.dtor = 0;
+        sdfGeomClass = dCreateGeomClass(&c);
+      }
+      dGeomID geom = dCreateGeom(sdfGeomClass);
+      *(MeshSDF**)dGeomGetClassData(geom) = sdf;
+      if(space) dSpaceAdd(space, geom);
+      return geom;
+    }
+
+  } // end of namespace sim
+} // end of namespace mars
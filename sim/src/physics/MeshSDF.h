@@ -0,0 +1,117 @@
+/*
+ *  Copyright 2017, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * \file MeshSDF.h
+ * \brief A sparse signed distance field of a static triangle mesh that is
+ *        used as custom ode geom instead of a trimesh.
+ */
+
+#ifndef MESH_SDF_H
+#define MESH_SDF_H
+
+#ifdef _PRINT_HEADER_
+  #warning "MeshSDF.h"
+#endif
+
+#include <ode/ode.h>
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <stdint.h>
+
+#ifndef ODE11
+  #define dTriIndex int
+#endif
+
+namespace mars {
+  namespace sim {
+
+    /**
+     * The distance field is sampled on the vertices of a regular grid in
+     * the mesh frame. Only blocks of 8x8x8 grid vertices that lie within
+     * \c bandWidth of a triangle are stored. Outside of that narrow band
+     * getDistance() returns \c bandWidth, thus geoms are only tested
+     * against the field near the surface.
+     *
+     * The sign is taken from the angle weighted pseudo normal of the
+     * closest feature. This is well defined for closed meshes and gives
+     * "below the surface" for open meshes like scanned terrain.
+     */
+    class MeshSDF {
+    public:
+      MeshSDF();
+
+      /**
+       * \brief Returns the field of the mesh. The field is shared with
+       * other nodes using the same mesh and cached in the directory
+       * "mars_sdf_cache" below $TMPDIR, thus it is computed only once.
+       */
+      static std::shared_ptr<MeshSDF> get(const dVector3 *vertices, int vertexCount,
+                                          const dTriIndex *indices, int indexCount,
+                                          dReal cellSize, dReal bandWidth);
+
+      void build(const dVector3 *vertices, int vertexCount,
+                 const dTriIndex *indices, int indexCount,
+                 dReal cellSize, dReal bandWidth);
+      bool load(const std::string &filename, uint64_t hash);
+      bool save(const std::string &filename, uint64_t hash) const;
+
+      //! signed distance at the point \a p given in mesh coordinates
+      dReal getDistance(const dReal *p) const;
+      //! normalized gradient of the field at \a p in mesh coordinates
+      void getNormal(const dReal *p, dVector3 n) const;
+      dReal getBandWidth() const {return bandWidth;}
+      dReal getCellSize() const {return cellSize;}
+      //! bounding box of the mesh as minx, maxx, miny, maxy, minz, maxz
+      const dReal* getBounds() const {return bounds;}
+      size_t getBlockCount() const {return blockIndex.size();}
+
+    private:
+      static const int blockSize = 8;
+      static const int blockVolume = blockSize*blockSize*blockSize;
+
+      dReal cellSize, bandWidth;
+      dReal origin[3];
+      dReal bounds[6];
+      int dims[3];
+      std::unordered_map<uint64_t, int> blockIndex;
+      std::vector<float> values;
+
+      static uint64_t blockKey(int bx, int by, int bz);
+      float getValue(int x, int y, int z) const;
+      float* getOrCreateValue(int x, int y, int z);
+    };
+
+    /**
+     * \brief Creates an ode geom of the custom class that collides
+     * spheres, capsules, boxes, cylinders, trimeshes and rays with \a sdf.
+     * The geom is static and must be positioned with dGeomSetPosition and
+     * dGeomSetQuaternion. \a sdf has to stay valid until the geom is
+     * destroyed.
+     */
+    dGeomID createMeshSDFGeom(dSpaceID space, MeshSDF *sdf);
+
+  } // end of namespace sim
+} // end of namespace mars
+
+#endif  // MESH_SDF_H
@@ -43,6 +43,7 @@
 #include <mars/utils/mathUtils.h>
 #include <mars/interfaces/sensor_bases.h>
 #include <mars/interfaces/terrainStruct.h>
+#include <algorithm>
 #include <cmath>
 #include <set>
 
@@ -76,6 +77,12 @@ namespace mars {
       myIndices = 0;
       myTriMeshData = 0;
       composite = false;
+      fluidNode = false;
+      ccdNode = false;
+      ccdRadius = ccdThreshold = 0;
+      kinematicNode = kinematicTargetSet = false;
+      kinematicTime = 0;
+      carrierNode = 0;
       //node_data.num_ground_collisions = 0;
       node_data.setZero();
       height_data = 0;
@@ -97,6 +104,11 @@ namespace mars {
       std::vector<sensor_list_element>::iterator iter;
       MutexLocker locker(&(theWorld->iMutex));
 
+      if(fluidNode) theWorld->removeFluidNode(this);
+      if(ccdNode) theWorld->removeCCDNode(this);
+      if(kinematicNode) theWorld->removeKinematicNode(this);
+      releaseCarrier();
+      releaseCarriedNodes();
       if(nBody) theWorld->destroyBody(nBody, this);
 
       if(nGeom) dGeomDestroy(nGeom);
@@ -115,6 +127,7 @@ namespace mars {
         sensor_list.erase(iter);
       }
       if(myTriMeshData) dGeomTriMeshDataDestroy(myTriMeshData);
+      meshSDF.reset();
     }
 
     dReal heightfield_callback(void* pUserData, int x, int z ) {
@@ -181,7 +194,12 @@ namespace mars {
 
         // then, if the geometry was sucsessfully build, we can create a
         // body for the node or add the node to an existing body
-        if(node->movable) setProperties(node);
+        if(node->movable) {
+          setProperties(node);
+          setupFluid(node);
+          setupCCD(node);
+          setupKinematic(node);
+        }
         else if(node->physicMode != NODE_TYPE_PLANE) {
           dQuaternion tmp, t1, t2;
           tmp[1] = (dReal)node->rot.x();
@@ -389,7 +407,15 @@ namespace mars {
       const dReal *tmp;
       MutexLocker locker(&(theWorld->iMutex));
 
-      if(nBody) {
+      if(carrierNode) {
+        dVector3 v;
+        tmp = dGeomGetPosition(nGeom);
+        dBodyGetPointVel(carrierNode->nBody, tmp[0], tmp[1], tmp[2], v);
+        vel->x() = (sReal)v[0];
+        vel->y() = (sReal)v[1];
+        vel->z() = (sReal)v[2];
+      }
+      else if(nBody) {
         tmp = dBodyGetLinearVel(nBody);
         vel->x() = (sReal)tmp[0];
         vel->y() = (sReal)tmp[1];
@@ -422,7 +448,7 @@ namespace mars {
       MutexLocker locker(&(theWorld->iMutex));
 
       if(nBody) {
-        tmp = dBodyGetAngularVel(nBody);
+        tmp = dBodyGetAngularVel(carrierNode ? carrierNode->nBody : nBody);
         vel->x() = (sReal)tmp[0];
         vel->y() = (sReal)tmp[1];
         vel->z() = (sReal)tmp[2];
@@ -656,6 +682,23 @@ namespace mars {
         myIndices[i] = (dTriIndex)node->mesh.indices[i];
       }
 
+      // static meshes can be represented by a signed distance field that
+      // is sampled by the colliding geoms instead of a trimesh
+      if(!node->movable && node->map.get("sdf_collider", false)) {
+        dReal maxExt = std::max(node->ext.x(), std::max(node->ext.y(), node->ext.z()));
+        dReal cellSize = node->map.get("sdf_cell_size", maxExt/256.0);
+        dReal bandWidth = node->map.get("sdf_band_width", 3.0*cellSize);
+        if(cellSize > 0 && bandWidth > 0) {
+          meshSDF = MeshSDF::get(myVertices, node->mesh.vertexcount,
+                                 myIndices, node->mesh.indexcount,
+                                 cellSize, bandWidth);
+          nGeom = createMeshSDFGeom(theWorld->getSpace(), meshSDF.get());
+          return true;
+        }
+        LOG_WARN("NodePhysics: invalid sdf parameters for node \"%s\", using a trimesh",
+                 node->name.c_str());
+      }
+
       // then we can build the ode representation
       myTriMeshData = dGeomTriMeshDataCreate();
       dGeomTriMeshDataBuildSimple(myTriMeshData, (dReal*)myVertices,
@@ -1119,6 +1162,9 @@ namespace mars {
             }
           }
         }
+        setupFluid(node);
+        setupCCD(node);
+        setupKinematic(node);
         dGeomSetData(nGeom, &node_data);
         locker.unlock();
         setContactParams(node->c_params);
@@ -1264,6 +1310,21 @@ namespace mars {
       }
     }
 
+    void NodePhysics::getContactForces(std::vector<Vector> *contact_points,
+                                       std::vector<Vector> *forces) const {
+      contact_points->clear();
+      forces->clear();
+      if(!nGeom) return;
+      for(size_t i=0; i<node_data.contact_feedbacks.size(); ++i) {
+        const contact_feedback &cfb = node_data.contact_feedbacks[i];
+        if(!cfb.fb) continue;
+        const dReal *f = cfb.side == 2 ? cfb.fb->f2 : cfb.fb->f1;
+        double sign = cfb.side < 0 ? -1.0 : 1.0;
+        contact_points->push_back(node_data.contact_points[i]);
+        forces->push_back(Vector(sign*f[0], sign*f[1], sign*f[2]));
+      }
+    }
+
     void NodePhysics::getContactIDs(std::list<interfaces::NodeId> *ids) const {
       ids->clear();
       if(nGeom) {
@@ -1368,9 +1429,23 @@ namespace mars {
     void NodePhysics::setContactParams(contact_params& c_params) {
       MutexLocker locker(&(theWorld->iMutex));
       node_data.c_params = c_params;
+      // keep the exclusion list sorted for the lookup in the near callback
+      std::sort(node_data.c_params.coll_exclude.begin(),
+                node_data.c_params.coll_exclude.end());
+      if(c_params.contact_material.empty()) {
+        node_data.contact_material = -1;
+      }
+      else {
+        node_data.contact_material = theWorld->getContactMaterialIndex(c_params.contact_material);
+      }
       if(nGeom) {
         dGeomSetCollideBits(nGeom, c_params.coll_bitmask);
-        dGeomSetCategoryBits(nGeom, c_params.coll_bitmask);
+        if(c_params.coll_category < 0) {
+          dGeomSetCategoryBits(nGeom, c_params.coll_bitmask);
+        }
+        else {
+          dGeomSetCategoryBits(nGeom, c_params.coll_category);
+        }
       }
     }
 
@@ -1581,6 +1656,13 @@ namespace mars {
         } else
           ++iter;
       }
+      inactiveSensors.erase(sensor);
+    }
+
+    void NodePhysics::setSensorActive(BaseSensor *sensor, bool active) {
+      MutexLocker locker(&(theWorld->iMutex));
+      if(active) inactiveSensors.erase(sensor);
+      else inactiveSensors.insert(sensor);
     }
 
     /**
@@ -1612,6 +1694,9 @@ namespace mars {
       int i=0;
       for(iter = sensor_list.begin(); iter != sensor_list.end(); iter++) {
         i+=1;
+        if(!inactiveSensors.empty() && inactiveSensors.count(iter->sensor)) {
+          continue;
+        }
         if((double)iter->sensor->updateRate * 0.001 > worldStep) {
           iter->updateTime += worldStep;
           if(iter->updateTime < 0.001*iter->sensor->updateRate) continue;
@@ -1711,6 +1796,168 @@ namespace mars {
       } // end for loop.
     }
 
+    /**
+     * \brief Registers the node for the fluid forces if it has a body and
+     * a "fluid" section in its config. The iMutex has to be locked by the
+     * caller.
+     */
+    void NodePhysics::setupFluid(NodeData *node) {
+      dReal meshVolume = 0;
+      if(node->physicMode == NODE_TYPE_MESH && myVertices && myIndices) {
+        // divergence theorem on the closed mesh
+        for(int i=0; i+2<node->mesh.indexcount; i+=3) {
+          const dReal *a = myVertices[myIndices[i]];
+          const dReal *b = myVertices[myIndices[i+1]];
+          const dReal *c = myVertices[myIndices[i+2]];
+          meshVolume += (a[0]*(b[1]*c[2]-b[2]*c[1]) -
+                         a[1]*(b[0]*c[2]-b[2]*c[0]) +
+                         a[2]*(b[0]*c[1]-b[1]*c[0]))/6.0;
+        }
+        meshVolume = fabs(meshVolume);
+      }
+      bool fluid = node->movable && nBody &&
+        fluidNodeParamsFromConfig(*node, meshVolume, &fluidParams);
+      if(fluid && !fluidNode) theWorld->addFluidNode(this);
+      else if(!fluid && fluidNode) theWorld->removeFluidNode(this);
+      fluidNode = fluid;
+    }
+
+    void NodePhysics::handleFluid(const FluidDescription &fluid,
+                                  const dReal *gravity, dReal stepSize) {
+      if(nBody && nGeom && dBodyIsEnabled(nBody)) {
+        addFluidForces(fluid, fluidParams, nBody, nGeom, gravity, stepSize);
+      }
+    }
+
+    void NodePhysics::collectAddedMass(std::map<dBodyID, FluidAddedMass> *added) {
+      if(nBody && nGeom && dBodyIsEnabled(nBody)) {
+        addAddedMass(fluidParams, nGeom, &(*added)[nBody]);
+      }
+    }
+
+    /**
+     * \brief Registers the node for continuous collision detection if it
+     * has a body and "ccd" is set in its config, either as "ccd: true" or
+     * as map with the optional keys "radius" (the sweep resolution,
+     * default is the inner radius of the geometry) and "threshold" (the
+     * motion per step below which the discrete collision is sufficient,
+     * default is the radius). The iMutex has to be locked by the caller.
+     */
+    void NodePhysics::setupCCD(NodeData *node) {
+      configmaps::ConfigMap map = node->map;
+      bool ccd = node->movable && nBody && nGeom && map.hasKey("ccd") &&
+        (map["ccd"].isMap() || (bool)map["ccd"]);
+      if(ccd) {
+        const Vector &ext = node->ext;
+        switch(node->physicMode) {
+        case NODE_TYPE_SPHERE:
+        case NODE_TYPE_CAPSULE:
+          ccdRadius = ext.x();
+          break;
+        case NODE_TYPE_CYLINDER:
+          ccdRadius = std::min(ext.x(), 0.5*ext.y());
+          break;
+        default:
+          ccdRadius = 0.5*std::min(ext.x(), std::min(ext.y(), ext.z()));
+          break;
+        }
+        ccdThreshold = -1;
+        if(map["ccd"].isMap()) {
+          configmaps::ConfigMap &params = map["ccd"];
+          if(params.hasKey("radius")) ccdRadius = params["radius"];
+          if(params.hasKey("threshold")) ccdThreshold = params["threshold"];
+        }
+        if(ccdThreshold < 0) ccdThreshold = ccdRadius;
+        if(ccdRadius <= 0) {
+          LOG_WARN("NodePhysics: no continuous collision for node \"%s\" "
+                   "without extent", node->name.c_str());
+          ccd = false;
+        }
+      }
+      if(ccd && !ccdNode) theWorld->addCCDNode(this);
+      else if(!ccd && ccdNode) theWorld->removeCCDNode(this);
+      ccdNode = ccd;
+    }
+
+    void NodePhysics::handleCCD(dReal stepSize) {
+      if(nBody && nGeom) {
+        theWorld->sweepGeom(nGeom, ccdRadius, ccdThreshold, stepSize);
+      }
+    }
+
+    /**
+     * \brief Makes the body of the node kinematic if its config has a
+     * "kinematic" section, see KinematicTrajectory for the format. The ode
+     * body keeps moving with the velocities that are set before every step
+     * and is never part of the solver. Contacts and joints see it like a
+     * moving static object. The iMutex has to be locked by the caller.
+     */
+    void NodePhysics::setupKinematic(NodeData *node) {
+      configmaps::ConfigMap map = node->map;
+      bool kinematic = node->movable && nBody && map.hasKey("kinematic") &&
+        (map["kinematic"].isMap() || (bool)map["kinematic"]);
+      if(kinematic && composite) {
+        LOG_WARN("NodePhysics: node \"%s\" is part of a composite body "
+                 "and can't be kinematic", node->name.c_str());
+        kinematic = false;
+      }
+      if(kinematic) {
+        configmaps::ConfigMap empty;
+        configmaps::ConfigMap &config = map["kinematic"].isMap() ?
+          (configmaps::ConfigMap&)map["kinematic"] : empty;
+        kinematicTrajectory.fromConfig(config, node->pos, node->rot);
+        kinematicTime = 0;
+        kinematicTargetSet = false;
+        dBodySetKinematic(nBody);
+      }
+      else if(kinematicNode && nBody) {
+        dBodySetDynamic(nBody);
+      }
+      if(kinematic && !kinematicNode) theWorld->addKinematicNode(this);
+      else if(!kinematic && kinematicNode) theWorld->removeKinematicNode(this);
+      kinematicNode = kinematic;
+    }
+
+    void NodePhysics::handleKinematic(dReal stepSize) {
+      if(!nBody || !dBodyIsEnabled(nBody) || stepSize <= 0) return;
+      kinematicTime += stepSize;
+      Vector targetPos;
+      Quaternion targetRot;
+      if(kinematicTargetSet) {
+        targetPos = kinematicTargetPos;
+        targetRot = kinematicTargetRot;
+      }
+      else if(!kinematicTrajectory.empty()) {
+        kinematicTrajectory.getPose(kinematicTime, &targetPos, &targetRot);
+      }
+      else {
+        // without trajectory the node stays where it is
+        dBodySetLinearVel(nBody, 0, 0, 0);
+        dBodySetAngularVel(nBody, 0, 0, 0);
+        return;
+      }
+
+      const dReal *p = dBodyGetPosition(nBody);
+      const dReal *q = dBodyGetQuaternion(nBody);
+      Vector linearVel = (targetPos - Vector(p[0], p[1], p[2]))/stepSize;
+      Quaternion rot(q[0], q[1], q[2], q[3]);
+      Quaternion delta = targetRot*rot.conjugate();
+      if(delta.w() < 0) delta.coeffs() *= -1;
+      Eigen::AngleAxis<double> angleAxis(delta);
+      Vector angularVel = angleAxis.axis()*angleAxis.angle()/stepSize;
+      dBodySetLinearVel(nBody, linearVel.x(), linearVel.y(), linearVel.z());
+      dBodySetAngularVel(nBody, angularVel.x(), angularVel.y(),
+                         angularVel.z());
+    }
+
+    void NodePhysics::setKinematicTarget(const Vector &pos,
+                                         const Quaternion &rot) {
+      MutexLocker locker(&(theWorld->iMutex));
+      kinematicTargetPos = pos;
+      kinematicTargetRot = rot.normalized();
+      kinematicTargetSet = true;
+    }
+
     /**
      * \brief destroyes a node from the physics
      *
@@ -1720,6 +1967,14 @@ namespace mars {
      */
     void NodePhysics::destroyNode(void) {
       MutexLocker locker(&(theWorld->iMutex));
+      if(fluidNode) theWorld->removeFluidNode(this);
+      fluidNode = false;
+      if(ccdNode) theWorld->removeCCDNode(this);
+      ccdNode = false;
+      if(kinematicNode) theWorld->removeKinematicNode(this);
+      kinematicNode = false;
+      releaseCarrier();
+      releaseCarriedNodes();
       if(nBody) theWorld->destroyBody(nBody, this);
 
       if(nGeom) dGeomDestroy(nGeom);
@@ -1733,12 +1988,193 @@ namespace mars {
       myVertices = 0;
       myIndices = 0;
       myTriMeshData = 0;
+      meshSDF.reset();
       composite = false;
       //node_data.num_ground_collisions = 0;
       node_data.setZero();
       height_data = 0;
     }
 
+    /**
+     * \brief Enables or disables the body and the geom of the node
+     *
+     * A disabled body is skipped by the world step and a disabled geom
+     * by the collision detection, thus an inactive node costs nothing
+     * while it keeps its body, geom and mesh data for a later reuse.
+     * The velocities and accumulated forces are cleared on activation.
+     */
+    void NodePhysics::setActive(bool active) {
+      MutexLocker locker(&(theWorld->iMutex));
+      if(nGeom) {
+        if(active) dGeomEnable(nGeom);
+        else dGeomDisable(nGeom);
+      }
+      // the body of a carried node stays disabled until it is released
+      if(nBody && !carrierNode) {
+        if(active) {
+          dBodySetLinearVel(nBody, 0, 0, 0);
+          dBodySetAngularVel(nBody, 0, 0, 0);
+          dBodySetForce(nBody, 0, 0, 0);
+          dBodySetTorque(nBody, 0, 0, 0);
+          dBodyEnable(nBody);
+        }
+        else {
+          dBodyDisable(nBody);
+        }
+      }
+    }
+
+    /**
+     * \brief Carries the geom of the node rigidly on the body of another
+     * node
+     *
+     * The own body is disabled and its mass is added to the carrier at the
+     * current relative pose. The geom keeps its world pose as offset on the
+     * carrier body. ode needs the center of mass in the body origin, thus
+     * the combined mass is shifted there, which is the approximation of
+     * the reduced model.
+     *
+     * With carrier 0 the own body is placed at the pose of the geom again
+     * and takes over the velocity of the carrier at that point. The
+     * carrier gets its original mass back with the last released node.
+     * A destroyed carrier releases its nodes the same way.
+     * Nodes of a composite body can't be carried.
+     */
+    bool NodePhysics::setCarrier(NodeInterface *carrier) {
+      MutexLocker locker(&(theWorld->iMutex));
+      NodePhysics *c = (NodePhysics*)carrier;
+      if(!nBody || !nGeom || c == this) return true;
+
+      if(c) {
+        if(carrierNode) return carrierNode == c;
+        if(c->nBody == nBody) return true;
+        if(composite || !c->nBody) return false;
+        dVector3 pos;
+        dQuaternion rot;
+        const dReal *tmp = dGeomGetPosition(nGeom);
+        pos[0] = tmp[0];
+        pos[1] = tmp[1];
+        pos[2] = tmp[2];
+        dGeomGetQuaternion(nGeom, rot);
+        tmp = dGeomGetOffsetPosition(nGeom);
+        carrierOffsetPos[0] = tmp[0];
+        carrierOffsetPos[1] = tmp[1];
+        carrierOffsetPos[2] = tmp[2];
+        dGeomGetOffsetQuaternion(nGeom, carrierOffsetRot);
+
+        // the own mass in the frame of the carrier body
+        dMass m, cm;
+        dMatrix3 relR;
+        dVector3 d, relP;
+        const dReal *bp = dBodyGetPosition(nBody);
+        const dReal *cp = dBodyGetPosition(c->nBody);
+        const dReal *cR = dBodyGetRotation(c->nBody);
+        dBodyGetMass(nBody, &m);
+        dMULTIPLY1_333(relR, cR, dBodyGetRotation(nBody));
+        d[0] = bp[0]-cp[0];
+        d[1] = bp[1]-cp[1];
+        d[2] = bp[2]-cp[2];
+        dMULTIPLY1_331(relP, cR, d);
+        dMassRotate(&m, relR);
+        dMassTranslate(&m, relP[0], relP[1], relP[2]);
+        if(c->carriedNodes.empty()) dBodyGetMass(c->nBody, &c->carrierMass);
+        c->carriedNodes.push_back(this);
+        dBodyGetMass(c->nBody, &cm);
+        dMassAdd(&cm, &m);
+        dMassTranslate(&cm, -cm.c[0], -cm.c[1], -cm.c[2]);
+        dBodySetMass(c->nBody, &cm);
+
+        dGeomSetBody(nGeom, c->nBody);
+        dGeomSetOffsetWorldPosition(nGeom, pos[0], pos[1], pos[2]);
+        dGeomSetOffsetWorldQuaternion(nGeom, rot);
+        dBodyDisable(nBody);
+        carrierNode = c;
+      }
+      else if(carrierNode) {
+        releaseCarrier();
+      }
+      return true;
+    }
+
+    /**
+     * Puts the own body back at the pose of the geom, see setCarrier().
+     * The iMutex has to be locked by the caller.
+     */
+    void NodePhysics::releaseCarrier() {
+      if(!carrierNode) return;
+      dVector3 pos, vel, avel, d;
+      dQuaternion rot, offsetInv, bodyRot;
+      dMatrix3 R;
+      const dReal *tmp = dGeomGetPosition(nGeom);
+      pos[0] = tmp[0];
+      pos[1] = tmp[1];
+      pos[2] = tmp[2];
+      dGeomGetQuaternion(nGeom, rot);
+      dBodyGetPointVel(carrierNode->nBody, pos[0], pos[1], pos[2], vel);
+      tmp = dBodyGetAngularVel(carrierNode->nBody);
+      avel[0] = tmp[0];
+      avel[1] = tmp[1];
+      avel[2] = tmp[2];
+
+      // setting the own body clears the offset on the carrier
+      dGeomSetBody(nGeom, nBody);
+      offsetInv[0] = carrierOffsetRot[0];
+      offsetInv[1] = -carrierOffsetRot[1];
+      offsetInv[2] = -carrierOffsetRot[2];
+      offsetInv[3] = -carrierOffsetRot[3];
+      dQMultiply0(bodyRot, rot, offsetInv);
+      dQtoR(bodyRot, R);
+      dMULTIPLY0_331(d, R, carrierOffsetPos);
+      dBodySetQuaternion(nBody, bodyRot);
+      dBodySetPosition(nBody, pos[0]-d[0], pos[1]-d[1], pos[2]-d[2]);
+      if(dLENGTHSQUARED(carrierOffsetPos) > 0 || carrierOffsetRot[0] < 1) {
+        dGeomSetOffsetPosition(nGeom, carrierOffsetPos[0],
+                               carrierOffsetPos[1], carrierOffsetPos[2]);
+        dGeomSetOffsetQuaternion(nGeom, carrierOffsetRot);
+      }
+      dBodySetLinearVel(nBody, vel[0], vel[1], vel[2]);
+      dBodySetAngularVel(nBody, avel[0], avel[1], avel[2]);
+      dBodySetForce(nBody, 0, 0, 0);
+      dBodySetTorque(nBody, 0, 0, 0);
+      if(dGeomIsEnabled(nGeom)) dBodyEnable(nBody);
+
+      std::vector<NodePhysics*> &carried = carrierNode->carriedNodes;
+      carried.erase(std::find(carried.begin(), carried.end(), this));
+      if(carried.empty()) {
+        dBodySetMass(carrierNode->nBody, &carrierNode->carrierMass);
+      }
+      carrierNode = 0;
+    }
+
+    /**
+     * Releases the nodes carried by this one before its body is destroyed,
+     * otherwise they would keep a dangling carrierNode. The iMutex has to
+     * be locked by the caller.
+     */
+    void NodePhysics::releaseCarriedNodes() {
+      while(!carriedNodes.empty()) {
+        carriedNodes.back()->releaseCarrier();
+      }
+    }
+
+    /**
+     * \brief Switches the body between dynamic and kinematic
+     *
+     * The body keeps its velocity. The geom is enabled or disabled by
+     * \c collide, a carried node only changes its geom. Kinematic nodes
+     * keep the mode of their configuration.
+     */
+    void NodePhysics::setKinematicBody(bool kinematic, bool collide) {
+      MutexLocker locker(&(theWorld->iMutex));
+      if(nGeom) {
+        if(collide) dGeomEnable(nGeom);
+        else dGeomDisable(nGeom);
+      }
+      if(!nBody || carrierNode || kinematicNode) return;
+      if(kinematic) dBodySetKinematic(nBody);
+      else dBodySetDynamic(nBody);
+    }
+
     void NodePhysics::setInertiaMass(NodeData* node) {
 
       dMassSetZero(&nMass);
@@ -33,9 +33,15 @@
 #endif
 
 #include "WorldPhysics.h"
+#include "MeshSDF.h"
+#include "FluidForces.h"
+#include "KinematicTrajectory.h"
 
 #include <mars/interfaces/sim/NodeInterface.h>
 
+#include <memory>
+#include <set>
+
 #ifndef ODE11
   #define dTriIndex int
 #endif
@@ -43,6 +49,16 @@
 namespace mars {
   namespace sim {
 
+    /*
+     * The feedback of one contact joint of a geom. \c side selects the
+     * force acting on the geom: 1 for f1, 2 for f2 and -1 for -f1 if the
+     * geom has no body, ode only writes f1 in that case.
+     */
+    struct contact_feedback {
+      dJointFeedback *fb;
+      int side;
+    };
+
     /*
      * we need a data structure to handle different collision parameter
      * and we need to save the collision_data somewhere
@@ -54,6 +70,7 @@ namespace mars {
         ray_sensor = 0;
         sense_contact_force = 1;
         value = 0;
+        contact_material = -1;
         c_params.setZero();
       }
 
@@ -65,8 +82,12 @@ namespace mars {
       std::vector<utils::Vector> contact_points;
       std::list<unsigned long> contact_ids;
       std::vector<dJointFeedback*> ground_feedbacks;
+      // aligned with contact_points, fb is 0 if no force is sensed
+      std::vector<contact_feedback> contact_feedbacks;
       bool node1;
       interfaces::contact_params c_params;
+      // index into the contact material table, -1 if not used
+      int contact_material;
       bool ray_sensor;
       bool sense_contact_force;
       interfaces::sReal value;
@@ -115,13 +136,17 @@ namespace mars {
       virtual void addTorque(const utils::Vector &t);
       virtual bool getGroundContact(void) const;
       virtual void getContactPoints(std::vector<utils::Vector> *contact_points) const;
+      virtual void getContactForces(std::vector<utils::Vector> *contact_points,
+                                    std::vector<utils::Vector> *forces) const;
       virtual void getContactIDs(std::list<interfaces::NodeId> *ids) const;
       virtual interfaces::sReal getGroundContactForce(void) const;
       virtual void setContactParams(interfaces::contact_params &c_params);
       virtual void addSensor(interfaces::BaseSensor *sensor);
       virtual void removeSensor(interfaces::BaseSensor *sensor);
+      virtual void setSensorActive(interfaces::BaseSensor *sensor, bool active);
       virtual void handleSensorData(bool physics_thread = true);
       virtual void destroyNode(void);
+      virtual void setActive(bool active);
       virtual void getMass(interfaces::sReal *mass, interfaces::sReal *inertia=0) const;
       virtual const utils::Vector getContactForce(void) const;
       virtual interfaces::sReal getCollisionDepth(void) const;
@@ -133,6 +158,36 @@ namespace mars {
       void addMassToCompositeBody(dBodyID theBody, dMass *bodyMass);
       void getAbsMass(dMass *pMass) const;
       dReal heightCallback(int x, int y);
+      /**
+       * \brief Adds the fluid forces of the node to its body. Called by
+       * WorldPhysics for all fluid nodes before the step, the iMutex has
+       * to be locked by the caller.
+       */
+      void handleFluid(const FluidDescription &fluid, const dReal *gravity,
+                       dReal stepSize);
+      /**
+       * \brief Adds the added mass of the node to the sum of its body,
+       * the nodes of a composite body share one entry. The iMutex has to
+       * be locked by the caller.
+       */
+      void collectAddedMass(std::map<dBodyID, FluidAddedMass> *added);
+      /**
+       * \brief Adds the time of impact contacts of a continuous collision
+       * node. Called by WorldPhysics after the discrete collision, the
+       * iMutex has to be locked by the caller.
+       */
+      void handleCCD(dReal stepSize);
+      /**
+       * \brief Sets the velocities of a kinematic node that move it to the
+       * pose of its trajectory at the end of the step. Called by
+       * WorldPhysics before the step, the iMutex has to be locked by the
+       * caller.
+       */
+      void handleKinematic(dReal stepSize);
+      virtual void setKinematicTarget(const utils::Vector &pos,
+                                      const utils::Quaternion &rot);
+      virtual bool setCarrier(interfaces::NodeInterface *carrier);
+      virtual void setKinematicBody(bool kinematic, bool collide);
 
     protected:
       WorldPhysics *theWorld;
@@ -142,11 +197,32 @@ namespace mars {
       dVector3 *myVertices;
       dTriIndex *myIndices;
       dTriMeshDataID myTriMeshData;
+      std::shared_ptr<MeshSDF> meshSDF;
       bool composite;
+      bool fluidNode;
+      FluidNodeParams fluidParams;
+      bool ccdNode;
+      dReal ccdRadius, ccdThreshold;
+      bool kinematicNode, kinematicTargetSet;
+      KinematicTrajectory kinematicTrajectory;
+      double kinematicTime;
+      utils::Vector kinematicTargetPos;
+      utils::Quaternion kinematicTargetRot;
+      // the node whose body carries the geom and the original geom offset
+      NodePhysics *carrierNode;
+      dVector3 carrierOffsetPos;
+      dQuaternion carrierOffsetRot;
+      // the carried nodes and the own mass before carrying them
+      std::vector<NodePhysics*> carriedNodes;
+      dMass carrierMass;
       geom_data node_data;
       interfaces::terrainStruct *terrain;
       dReal *height_data;
       std::vector<sensor_list_element> sensor_list;
+      std::set<interfaces::BaseSensor*> inactiveSensors;
+      void setupFluid(interfaces::NodeData *node);
+      void setupCCD(interfaces::NodeData *node);
+      void setupKinematic(interfaces::NodeData *node);
       bool createMesh(interfaces::NodeData *node);
       bool createBox(interfaces::NodeData *node);
       bool createSphere(interfaces::NodeData *node);
@@ -156,6 +232,8 @@ namespace mars {
       bool createHeightfield(interfaces::NodeData *node);
       void setProperties(interfaces::NodeData *node);
       void setInertiaMass(interfaces::NodeData *node);
+      void releaseCarrier();
+      void releaseCarriedNodes();
     };
 
   } // end of namespace sim
@@ -38,6 +38,9 @@
 
 #include "WorldPhysics.h"
 #include "NodePhysics.h"
+#include "JointPhysics.h"
+#include "Articulation.h"
+#include "CablePhysics.h"
 
 
 #include <mars/utils/MutexLocker.h>
@@ -46,6 +49,10 @@
 #include <mars/interfaces/sim/SimulatorInterface.h>
 #include <mars/interfaces/Logging.hpp>
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
 #define EPSILON 1e-10
 
 namespace mars {
@@ -53,6 +60,7 @@ namespace mars {
 
     using namespace utils;
     using namespace interfaces;
+    using namespace configmaps;
 
     PhysicsError WorldPhysics::error = PHYSICS_NO_ERROR;
 
@@ -102,6 +110,18 @@ namespace mars {
       num_contacts = 0;
       create_contacts = 1;
       log_contacts = 0;
+      contactTableSize = 0;
+      contactTableDirty = false;
+      articulationsDirty = false;
+      ccdGeom = 0;
+      // the defaults reproduce the combination of the per node parameters
+      contactRules[CONTACT_GROUP_FRICTION] = CONTACT_COMBINE_AVERAGE;
+      contactRules[CONTACT_GROUP_ERP] = CONTACT_COMBINE_AVERAGE;
+      contactRules[CONTACT_GROUP_CFM] = CONTACT_COMBINE_AVERAGE;
+      contactRules[CONTACT_GROUP_BOUNCE] = CONTACT_COMBINE_SUM;
+      contactRules[CONTACT_GROUP_BOUNCE_VEL] = CONTACT_COMBINE_MAX;
+      contactRules[CONTACT_GROUP_ROLLING] = CONTACT_COMBINE_SUM;
+      contactRules[CONTACT_GROUP_SLIP] = CONTACT_COMBINE_SUM;
 
       // the step size in seconds
       step_size = 0.01;
@@ -192,6 +212,7 @@ namespace mars {
       MutexLocker locker(&iMutex);
       if(world_init) {
         //LOG_DEBUG("free physics world");
+        clearArticulations();
         dJointGroupDestroy(contactgroup);
         dSpaceDestroy(space);
         dWorldDestroy(world);
@@ -255,6 +276,7 @@ namespace mars {
           data->num_ground_collisions = 0;
           data->contact_ids.clear();
           data->contact_points.clear();
+          data->contact_feedbacks.clear();
           data->ground_feedbacks.clear();
         }
         for(iter = contact_feedback_list.begin();
@@ -268,16 +290,74 @@ namespace mars {
         /// first check for collisions
         num_contacts = log_contacts = 0;
         create_contacts = 1;
+        if(contactTableDirty) buildContactTable();
         dSpaceCollide(space,this, &WorldPhysics::callbackForward);
+        // the fast ccd nodes add contacts for the geoms they would pass
+        // through during the step
+        for(size_t k=0; k<ccdNodes.size(); ++k) {
+          ccdNodes[k]->handleCCD(step_size);
+        }
 
         drawLock.lock();
         draw_extern.swap(draw_intern);
         drawLock.unlock();
 
+        // fluid forces of all fluid nodes in one pass before the step, the
+        // added mass scales the forces that were accumulated on the bodies
+        if(!fluidNodes.empty()) {
+          const dReal gravity[3] = {world_gravity.x(), world_gravity.y(),
+                                    world_gravity.z()};
+          for(size_t k=0; k<fluidNodes.size(); ++k) {
+            fluidNodes[k]->handleFluid(fluid, gravity, step_size);
+          }
+          // the nodes of a composite body add up to one added mass
+          std::map<dBodyID, FluidAddedMass> addedMass;
+          for(size_t k=0; k<fluidNodes.size(); ++k) {
+            fluidNodes[k]->collectAddedMass(&addedMass);
+          }
+          std::map<dBodyID, FluidAddedMass>::iterator it;
+          for(it=addedMass.begin(); it!=addedMass.end(); ++it) {
+            applyAddedMass(it->second, it->first, gravity);
+          }
+        }
+
+        // the taut cables add their end rows to the contact group
+        if(!cables.empty()) {
+          const dReal gravity[3] = {world_gravity.x(), world_gravity.y(),
+                                    world_gravity.z()};
+          std::vector<draw_item> cableDraw;
+          for(size_t k=0; k<cables.size(); ++k) {
+            cables[k]->step(step_size, gravity, fluid);
+            addCableDrawItems(cables[k], &cableDraw);
+          }
+          drawLock.lock();
+          cable_draw.swap(cableDraw);
+          drawLock.unlock();
+        }
+
+        // the kinematic nodes get the velocities that take them to their
+        // next pose, ode integrates them without solving for them
+        for(size_t k=0; k<kinematicNodes.size(); ++k) {
+          kinematicNodes[k]->handleKinematic(step_size);
+        }
+
+        if(articulationsDirty) {
+          clearArticulations();
+          Articulation::build(articulatedJoints, &articulations);
+          articulationsDirty = false;
+        }
+        for(size_t k=0; k<articulations.size(); ++k) {
+          articulations[k]->beginStep(step_size);
+        }
+
         /// then calculate the next state for a time of step_size seconds
         try {
           if(fast_step) dWorldQuickStep(world, step_size);
           else dWorldStep(world, step_size);
+          // the articulated trees replace the free motion of their links
+          for(size_t k=0; k<articulations.size(); ++k) {
+            articulations[k]->endStep(step_size);
+          }
         } catch (...) {
           control->sim->handleError(PHYSICS_UNKNOWN);
         }
@@ -288,6 +368,254 @@ namespace mars {
       }
     }
 
+    void WorldPhysics::addArticulatedJoint(JointPhysics *joint) {
+      articulatedJoints.push_back(joint);
+      articulationsDirty = true;
+    }
+
+    void WorldPhysics::removeArticulatedJoint(JointPhysics *joint) {
+      std::vector<JointPhysics*>::iterator it;
+      it = std::find(articulatedJoints.begin(), articulatedJoints.end(), joint);
+      if(it == articulatedJoints.end()) return;
+      articulatedJoints.erase(it);
+      // the articulations must not access the joint anymore
+      clearArticulations();
+      articulationsDirty = true;
+    }
+
+    void WorldPhysics::addFluidNode(NodePhysics *node) {
+      fluidNodes.push_back(node);
+    }
+
+    void WorldPhysics::removeFluidNode(NodePhysics *node) {
+      std::vector<NodePhysics*>::iterator it;
+      it = std::find(fluidNodes.begin(), fluidNodes.end(), node);
+      if(it != fluidNodes.end()) fluidNodes.erase(it);
+    }
+
+    void WorldPhysics::addCCDNode(NodePhysics *node) {
+      ccdNodes.push_back(node);
+    }
+
+    void WorldPhysics::removeCCDNode(NodePhysics *node) {
+      std::vector<NodePhysics*>::iterator it;
+      it = std::find(ccdNodes.begin(), ccdNodes.end(), node);
+      if(it != ccdNodes.end()) ccdNodes.erase(it);
+    }
+
+    void WorldPhysics::addCable(CablePhysics *cable) {
+      cables.push_back(cable);
+    }
+
+    void WorldPhysics::removeCable(CablePhysics *cable) {
+      std::vector<CablePhysics*>::iterator it;
+      it = std::find(cables.begin(), cables.end(), cable);
+      if(it != cables.end()) cables.erase(it);
+      if(cables.empty()) {
+        MutexLocker locker(&drawLock);
+        cable_draw.clear();
+      }
+    }
+
+    void WorldPhysics::addCableDrawItems(CablePhysics *cable,
+                                         std::vector<draw_item> *items) {
+      draw_item item;
+      item.id = 0;
+      item.type = DRAW_LINE;
+      item.draw_state = DRAW_STATE_CREATE;
+      item.point_size = 2;
+      item.myColor.r = 0.9;
+      item.myColor.g = 0.7;
+      item.myColor.b = 0.1;
+      item.myColor.a = 1;
+      item.label = "";
+      item.t_width = item.t_height = 0;
+      item.texture = "";
+      item.get_light = 0;
+      const std::vector<Vector> &points = cable->getPointsIntern();
+      for(size_t i=1; i<points.size(); ++i) {
+        item.start = points[i-1];
+        item.end = points[i];
+        items->push_back(item);
+      }
+    }
+
+    void WorldPhysics::addKinematicNode(NodePhysics *node) {
+      kinematicNodes.push_back(node);
+    }
+
+    void WorldPhysics::removeKinematicNode(NodePhysics *node) {
+      std::vector<NodePhysics*>::iterator it;
+      it = std::find(kinematicNodes.begin(), kinematicNodes.end(), node);
+      if(it != kinematicNodes.end()) kinematicNodes.erase(it);
+    }
+
+    /**
+     * \brief Continuous collision detection by a sampled sweep.
+     *
+     * The body is moved along its linear velocity of the step in samples
+     * of at most the given radius, thus no geom thicker than zero can lie
+     * between two samples. The first sample that touches a new geom is
+     * refined by bisection to the time of impact. The contacts found at
+     * that pose get zero depth and a normal motion that lets the body
+     * approach the surface by the remaining gap within the step, so the
+     * body ends the step at the surface instead of passing it. The contact
+     * points are moved back to the start pose of the body and registered
+     * like the discrete contacts for the sensors. Geoms that already touch
+     * the body are left to the discrete contacts. The orientation is kept
+     * during the sweep.
+     */
+    void WorldPhysics::sweepGeom(dGeomID geom, dReal radius, dReal threshold,
+                                 dReal stepSize) {
+      // bounds the cost for extreme velocities
+      const int maxSamples = 256;
+      const int bisections = 8;
+      dBodyID body = dGeomGetBody(geom);
+      if(!body || !dBodyIsEnabled(body) || radius <= 0) return;
+
+      const dReal *vel = dBodyGetLinearVel(body);
+      dVector3 d = {vel[0]*stepSize, vel[1]*stepSize, vel[2]*stepSize};
+      dReal length = dSqrt(dDOT(d, d));
+      if(length <= threshold) return;
+
+      const dReal *pos = dBodyGetPosition(body);
+      const dVector3 start = {pos[0], pos[1], pos[2]};
+      std::vector<dGeomID> touching, hits;
+      collectTouchingGeoms(geom, &touching);
+      std::sort(touching.begin(), touching.end());
+
+      int samples = (int)ceil(length/radius);
+      if(samples > maxSamples) samples = maxSamples;
+      dReal lo = 0, hi = 0;
+      for(int k=1; k<=samples && hits.empty(); ++k) {
+        hi = (dReal)k/samples;
+        dBodySetPosition(body, start[0]+hi*d[0], start[1]+hi*d[1],
+                         start[2]+hi*d[2]);
+        collectTouchingGeoms(geom, &hits);
+        for(size_t i=0; i<hits.size();) {
+          if(std::binary_search(touching.begin(), touching.end(), hits[i])) {
+            hits[i] = hits.back();
+            hits.pop_back();
+          }
+          else ++i;
+        }
+        if(hits.empty()) lo = hi;
+      }
+      if(hits.empty()) {
+        dBodySetPosition(body, start[0], start[1], start[2]);
+        return;
+      }
+
+      // the time of impact is between lo (free) and hi (touching)
+      dContactGeom probe;
+      for(int i=0; i<bisections; ++i) {
+        dReal mid = 0.5*(lo+hi);
+        dBodySetPosition(body, start[0]+mid*d[0], start[1]+mid*d[1],
+                         start[2]+mid*d[2]);
+        bool hit = false;
+        for(size_t k=0; k<hits.size() && !hit; ++k) {
+          hit = dCollide(geom, hits[k], 1|CONTACTS_UNIMPORTANT, &probe,
+                         sizeof(dContactGeom)) > 0;
+        }
+        if(hit) hi = mid;
+        else lo = mid;
+      }
+
+      dBodySetPosition(body, start[0]+hi*d[0], start[1]+hi*d[1],
+                       start[2]+hi*d[2]);
+      geom_data *gd1 = (geom_data*)dGeomGetData(geom);
+      for(size_t k=0; k<hits.size(); ++k) {
+        geom_data *gd2 = (geom_data*)dGeomGetData(hits[k]);
+        int maxNumContacts = std::min(gd1->c_params.max_num_contacts,
+                                      gd2->c_params.max_num_contacts);
+        if(maxNumContacts < 1) continue;
+        dContact *contact = new dContact[maxNumContacts];
+        int numc = dCollide(geom, hits[k], maxNumContacts,
+                            &contact[0].geom, sizeof(dContact));
+        dSurfaceParameters surface;
+        initContactSurface(gd1, gd2, &surface);
+        for(int i=0; i<numc; ++i) {
+          // the normal points from the other geom to the swept one
+          dReal gap = -lo*dDOT(d, contact[i].geom.normal);
+          if(gap <= 0) continue;
+          contact[i].surface = surface;
+          contact[i].surface.mode |= dContactMotionN;
+          contact[i].surface.motionN = -gap/stepSize;
+          contact[i].geom.depth = 0;
+          // ode takes the lever arm from the body position, which is
+          // reset to the start of the sweep before the step, thus the
+          // point is moved back with the body (for a dynamic other body
+          // the lever arm is off by this offset instead)
+          contact[i].geom.pos[0] -= hi*d[0];
+          contact[i].geom.pos[1] -= hi*d[1];
+          contact[i].geom.pos[2] -= hi*d[2];
+          dJointID c = dJointCreateContact(world, contactgroup, contact+i);
+          dJointAttach(c, body, dGeomGetBody(hits[k]));
+          // the contact sensors and force feedbacks see these contacts too
+          registerContact(c, geom, hits[k], contact[i].geom, numc);
+          num_contacts++;
+        }
+        delete[] contact;
+      }
+      dBodySetPosition(body, start[0], start[1], start[2]);
+    }
+
+    void WorldPhysics::collectTouchingGeoms(dGeomID geom,
+                                            std::vector<dGeomID> *hits) {
+      ccdGeom = geom;
+      ccdHits.clear();
+      dSpaceCollide2(geom, (dGeomID)space, this,
+                     &WorldPhysics::ccdCallbackForward);
+      hits->swap(ccdHits);
+      ccdGeom = 0;
+    }
+
+    void WorldPhysics::ccdCallbackForward(void *data, dGeomID o1,
+                                          dGeomID o2) {
+      WorldPhysics *wp = (WorldPhysics*)data;
+      if(dGeomIsSpace(o1) || dGeomIsSpace(o2)) {
+        dSpaceCollide2(o1, o2, data, &WorldPhysics::ccdCallbackForward);
+        return;
+      }
+      dGeomID other = (o1 == wp->ccdGeom) ? o2 : o1;
+      if(other == wp->ccdGeom || !wp->canCollide(wp->ccdGeom, other)) return;
+      dContactGeom contact;
+      if(dCollide(wp->ccdGeom, other, 1|CONTACTS_UNIMPORTANT, &contact,
+                  sizeof(dContactGeom))) {
+        wp->ccdHits.push_back(other);
+      }
+    }
+
+    /**
+     * \brief The collision filter of nearCallback for geoms that get
+     * contact joints.
+     */
+    bool WorldPhysics::canCollide(dGeomID o1, dGeomID o2) const {
+      if(!(dGeomGetCategoryBits(o1) & dGeomGetCollideBits(o2)) ||
+         !(dGeomGetCategoryBits(o2) & dGeomGetCollideBits(o1))) {
+        return false;
+      }
+      geom_data *gd1 = (geom_data*)dGeomGetData(o1);
+      geom_data *gd2 = (geom_data*)dGeomGetData(o2);
+      if(!gd1 || !gd2 || gd1->ray_sensor || gd2->ray_sensor) return false;
+      dBodyID b1 = dGeomGetBody(o1);
+      dBodyID b2 = dGeomGetBody(o2);
+      if(!b1 && !b2) return false;
+      if(b1 == b2) return false;
+      if(isExcluded(gd1, gd2)) return false;
+      if(b1 && b2 && dAreConnectedExcluding(b1, b2, dJointTypeContact)) {
+        return false;
+      }
+      return true;
+    }
+
+    void WorldPhysics::clearArticulations() {
+      for(size_t i=0; i<articulations.size(); ++i) {
+        delete articulations[i];
+      }
+      articulations.clear();
+    }
+
     /**
      * \brief Returns the ode ID of the world object.
      *
@@ -314,6 +642,19 @@ namespace mars {
       return space;
     }
 
+    /**
+     * \brief Returns the joint group of the contacts of the current step.
+     *
+     * pre:
+     *     - none
+     *
+     * post:
+     *     - contact group ID returned
+     */
+    dJointGroupID WorldPhysics::getContactGroup(void) const {
+      return contactgroup;
+    }
+
     /**
      * \brief Sets the body pointer param to the body for the comp_group_id
      *
@@ -393,6 +734,9 @@ namespace mars {
             return;
           }
           else {
+            for(size_t k=0; k<cables.size(); ++k) {
+              cables[k]->detachBody(theBody);
+            }
             dBodyDestroy(theBody);
             comp_body_list.erase(iter);
             return;
@@ -401,6 +745,9 @@ namespace mars {
       }
       // if we get here in the code, the body is not in the list and can
       // be removed from the world
+      for(size_t k=0; k<cables.size(); ++k) {
+        cables[k]->detachBody(theBody);
+      }
       dBodyDestroy(theBody);
     }
 
@@ -455,6 +802,13 @@ namespace mars {
       geom_data* geom_data1 = (geom_data*)dGeomGetData(o1);
       geom_data* geom_data2 = (geom_data*)dGeomGetData(o2);
 
+      // ode only requires one of the category/collide combinations to
+      // match, we want both geoms to agree on the collision
+      if(!(dGeomGetCategoryBits(o1) & dGeomGetCollideBits(o2)) ||
+         !(dGeomGetCategoryBits(o2) & dGeomGetCollideBits(o1))) {
+        return;
+      }
+
       // test if we have a ray sensor:
       if(geom_data1->ray_sensor) {
         dContact contact;
@@ -491,11 +845,14 @@ namespace mars {
         return;
       }
 
+      if(!b1 && !b2 && !geom_data1->ray_sensor && !geom_data2->ray_sensor) return;
+
+      // the precomputed exclusion lists are cheaper than walking the joints
+      if(isExcluded(geom_data1, geom_data2)) return;
+
       if(b1 && b2 && dAreConnectedExcluding(b1,b2,dJointTypeContact))
         return;
 
-      if(!b1 && !b2 && !geom_data1->ray_sensor && !geom_data2->ray_sensor) return;
-
       int maxNumContacts = 0;
       if(geom_data1->c_params.max_num_contacts <
          geom_data2->c_params.max_num_contacts) {
@@ -551,46 +908,7 @@ namespace mars {
 
 
 
-      // frist we set the softness values:
-      contact[0].surface.mode = dContactSoftERP | dContactSoftCFM;
-      contact[0].surface.soft_cfm = (geom_data1->c_params.cfm +
-                                     geom_data2->c_params.cfm)/2;
-      contact[0].surface.soft_erp = (geom_data1->c_params.erp +
-                                     geom_data2->c_params.erp)/2;
-      // then check if one of the geoms want to use the pyramid approximation
-      if(geom_data1->c_params.approx_pyramid ||
-         geom_data2->c_params.approx_pyramid)
-        contact[0].surface.mode |= dContactApprox1;
-
-      // Then check the friction for both directions
-      contact[0].surface.mu = (geom_data1->c_params.friction1 +
-                               geom_data2->c_params.friction1)/2;
-      contact[0].surface.mu2 = (geom_data1->c_params.friction2 +
-                                geom_data2->c_params.friction2)/2;
-
-      if(contact[0].surface.mu != contact[0].surface.mu2)
-        contact[0].surface.mode |= dContactMu2;
-
-      if(geom_data1->c_params.rolling_friction > EPSILON ||
-         geom_data2->c_params.rolling_friction > EPSILON) {
-        contact[0].surface.mode |= dContactRolling;
-        contact[0].surface.rho = geom_data1->c_params.rolling_friction + geom_data2->c_params.rolling_friction;
-        // fprintf(stderr, "set rolling friction to: %g\n", contact[0].surface.rho);
-        if(geom_data1->c_params.rolling_friction2 > EPSILON ||
-           geom_data2->c_params.rolling_friction2 > EPSILON) {
-          contact[0].surface.rho2 = geom_data1->c_params.rolling_friction2 + geom_data2->c_params.rolling_friction2;
-        }
-        else {
-          contact[0].surface.rho2 = geom_data1->c_params.rolling_friction + geom_data2->c_params.rolling_friction;
-        }
-        if(geom_data1->c_params.spinning_friction > EPSILON ||
-           geom_data2->c_params.spinning_friction > EPSILON) {
-          contact[0].surface.rhoN = geom_data1->c_params.spinning_friction + geom_data2->c_params.spinning_friction;
-        }
-        else {
-          contact[0].surface.rhoN = 0.0;
-        }
-      }
+      initContactSurface(geom_data1, geom_data2, &contact[0].surface);
 
       // check if we have to calculate friction direction1
       if(geom_data1->c_params.friction_direction1 ||
@@ -652,61 +970,15 @@ namespace mars {
         }
       }
 
-      // then check for fds
-      if(geom_data1->c_params.fds1 || geom_data2->c_params.fds1) {
-        contact[0].surface.mode |= dContactSlip1;
-        contact[0].surface.slip1 = (geom_data1->c_params.fds1 +
-                                    geom_data2->c_params.fds1);
-      }
-      if(geom_data1->c_params.fds2 || geom_data2->c_params.fds2) {
-        contact[0].surface.mode |= dContactSlip2;
-        contact[0].surface.slip2 = (geom_data1->c_params.fds2 +
-                                    geom_data2->c_params.fds2);
-      }
-      if(geom_data1->c_params.bounce || geom_data2->c_params.bounce) {
-        contact[0].surface.mode |= dContactBounce;
-        contact[0].surface.bounce = (geom_data1->c_params.bounce +
-                                     geom_data2->c_params.bounce);
-        if(geom_data1->c_params.bounce_vel > geom_data2->c_params.bounce_vel)
-          contact[0].surface.bounce_vel = geom_data1->c_params.bounce_vel;
-        else
-          contact[0].surface.bounce_vel = geom_data2->c_params.bounce_vel;
-      }
-
       for (i=1;i<maxNumContacts;i++){
         contact[i] = contact[0];
       }
 
       numc=dCollide(o1,o2, maxNumContacts, &contact[0].geom,sizeof(dContact));
       if(numc){
-        dJointFeedback *fb;
-        draw_item item;
-        Vector contact_point;
-
         num_contacts++;
         if(create_contacts) {
-          fb = 0;
-          item.id = 0;
-          item.type = DRAW_LINE;
-          item.draw_state = DRAW_STATE_CREATE;
-          item.point_size = 10;
-          item.myColor.r = 1;
-          item.myColor.g = 0;
-          item.myColor.b = 0;
-          item.myColor.a = 1;
-          item.label = "";
-          item.t_width = item.t_height = 0;
-          item.texture = "";
-          item.get_light = 0;
-
           for(i=0;i<numc;i++){
-            item.start.x() = contact[i].geom.pos[0];
-            item.start.y() = contact[i].geom.pos[1];
-            item.start.z() = contact[i].geom.pos[2];
-            item.end.x() = contact[i].geom.pos[0] + contact[i].geom.normal[0];
-            item.end.y() = contact[i].geom.pos[1] + contact[i].geom.normal[1];
-            item.end.z() = contact[i].geom.pos[2] + contact[i].geom.normal[2];
-            draw_intern.push_back(item);
             if(geom_data1->c_params.friction_direction1 ||
                geom_data2->c_params.friction_direction1) {
               v[0] = contact[i].geom.normal[0];
@@ -725,43 +997,186 @@ namespace mars {
             if(contact[0].geom.depth < 0.0) contact[0].geom.depth = 0.0;
             dJointID c=dJointCreateContact(world,contactgroup,contact+i);
             dJointAttach(c,b1,b2);
-
-            geom_data1->num_ground_collisions += numc;
-            geom_data2->num_ground_collisions += numc;
-
-            contact_point.x() = contact[i].geom.pos[0];
-            contact_point.y() = contact[i].geom.pos[1];
-            contact_point.z() = contact[i].geom.pos[2];
-
-            geom_data1->contact_ids.push_back(geom_data2->id);
-            geom_data2->contact_ids.push_back(geom_data1->id);
-            geom_data1->contact_points.push_back(contact_point);
-            geom_data2->contact_points.push_back(contact_point);
-            //if(dGeomGetClass(o1) == dPlaneClass) {
-            fb = 0;
-            if(geom_data2->sense_contact_force) {
-              fb = (dJointFeedback*)malloc(sizeof(dJointFeedback));
-              dJointSetFeedback(c, fb);
-              contact_feedback_list.push_back(fb);
-              geom_data2->ground_feedbacks.push_back(fb);
-              geom_data2->node1 = false;
-            }
-            //else if(dGeomGetClass(o2) == dPlaneClass) {
-            if(geom_data1->sense_contact_force) {
-              if(!fb) {
-                fb = (dJointFeedback*)malloc(sizeof(dJointFeedback));
-                dJointSetFeedback(c, fb);
-                contact_feedback_list.push_back(fb);
-              }
-              geom_data1->ground_feedbacks.push_back(fb);
-              geom_data1->node1 = true;
-            }
+            registerContact(c, o1, o2, contact[i].geom, numc);
           }
         }
       }
       delete[] contact;
     }
 
+    /**
+     * \brief Does the bookkeeping of a contact joint between the geoms o1
+     * and o2 for the debug drawing, the contact sensors and the force
+     * feedback.
+     *
+     * \a numc is the number of contacts of the pair, it is added to the
+     * ground collision counts for each of its contacts.
+     */
+    void WorldPhysics::registerContact(dJointID c, dGeomID o1, dGeomID o2,
+                                       const dContactGeom &contact,
+                                       int numc) {
+      dBodyID b1 = dGeomGetBody(o1);
+      dBodyID b2 = dGeomGetBody(o2);
+      geom_data* geom_data1 = (geom_data*)dGeomGetData(o1);
+      geom_data* geom_data2 = (geom_data*)dGeomGetData(o2);
+      dJointFeedback *fb;
+      draw_item item;
+      Vector contact_point;
+
+      item.id = 0;
+      item.type = DRAW_LINE;
+      item.draw_state = DRAW_STATE_CREATE;
+      item.point_size = 10;
+      item.myColor.r = 1;
+      item.myColor.g = 0;
+      item.myColor.b = 0;
+      item.myColor.a = 1;
+      item.label = "";
+      item.t_width = item.t_height = 0;
+      item.texture = "";
+      item.get_light = 0;
+      item.start.x() = contact.pos[0];
+      item.start.y() = contact.pos[1];
+      item.start.z() = contact.pos[2];
+      item.end.x() = contact.pos[0] + contact.normal[0];
+      item.end.y() = contact.pos[1] + contact.normal[1];
+      item.end.z() = contact.pos[2] + contact.normal[2];
+      draw_intern.push_back(item);
+
+      geom_data1->num_ground_collisions += numc;
+      geom_data2->num_ground_collisions += numc;
+
+      contact_point.x() = contact.pos[0];
+      contact_point.y() = contact.pos[1];
+      contact_point.z() = contact.pos[2];
+
+      geom_data1->contact_ids.push_back(geom_data2->id);
+      geom_data2->contact_ids.push_back(geom_data1->id);
+      geom_data1->contact_points.push_back(contact_point);
+      geom_data2->contact_points.push_back(contact_point);
+      //if(dGeomGetClass(o1) == dPlaneClass) {
+      fb = 0;
+      if(geom_data2->sense_contact_force) {
+        fb = (dJointFeedback*)malloc(sizeof(dJointFeedback));
+        dJointSetFeedback(c, fb);
+        contact_feedback_list.push_back(fb);
+        geom_data2->ground_feedbacks.push_back(fb);
+        geom_data2->node1 = false;
+      }
+      //else if(dGeomGetClass(o2) == dPlaneClass) {
+      if(geom_data1->sense_contact_force) {
+        if(!fb) {
+          fb = (dJointFeedback*)malloc(sizeof(dJointFeedback));
+          dJointSetFeedback(c, fb);
+          contact_feedback_list.push_back(fb);
+        }
+        geom_data1->ground_feedbacks.push_back(fb);
+        geom_data1->node1 = true;
+      }
+      contact_feedback cfb1 = {fb, b1 ? 1 : -1};
+      // ode only writes f2 if both geoms have a body
+      contact_feedback cfb2 = {fb, b1 ? (b2 ? 2 : -1) : 1};
+      geom_data1->contact_feedbacks.push_back(cfb1);
+      geom_data2->contact_feedbacks.push_back(cfb2);
+    }
+
+    /**
+     * \brief Sets the surface parameters of a contact between two geoms,
+     * either from the contact material table or from their contact params.
+     */
+    void WorldPhysics::initContactSurface(const geom_data *gd1,
+                                          const geom_data *gd2,
+                                          dSurfaceParameters *surface) const {
+      const int m1 = gd1->contact_material;
+      const int m2 = gd2->contact_material;
+      if(m1 >= 0 && m2 >= 0 && m1 < contactTableSize && m2 < contactTableSize) {
+        // both geoms use contact materials: take the precomputed surface
+        *surface = contactTable[m1*contactTableSize+m2];
+      }
+      else {
+        // frist we set the softness values:
+        surface->mode = dContactSoftERP | dContactSoftCFM;
+        surface->soft_cfm = (gd1->c_params.cfm +
+                             gd2->c_params.cfm)/2;
+        surface->soft_erp = (gd1->c_params.erp +
+                             gd2->c_params.erp)/2;
+        // then check if one of the geoms want to use the pyramid approximation
+        if(gd1->c_params.approx_pyramid ||
+           gd2->c_params.approx_pyramid)
+          surface->mode |= dContactApprox1;
+
+        // Then check the friction for both directions
+        surface->mu = (gd1->c_params.friction1 +
+                       gd2->c_params.friction1)/2;
+        surface->mu2 = (gd1->c_params.friction2 +
+                        gd2->c_params.friction2)/2;
+
+        if(surface->mu != surface->mu2)
+          surface->mode |= dContactMu2;
+
+        if(gd1->c_params.rolling_friction > EPSILON ||
+           gd2->c_params.rolling_friction > EPSILON) {
+          surface->mode |= dContactRolling;
+          surface->rho = gd1->c_params.rolling_friction + gd2->c_params.rolling_friction;
+          // fprintf(stderr, "set rolling friction to: %g\n", surface->rho);
+          if(gd1->c_params.rolling_friction2 > EPSILON ||
+             gd2->c_params.rolling_friction2 > EPSILON) {
+            surface->rho2 = gd1->c_params.rolling_friction2 + gd2->c_params.rolling_friction2;
+          }
+          else {
+            surface->rho2 = gd1->c_params.rolling_friction + gd2->c_params.rolling_friction;
+          }
+          if(gd1->c_params.spinning_friction > EPSILON ||
+             gd2->c_params.spinning_friction > EPSILON) {
+            surface->rhoN = gd1->c_params.spinning_friction + gd2->c_params.spinning_friction;
+          }
+          else {
+            surface->rhoN = 0.0;
+          }
+        }
+
+        // then check for fds
+        if(gd1->c_params.fds1 || gd2->c_params.fds1) {
+          surface->mode |= dContactSlip1;
+          surface->slip1 = (gd1->c_params.fds1 +
+                            gd2->c_params.fds1);
+        }
+        if(gd1->c_params.fds2 || gd2->c_params.fds2) {
+          surface->mode |= dContactSlip2;
+          surface->slip2 = (gd1->c_params.fds2 +
+                            gd2->c_params.fds2);
+        }
+        if(gd1->c_params.bounce || gd2->c_params.bounce) {
+          surface->mode |= dContactBounce;
+          surface->bounce = (gd1->c_params.bounce +
+                             gd2->c_params.bounce);
+          if(gd1->c_params.bounce_vel > gd2->c_params.bounce_vel)
+            surface->bounce_vel = gd1->c_params.bounce_vel;
+          else
+            surface->bounce_vel = gd2->c_params.bounce_vel;
+        }
+      }
+    }
+
+    /**
+     * \brief Checks the collision exclusion lists of two geoms.
+     *
+     * The lists are kept sorted by NodePhysics::setContactParams, thus
+     * the check is a binary search per non-empty list.
+     */
+    bool WorldPhysics::isExcluded(const geom_data *gd1,
+                                  const geom_data *gd2) const {
+      const std::vector<NodeId> &ex1 = gd1->c_params.coll_exclude;
+      const std::vector<NodeId> &ex2 = gd2->c_params.coll_exclude;
+      if(!ex1.empty() && std::binary_search(ex1.begin(), ex1.end(), gd2->id)) {
+        return true;
+      }
+      if(!ex2.empty() && std::binary_search(ex2.begin(), ex2.end(), gd1->id)) {
+        return true;
+      }
+      return false;
+    }
+
     /**
      * \brief This static function is used to project a normal function
      *   pointer to a method from a class
@@ -855,6 +1270,9 @@ namespace mars {
           drawItems->push_back(*iter);
         }
       }
+      for(iter=cable_draw.begin(); iter!=cable_draw.end(); iter++) {
+        drawItems->push_back(*iter);
+      }
     }
 
     int WorldPhysics::handleCollision(dGeomID theGeom) {
@@ -901,6 +1319,7 @@ namespace mars {
       MutexLocker locker(&iMutex);
       num_contacts = log_contacts = 0;
       create_contacts = 0;
+      if(contactTableDirty) buildContactTable();
       dSpaceCollide(space,this, &WorldPhysics::callbackForward);
       return num_contacts;
     }
@@ -934,5 +1353,239 @@ namespace mars {
       return depth;
     }
 
+
+    static bool contactRuleFromString(const std::string &s,
+                                      ContactCombineRule *rule) {
+      if(s == "average") *rule = CONTACT_COMBINE_AVERAGE;
+      else if(s == "min") *rule = CONTACT_COMBINE_MIN;
+      else if(s == "max") *rule = CONTACT_COMBINE_MAX;
+      else if(s == "multiply") *rule = CONTACT_COMBINE_MULTIPLY;
+      else if(s == "sum") *rule = CONTACT_COMBINE_SUM;
+      else return false;
+      return true;
+    }
+
+    static sReal combineContactValue(ContactCombineRule rule,
+                                     sReal v1, sReal v2) {
+      switch(rule) {
+      case CONTACT_COMBINE_MIN: return v1 < v2 ? v1 : v2;
+      case CONTACT_COMBINE_MAX: return v1 > v2 ? v1 : v2;
+      case CONTACT_COMBINE_MULTIPLY: return v1*v2;
+      case CONTACT_COMBINE_SUM: return v1+v2;
+      default: return (v1+v2)/2;
+      }
+    }
+
+    /**
+     * Overwrites the values of params that are given in the map. The
+     * "friction" key sets both friction directions.
+     */
+    static void contactParamsFromConfig(ConfigMap &map,
+                                        contact_params *params) {
+      if(map.hasKey("friction")) {
+        params->friction1 = params->friction2 = map["friction"];
+      }
+      if(map.hasKey("friction1")) params->friction1 = map["friction1"];
+      if(map.hasKey("friction2")) params->friction2 = map["friction2"];
+      if(map.hasKey("erp")) params->erp = map["erp"];
+      if(map.hasKey("cfm")) params->cfm = map["cfm"];
+      if(map.hasKey("bounce")) params->bounce = map["bounce"];
+      if(map.hasKey("bounce_vel")) params->bounce_vel = map["bounce_vel"];
+      if(map.hasKey("fds1")) params->fds1 = map["fds1"];
+      if(map.hasKey("fds2")) params->fds2 = map["fds2"];
+      if(map.hasKey("rolling_friction")) {
+        params->rolling_friction = map["rolling_friction"];
+      }
+      if(map.hasKey("rolling_friction2")) {
+        params->rolling_friction2 = map["rolling_friction2"];
+      }
+      if(map.hasKey("spinning_friction")) {
+        params->spinning_friction = map["spinning_friction"];
+      }
+      if(map.hasKey("approx_pyramid")) {
+        params->approx_pyramid = map["approx_pyramid"];
+      }
+    }
+
+    /**
+     * \brief Sets up contact materials from a config map:
+     *
+     * \code
+     * combine: {friction: min, bounce: max}
+     * materials:
+     *   rubber: {friction: 1.2, bounce: 0.3, erp: 0.2}
+     *   ice: {friction: 0.05}
+     * pairs:
+     *   - {materials: [rubber, ice], friction: 0.1}
+     * \endcode
+     *
+     * Valid rules are "average", "min", "max", "multiply" and "sum" for
+     * the groups "friction", "erp", "cfm", "bounce", "bounce_vel",
+     * "rolling" and "slip". Materials that already exist are updated, the
+     * table indices of existing materials stay valid. The pair table is
+     * rebuilt before the next collision check.
+     */
+    void WorldPhysics::setContactMaterials(ConfigMap &config) {
+      MutexLocker locker(&iMutex);
+      if(config.hasKey("combine")) {
+        static const char* groupNames[CONTACT_GROUP_COUNT] = {
+          "friction", "erp", "cfm", "bounce", "bounce_vel", "rolling", "slip"};
+        ConfigMap &combine = config["combine"];
+        for(int i=0; i<CONTACT_GROUP_COUNT; ++i) {
+          if(!combine.hasKey(groupNames[i])) continue;
+          std::string rule = (std::string)combine[groupNames[i]];
+          if(!contactRuleFromString(rule, &contactRules[i])) {
+            LOG_ERROR("WorldPhysics: unknown combine rule \"%s\" for \"%s\"",
+                      rule.c_str(), groupNames[i]);
+          }
+        }
+      }
+      if(config.hasKey("materials")) {
+        ConfigMap &materials = config["materials"];
+        for(ConfigMap::iterator it=materials.begin(); it!=materials.end(); ++it) {
+          int index = getContactMaterialIndex(it->first);
+          contact_material &material = contactMaterials[index];
+          material.params = contact_params();
+          contactParamsFromConfig(it->second, &material.params);
+          material.defined = true;
+        }
+      }
+      if(config.hasKey("pairs")) {
+        ConfigVector &pairs = config["pairs"];
+        for(ConfigVector::iterator it=pairs.begin(); it!=pairs.end(); ++it) {
+          ConfigMap &pair = *it;
+          if(!pair.hasKey("materials") || pair["materials"].size() != 2) {
+            LOG_ERROR("WorldPhysics: contact material pair needs a list of two \"materials\"");
+            continue;
+          }
+          int m1 = getContactMaterialIndex((std::string)pair["materials"][0]);
+          int m2 = getContactMaterialIndex((std::string)pair["materials"][1]);
+          if(m1 > m2) std::swap(m1, m2);
+          contactPairOverrides[std::make_pair(m1, m2)] = pair;
+        }
+      }
+      contactTableDirty = true;
+    }
+
+    /**
+     * \brief Sets the fluid that surrounds the nodes with a "fluid" section,
+     * see fluidDescriptionFromConfig().
+     */
+    void WorldPhysics::setFluid(ConfigMap &config) {
+      MutexLocker locker(&iMutex);
+      fluidDescriptionFromConfig(config, &fluid);
+    }
+
+    int WorldPhysics::getContactMaterialIndex(const std::string &name) {
+      std::map<std::string, int>::iterator it = contactMaterialIndex.find(name);
+      if(it != contactMaterialIndex.end()) return it->second;
+      contact_material material;
+      material.name = name;
+      material.defined = false;
+      contactMaterials.push_back(material);
+      int index = (int)contactMaterials.size()-1;
+      contactMaterialIndex[name] = index;
+      contactTableDirty = true;
+      return index;
+    }
+
+    void WorldPhysics::combineContactParams(const contact_params &p1,
+                                            const contact_params &p2,
+                                            contact_params *result) const {
+      const ContactCombineRule *rules = contactRules;
+      result->friction1 = combineContactValue(rules[CONTACT_GROUP_FRICTION],
+                                              p1.friction1, p2.friction1);
+      result->friction2 = combineContactValue(rules[CONTACT_GROUP_FRICTION],
+                                              p1.friction2, p2.friction2);
+      result->erp = combineContactValue(rules[CONTACT_GROUP_ERP], p1.erp, p2.erp);
+      result->cfm = combineContactValue(rules[CONTACT_GROUP_CFM], p1.cfm, p2.cfm);
+      result->bounce = combineContactValue(rules[CONTACT_GROUP_BOUNCE],
+                                           p1.bounce, p2.bounce);
+      result->bounce_vel = combineContactValue(rules[CONTACT_GROUP_BOUNCE_VEL],
+                                               p1.bounce_vel, p2.bounce_vel);
+      result->fds1 = combineContactValue(rules[CONTACT_GROUP_SLIP],
+                                         p1.fds1, p2.fds1);
+      result->fds2 = combineContactValue(rules[CONTACT_GROUP_SLIP],
+                                         p1.fds2, p2.fds2);
+      result->rolling_friction = combineContactValue(rules[CONTACT_GROUP_ROLLING],
+                                                     p1.rolling_friction,
+                                                     p2.rolling_friction);
+      // the second rolling direction falls back to the first one as in
+      // the per node combination
+      if(p1.rolling_friction2 > EPSILON || p2.rolling_friction2 > EPSILON) {
+        result->rolling_friction2 = combineContactValue(rules[CONTACT_GROUP_ROLLING],
+                                                        p1.rolling_friction2,
+                                                        p2.rolling_friction2);
+      }
+      else {
+        result->rolling_friction2 = result->rolling_friction;
+      }
+      result->spinning_friction = combineContactValue(rules[CONTACT_GROUP_ROLLING],
+                                                      p1.spinning_friction,
+                                                      p2.spinning_friction);
+      result->approx_pyramid = p1.approx_pyramid || p2.approx_pyramid;
+    }
+
+    /**
+     * \brief Precomputes the surface parameters of all material pairs.
+     *
+     * The near callback only copies the entry of the table for geoms
+     * that both have a contact material. The iMutex has to be locked.
+     */
+    void WorldPhysics::buildContactTable() {
+      const int n = (int)contactMaterials.size();
+      contactTable.resize(n*n);
+      for(int i=0; i<n; ++i) {
+        if(!contactMaterials[i].defined) {
+          LOG_WARN("WorldPhysics: contact material \"%s\" is not defined, using default parameters",
+                   contactMaterials[i].name.c_str());
+        }
+      }
+      for(int i=0; i<n; ++i) {
+        for(int j=i; j<n; ++j) {
+          contact_params params;
+          combineContactParams(contactMaterials[i].params,
+                               contactMaterials[j].params, &params);
+          std::map<std::pair<int, int>, ConfigMap>::iterator it;
+          it = contactPairOverrides.find(std::make_pair(i, j));
+          if(it != contactPairOverrides.end()) {
+            contactParamsFromConfig(it->second, &params);
+          }
+
+          dSurfaceParameters &surface = contactTable[i*n+j];
+          memset(&surface, 0, sizeof(dSurfaceParameters));
+          surface.mode = dContactSoftERP | dContactSoftCFM;
+          surface.soft_erp = params.erp;
+          surface.soft_cfm = params.cfm;
+          if(params.approx_pyramid) surface.mode |= dContactApprox1;
+          surface.mu = params.friction1;
+          surface.mu2 = params.friction2;
+          if(surface.mu != surface.mu2) surface.mode |= dContactMu2;
+          if(params.rolling_friction > EPSILON) {
+            surface.mode |= dContactRolling;
+            surface.rho = params.rolling_friction;
+            surface.rho2 = params.rolling_friction2;
+            surface.rhoN = params.spinning_friction;
+          }
+          if(params.fds1) {
+            surface.mode |= dContactSlip1;
+            surface.slip1 = params.fds1;
+          }
+          if(params.fds2) {
+            surface.mode |= dContactSlip2;
+            surface.slip2 = params.fds2;
+          }
+          if(params.bounce) {
+            surface.mode |= dContactBounce;
+            surface.bounce = params.bounce;
+            surface.bounce_vel = params.bounce_vel;
+          }
+          contactTable[j*n+i] = surface;
+        }
+      }
+      contactTableSize = n;
+      contactTableDirty = false;
+    }
+
   } // end of namespace sim
 } // end of namespace mars
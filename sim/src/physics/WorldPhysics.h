@@ -42,14 +42,22 @@
 #include <mars/interfaces/sim/PhysicsInterface.h>
 #include <mars/interfaces/graphics/draw_structs.h>
 
+#include <map>
+#include <string>
 #include <vector>
 
 #include <ode/ode.h>
 
+#include "FluidForces.h"
+
 namespace mars {
   namespace sim {
 
     class NodePhysics;
+    class CablePhysics;
+    class JointPhysics;
+    class Articulation;
+    struct geom_data;
 
     /**
      * The struct is used to handle some sensors in the physical
@@ -78,11 +86,44 @@ namespace mars {
       std::vector<NodePhysics*> comp_nodes;
     };
 
+    /**
+     * Rules used to combine the parameters of two contact materials.
+     */
+    enum ContactCombineRule {
+      CONTACT_COMBINE_AVERAGE,
+      CONTACT_COMBINE_MIN,
+      CONTACT_COMBINE_MAX,
+      CONTACT_COMBINE_MULTIPLY,
+      CONTACT_COMBINE_SUM
+    };
+
+    /**
+     * Parameter groups that can get their own combine rule.
+     */
+    enum ContactCombineGroup {
+      CONTACT_GROUP_FRICTION,
+      CONTACT_GROUP_ERP,
+      CONTACT_GROUP_CFM,
+      CONTACT_GROUP_BOUNCE,
+      CONTACT_GROUP_BOUNCE_VEL,
+      CONTACT_GROUP_ROLLING,
+      CONTACT_GROUP_SLIP,
+      CONTACT_GROUP_COUNT
+    };
+
+    struct contact_material {
+      std::string name;
+      interfaces::contact_params params;
+      // false if the material is only referenced by a node so far
+      bool defined;
+    };
+
     /**
      * Declaration of the physical class, that implements the
      * physics interface.
      */
-    class WorldPhysics : public interfaces::PhysicsInterface, interfaces::DrawInterface {
+    class WorldPhysics : public interfaces::PhysicsInterface,
+                         public interfaces::DrawInterface {
     public:
       WorldPhysics(interfaces::ControlCenter *control);
       virtual ~WorldPhysics(void);
@@ -94,10 +135,14 @@ namespace mars {
       virtual void update(std::vector<interfaces::draw_item> *drawItems);
       virtual int checkCollisions(void);
       virtual interfaces::sReal getVectorCollision(const utils::Vector &pos, const utils::Vector &ray) const;
+      virtual void setContactMaterials(configmaps::ConfigMap &config);
+      virtual void setFluid(configmaps::ConfigMap &config);
 
       // this functions are used by the other physical classes
       dWorldID getWorld(void) const;
       dSpaceID getSpace(void) const;
+      //! The joints of the group are destroyed before the next step.
+      dJointGroupID getContactGroup(void) const;
       bool getCompositeBody(int comp_group, dBodyID *body, NodePhysics *node);
       void destroyBody(dBodyID theBody, NodePhysics *node);
       dReal getWorldStep(void);
@@ -105,6 +150,50 @@ namespace mars {
       void moveCompositeMassCenter(dBodyID theBody, dReal x, dReal y, dReal z);
       int handleCollision(dGeomID theGeom);
       interfaces::sReal getCollisionDepth(dGeomID theGeom);
+      /**
+       * \brief Returns the table index of the named contact material. An
+       * unknown name is added as placeholder with default parameters, thus
+       * the materials can be defined after the nodes are created.
+       * The iMutex has to be locked by the caller.
+       */
+      int getContactMaterialIndex(const std::string &name);
+      /**
+       * \brief Adds a joint that is integrated in joint space together with
+       * the other articulated joints of its tree, see Articulation.
+       * The iMutex has to be locked by the caller.
+       */
+      void addArticulatedJoint(JointPhysics *joint);
+      //! The iMutex has to be locked by the caller.
+      void removeArticulatedJoint(JointPhysics *joint);
+      //! rebuilds the articulations before the next step
+      void setArticulationsDirty() {articulationsDirty = true;}
+      //! The iMutex has to be locked by the caller.
+      void addFluidNode(NodePhysics *node);
+      //! The iMutex has to be locked by the caller.
+      void removeFluidNode(NodePhysics *node);
+      //! The iMutex has to be locked by the caller.
+      void addCCDNode(NodePhysics *node);
+      //! The iMutex has to be locked by the caller.
+      void removeCCDNode(NodePhysics *node);
+      //! The iMutex has to be locked by the caller.
+      void addKinematicNode(NodePhysics *node);
+      //! The iMutex has to be locked by the caller.
+      void removeKinematicNode(NodePhysics *node);
+      //! The iMutex has to be locked by the caller.
+      void addCable(CablePhysics *cable);
+      //! The iMutex has to be locked by the caller.
+      void removeCable(CablePhysics *cable);
+      /**
+       * \brief Sweeps the geom along the motion of its body in the next
+       * step and adds time of impact contacts for the geoms it would hit.
+       * The iMutex has to be locked by the caller.
+       *
+       * \param radius The distance between two sweep samples, has to be
+       *        smaller than the inner radius of the geom.
+       * \param threshold The sweep is skipped if the body moves less.
+       */
+      void sweepGeom(dGeomID geom, dReal radius, dReal threshold,
+                     dReal stepSize);
       mutable utils::Mutex iMutex;
 
       static interfaces::PhysicsError error;
@@ -127,8 +216,50 @@ namespace mars {
       bool create_contacts, log_contacts;
       int num_contacts;
       int ray_collision;
+
+      // contact materials and the precomputed pair table, the table has
+      // contactTableSize x contactTableSize entries
+      std::vector<contact_material> contactMaterials;
+      std::map<std::string, int> contactMaterialIndex;
+      std::map<std::pair<int, int>, configmaps::ConfigMap> contactPairOverrides;
+      ContactCombineRule contactRules[CONTACT_GROUP_COUNT];
+      std::vector<dSurfaceParameters> contactTable;
+      int contactTableSize;
+      bool contactTableDirty;
+      void buildContactTable();
+
+      std::vector<JointPhysics*> articulatedJoints;
+      std::vector<Articulation*> articulations;
+      bool articulationsDirty;
+      void clearArticulations();
+
+      FluidDescription fluid;
+      std::vector<NodePhysics*> fluidNodes;
+
+      std::vector<NodePhysics*> ccdNodes;
+      std::vector<NodePhysics*> kinematicNodes;
+      std::vector<CablePhysics*> cables;
+      std::vector<interfaces::draw_item> cable_draw;
+      void addCableDrawItems(CablePhysics *cable,
+                             std::vector<interfaces::draw_item> *items);
+      // the swept geom and the geoms it touches during a sweep
+      dGeomID ccdGeom;
+      std::vector<dGeomID> ccdHits;
+      void collectTouchingGeoms(dGeomID geom, std::vector<dGeomID> *hits);
+      bool canCollide(dGeomID o1, dGeomID o2) const;
+      static void ccdCallbackForward(void *data, dGeomID o1, dGeomID o2);
+
+      void initContactSurface(const geom_data *gd1, const geom_data *gd2,
+                              dSurfaceParameters *surface) const;
+      void combineContactParams(const interfaces::contact_params &p1,
+                                const interfaces::contact_params &p2,
+                                interfaces::contact_params *result) const;
+
       // this functions are for the collision implementation
       void nearCallback (dGeomID o1, dGeomID o2);
+      void registerContact(dJointID c, dGeomID o1, dGeomID o2,
+                           const dContactGeom &contact, int numc);
+      bool isExcluded(const geom_data *gd1, const geom_data *gd2) const;
       static void callbackForward(void *data, dGeomID o1, dGeomID o2);
     };
 
@@ -25,6 +25,7 @@
 #include <mars/utils/Vector.h>
 #include <mars/utils/Quaternion.h>
 #include <mars/utils/Geometry.hpp>
+#include <mars/utils/misc.h>
 #include <mars/interfaces/sim/LoadCenter.h>
 #include <mars/interfaces/sim/NodeManagerInterface.h>
 #include <mars/interfaces/sim/EntityManagerInterface.h>
@@ -45,6 +46,63 @@ namespace mars {
     using namespace utils;
     using namespace interfaces;
 
+    /**
+     * Reads a lens calibration in the camera_info format of ROS/OpenCV.
+     * The keys are either given in the sensor config or in the yaml file
+     * referenced by "calibration_file". A relative file name is resolved
+     * against the "filePrefix" the loaders set to the scene path.
+     */
+    static bool getDistortion(ConfigMap map,
+                              interfaces::cameraDistortionStruct *distortion) {
+      if(map.hasKey("calibration_file")) {
+        std::string file = map["calibration_file"];
+        if(map.hasKey("filePrefix")) {
+          handleFilenamePrefix(&file, (std::string)map["filePrefix"]);
+        }
+        if(!utils::pathExists(file)) {
+          LOG_ERROR("CameraSensor: calibration file \"%s\" not found",
+                    file.c_str());
+          return false;
+        }
+        map = ConfigMap::fromYamlFile(file);
+      }
+      if(!map.hasKey("camera_matrix") ||
+         !map.hasKey("distortion_coefficients")) {
+        return false;
+      }
+
+      ConfigItem &k = map["camera_matrix"]["data"];
+      ConfigItem &d = map["distortion_coefficients"]["data"];
+      if(k.size() != 9) {
+        LOG_ERROR("CameraSensor: the camera_matrix needs 9 values");
+        return false;
+      }
+      std::string model = map.get("distortion_model", std::string("plumb_bob"));
+      if(model == "plumb_bob" || model == "rational_polynomial" ||
+         model == "radtan") {
+        distortion->model = interfaces::DISTORTION_BROWN_CONRADY;
+      }
+      else if(model == "equidistant" || model == "fisheye") {
+        distortion->model = interfaces::DISTORTION_FISHEYE;
+      }
+      else {
+        LOG_ERROR("CameraSensor: unknown distortion_model \"%s\"",
+                  model.c_str());
+        return false;
+      }
+      distortion->width = map["image_width"];
+      distortion->height = map["image_height"];
+      distortion->fx = k[0];
+      distortion->cx = k[2];
+      distortion->fy = k[4];
+      distortion->cy = k[5];
+      distortion->coefficients.clear();
+      for(size_t i=0; i<d.size(); ++i) {
+        distortion->coefficients.push_back((double)d[i]);
+      }
+      return true;
+    }
+
     BaseSensor* CameraSensor::instanciate(ControlCenter *control, BaseConfig *config ){
       CameraConfigStruct *cfg = dynamic_cast<CameraConfigStruct*>(config);
       assert(cfg);
@@ -110,7 +168,11 @@ namespace mars {
           control->graphics->addGraphicsUpdateInterface(this);
           gc->setFrustumFromRad(config.opening_width/180.0*M_PI, config.opening_height/180.0*M_PI, 0.5, 100);
           ConfigMap map = config.map;
-          if(map.hasKey("distortion_factor")) {
+          interfaces::cameraDistortionStruct distortion;
+          if(getDistortion(map, &distortion)) {
+            gw->setupDistortion(distortion);
+          }
+          else if(map.hasKey("distortion_factor")) {
             gw->setupDistortion(map["distortion_factor"]);
           }
         }
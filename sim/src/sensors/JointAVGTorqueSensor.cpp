@@ -48,6 +48,7 @@ namespace mars {
       JointArraySensor(control, config) {
 
       torqueIndices[0] = -1;
+      torqueSum = 0.0;
       typeName = "JointAVGTorque";
       if (control->dataBroker) {
         dbPackage.add("id", (long)config.id);
@@ -70,32 +71,20 @@ namespace mars {
       }
     }
 
+    sReal JointAVGTorqueSensor::getAverage() const {
+      if(doubleArray.empty()) return 0.0;
+      return torqueSum / doubleArray.size();
+    }
+
     // this function should be overwritten by the special sensor to
     int JointAVGTorqueSensor::getAsciiData(char* data) const {
-      char *p;
-      sReal torque = 0;
-      std::vector<double>::const_iterator iter;
-
-      p = data;
-      for(iter = doubleArray.begin(); iter != doubleArray.end(); iter++) {
-        torque += *iter;
-      }
-      torque /= doubleArray.size();
-      sprintf(p, " %6.2f", torque);
+      sprintf(data, " %6.2f", getAverage());
       return 7;
-
     }
 
     int JointAVGTorqueSensor::getSensorData(sReal** data) const {
-      std::vector<double>::const_iterator iter;
-
       *data = (sReal*)malloc(sizeof(sReal));
-      **data = 0;
-      for(iter = doubleArray.begin(); iter != doubleArray.end(); iter++) {
-        **data += *iter;
-      }
-      **data /= doubleArray.size();
-
+      **data = getAverage();
       return 1;
     }
 
@@ -105,20 +94,8 @@ namespace mars {
                                            int callbackParam) {
       (void)callbackParam;
       (void)info;
-      sReal torque = 0;
-      std::vector<double>::const_iterator iter;
-
-      if(doubleArray.size() == 0) {
-        dbPackage->set(0, (long)id);
-        dbPackage->set(1, torque);
-        return;
-      }
-      for(iter = doubleArray.begin(); iter != doubleArray.end(); iter++) {
-        torque += *iter;
-      }
-      torque /= doubleArray.size();
       dbPackage->set(0, (long)id);
-      dbPackage->set(1, torque);
+      dbPackage->set(1, getAverage());
     }
 
     void JointAVGTorqueSensor::receiveData(const data_broker::DataInfo &info,
@@ -132,7 +109,9 @@ namespace mars {
       Vector torque;
       for(int i = 0; i < 3; ++i)
         package.get(torqueIndices[i], &torque[i]);
-      doubleArray[callbackParam] = torque.norm();
+      sReal value = torque.norm();
+      torqueSum += value - doubleArray[callbackParam];
+      doubleArray[callbackParam] = value;
       //values[callbackParam].value = torque.length();
       //values[callbackParam].value = torque.norm();
     }
@@ -61,6 +61,9 @@ namespace mars {
 
     private:
       long torqueIndices[3];
+      // sum of doubleArray, updated with every received value
+      interfaces::sReal torqueSum;
+      interfaces::sReal getAverage() const;
       data_broker::DataPackage dbPackage;
     };
 
@@ -0,0 +1,181 @@
+/*
+ *  Copyright 2011, 2012, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "SensorFilter.h"
+
+#include <mars/interfaces/Logging.hpp>
+#include <cmath>
+
+namespace mars {
+  namespace sim {
+
+    using namespace interfaces;
+    using namespace configmaps;
+
+    SensorFilter::SensorFilter() : channels(0) {
+    }
+
+    SensorFilter::~SensorFilter() {
+    }
+
+    bool SensorFilter::fromConfigItem(ConfigItem &config) {
+      stages.clear();
+      std::vector<ConfigItem*> items;
+      if(config.isVector()) {
+        for(ConfigVector::iterator it = config.begin(); it != config.end(); ++it) {
+          items.push_back(&(*it));
+        }
+      }
+      else if(config.isMap()) {
+        items.push_back(&config);
+      }
+      for(size_t i = 0; i < items.size(); ++i) {
+        ConfigMap &map = *(items[i]);
+        std::string type = map.get("type", std::string());
+        Stage stage;
+        stage.window = map.get("window", 10);
+        stage.alpha = map.get("alpha", 0.1);
+        stage.count = 0;
+        if(type == "mean") stage.type = FILTER_MEAN;
+        else if(type == "rms") stage.type = FILTER_RMS;
+        else if(type == "min") stage.type = FILTER_MIN;
+        else if(type == "max") stage.type = FILTER_MAX;
+        else if(type == "lowpass") stage.type = FILTER_LOWPASS;
+        else {
+          LOG_ERROR("SensorFilter: unknown filter type \"%s\"", type.c_str());
+          continue;
+        }
+        if(stage.window < 1) stage.window = 1;
+        if(stage.alpha <= 0.0 || stage.alpha > 1.0) {
+          LOG_WARN("SensorFilter: alpha has to be in (0, 1], using 0.1");
+          stage.alpha = 0.1;
+        }
+        stages.push_back(stage);
+      }
+      channels = 0;
+      output.clear();
+      return !stages.empty();
+    }
+
+    void SensorFilter::reset() {
+      resize(channels);
+    }
+
+    void SensorFilter::resize(int size) {
+      channels = size;
+      output.assign(size, 0.0);
+      for(size_t i = 0; i < stages.size(); ++i) {
+        Stage &stage = stages[i];
+        stage.count = 0;
+        switch(stage.type) {
+        case FILTER_MEAN:
+        case FILTER_RMS:
+          stage.history.assign(size*stage.window, 0.0);
+          stage.sum.assign(size, 0.0);
+          break;
+        case FILTER_MIN:
+        case FILTER_MAX:
+          stage.history.assign(size*stage.window, 0.0);
+          stage.queue.assign(size*stage.window, 0);
+          stage.queueHead.assign(size, 0);
+          stage.queueSize.assign(size, 0);
+          break;
+        case FILTER_LOWPASS:
+          stage.history.assign(size, 0.0);
+          break;
+        }
+      }
+    }
+
+    const std::vector<sReal>& SensorFilter::process(const sReal *data,
+                                                     int size) {
+      if(size != channels) resize(size);
+      for(int c = 0; c < size; ++c) output[c] = data[c];
+      for(size_t i = 0; i < stages.size(); ++i) {
+        processStage(stages[i], output);
+      }
+      return output;
+    }
+
+    void SensorFilter::processStage(Stage &stage, std::vector<sReal> &values) {
+      const int window = stage.window;
+      const int slot = stage.count % window;
+      const unsigned long n = stage.count < (unsigned long)window ? stage.count+1 : window;
+      for(int c = 0; c < channels; ++c) {
+        const sReal x = values[c];
+        sReal *history = &stage.history[0];
+        switch(stage.type) {
+        case FILTER_MEAN:
+        case FILTER_RMS:
+          {
+            sReal v = stage.type == FILTER_RMS ? x*x : x;
+            history += c*window;
+            if(stage.count >= (unsigned long)window) stage.sum[c] -= history[slot];
+            history[slot] = v;
+            stage.sum[c] += v;
+            if(slot == window-1) {
+              // once per window the sum is rebuilt to stop the
+              // rounding errors of the running updates from piling up
+              sReal sum = 0.0;
+              for(int k = 0; k < window; ++k) sum += history[k];
+              stage.sum[c] = sum;
+            }
+            if(stage.type == FILTER_MEAN) {
+              values[c] = stage.sum[c] / n;
+            }
+            else {
+              values[c] = stage.sum[c] > 0.0 ? sqrt(stage.sum[c] / n) : 0.0;
+            }
+            break;
+          }
+        case FILTER_MIN:
+        case FILTER_MAX:
+          {
+            history += c*window;
+            unsigned long *queue = &stage.queue[c*window];
+            int &head = stage.queueHead[c];
+            int &qSize = stage.queueSize[c];
+            history[slot] = x;
+            if(qSize && queue[head] + window <= stage.count) {
+              head = (head+1) % window;
+              --qSize;
+            }
+            while(qSize) {
+              sReal back = history[queue[(head+qSize-1) % window] % window];
+              if(stage.type == FILTER_MIN ? back >= x : back <= x) --qSize;
+              else break;
+            }
+            queue[(head+qSize) % window] = stage.count;
+            ++qSize;
+            values[c] = history[queue[head] % window];
+            break;
+          }
+        case FILTER_LOWPASS:
+          if(stage.count == 0) history[c] = x;
+          else history[c] += stage.alpha * (x - history[c]);
+          values[c] = history[c];
+          break;
+        }
+      }
+      ++stage.count;
+    }
+
+  } // end of namespace sim
+} // end of namespace mars
@@ -0,0 +1,119 @@
+/*
+ *  Copyright 2011, 2012, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * \file SensorFilter.h
+ * \brief Incremental post-processing of sensor outputs (moving mean, RMS,
+ *        min/max and low-pass) declared in the sensor config.
+ */
+
+#ifndef SENSORFILTER_H
+#define SENSORFILTER_H
+
+#ifdef _PRINT_HEADER_
+#warning "SensorFilter.h"
+#endif
+
+#include <mars/interfaces/MARSDefs.h>
+#include <configmaps/ConfigData.h>
+
+#include <vector>
+
+namespace mars {
+  namespace sim {
+
+    /**
+     * A chain of filter stages that is applied to every output channel of
+     * a sensor. The stages are declared in the "filter" entry of the sensor
+     * config, either as one map or as a list of maps that are applied in
+     * the given order:
+     *
+     * \code
+     * filter:
+     *   - {type: lowpass, alpha: 0.2}
+     *   - {type: mean, window: 50}
+     * \endcode
+     *
+     * Supported types are "mean", "rms", "min", "max" (with "window" in
+     * samples, default 10) and "lowpass" (first order, "alpha" in (0, 1],
+     * default 0.1). Every sample costs constant time per channel; the
+     * windows are allocated when the number of channels changes only.
+     */
+    class SensorFilter {
+    public:
+      enum StageType {
+        FILTER_MEAN,
+        FILTER_RMS,
+        FILTER_MIN,
+        FILTER_MAX,
+        FILTER_LOWPASS
+      };
+
+      SensorFilter();
+      ~SensorFilter();
+
+      /**
+       * \brief Reads the stages from the "filter" entry of a sensor config.
+       * \return false if no valid stage was found
+       */
+      bool fromConfigItem(configmaps::ConfigItem &config);
+
+      /**
+       * \brief Adds one sample of all channels and returns the filtered
+       * values.
+       */
+      const std::vector<interfaces::sReal>& process(const interfaces::sReal *data,
+                                                     int size);
+
+      const std::vector<interfaces::sReal>& getOutput() const {
+        return output;
+      }
+
+      void reset();
+
+    private:
+      struct Stage {
+        StageType type;
+        int window;
+        interfaces::sReal alpha;
+        // number of samples added since the last reset
+        unsigned long count;
+        // input history, window values per channel
+        std::vector<interfaces::sReal> history;
+        // running sum (mean) or sum of squares (rms) per channel
+        std::vector<interfaces::sReal> sum;
+        // monotonic queues of sample numbers for min/max, window entries
+        // per channel
+        std::vector<unsigned long> queue;
+        std::vector<int> queueHead, queueSize;
+      };
+
+      std::vector<Stage> stages;
+      std::vector<interfaces::sReal> output;
+      int channels;
+
+      void resize(int size);
+      void processStage(Stage &stage, std::vector<interfaces::sReal> &values);
+    };
+
+  } // end of namespace sim
+} // end of namespace mars
+
+#endif // SENSORFILTER_H
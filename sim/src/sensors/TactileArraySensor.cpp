@@ -0,0 +1,293 @@
+/*
+ *  Copyright 2017, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "TactileArraySensor.h"
+
+#include <mars/data_broker/DataBrokerInterface.h>
+#include <mars/interfaces/sim/NodeManagerInterface.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+namespace mars {
+  namespace sim {
+
+    using namespace utils;
+    using namespace interfaces;
+
+    static void buildKernel(double sigma, std::vector<double> *kernel,
+                            int *radius) {
+      kernel->clear();
+      *radius = 0;
+      if(sigma <= 0.0) return;
+      *radius = (int)ceil(3.0*sigma);
+      double sum = 0.0;
+      for(int k = -*radius; k <= *radius; ++k) {
+        kernel->push_back(exp(-0.5*k*k/(sigma*sigma)));
+        sum += kernel->back();
+      }
+      for(size_t k = 0; k < kernel->size(); ++k) (*kernel)[k] /= sum;
+    }
+
+    BaseSensor* TactileArraySensor::instanciate(ControlCenter *control,
+                                                BaseConfig *config) {
+      TactileArrayConfig *cfg = dynamic_cast<TactileArrayConfig*>(config);
+      assert(cfg);
+      return new TactileArraySensor(control, *cfg);
+    }
+
+    BaseConfig* TactileArraySensor::parseConfig(ControlCenter *control,
+                                                configmaps::ConfigMap *config) {
+      TactileArrayConfig *cfg = new TactileArrayConfig;
+      cfg->parseConfig(control, config);
+      return cfg;
+    }
+
+    TactileArraySensor::TactileArraySensor(ControlCenter *control,
+                                           TactileArrayConfig config) :
+      SensorInterface(control), BaseNodeSensor(config.id, config.name),
+      config(config) {
+
+      updateRate = config.updateRate;
+      attached_node = config.attached_node;
+      if(this->config.cols < 1) this->config.cols = 1;
+      if(this->config.rows < 1) this->config.rows = 1;
+      if(this->config.stepX <= 0.0) this->config.stepX = 0.01;
+      if(this->config.stepY <= 0.0) this->config.stepY = 0.01;
+      const int size = this->config.cols*this->config.rows;
+      pressure.resize(size, 0.0);
+      splat.resize(size, 0.0);
+      blurTmp.resize(size, 0.0);
+      buildKernel(config.blur/this->config.stepX, &kernelX, &radiusX);
+      buildKernel(config.blur/this->config.stepY, &kernelY, &radiusY);
+      minCol = minRow = 0;
+      maxCol = maxRow = -1;
+      totalForce = 0.0;
+      for(int i = 0; i < 3; ++i) positionIndices[i] = -1;
+      for(int i = 0; i < 4; ++i) rotationIndices[i] = -1;
+
+      position = control->nodes->getPosition(attached_node);
+      orientation = control->nodes->getRotation(attached_node);
+
+      std::string groupName, dataName;
+      if(control->dataBroker &&
+         control->nodes->getDataBrokerNames(attached_node, &groupName,
+                                            &dataName)) {
+        control->dataBroker->registerTimedReceiver(this, groupName, dataName,
+                                                   "mars_sim/simTimer",
+                                                   updateRate);
+      }
+
+      data_broker::DataPackage dbPackage;
+      char text[32];
+      dbPackage.add("force", 0.0);
+      for(int r = 0; r < this->config.rows; ++r) {
+        for(int c = 0; c < this->config.cols; ++c) {
+          sprintf(text, "pressure/%d/%d", r, c);
+          dbPackage.add(text, 0.0);
+        }
+      }
+      if(control->dataBroker) {
+        std::string groupName = "mars_sim";
+        std::string dataName = "sensors/"+name;
+        control->dataBroker->pushData(groupName, dataName,
+                                      dbPackage, NULL,
+                                      data_broker::DATA_PACKAGE_READ_FLAG);
+        control->dataBroker->registerTimedProducer(this, groupName, dataName,
+                                                   "mars_sim/simTimer",
+                                                   updateRate);
+      }
+    }
+
+    TactileArraySensor::~TactileArraySensor() {
+      if(control->dataBroker) {
+        control->dataBroker->unregisterTimedReceiver(this, "*", "*",
+                                                     "mars_sim/simTimer");
+        control->dataBroker->unregisterTimedProducer(this, "*", "*",
+                                                     "mars_sim/simTimer");
+      }
+    }
+
+    int TactileArraySensor::getAsciiData(char* data) const {
+      sprintf(data, " %9.3f", totalForce);
+      return 10;
+    }
+
+    int TactileArraySensor::getSensorData(sReal** data) const {
+      *data = (sReal*)malloc(pressure.size()*sizeof(sReal));
+      for(size_t i = 0; i < pressure.size(); ++i) {
+        (*data)[i] = pressure[i];
+      }
+      return pressure.size();
+    }
+
+    void TactileArraySensor::receiveData(const data_broker::DataInfo &info,
+                                         const data_broker::DataPackage &package,
+                                         int callbackParam) {
+      CPP_UNUSED(info);
+      CPP_UNUSED(callbackParam);
+      if(positionIndices[0] == -1) {
+        positionIndices[0] = package.getIndexByName("position/x");
+        positionIndices[1] = package.getIndexByName("position/y");
+        positionIndices[2] = package.getIndexByName("position/z");
+        rotationIndices[0] = package.getIndexByName("rotation/x");
+        rotationIndices[1] = package.getIndexByName("rotation/y");
+        rotationIndices[2] = package.getIndexByName("rotation/z");
+        rotationIndices[3] = package.getIndexByName("rotation/w");
+      }
+      for(int i = 0; i < 3; ++i) {
+        package.get(positionIndices[i], &position[i]);
+      }
+      package.get(rotationIndices[0], &orientation.x());
+      package.get(rotationIndices[1], &orientation.y());
+      package.get(rotationIndices[2], &orientation.z());
+      package.get(rotationIndices[3], &orientation.w());
+
+      computePressure();
+    }
+
+    void TactileArraySensor::produceData(const data_broker::DataInfo &info,
+                                         data_broker::DataPackage *package,
+                                         int callbackParam) {
+      CPP_UNUSED(info);
+      CPP_UNUSED(callbackParam);
+      package->set(0, totalForce);
+      for(size_t i = 0; i < pressure.size(); ++i) {
+        package->set(i+1, pressure[i]);
+      }
+    }
+
+    void TactileArraySensor::splatForce(int col, int row, double force) {
+      if(col < 0 || col >= config.cols || row < 0 || row >= config.rows ||
+         force <= 0.0) {
+        return;
+      }
+      splat[row*config.cols+col] += force;
+      totalForce += force;
+      if(col < minCol) minCol = col;
+      if(col > maxCol) maxCol = col;
+      if(row < minRow) minRow = row;
+      if(row > maxRow) maxRow = row;
+    }
+
+    void TactileArraySensor::computePressure() {
+      const int cols = config.cols, rows = config.rows;
+
+      // clear what the last contacts left in the image
+      for(int r = minRow; r <= maxRow; ++r) {
+        for(int c = minCol; c <= maxCol; ++c) pressure[r*cols+c] = 0.0;
+      }
+      minCol = cols;
+      minRow = rows;
+      maxCol = maxRow = -1;
+      totalForce = 0.0;
+
+      control->nodes->getContactForces(attached_node, &contactPoints,
+                                       &contactForces);
+      if(contactPoints.empty()) {
+        minCol = minRow = 0;
+        return;
+      }
+
+      const Quaternion inv = orientation.inverse();
+      const Vector normal = orientation * Vector(0.0, 0.0, 1.0);
+      const double halfWidth = 0.5*cols*config.stepX;
+      const double halfHeight = 0.5*rows*config.stepY;
+      for(size_t i = 0; i < contactPoints.size(); ++i) {
+        Vector p = inv*(contactPoints[i] - position) - config.offset;
+        if(config.maxDistance > 0.0 && fabs(p.z()) > config.maxDistance) {
+          continue;
+        }
+        // grid coordinates with the taxel centers at integer positions
+        double u = (p.x() + halfWidth)/config.stepX - 0.5;
+        double v = (p.y() + halfHeight)/config.stepY - 0.5;
+        if(u <= -1.0 || v <= -1.0 || u >= cols || v >= rows) continue;
+        double force = fabs(contactForces[i].dot(normal));
+        int c = (int)floor(u), r = (int)floor(v);
+        double fu = u - c, fv = v - r;
+        splatForce(c, r, (1.0-fu)*(1.0-fv)*force);
+        splatForce(c+1, r, fu*(1.0-fv)*force);
+        splatForce(c, r+1, (1.0-fu)*fv*force);
+        splatForce(c+1, r+1, fu*fv*force);
+      }
+      if(maxCol < 0) {
+        minCol = minRow = 0;
+        return;
+      }
+
+      const double scale = 1.0/(config.stepX*config.stepY);
+      if(kernelX.empty() && kernelY.empty()) {
+        for(int r = minRow; r <= maxRow; ++r) {
+          for(int c = minCol; c <= maxCol; ++c) {
+            pressure[r*cols+c] = splat[r*cols+c]*scale;
+            splat[r*cols+c] = 0.0;
+          }
+        }
+        return;
+      }
+
+      // separable blur restricted to the rows and cols the kernels reach
+      const int c0 = std::max(minCol-radiusX, 0);
+      const int c1 = std::min(maxCol+radiusX, cols-1);
+      const int r0 = std::max(minRow-radiusY, 0);
+      const int r1 = std::min(maxRow+radiusY, rows-1);
+      for(int r = minRow; r <= maxRow; ++r) {
+        for(int c = c0; c <= c1; ++c) {
+          double sum = 0.0;
+          if(kernelX.empty()) sum = splat[r*cols+c];
+          else {
+            for(int k = -radiusX; k <= radiusX; ++k) {
+              int cc = c+k;
+              if(cc < minCol || cc > maxCol) continue;
+              sum += kernelX[k+radiusX]*splat[r*cols+cc];
+            }
+          }
+          blurTmp[r*cols+c] = sum;
+        }
+      }
+      for(int r = r0; r <= r1; ++r) {
+        for(int c = c0; c <= c1; ++c) {
+          double sum = 0.0;
+          if(kernelY.empty()) sum = r >= minRow && r <= maxRow ? blurTmp[r*cols+c] : 0.0;
+          else {
+            for(int k = -radiusY; k <= radiusY; ++k) {
+              int rr = r+k;
+              if(rr < minRow || rr > maxRow) continue;
+              sum += kernelY[k+radiusY]*blurTmp[rr*cols+c];
+            }
+          }
+          pressure[r*cols+c] = sum*scale;
+        }
+      }
+      for(int r = minRow; r <= maxRow; ++r) {
+        for(int c = c0; c <= c1; ++c) {
+          splat[r*cols+c] = blurTmp[r*cols+c] = 0.0;
+        }
+      }
+      minCol = c0;
+      maxCol = c1;
+      minRow = r0;
+      maxRow = r1;
+    }
+
+  } // end of namespace sim
+} // end of namespace mars
@@ -0,0 +1,143 @@
+/*
+ *  Copyright 2017, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * \file TactileArraySensor.h
+ * \brief A taxel grid on the surface of a node that maps the contact
+ *        forces of the node into a pressure image.
+ */
+
+#ifndef TACTILEARRAYSENSOR_H
+#define TACTILEARRAYSENSOR_H
+
+#ifdef _PRINT_HEADER_
+#warning "TactileArraySensor.h"
+#endif
+
+#include <mars/interfaces/sim/SensorInterface.h>
+#include <mars/interfaces/sim/LoadCenter.h>
+#include <mars/interfaces/sensor_bases.h>
+#include <mars/data_broker/ProducerInterface.h>
+#include <mars/data_broker/ReceiverInterface.h>
+#include <mars/utils/mathUtils.h>
+
+#include <vector>
+
+namespace mars {
+  namespace sim {
+
+    class TactileArrayConfig : public interfaces::BaseConfig {
+    public:
+      TactileArrayConfig() {
+        name = "tactile array";
+        attached_node = 0;
+        cols = rows = 1;
+        stepX = stepY = 0.01;
+        blur = 0.0;
+        maxDistance = 0.0;
+        offset = utils::Vector(0.0, 0.0, 0.0);
+      }
+
+      void parseConfig(interfaces::ControlCenter *control,
+                       configmaps::ConfigMap *config) {
+        unsigned int mapIndex = (*config)["mapIndex"];
+        name = config->get("name", name);
+        updateRate = config->get("rate", 10);
+        cols = config->get("cols", cols);
+        rows = config->get("rows", rows);
+        stepX = config->get("stepX", stepX);
+        stepY = config->get("stepY", stepY);
+        blur = config->get("blur", blur);
+        maxDistance = config->get("maxDistance", maxDistance);
+        if(config->hasKey("offset")) {
+          utils::vectorFromConfigItem(&(*config)["offset"], &offset);
+        }
+        attached_node = control->loadCenter->getMappedID((*config)["attached_node"],
+            interfaces::MAP_TYPE_NODE, mapIndex);
+      }
+
+      unsigned long attached_node; // node the skin is attached to
+      int cols, rows; // size of the taxel grid
+      double stepX, stepY; // taxel pitch in m
+      double blur; // standard deviation of the spatial blur in m
+      double maxDistance; // contacts farther from the grid plane are ignored, 0: no limit
+      utils::Vector offset; // center of the grid in node coordinates
+    };
+
+    /**
+     * TactileArraySensor is a skin patch of cols x rows taxels in the
+     * x-y plane of the attached node, centered at \c offset. The normal
+     * of the patch is the z axis of the node.
+     *
+     * Instead of probing every taxel with a ray, the contact points and
+     * forces the physics already collected for the node are projected
+     * onto the grid. The normal component of every contact force is
+     * split bilinearly between the four surrounding taxels and then
+     * blurred with a gaussian of standard deviation \c blur, which
+     * models the spreading of the load through the elastic skin. Only
+     * the part of the grid touched by the kernels is processed, thus the
+     * cost scales with the number of contacts.
+     *
+     * The output is the pressure image in N/m^2, row by row.
+     */
+    class TactileArraySensor : public interfaces::SensorInterface,
+                               public interfaces::BaseNodeSensor,
+                               public data_broker::ProducerInterface,
+                               public data_broker::ReceiverInterface {
+
+    public:
+      TactileArraySensor(interfaces::ControlCenter *control,
+                         TactileArrayConfig config);
+      ~TactileArraySensor();
+
+      virtual int getAsciiData(char* data) const;
+      virtual int getSensorData(interfaces::sReal** data) const;
+      virtual void receiveData(const data_broker::DataInfo &info,
+                               const data_broker::DataPackage &package,
+                               int callbackParam);
+      virtual void produceData(const data_broker::DataInfo &info,
+                               data_broker::DataPackage *package,
+                               int callbackParam);
+
+      static interfaces::BaseConfig* parseConfig(interfaces::ControlCenter *control,
+                                                 configmaps::ConfigMap *config);
+      static interfaces::BaseSensor* instanciate(interfaces::ControlCenter *control,
+                                                 interfaces::BaseConfig *config);
+
+    private:
+      TactileArrayConfig config;
+      std::vector<double> pressure, splat, blurTmp;
+      std::vector<double> kernelX, kernelY;
+      int radiusX, radiusY;
+      // the region of the grid that is not zero
+      int minCol, maxCol, minRow, maxRow;
+      double totalForce;
+      std::vector<utils::Vector> contactPoints, contactForces;
+      long positionIndices[3];
+      long rotationIndices[4];
+
+      void computePressure();
+      void splatForce(int col, int row, double force);
+    };
+
+  } // end of namespace sim
+} // end of namespace mars
+
+#endif // TACTILEARRAYSENSOR_H
@@ -25,7 +25,6 @@
  */
 
 #include "SMURFLoader.h"
-#include "zipit.h"
 
 #include <algorithm>
 #include <lib_manager/LibManager.hpp>
@@ -37,6 +36,7 @@
 #include <mars/sim/SimEntity.h>
 #include <mars/utils/misc.h>
 #include <mars/utils/mathUtils.h>
+#include <mars/utils/ArchiveFileSystem.h>
 
 
 namespace mars {
@@ -388,7 +388,10 @@ namespace mars {
                               std::string robotname,
                               void* args, bool do_not_create/*=false*/) {
       LOG_INFO("urdf_loader: prepare loading");
-      if (!do_not_create) entitylist.clear();
+      if (!do_not_create) {
+        entitylist.clear();
+        cablelist.clear();
+      }
 
       // split up filename in path + _filename and retrieve file extension
       std::string file_extension = utils::getFilenameSuffix(filename);
@@ -397,12 +400,17 @@ namespace mars {
       std::string _filename = filename;
       utils::removeFilenamePrefix(&_filename);
 
-      // need to unzip into a temporary directory
+      // zipped files are read in place, continue with the contained
+      // smurf file
       if (file_extension == ".zsmurf" || file_extension == ".zsmurfs" || file_extension == ".zsmurfa") {
-        if (unzip(tmpPath, filename) == 0) {
-          path = tmpPath;
+        file_extension = "." + file_extension.substr(2);
+        std::string contained = mountArchive(filename, file_extension);
+        if (contained.empty()) {
           return 0;
         }
+        path = utils::getPathOfFile(contained);
+        _filename = contained;
+        utils::removeFilenamePrefix(&_filename);
       }
 
       // read in the provided file - .smurfs / .smurf / .urdf
@@ -412,7 +420,16 @@ namespace mars {
       fprintf(stderr, "Reading in %s...\n", (path+_filename).c_str());
       if(file_extension == ".smurfs" || file_extension == ".smurfa") {
         configmaps::ConfigVector::iterator it;
-        map = configmaps::ConfigMap::fromYamlFile(path+_filename, true);
+        if (utils::isArchivePath(path+_filename)) {
+          std::string content;
+          if (!utils::readVirtualFile(path+_filename, &content)) {
+            LOG_ERROR("SMURFLoader: could not read %s", (path+_filename).c_str());
+            return 0;
+          }
+          map = configmaps::ConfigMap::fromYamlString(content);
+        } else {
+          map = configmaps::ConfigMap::fromYamlFile(path+_filename, true);
+        }
         //map.toYamlFile("smurfs_debugmap.yml");
         for (it = map["smurfs"].begin(); it != map["smurfs"].end(); ++it) { // backwards compatibility
           configmaps::ConfigMap &m = *it;
@@ -444,6 +461,20 @@ namespace mars {
               gravvec.z() = physicsmap["gravity"]["z"];
               control->sim->setGravity(gravvec);
               }
+            if (physicsmap.hasKey("fluid")) {
+              configmaps::ConfigMap fluidmap = physicsmap["fluid"];
+              control->sim->getPhysics()->setFluid(fluidmap);
+            }
+            if (physicsmap.hasKey("cables")) {
+              // the cables are created after the entities they are
+              // anchored to
+              configmaps::ConfigVector::iterator cit;
+              for (cit = physicsmap["cables"].begin();
+                   cit != physicsmap["cables"].end(); ++cit) {
+                configmaps::ConfigMap cablemap = *cit;
+                cablelist.push_back(cablemap);
+              }
+            }
             if (physicsmap.hasKey("ode")) {
               if (physicsmap["ode"].hasKey("cfm")) {
                 control->cfg->setPropertyValue("Simulator", "world cfm", "value", (sReal)(physicsmap["ode"]["cfm"]));
@@ -611,6 +642,12 @@ namespace mars {
         }
         if (iterations-1 > entitiesToLoad)
           fprintf(stderr, "WARNING: Loading all remaining entities as max iter is reached!\n");
+        for (size_t i = 0; i < cablelist.size(); ++i) {
+          if (!control->sim->addCable(cablelist[i])) {
+            LOG_ERROR("SMURFLoader: could not create cable %lu", (unsigned long)i);
+          }
+        }
+        cablelist.clear();
       }
 
       return 1; //TODO: check number of successfully loaded entities before returning 1
@@ -621,18 +658,43 @@ namespace mars {
     }
 
 
-    unsigned int SMURFLoader::unzip(const std::string& destinationDir,
-                                     const std::string& zipFilename) {
-      if (!utils::createDirectory(destinationDir))
-        return 0;
-
-      Zipit myZipFile(zipFilename);
-      LOG_INFO("Load: unsmurfing zipped SMURF: %s", zipFilename.c_str());
-
-      if (!myZipFile.unpackWholeZipTo(destinationDir))
-        return 0;
-
-      return 1;
+    std::string SMURFLoader::mountArchive(const std::string& zipFilename,
+                                          const std::string& extension) {
+      LOG_INFO("Load: mounting zipped SMURF: %s", zipFilename.c_str());
+      // the archive stays mounted, the meshes are loaded later on by the
+      // graphics and the node manager
+      if (!utils::mountArchive(zipFilename)) {
+        LOG_ERROR("SMURFLoader: could not open archive: %s", zipFilename.c_str());
+        return "";
+      }
+      // prefer the file named like the archive, otherwise take the
+      // first file with the right extension closest to the root
+      std::string name = zipFilename;
+      utils::removeFilenamePrefix(&name);
+      utils::removeFilenameSuffix(&name);
+      name += extension;
+      std::vector<std::string> files = utils::listArchiveFiles(zipFilename);
+      std::string found;
+      for (size_t i = 0; i < files.size(); ++i) {
+        if (utils::getFilenameSuffix(files[i]) != extension) continue;
+        std::string base = files[i];
+        utils::removeFilenamePrefix(&base);
+        if (base == name) {
+          found = files[i];
+          break;
+        }
+        if (found.empty() ||
+            std::count(files[i].begin(), files[i].end(), '/') <
+            std::count(found.begin(), found.end(), '/')) {
+          found = files[i];
+        }
+      }
+      if (found.empty()) {
+        LOG_ERROR("SMURFLoader: no %s file in archive %s", extension.c_str(),
+                  zipFilename.c_str());
+        return "";
+      }
+      return zipFilename + "/" + found;
     }
 
     void SMURFLoader::applyConfigStruct(ConfigStruct *cfg_struct,
@@ -93,9 +93,10 @@ namespace mars {
       interfaces::ControlCenter *control;
       entity_generation::EntityFactoryManager* factoryManager;
       std::vector<configmaps::ConfigMap> entitylist; // a list of the entities to be loaded
+      std::vector<configmaps::ConfigMap> cablelist; // the cables between these entities
 
-      unsigned int unzip(const std::string& destinationDir,
-                         const std::string& zipFilename);
+      std::string mountArchive(const std::string& zipFilename,
+                               const std::string& extension);
       void applyConfigStruct(ConfigStruct* cfg_struct, configmaps::ConfigMap& m,
         bool is_smurfa=false);
       void transformConfigMapPose(utils::Vector pos_offset,
@@ -0,0 +1,184 @@
+/*
+ *  Copyright 2017, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * \file SceneStreamClient.cpp
+ * \brief Shows the scene that is streamed by a running simulation.
+ *
+ */
+
+#include "SceneStreamClient.h"
+
+#include <mars/interfaces/NodeData.h>
+#include <mars/interfaces/MaterialData.h>
+#include <mars/interfaces/terrainStruct.h>
+#include <mars/interfaces/graphics/draw_structs.h>
+#include <mars/interfaces/Logging.hpp>
+#include <mars/utils/MutexLocker.h>
+#include <configmaps/ConfigData.h>
+
+namespace mars {
+
+  using namespace interfaces;
+
+  namespace viz {
+
+    SceneStreamClient::SceneStreamClient(GraphicsManagerInterface *graphics) :
+      graphics(graphics), newScene(false), newState(false) {
+    }
+
+    SceneStreamClient::~SceneStreamClient() {
+      if(isRunning()) cancel(true);
+      connection.close();
+      graphics->removeGraphicsUpdateInterface(this);
+      graphics->removeDrawItems(this);
+    }
+
+    bool SceneStreamClient::connectToServer(const std::string &host,
+                                            unsigned short port) {
+      if(connection.connectToTCPServer(host, port) != utils::SOCKET_SUCCESS) {
+        LOG_ERROR("SceneStreamClient: can not connect to %s:%d",
+                  host.c_str(), port);
+        return false;
+      }
+      graphics->addGraphicsUpdateInterface(this);
+      drawStruct draw;
+      draw.ptr_draw = this;
+      graphics->addDrawItems(&draw);
+      start();
+      return true;
+    }
+
+    void SceneStreamClient::run() {
+      std::vector<char> buffer;
+      while(true) {
+        unsigned char header[4];
+        if(connection.recvAll((char*)header, 4) != utils::SOCKET_SUCCESS) {
+          break;
+        }
+        size_t length = ((size_t)header[0] << 24 | (size_t)header[1] << 16 |
+                         (size_t)header[2] << 8 | (size_t)header[3]);
+        if(length == 0) break;
+        buffer.resize(length);
+        if(connection.recvAll(&buffer[0], length) != utils::SOCKET_SUCCESS) {
+          break;
+        }
+
+        if(buffer[0] == SCENE_STREAM_SCENE) {
+          utils::MutexLocker locker(&mutex);
+          scene.assign(&buffer[1], length-1);
+          newScene = true;
+          newState = false;
+        }
+        // a broken delta is followed by the next keyframe
+        else if(decoder.decode(&buffer[0], length, &decoded)) {
+          utils::MutexLocker locker(&mutex);
+          received.time = decoded.time;
+          received.positions.swap(decoded.positions);
+          received.rotations.swap(decoded.rotations);
+          received.jointValues.swap(decoded.jointValues);
+          received.lines.swap(decoded.lines);
+          newState = true;
+        }
+      }
+      LOG_WARN("SceneStreamClient: connection closed");
+    }
+
+    void SceneStreamClient::createScene(const std::string &yaml) {
+      for(size_t i=0; i<drawIds.size(); ++i) {
+        graphics->removeDrawObject(drawIds[i]);
+      }
+      drawIds.clear();
+
+      configmaps::ConfigMap map = configmaps::ConfigMap::fromYamlString(yaml);
+      configmaps::ConfigVector::iterator it;
+      for(it=map["nodelist"].begin(); it!=map["nodelist"].end(); ++it) {
+        configmaps::ConfigMap nodeMap = *it;
+        NodeData node;
+        node.fromConfigMap(&nodeMap, "", NULL);
+        if(nodeMap.hasKey("material_data")) {
+          configmaps::ConfigMap material = nodeMap["material_data"];
+          node.material.fromConfigMap(&material, "");
+        }
+        if(node.terrain) {
+          graphics->getLoadHeightmapInterface()->readPixelData(node.terrain);
+        }
+        drawIds.push_back(graphics->addDrawObject(node));
+      }
+    }
+
+    void SceneStreamClient::preGraphicsUpdate(void) {
+      std::string yaml;
+      bool createNewScene = false;
+      {
+        utils::MutexLocker locker(&mutex);
+        if(newScene) {
+          yaml.swap(scene);
+          newScene = false;
+          createNewScene = true;
+        }
+        if(newState) {
+          state.time = received.time;
+          state.positions.swap(received.positions);
+          state.rotations.swap(received.rotations);
+          state.jointValues.swap(received.jointValues);
+          state.lines.swap(received.lines);
+          newState = false;
+        }
+      }
+      if(createNewScene) createScene(yaml);
+
+      // the frames arrive with the scene they belong to
+      if(state.positions.size() != drawIds.size()) return;
+      for(size_t i=0; i<drawIds.size(); ++i) {
+        graphics->setDrawObjectPos(drawIds[i], state.positions[i]);
+        graphics->setDrawObjectRot(drawIds[i], state.rotations[i]);
+      }
+    }
+
+    void SceneStreamClient::update(std::vector<draw_item> *drawItems) {
+      std::vector<draw_item>::iterator iter;
+      for(iter=drawItems->begin(); iter!=drawItems->end(); ++iter) {
+        iter->draw_state = DRAW_STATE_ERASE;
+      }
+
+      draw_item item;
+      item.id = 0;
+      item.type = DRAW_LINE;
+      item.draw_state = DRAW_STATE_CREATE;
+      item.point_size = 10;
+      item.myColor.a = 1;
+      item.label = "";
+      item.t_width = item.t_height = 0;
+      item.texture = "";
+      item.get_light = 0;
+      for(size_t i=0; i<state.lines.size(); ++i) {
+        const SceneStreamLine &line = state.lines[i];
+        item.start = line.start;
+        item.end = line.end;
+        item.myColor.r = line.color[0]/255.0;
+        item.myColor.g = line.color[1]/255.0;
+        item.myColor.b = line.color[2]/255.0;
+        drawItems->push_back(item);
+      }
+    }
+
+  } // end of namespace viz
+} // end of namespace mars
@@ -0,0 +1,88 @@
+/*
+ *  Copyright 2017, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * \file SceneStreamClient.h
+ * \brief Shows the scene that is streamed by a running simulation.
+ *
+ */
+
+#ifndef MARS_VIZ_SCENE_STREAM_CLIENT_H
+#define MARS_VIZ_SCENE_STREAM_CLIENT_H
+
+#ifdef _PRINT_HEADER_
+  #warning "SceneStreamClient.h"
+#endif
+
+#include <mars/interfaces/graphics/GraphicsManagerInterface.h>
+#include <mars/interfaces/graphics/GraphicsUpdateInterface.h>
+#include <mars/interfaces/graphics/DrawInterface.h>
+#include <mars/interfaces/sim/SceneStream.h>
+#include <mars/utils/Thread.h>
+#include <mars/utils/Mutex.h>
+#include <mars/utils/Socket.h>
+
+#include <string>
+#include <vector>
+
+namespace mars {
+
+  namespace viz {
+
+    /**
+     * Receives the scene and the frames in its own thread, the draw
+     * objects are created and moved in the graphics update.
+     */
+    class SceneStreamClient : public utils::Thread,
+                              public interfaces::GraphicsUpdateInterface,
+                              public interfaces::DrawInterface {
+    public:
+      explicit SceneStreamClient(interfaces::GraphicsManagerInterface *graphics);
+      ~SceneStreamClient();
+
+      bool connectToServer(const std::string &host, unsigned short port);
+
+      // GraphicsUpdateInterface methods
+      void preGraphicsUpdate(void);
+
+      // DrawInterface methods
+      void update(std::vector<interfaces::draw_item> *drawItems);
+
+    protected:
+      void run();
+
+    private:
+      interfaces::GraphicsManagerInterface *graphics;
+      utils::TCPConnection connection;
+      utils::Mutex mutex;
+      interfaces::SceneStreamDecoder decoder;
+      // decoded, received and shown state
+      interfaces::SceneStreamState decoded, received, state;
+      std::string scene;
+      bool newScene, newState;
+      std::vector<unsigned long> drawIds;
+
+      void createScene(const std::string &yaml);
+    };
+
+  } // end of namespace viz
+} // end of namespace mars
+
+#endif // MARS_VIZ_SCENE_STREAM_CLIENT_H
@@ -21,10 +21,14 @@
 #include "Viz.h"
 #include "GraphicsTimer.h"
 #include "MyApp.h"
+#include "SceneStreamClient.h"
 
 #include <signal.h>
 
+#include <cstdio>
+#include <cstdlib>
 #include <stdexcept>
+#include <string>
 
 void qtExitHandler(int sig) {
   qApp->quit();
@@ -66,7 +70,30 @@ int main(int argc, char *argv[]) {
   mars::viz::GraphicsTimer *graphicsTimer = new mars::viz::GraphicsTimer(viz->graphics);
   graphicsTimer->run();
 
-  if(argc > 2) {
+  // show the scene of a running simulation: --connect host:port
+  mars::viz::SceneStreamClient *streamClient = NULL;
+  if(argc > 2 && std::string(argv[1]) == "--connect") {
+    std::string address = argv[2];
+    std::string host = "localhost";
+    unsigned short port = 5757;
+    size_t pos = address.rfind(':');
+    if(pos != std::string::npos) {
+      if(pos > 0) host = address.substr(0, pos);
+      port = atoi(address.substr(pos+1).c_str());
+    }
+    else if(!address.empty()) {
+      host = address;
+    }
+    streamClient = new mars::viz::SceneStreamClient(viz->graphics);
+    if(!streamClient->connectToServer(host, port)) {
+      fprintf(stderr, "viz: can not connect to %s:%d\n", host.c_str(), port);
+      graphicsTimer->stop();
+      delete streamClient;
+      delete viz;
+      return EXIT_FAILURE;
+    }
+  }
+  else if(argc > 2) {
     viz->loadScene(argv[2], argv[1]);
   }
   else if(argc > 1) {
@@ -76,6 +103,7 @@ int main(int argc, char *argv[]) {
   int state;
   state = app->exec();
 
+  delete streamClient;
   delete viz;
   return state;
 }